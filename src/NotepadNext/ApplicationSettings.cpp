@@ -54,6 +54,7 @@ CREATE_SETTING(Gui, CombineSearchResults, combineSearchResults, bool, false)
 CREATE_SETTING(App, RestorePreviousSession, restorePreviousSession, bool, false)
 CREATE_SETTING(App, RestoreUnsavedFiles, restoreUnsavedFiles, bool, false)
 CREATE_SETTING(App, RestoreTempFiles, restoreTempFiles, bool, false)
+CREATE_SETTING(App, CompressSessionFiles, compressSessionFiles, bool, false)
 
 CREATE_SETTING(App, DefaultDirectoryBehavior, defaultDirectoryBehavior, ApplicationSettings::DefaultDirectoryBehaviorEnum, ApplicationSettings::FollowCurrentDocument)
 CREATE_SETTING(App, DefaultDirectory, defaultDirectory, QString, QString())
@@ -71,3 +72,10 @@ CREATE_SETTING(Editor, AdditionalWordChars, additionalWordChars, QString, QStrin
 CREATE_SETTING(Editor, DefaultEOLMode, defaultEOLMode, QString, QStringLiteral(""))
 CREATE_SETTING(Editor, URLHighlighting, urlHighlighting, bool, true)
 CREATE_SETTING(Editor, ShowLineNumbers, showLineNumbers, bool, true)
+CREATE_SETTING(Editor, EditJournal, editJournal, bool, false)
+CREATE_SETTING(Editor, LargeFileSizeMB, largeFileSizeMB, int, 256)
+CREATE_SETTING(Editor, PagedViewSizeMB, pagedViewSizeMB, int, 2048)
+CREATE_SETTING(Editor, HibernateAfterMinutes, hibernateAfterMinutes, int, 0)
+CREATE_SETTING(Editor, MemoryBudgetMB, memoryBudgetMB, int, 0)
+CREATE_SETTING(Editor, UndoMemoryLimitMB, undoMemoryLimitMB, int, 64)
+CREATE_SETTING(Editor, LayoutThreads, layoutThreads, int, 0)
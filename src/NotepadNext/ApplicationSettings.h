@@ -102,6 +102,7 @@ public:
     DEFINE_SETTING(RestorePreviousSession, restorePreviousSession, bool)
     DEFINE_SETTING(RestoreUnsavedFiles, restoreUnsavedFiles, bool)
     DEFINE_SETTING(RestoreTempFiles, restoreTempFiles, bool)
+    DEFINE_SETTING(CompressSessionFiles, compressSessionFiles, bool)
 
     DEFINE_SETTING(DefaultDirectoryBehavior, defaultDirectoryBehavior, DefaultDirectoryBehaviorEnum)
     DEFINE_SETTING(DefaultDirectory, defaultDirectory, QString)
@@ -119,4 +120,11 @@ public:
     DEFINE_SETTING(DefaultEOLMode, defaultEOLMode, QString)
     DEFINE_SETTING(URLHighlighting, urlHighlighting, bool)
     DEFINE_SETTING(ShowLineNumbers, showLineNumbers, bool)
+    DEFINE_SETTING(EditJournal, editJournal, bool)
+    DEFINE_SETTING(LargeFileSizeMB, largeFileSizeMB, int)
+    DEFINE_SETTING(PagedViewSizeMB, pagedViewSizeMB, int)
+    DEFINE_SETTING(HibernateAfterMinutes, hibernateAfterMinutes, int)
+    DEFINE_SETTING(MemoryBudgetMB, memoryBudgetMB, int)
+    DEFINE_SETTING(UndoMemoryLimitMB, undoMemoryLimitMB, int)
+    DEFINE_SETTING(LayoutThreads, layoutThreads, int)
 };
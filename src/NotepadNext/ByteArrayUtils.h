@@ -49,6 +49,8 @@ private:
 #include <QSet>
 #include <algorithm>
 #include <cstring>
+#include <functional>
+#include <iterator>
 #include <unordered_set>
 
 namespace ByteArrayUtils
@@ -143,4 +145,31 @@ inline QByteArray join(const QList<QByteArrayView>& parts, const QByteArray& del
     return out;
 }
 
+
+// Finds text in a raw buffer that may be far larger than a QByteArray can hold.
+// Searching backwards finds the last match ending at or before 'from'. Returns -1 if not found.
+inline qint64 find(const char* data, qint64 size, const QByteArray& text, qint64 from, bool forward = true)
+{
+    if (text.isEmpty() || data == nullptr)
+        return -1;
+
+    from = qBound(Q_INT64_C(0), from, size);
+
+    if (forward) {
+        const std::boyer_moore_horspool_searcher searcher(text.cbegin(), text.cend());
+        const char* match = std::search(data + from, data + size, searcher);
+
+        return match == data + size ? -1 : match - data;
+    }
+    else {
+        // Match the reversed text against the data in reverse
+        const std::boyer_moore_horspool_searcher searcher(text.crbegin(), text.crend());
+        const auto begin = std::make_reverse_iterator(data + from);
+        const auto end = std::make_reverse_iterator(data);
+        const auto match = std::search(begin, end, searcher);
+
+        return match == end ? -1 : (match.base() - data) - text.size();
+    }
+}
+
 } // namespace ByteArrayViewUtils
@@ -29,8 +29,13 @@ void Converter::convert(QTextStream &stream)
     convertRange(stream, 0, editor->length());
 }
 
-void Converter::ensureDocumentStyled(int start, int end)
+void Converter::ensureDocumentStyled(int end)
 {
-    // If idle styling is used, then the document may not have styling information yet
-    editor->colourise(start, end);
+    // If idle or background styling is used, then the document may not have styling information yet.
+    // Only lex from where styling stopped, as any earlier text (including results already produced
+    // by background styling) is styled correctly
+    const int endStyled = editor->endStyled();
+    if (endStyled < end) {
+        editor->colourise(editor->positionFromLine(editor->lineFromPosition(endStyled)), end);
+    }
 }
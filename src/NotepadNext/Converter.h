@@ -32,7 +32,7 @@ public:
     virtual void convertRange(QTextStream &stream, int start, int end) = 0;
 
 protected:
-    void ensureDocumentStyled(int start, int end);
+    void ensureDocumentStyled(int end);
 
     ScintillaNext *editor;
 };
@@ -160,7 +160,7 @@ void DockedEditor::addEditor(ScintillaNext *editor)
     }
 
     // Create the dock widget for the editor
-    ads::CDockWidget *dockWidget = dockManager->createDockWidget(editor->getName());
+    ads::CDockWidget *dockWidget = dockManager->createDockWidget(tabTitle(editor));
 
     // Disable elide, elided file names not readable when lots of files opened
     dockWidget->tabWidget()->setElideMode(Qt::ElideNone);
@@ -188,8 +188,9 @@ void DockedEditor::addEditor(ScintillaNext *editor)
         dockWidget->tabWidget()->setToolTip(editor->getName());
     }
 
-    // Set the icon
-    if (editor->readOnly()) {
+    // Set the icon, a hibernating editor is only read-only until it wakes up
+    const bool readOnly = editor->isHibernating() ? editor->hibernationState()->readOnly : editor->readOnly();
+    if (readOnly) {
         dockWidget->tabWidget()->setIcon(QIcon(":/icons/readonly.png"));
     }
     else {
@@ -213,13 +214,26 @@ void DockedEditor::addEditor(ScintillaNext *editor)
     emit editorAdded(editor);
 }
 
+QString DockedEditor::tabTitle(const ScintillaNext *editor) const
+{
+    // Make it obvious some features are turned off for this editor
+    if (editor->isPagedView()) {
+        return tr("%1 [Paged]").arg(editor->getName());
+    }
+    else if (editor->isLargeFile()) {
+        return tr("%1 [Large File]").arg(editor->getName());
+    }
+
+    return editor->getName();
+}
+
 void DockedEditor::editorRenamed(ScintillaNext *editor)
 {
     Q_ASSERT(editor != Q_NULLPTR);
 
     ads::CDockWidget *dockWidget = qobject_cast<ads::CDockWidget *>(editor->parentWidget());
 
-    dockWidget->setWindowTitle(editor->getName());
+    dockWidget->setWindowTitle(tabTitle(editor));
 
     if (editor->isFile()) {
         dockWidget->tabWidget()->setToolTip(editor->getFilePath());
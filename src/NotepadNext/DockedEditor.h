@@ -34,6 +34,8 @@ private:
     ads::CDockAreaWidget* latestDockArea = Q_NULLPTR;
     ScintillaNext *currentEditor = Q_NULLPTR;
 
+    QString tabTitle(const ScintillaNext *editor) const;
+
 public:
     explicit DockedEditor(QWidget *parent);
 
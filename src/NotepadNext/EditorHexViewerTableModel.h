@@ -1,51 +0,0 @@
-/*
- * This file is part of Notepad Next.
- * Copyright 2022 Justin Dailey
- *
- * Notepad Next is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * Notepad Next is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
- */
-
-
-#ifndef EDITORHEXVIEWERTABLEMODEL_H
-#define EDITORHEXVIEWERTABLEMODEL_H
-
-#include <QAbstractTableModel>
-
-
-class ScintillaNext;
-
-class EditorHexViewerTableModel : public QAbstractTableModel
-{
-    Q_OBJECT
-
-public:
-    explicit EditorHexViewerTableModel(QObject *parent = nullptr);
-
-    void setEditor(ScintillaNext *e);
-
-    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
-
-    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
-    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
-
-    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
-    bool setData(const QModelIndex &index, const QVariant &value, int role) override;
-
-    Qt::ItemFlags flags(const QModelIndex &index) const override;
-
-private:
-    ScintillaNext *editor;
-};
-
-#endif // EDITORHEXVIEWERTABLEMODEL_H
@@ -17,6 +17,10 @@
  */
 
 #include <QApplication>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
 
 #include "ApplicationSettings.h"
 
@@ -36,12 +40,24 @@
 #include "URLFinder.h"
 #include "BookMarkDecorator.h"
 #include "HTMLAutoCompleteDecorator.h"
+#include "EditJournal.h"
+#include "PagedView.h"
 
 
 const int MARK_HIDELINESBEGIN = 23;
 const int MARK_HIDELINESEND = 22;
 const int MARK_HIDELINESUNDERLINE = 21;
 
+// Editors that were only just switched away from are left alone, even when over the memory budget
+const qint64 MIN_HIBERNATE_IDLE_TIME = 60 * 1000;
+
+
+static qint64 DocumentMemory(const ScintillaNext *editor, qint64 length)
+{
+    // Large files store styles as runs which take little space, everything else has a style byte for every byte of text
+    return editor->isLargeFile() ? length : length * 2;
+}
+
 
 EditorManager::EditorManager(ApplicationSettings *settings, QObject *parent)
     : QObject(parent), settings(settings)
@@ -52,6 +68,12 @@ EditorManager::EditorManager(ApplicationSettings *settings, QObject *parent)
         });
     });
 
+    connect(settings, &ApplicationSettings::undoMemoryLimitMBChanged, this, [=]() {
+        for (auto &editor : getEditors()) {
+            editor->setUndoMemoryLimit(undoMemoryLimit());
+        }
+    });
+
     connect(settings, &ApplicationSettings::showWrapSymbolChanged, this, [=](bool b) {
         for (auto &editor : getEditors()) {
             editor->setWrapVisualFlags(b ? SC_WRAPVISUALFLAG_END : SC_WRAPVISUALFLAG_NONE);
@@ -82,7 +104,9 @@ EditorManager::EditorManager(ApplicationSettings *settings, QObject *parent)
     connect(settings, &ApplicationSettings::wordWrapChanged, this, [=](bool b) {
         if (b) {
             for (auto &editor : getEditors()) {
-                editor->setWrapMode(SC_WRAP_WORD);
+                if (!editor->isLargeFile()) {
+                    editor->setWrapMode(SC_WRAP_WORD);
+                }
             }
         }
         else {
@@ -128,6 +152,29 @@ EditorManager::EditorManager(ApplicationSettings *settings, QObject *parent)
             }
         }
     });
+
+    connect(settings, &ApplicationSettings::editJournalChanged, this, [=](bool b){
+        for (auto &editor : getEditors()) {
+            EditJournal *decorator = editor->findChild<EditJournal *>(QString(), Qt::FindDirectChildrenOnly);
+            if (decorator) {
+                decorator->setEnabled(b);
+            }
+        }
+    });
+
+    connect(settings, &ApplicationSettings::layoutThreadsChanged, this, [=]() {
+        for (auto &editor : getEditors()) {
+            applyLayoutThreads(editor);
+        }
+    });
+
+    hibernationTimer.setInterval(60 * 1000);
+    connect(&hibernationTimer, &QTimer::timeout, this, &EditorManager::hibernateIdleEditors);
+    hibernationTimer.start();
+
+    layoutTuningTimer.setInterval(5 * 1000);
+    connect(&layoutTuningTimer, &QTimer::timeout, this, &EditorManager::tuneLayoutThreads);
+    layoutTuningTimer.start();
 }
 
 ScintillaNext *EditorManager::createEditor(const QString &name)
@@ -141,7 +188,14 @@ ScintillaNext *EditorManager::createEditor(const QString &name)
 
 ScintillaNext *EditorManager::createEditorFromFile(const QString &filePath, bool tryToCreate)
 {
-    ScintillaNext *editor = ScintillaNext::fromFile(filePath, tryToCreate);
+    ScintillaNext *editor;
+
+    if (pagedViewSize() > 0 && QFileInfo(filePath).size() >= pagedViewSize()) {
+        editor = ScintillaNext::pagedFromFile(filePath);
+    }
+    else {
+        editor = ScintillaNext::fromFile(filePath, tryToCreate, largeFileSize());
+    }
 
     if (editor) {
         manageEditor(editor);
@@ -150,6 +204,38 @@ ScintillaNext *EditorManager::createEditorFromFile(const QString &filePath, bool
     return editor;
 }
 
+ScintillaNext *EditorManager::createHibernatedEditorFromFile(const QString &filePath)
+{
+    ScintillaNext *editor;
+
+    // A paged view doesn't read anything up front either
+    if (pagedViewSize() > 0 && QFileInfo(filePath).size() >= pagedViewSize()) {
+        editor = ScintillaNext::pagedFromFile(filePath);
+    }
+    else {
+        editor = ScintillaNext::hibernatedFromFile(filePath, largeFileSize());
+    }
+
+    manageEditor(editor);
+
+    return editor;
+}
+
+qint64 EditorManager::largeFileSize() const
+{
+    return qMax(0, settings->largeFileSizeMB()) * Q_INT64_C(1024 * 1024);
+}
+
+qint64 EditorManager::pagedViewSize() const
+{
+    return qMax(0, settings->pagedViewSizeMB()) * Q_INT64_C(1024 * 1024);
+}
+
+qint64 EditorManager::undoMemoryLimit() const
+{
+    return qMax(0, settings->undoMemoryLimitMB()) * Q_INT64_C(1024 * 1024);
+}
+
 ScintillaNext *EditorManager::getEditorByFilePath(const QString &filePath)
 {
     QFileInfo newInfo(filePath);
@@ -166,6 +252,112 @@ ScintillaNext *EditorManager::getEditorByFilePath(const QString &filePath)
     return Q_NULLPTR;
 }
 
+ScintillaNext *EditorManager::getTempEditorByName(const QString &name)
+{
+    purgeOldEditorPointers();
+
+    for (ScintillaNext *editor : qAsConst(editors)) {
+        if (!editor->isFile() && editor->getName() == name) {
+            return editor;
+        }
+    }
+
+    return Q_NULLPTR;
+}
+
+qint64 EditorManager::reclaimedBytes()
+{
+    qint64 total = 0;
+
+    for (auto &editor : getEditors()) {
+        if (editor->isHibernating()) {
+            total += DocumentMemory(editor, editor->hibernationState()->length);
+        }
+    }
+
+    return total;
+}
+
+void EditorManager::hibernateIdleEditors()
+{
+    const qint64 idleLimit = qMax(0, settings->hibernateAfterMinutes()) * Q_INT64_C(60 * 1000);
+    const qint64 budget = qMax(0, settings->memoryBudgetMB()) * Q_INT64_C(1024 * 1024);
+
+    if (idleLimit == 0 && budget == 0) {
+        return;
+    }
+
+    // The idle time keeps ticking so take a snapshot of it to sort by
+    QVector<QPair<qint64, ScintillaNext *>> candidates;
+    qint64 used = 0;
+
+    for (auto &editor : getEditors()) {
+        if (editor->isHibernating()) {
+            continue;
+        }
+
+        used += editor->totalMemoryUsage();
+
+        const qint64 idleTime = editor->idleTime();
+        if (idleTime >= MIN_HIBERNATE_IDLE_TIME) {
+            candidates.append(qMakePair(idleTime, editor.data()));
+        }
+    }
+
+    // Whatever has been idle the longest goes first
+    std::sort(candidates.begin(), candidates.end(), [](const QPair<qint64, ScintillaNext *> &a, const QPair<qint64, ScintillaNext *> &b) {
+        return a.first > b.first;
+    });
+
+    int count = 0;
+    for (const auto &candidate : qAsConst(candidates)) {
+        ScintillaNext *editor = candidate.second;
+        const bool isIdle = idleLimit > 0 && candidate.first >= idleLimit;
+        const bool isOverBudget = budget > 0 && used > budget;
+
+        if (!isIdle && !isOverBudget) {
+            break;
+        }
+
+        const qint64 memory = editor->totalMemoryUsage();
+
+        if (editor->hibernate()) {
+            used -= memory;
+            ++count;
+        }
+    }
+
+    if (count > 0) {
+        qInfo("Hibernated %d editors, %lld bytes reclaimed in total", count, reclaimedBytes());
+    }
+}
+
+void EditorManager::applyLayoutThreads(ScintillaNext *editor)
+{
+    const int threads = settings->layoutThreads();
+
+    if (threads > 0) {
+        editor->setLayoutThreads(threads);
+    }
+    else {
+        // Automatic, start with a thread per core and let the wrap timings cut it down
+        editor->resetLayoutThreads(QThread::idealThreadCount());
+    }
+}
+
+void EditorManager::tuneLayoutThreads()
+{
+    if (settings->layoutThreads() > 0) {
+        return;
+    }
+
+    for (auto &editor : getEditors()) {
+        if (!editor->isHibernating()) {
+            editor->tuneLayoutThreads();
+        }
+    }
+}
+
 void EditorManager::manageEditor(ScintillaNext *editor)
 {
     editors.append(QPointer<ScintillaNext>(editor));
@@ -179,6 +371,12 @@ void EditorManager::setupEditor(ScintillaNext *editor)
 {
     qInfo(Q_FUNC_INFO);
 
+    // This loads the text, which everything below expects to be there
+    if (editor->isPagedView()) {
+        PagedView *pv = new PagedView(editor);
+        pv->setEnabled(true);
+    }
+
     editor->clearCmdKey(SCK_INSERT);
 
     editor->setFoldMarkers(QStringLiteral("box"));
@@ -188,9 +386,23 @@ void EditorManager::setupEditor(ScintillaNext *editor)
         editor->markerSetBackSelected(i, 0x0000FF);
     }
 
-    editor->setIdleStyling(SC_IDLESTYLING_TOVISIBLE);
+    // Large files are only lexed as far as they are viewed
+    editor->setIdleStyling(editor->isLargeFile() ? SC_IDLESTYLING_NONE : SC_IDLESTYLING_TOVISIBLE);
+    // Long runs of unstyled text before the view are lexed on a worker thread so jumping
+    // far into a file does not block
+    editor->setBackgroundStyling(true);
+    // Turning on word wrap for a long file wraps it on a worker thread instead of a little
+    // at a time during idle
+    editor->setBackgroundWrapping(true);
+    // Brace and tag matching in a long file count blocks on a worker thread instead of during idle
+    editor->setBackgroundIndexing(true);
     editor->setEndAtLastLine(false);
 
+    editor->setUndoMemoryLimit(undoMemoryLimit());
+
+    // 0 means automatic
+    applyLayoutThreads(editor);
+
     editor->setMultipleSelection(true);
     editor->setAdditionalSelectionTyping(true);
     editor->setMultiPaste(SC_MULTIPASTE_EACH);
@@ -282,7 +494,7 @@ void EditorManager::setupEditor(ScintillaNext *editor)
     editor->setViewEOL(settings->showEndOfLine());
     editor->setWrapVisualFlags(settings->showWrapSymbol() ? SC_WRAPVISUALFLAG_END : SC_WRAPVISUALFLAG_NONE);
     editor->setIndentationGuides(settings->showIndentGuide() ? SC_IV_LOOKBOTH : SC_IV_NONE);
-    editor->setWrapMode(settings->wordWrap() ? SC_WRAP_WORD : SC_WRAP_NONE);
+    editor->setWrapMode(settings->wordWrap() && !editor->isLargeFile() ? SC_WRAP_WORD : SC_WRAP_NONE);
 
     int detectedEOLMode = detectEOLMode(editor);
     if (detectedEOLMode == -1) {
@@ -301,17 +513,23 @@ void EditorManager::setupEditor(ScintillaNext *editor)
     }
 
     // Decorators
-    SmartHighlighter *s = new SmartHighlighter(editor);
-    s->setEnabled(true);
+    // Large files skip the ones that search or scan through the whole document
+    if (!editor->isLargeFile()) {
+        SmartHighlighter *s = new SmartHighlighter(editor);
+        s->setEnabled(true);
 
-    HighlightedScrollBarDecorator *h = new HighlightedScrollBarDecorator(editor);
-    h->setEnabled(true);
+        HighlightedScrollBarDecorator *h = new HighlightedScrollBarDecorator(editor);
+        h->setEnabled(true);
+    }
 
     BraceMatch *b = new BraceMatch(editor);
     b->setEnabled(true);
 
-    LineNumbers *l = new LineNumbers(editor);
-    l->setEnabled(settings->showLineNumbers());
+    // The paged view does its own line numbers
+    if (!editor->isPagedView()) {
+        LineNumbers *l = new LineNumbers(editor);
+        l->setEnabled(settings->showLineNumbers());
+    }
 
     SurroundSelection *ss = new SurroundSelection(editor);
     ss->setEnabled(true);
@@ -322,16 +540,21 @@ void EditorManager::setupEditor(ScintillaNext *editor)
     AutoIndentation *ai = new AutoIndentation(editor);
     ai->setEnabled(true);
 
-    AutoCompletion *ac = new AutoCompletion(editor);
-    ac->setEnabled(true);
+    if (!editor->isLargeFile()) {
+        AutoCompletion *ac = new AutoCompletion(editor);
+        ac->setEnabled(true);
 
-    URLFinder *uf = new URLFinder(editor);
-    uf->setEnabled(settings->urlHighlighting());
+        URLFinder *uf = new URLFinder(editor);
+        uf->setEnabled(settings->urlHighlighting());
+    }
 
     BookMarkDecorator *bm = new BookMarkDecorator(editor);
     bm->setEnabled(true);
 
     new HTMLAutoCompleteDecorator(editor);
+
+    EditJournal *ej = new EditJournal(editor);
+    ej->setEnabled(settings->editJournal());
 }
 
 void EditorManager::purgeOldEditorPointers()
@@ -22,6 +22,7 @@
 
 #include <QObject>
 #include <QPointer>
+#include <QTimer>
 
 
 class ApplicationSettings;
@@ -36,8 +37,23 @@ public:
 
     ScintillaNext *createEditor(const QString &name);
     ScintillaNext *createEditorFromFile(const QString &filePath, bool tryToCreate=false);
+    // Same as createEditorFromFile() but the file is only read once the editor is first shown
+    ScintillaNext *createHibernatedEditorFromFile(const QString &filePath);
+
+    // Size in bytes at which files are opened in large file mode
+    qint64 largeFileSize() const;
+
+    // Size in bytes at which files are opened as a read-only paged view
+    qint64 pagedViewSize() const;
+
+    // Bytes of undo text each document keeps in memory before the oldest is moved to a temporary file
+    qint64 undoMemoryLimit() const;
 
     ScintillaNext *getEditorByFilePath(const QString &filePath);
+    ScintillaNext *getTempEditorByName(const QString &name);
+
+    // Bytes of text and styles currently released by hibernated editors
+    qint64 reclaimedBytes();
 
     void manageEditor(ScintillaNext *editor);
 
@@ -47,12 +63,17 @@ signals:
 
 private:
     void setupEditor(ScintillaNext *editor);
+    void hibernateIdleEditors();
+    void applyLayoutThreads(ScintillaNext *editor);
+    void tuneLayoutThreads();
     void purgeOldEditorPointers();
     QList<QPointer<ScintillaNext>> getEditors();
     int detectEOLMode(ScintillaNext *editor) const;
 
     QList<QPointer<ScintillaNext>> editors;
     ApplicationSettings *settings;
+    QTimer hibernationTimer;
+    QTimer layoutTuningTimer;
 };
 
 #endif // EDITORMANAGER_H
@@ -71,7 +71,7 @@ static void AddCharEscaped(QTextStream &stream, int ch)
 
 void HtmlConverter::convertRange(QTextStream &stream, int start, int end)
 {
-    ensureDocumentStyled(start, end);
+    ensureDocumentStyled(end);
 
     // Create the raw html and keep track of the used styles
     QByteArray html;
@@ -71,7 +71,6 @@ SOURCES += \
     DebugManager.cpp \
     DefaultDirectoryManager.cpp \
     DockedEditor.cpp \
-    EditorHexViewerTableModel.cpp \
     EditorManager.cpp \
     EditorPrintPreviewRenderer.cpp \
     SearchResultHighlighterDelegate.cpp \
@@ -93,6 +92,7 @@ SOURCES += \
     MacroStepTableModel.cpp \
     NotepadNextApplication.cpp \
     NppImporter.cpp \
+    PagedFile.cpp \
     QRegexSearch.cpp \
     widgets/QuickFindWidget.cpp \
     RangeAllocator.cpp \
@@ -105,17 +105,22 @@ SOURCES += \
     SearchResultsCollector.cpp \
     SelectionTracker.cpp \
     SessionManager.cpp \
+    SessionStore.cpp \
     SpinBoxDelegate.cpp \
     TranslationManager.cpp \
+    Transcoder.cpp \
     UndoAction.cpp \
+    Utf8Validator.cpp \
     ZoomEventWatcher.cpp \
     decorators/ApplicationDecorator.cpp \
     decorators/AutoCompletion.cpp \
     decorators/AutoIndentation.cpp \
     decorators/BetterMultiSelection.cpp \
     decorators/BookMarkDecorator.cpp \
+    decorators/EditJournal.cpp \
     decorators/EditorConfigAppDecorator.cpp \
     decorators/HTMLAutoCompleteDecorator.cpp \
+    decorators/PagedView.cpp \
     decorators/SurroundSelection.cpp \
     decorators/URLFinder.cpp \
     dialogs/ColumnEditorDialog.cpp \
@@ -128,6 +133,7 @@ SOURCES += \
     docks/HexViewerDock.cpp \
     docks/LanguageInspectorDock.cpp \
     docks/LuaConsoleDock.cpp \
+    docks/MemoryUsageDock.cpp \
     dialogs/MacroRunDialog.cpp \
     dialogs/MacroSaveDialog.cpp \
     dialogs/MainWindow.cpp \
@@ -140,6 +146,7 @@ SOURCES += \
     decorators/LineNumbers.cpp \
     decorators/SmartHighlighter.cpp \
     widgets/EditorInfoStatusBar.cpp \
+    widgets/HexView.cpp \
     widgets/StatusLabel.cpp
 
 HEADERS += \
@@ -154,7 +161,6 @@ HEADERS += \
     DefaultDirectoryManager.h \
     DockedEditor.h \
     DockedEditorTitleBar.h \
-    EditorHexViewerTableModel.h \
     EditorManager.h \
     EditorPrintPreviewRenderer.h \
     SearchResultData.h \
@@ -179,6 +185,7 @@ HEADERS += \
     MacroStepTableModel.h \
     NotepadNextApplication.h \
     NppImporter.h \
+    PagedFile.h \
     QRegexSearch.h \
     widgets/QuickFindWidget.h \
     RangeAllocator.h \
@@ -192,17 +199,23 @@ HEADERS += \
     SearchResultsCollector.h \
     SelectionTracker.h \
     SessionManager.h \
+    SessionStore.h \
     SpinBoxDelegate.h \
     TranslationManager.h \
+    Transcoder.h \
+    TranscoderTables.h \
     UndoAction.h \
+    Utf8Validator.h \
     ZoomEventWatcher.h \
     decorators/ApplicationDecorator.h \
     decorators/AutoCompletion.h \
     decorators/AutoIndentation.h \
     decorators/BetterMultiSelection.h \
     decorators/BookMarkDecorator.h \
+    decorators/EditJournal.h \
     decorators/EditorConfigAppDecorator.h \
     decorators/HTMLAutoCompleteDecorator.h \
+    decorators/PagedView.h \
     decorators/SurroundSelection.h \
     decorators/URLFinder.h \
     dialogs/ColumnEditorDialog.h \
@@ -215,6 +228,7 @@ HEADERS += \
     docks/HexViewerDock.h \
     docks/LanguageInspectorDock.h \
     docks/LuaConsoleDock.h \
+    docks/MemoryUsageDock.h \
     dialogs/MacroRunDialog.h \
     dialogs/MacroSaveDialog.h \
     dialogs/MainWindow.h \
@@ -226,6 +240,7 @@ HEADERS += \
     decorators/SmartHighlighter.h \
     docks/SearchResultsDock.h \
     widgets/EditorInfoStatusBar.h \
+    widgets/HexView.h \
     widgets/StatusLabel.h
 
 FORMS += \
@@ -241,6 +256,7 @@ FORMS += \
     dialogs/MainWindow.ui \
     dialogs/FindReplaceDialog.ui \
     docks/LuaConsoleDock.ui \
+    docks/MemoryUsageDock.ui \
     dialogs/MacroRunDialog.ui \
     dialogs/MacroSaveDialog.ui \
     dialogs/PreferencesDialog.ui \
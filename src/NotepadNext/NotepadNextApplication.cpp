@@ -25,6 +25,7 @@
 #include "LuaExtension.h"
 #include "DebugManager.h"
 #include "SessionManager.h"
+#include "EditJournal.h"
 #include "TranslationManager.h"
 #include "ApplicationSettings.h"
 
@@ -142,6 +143,11 @@ bool NotepadNextApplication::init()
 
     connect(this, &NotepadNextApplication::aboutToQuit, this, &NotepadNextApplication::saveSettings);
 
+    // Session files are written in the background so make sure they have all landed before exiting
+    connect(this, &NotepadNextApplication::aboutToQuit, this, [=]() {
+        sessionManager->waitForPendingWrites();
+    });
+
     EditorConfigAppDecorator *ecad = new EditorConfigAppDecorator(this);
     ecad->setEnabled(true);
     MarkerAppDecorator *mad = new MarkerAppDecorator(this);
@@ -181,6 +187,13 @@ bool NotepadNextApplication::init()
         }
     });
 
+    // Any journals left behind mean the last instance did not exit cleanly. This has to happen before any
+    // other editors get created since they will start their own journals. It also has to happen before the
+    // session is loaded, which skips the entries for files and buffers that were recovered
+    for (ScintillaNext *editor : EditJournal::recoverEditors()) {
+        editorManager->manageEditor(editor);
+    }
+
     if (settings->restorePreviousSession()) {
         qInfo("Restoring previous session");
 
@@ -297,6 +310,19 @@ QString NotepadNextApplication::detectLanguage(ScintillaNext *editor) const
 
     QString language_name = QStringLiteral("Text");
 
+    // Lexing is too costly for most languages so only those that can handle large files are used
+    if (editor->isLargeFile()) {
+        if (editor->isFile()) {
+            const QString extension_language = detectLanguageFromExtension(editor->getFileInfo().suffix());
+
+            if (languageSupportsLargeFiles(extension_language)) {
+                language_name = extension_language;
+            }
+        }
+
+        return language_name;
+    }
+
     if (editor->isFile()) {
         language_name = detectLanguageFromExtension(editor->getFileInfo().suffix());
     }
@@ -327,6 +353,14 @@ QString NotepadNextApplication::detectLanguageFromExtension(const QString &exten
     )").arg(extension).toLatin1().constData());
 }
 
+bool NotepadNextApplication::languageSupportsLargeFiles(const QString &languageName) const
+{
+    return getLuaState()->executeAndReturn<bool>(QString(R"(
+    local L = languages["%1"]
+    return L ~= nil and L.largeFiles == true
+    )").arg(languageName).toLatin1().constData());
+}
+
 QString NotepadNextApplication::detectLanguageFromContents(ScintillaNext *editor) const
 {
     qInfo(Q_FUNC_INFO);
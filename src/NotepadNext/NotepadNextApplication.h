@@ -63,6 +63,7 @@ public:
     QString detectLanguage(ScintillaNext *editor) const;
     QString detectLanguageFromExtension(const QString &extension) const;
     QString detectLanguageFromContents(ScintillaNext *editor) const;
+    bool languageSupportsLargeFiles(const QString &languageName) const;
 
     void sendInfoToPrimaryInstance();
 
@@ -0,0 +1,220 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "PagedFile.h"
+#include "ByteArrayUtils.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cstring>
+
+
+// Memory for the index is one qint64 per this many lines
+const qint64 LINES_PER_CHECKPOINT = 4096;
+
+// How much is scanned between publishing the results to the other thread
+const qint64 SCAN_BLOCK_SIZE = 64 * 1024 * 1024;
+
+// How far back to look for the start of a line before giving up
+const qint64 MAX_LINE_SCAN = 64 * 1024;
+
+
+static const char *CountNewlines(const char *p, const char *end, qint64 &count, qint64 limit = -1)
+{
+    while (count != limit && (p = static_cast<const char *>(memchr(p, '\n', end - p))) != Q_NULLPTR) {
+        ++p;
+        ++count;
+    }
+
+    return p;
+}
+
+PagedFile::PagedFile(const QString &filePath, QObject *parent)
+    : QObject(parent), file(filePath)
+{
+    scanPool.setMaxThreadCount(1);
+}
+
+PagedFile::~PagedFile()
+{
+    close();
+}
+
+bool PagedFile::open()
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning("Cannot open \"%s\": %s", qUtf8Printable(file.fileName()), qUtf8Printable(file.errorString()));
+        return false;
+    }
+
+    mapSize = file.size();
+    map = mapSize > 0 ? file.map(0, mapSize) : Q_NULLPTR;
+
+    if (map == Q_NULLPTR) {
+        qWarning("Cannot map \"%s\": %s", qUtf8Printable(file.fileName()), qUtf8Printable(file.errorString()));
+        file.close();
+        mapSize = 0;
+        return false;
+    }
+
+    checkpoints = {0};
+    scannedBytes = 0;
+    scannedLines = 0;
+    cancelled.storeRelease(0);
+    indexed.storeRelease(0);
+
+    scanPool.start([=]() { scan(); });
+
+    return true;
+}
+
+void PagedFile::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    cancelled.storeRelease(1);
+    scanPool.waitForDone();
+
+    file.unmap(map);
+    file.close();
+
+    map = Q_NULLPTR;
+    mapSize = 0;
+}
+
+void PagedFile::scan()
+{
+    QVector<qint64> found;
+    qint64 lines = 0;
+    qint64 position = 0;
+
+    while (position < mapSize) {
+        if (cancelled.loadAcquire()) {
+            return;
+        }
+
+        const char *p = data() + position;
+        const char *end = data() + qMin(position + SCAN_BLOCK_SIZE, mapSize);
+
+        // Only stop at the lines that need to be recorded
+        while (p != Q_NULLPTR && p < end) {
+            const qint64 target = (lines / LINES_PER_CHECKPOINT + 1) * LINES_PER_CHECKPOINT;
+
+            p = CountNewlines(p, end, lines, target);
+
+            if (lines == target) {
+                found.append(p - data());
+            }
+        }
+
+        position = end - data();
+
+        {
+            QMutexLocker locker(&mutex);
+            checkpoints += found;
+            scannedBytes = position;
+            scannedLines = lines;
+        }
+        found.clear();
+
+        emit indexProgress(position);
+    }
+
+    indexed.storeRelease(1);
+
+    emit indexFinished();
+}
+
+qint64 PagedFile::lineCount() const
+{
+    QMutexLocker locker(&mutex);
+
+    return scannedLines + 1;
+}
+
+qint64 PagedFile::lineStart(qint64 line) const
+{
+    QMutexLocker locker(&mutex);
+
+    if (line < 0 || line > scannedLines) {
+        return -1;
+    }
+
+    const char *p = data() + checkpoints.at(line / LINES_PER_CHECKPOINT);
+    const char *end = data() + scannedBytes;
+    locker.unlock();
+
+    qint64 count = 0;
+    return CountNewlines(p, end, count, line % LINES_PER_CHECKPOINT) - data();
+}
+
+qint64 PagedFile::lineFromPosition(qint64 position) const
+{
+    QMutexLocker locker(&mutex);
+
+    if (position < 0 || position > scannedBytes) {
+        return -1;
+    }
+
+    const auto checkpoint = std::upper_bound(checkpoints.cbegin(), checkpoints.cend(), position) - 1;
+    qint64 line = (checkpoint - checkpoints.cbegin()) * LINES_PER_CHECKPOINT;
+    const char *p = data() + *checkpoint;
+    locker.unlock();
+
+    CountNewlines(p, data() + position, line);
+    return line;
+}
+
+qint64 PagedFile::alignToLineStart(qint64 position) const
+{
+    position = qBound(Q_INT64_C(0), position, mapSize);
+
+    if (position == 0 || position == mapSize) {
+        return position;
+    }
+
+    const char *p = data() + position;
+    const char *limit = data() + qMax(Q_INT64_C(0), position - MAX_LINE_SCAN);
+
+    for (const char *q = p; q > limit; --q) {
+        if (q[-1] == '\n') {
+            return q - data();
+        }
+    }
+
+    if (limit == data()) {
+        return 0;
+    }
+
+    // Don't split a UTF-8 character
+    while (p > limit && (static_cast<unsigned char>(*p) & 0xC0) == 0x80) {
+        --p;
+    }
+
+    return p - data();
+}
+
+qint64 PagedFile::find(const QByteArray &text, qint64 from, bool forward) const
+{
+    return ByteArrayUtils::find(data(), mapSize, text, from, forward);
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef PAGEDFILE_H
+#define PAGEDFILE_H
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+
+
+// Read-only access to a file through a memory mapping, so none of the file has to be held in memory.
+// A background scan builds a sparse index with the position of every LINES_PER_CHECKPOINT'th line,
+// any other line is found by scanning forward from the nearest checkpoint. Only '\n' ends a line.
+class PagedFile : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PagedFile(const QString &filePath, QObject *parent = Q_NULLPTR);
+    ~PagedFile() override;
+
+    bool open();
+    void close();
+
+    bool isOpen() const { return map != Q_NULLPTR; }
+    bool isIndexed() const { return indexed.loadAcquire() != 0; }
+
+    const char *data() const { return reinterpret_cast<const char *>(map); }
+    qint64 size() const { return mapSize; }
+
+    // These only know about the part of the file that has been scanned so far, and return -1 otherwise
+    qint64 lineCount() const;
+    qint64 lineStart(qint64 line) const;
+    qint64 lineFromPosition(qint64 position) const;
+
+    // Moves position back to the start of its line, or to a character boundary if the line is very long
+    qint64 alignToLineStart(qint64 position) const;
+
+    // Plain byte search directly over the mapping, returns -1 if there is no match
+    qint64 find(const QByteArray &text, qint64 from, bool forward = true) const;
+
+signals:
+    void indexProgress(qint64 bytesScanned);
+    void indexFinished();
+
+private:
+    void scan();
+
+    QFile file;
+    uchar *map = Q_NULLPTR;
+    qint64 mapSize = 0;
+
+    QThreadPool scanPool;
+    QAtomicInt cancelled;
+    QAtomicInt indexed;
+
+    // Guards everything below, which the scan appends to
+    mutable QMutex mutex;
+    QVector<qint64> checkpoints;
+    qint64 scannedBytes = 0;
+    qint64 scannedLines = 0;
+};
+
+#endif // PAGEDFILE_H
@@ -53,7 +53,7 @@ static QColor ScintillaColorToQColor(int color)
 
 void RtfConverter::convertRange(QTextStream &stream, int start, int end)
 {
-    ensureDocumentStyled(start, end);
+    ensureDocumentStyled(end);
 
     QByteArray rtf_body;
     QTextStream rtf_stream(&rtf_body);
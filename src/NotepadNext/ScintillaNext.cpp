@@ -22,34 +22,120 @@
 #include "ScintillaCommenter.h"
 
 #include "ByteArrayUtils.h"
+#include "ILoader.h"
+#include "Transcoder.h"
+#include "Utf8Validator.h"
 #include "uchardet.h"
 #include <cinttypes>
+#include <cmath>
+#include <limits>
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QMouseEvent>
 #include <QSaveFile>
+#include <QTemporaryFile>
 #include <QTextCodec>
 
 
 const int CHUNK_SIZE = 1024 * 1024 * 4; // Not sure what is best
 
 
-static QFileDevice::FileError writeToDisk(const QByteArray &data, const QString &path)
+static QFileDevice::FileError copyOnDisk(const QString &sourcePath, const QString &path)
 {
     qInfo(Q_FUNC_INFO);
 
+    // Copying it onto itself would truncate it
+    if (QFileInfo(sourcePath) == QFileInfo(path)) {
+        return QFileDevice::NoError;
+    }
+
+    QFile source(sourcePath);
     QFile file(path);
 
-    if (file.open(QIODevice::WriteOnly)) {
-        if (file.write(data) != -1) {
+    if (source.open(QIODevice::ReadOnly) && file.open(QIODevice::WriteOnly)) {
+        while (!source.atEnd()) {
+            const QByteArray chunk = source.read(CHUNK_SIZE);
+
+            if (chunk.isEmpty() || file.write(chunk) == -1) {
+                break;
+            }
+        }
+
+        if (source.atEnd()) {
             file.close();
             return QFileDevice::NoError;
         }
     }
 
     // If it got to this point there was an error
-    qWarning("writeToDisk() failure code %d: %s", file.error(), qPrintable(file.errorString()));
-    return file.error();
+    const QFileDevice::FileError error = file.error() != QFileDevice::NoError ? file.error() : source.error();
+    qWarning("copyOnDisk() failure code %d", error);
+    return error;
+}
+
+// Read-only mapping of a file that a piece table document refers to instead of holding a copy of the text.
+// The document releases it once the text is no longer needed, which closes the mapping. Nothing stops another
+// program from changing the file, so the text is copied out with detachMappedFile() before it is saved over.
+class MappedFile : public Scintilla::IMappedText
+{
+public:
+    explicit MappedFile(const QString &filePath) : file(filePath) {}
+
+    bool map()
+    {
+        if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+            return false;
+        }
+
+        mapped = file.map(0, file.size());
+        return mapped != Q_NULLPTR;
+    }
+
+    const char *SCI_METHOD Data() override { return reinterpret_cast<const char *>(mapped); }
+    Sci_Position SCI_METHOD Length() override { return mapped ? file.size() : 0; }
+    void SCI_METHOD Release() override { delete this; }
+
+private:
+    ~MappedFile()
+    {
+        if (mapped) {
+            file.unmap(mapped);
+        }
+    }
+
+    QFile file;
+    uchar *mapped = Q_NULLPTR;
+};
+
+static QByteArray readSpillFile(const QString &path)
+{
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning("Failed to open spill file \"%s\": %s", qUtf8Printable(path), qUtf8Printable(file.errorString()));
+        return QByteArray();
+    }
+
+    return qUncompress(file.readAll());
+}
+
+// Removes the last few bytes of the document and returns them
+static QByteArray takeTrailingBytes(ScintillaEdit *editor, int count)
+{
+    const Sci_Position end = editor->length();
+    QByteArray bytes(count + 1, Qt::Uninitialized);
+
+    Sci_TextRangeFull range;
+    range.chrg.cpMin = end - count;
+    range.chrg.cpMax = end;
+    range.lpstrText = bytes.data();
+    editor->send(SCI_GETTEXTRANGEFULL, 0, reinterpret_cast<sptr_t>(&range));
+
+    bytes.chop(1);
+    editor->deleteRange(end - count, count);
+
+    return bytes;
 }
 
 static bool isNewlineCharacter(char c)
@@ -66,13 +152,27 @@ ScintillaNext::ScintillaNext(QString name, QWidget *parent) :
     indicatorResources.disableRange(0, 7);
     indicatorResources.disableRange(INDICATOR_IME, INDICATOR_IME_MAX);
     indicatorResources.disableRange(INDICATOR_HISTORY_REVERTED_TO_ORIGIN_INSERTION, INDICATOR_HISTORY_REVERTED_TO_MODIFIED_DELETION);
+
+    connect(this, &ScintillaNext::notify, this, [=](Scintilla::NotificationData *pscn) {
+        if (pscn->nmhdr.code == Scintilla::Notification::Modified) {
+            if (FlagSet(pscn->modificationType, Scintilla::ModificationFlags::InsertText | Scintilla::ModificationFlags::DeleteText)) {
+                ++modificationCount;
+            }
+        }
+    });
+
+    // Editors that are never shown count as idle from the moment they are created
+    hiddenTimer.start();
 }
 
 ScintillaNext::~ScintillaNext()
 {
+    if (hibernation && !hibernation->spillFilePath.isEmpty()) {
+        QFile::remove(hibernation->spillFilePath);
+    }
 }
 
-ScintillaNext *ScintillaNext::fromFile(const QString &filePath, bool tryToCreate)
+ScintillaNext *ScintillaNext::fromFile(const QString &filePath, bool tryToCreate, qint64 largeFileSize)
 {
     QFile file(filePath);
     ScintillaNext *editor = new ScintillaNext(file.fileName());
@@ -87,6 +187,12 @@ ScintillaNext *ScintillaNext::fromFile(const QString &filePath, bool tryToCreate
         f.close();
     }
 
+    // This has to be decided before any text is loaded since the document gets replaced
+    if (largeFileSize > 0 && file.size() >= largeFileSize) {
+        qInfo("\"%s\" is %lld bytes, using large file mode", qUtf8Printable(filePath), file.size());
+        editor->enableLargeFileMode();
+    }
+
     bool readSuccessful = editor->readFromDisk(file);
 
     if (!readSuccessful) {
@@ -99,6 +205,42 @@ ScintillaNext *ScintillaNext::fromFile(const QString &filePath, bool tryToCreate
     return editor;
 }
 
+ScintillaNext *ScintillaNext::pagedFromFile(const QString &filePath)
+{
+    ScintillaNext *editor = new ScintillaNext(QFileInfo(filePath).fileName());
+
+    editor->enableLargeFileMode();
+    editor->setFileInfo(filePath);
+    editor->setReadOnly(true);
+    editor->pagedView = true;
+
+    return editor;
+}
+
+ScintillaNext *ScintillaNext::hibernatedFromFile(const QString &filePath, qint64 largeFileSize)
+{
+    ScintillaNext *editor = new ScintillaNext(QFileInfo(filePath).fileName());
+
+    editor->setFileInfo(filePath);
+
+    // This has to be decided before any text is loaded since the document gets replaced
+    if (largeFileSize > 0 && editor->fileInfo.size() >= largeFileSize) {
+        qInfo("\"%s\" is %lld bytes, using large file mode", qUtf8Printable(filePath), editor->fileInfo.size());
+        editor->enableLargeFileMode();
+    }
+
+    // The size on disk stands in for the length until it is read, the encoding may change it
+    QScopedPointer<HibernationState> state(new HibernationState);
+    state->length = editor->fileInfo.size();
+    state->fileSize = editor->fileInfo.size();
+    state->fileTimestamp = editor->modifiedTime;
+
+    editor->setReadOnly(true);
+    editor->hibernation.reset(state.take());
+
+    return editor;
+}
+
 QString ScintillaNext::eolModeToString(int eolMode)
 {
     if (eolMode == SC_EOL_CRLF)
@@ -128,6 +270,27 @@ int ScintillaNext::allocateIndicator(const QString &name)
     return indicatorResources.requestResource(name);
 }
 
+QByteArray ScintillaNext::textCopy(Sci_Position start, Sci_Position end) const
+{
+    // The range and its terminating NUL have to fit in a QByteArray, larger ranges should use forEachTextChunk()
+    if (end < start || end - start >= std::numeric_limits<int>::max()) {
+        qWarning("textCopy() cannot copy %lld bytes", static_cast<long long>(end - start));
+        return QByteArray();
+    }
+
+    QByteArray text(static_cast<int>(end - start) + 1, Qt::Uninitialized);
+
+    Sci_TextRangeFull range;
+    range.chrg.cpMin = start;
+    range.chrg.cpMax = end;
+    range.lpstrText = text.data();
+    send(SCI_GETTEXTRANGEFULL, 0, reinterpret_cast<sptr_t>(&range));
+
+    text.chop(1);
+
+    return text;
+}
+
 void ScintillaNext::goToRange(const Sci_CharacterRange &range)
 {
     qInfo(Q_FUNC_INFO);
@@ -174,22 +337,8 @@ void ScintillaNext::cutAllowLine()
 
 void ScintillaNext::modifyFoldLevels(int level, int action)
 {
-    const int totalLines = lineCount();
-
-    int line = 0;
-    while (line < totalLines) {
-        int foldFlags = foldLevel(line); // Even though its called fold level it contains several other flags
-        bool isHeader = foldFlags & SC_FOLDLEVELHEADERFLAG;
-        int actualLevel = (foldFlags & SC_FOLDLEVELNUMBERMASK) - SC_FOLDLEVELBASE;
-
-        if (isHeader && actualLevel == level) {
-            foldLine(line, action);
-            line = lastChild(line, -1) + 1;
-        }
-        else {
-            ++line;
-        }
-    }
+    // Scintilla finds all the headers of the level and updates the display once
+    foldAllAtLevel(SC_FOLDLEVELBASE + level, action);
 }
 
 void ScintillaNext::foldAllLevels(int level)
@@ -300,15 +449,342 @@ void ScintillaNext::close()
     deleteLater();
 }
 
+bool ScintillaNext::hibernate()
+{
+    qInfo(Q_FUNC_INFO);
+
+    // A paged view already only holds a small piece of the file
+    if (hibernation || pagedView || length() == 0) {
+        return false;
+    }
+
+    QScopedPointer<HibernationState> state(new HibernationState);
+    state->length = length();
+    state->modified = modify();
+    state->firstVisibleLine = firstVisibleLine();
+    state->currentPos = currentPos();
+    state->anchor = anchor();
+
+    state->readOnly = readOnly();
+
+    // Folding markers get recreated by the lexer, everything else is gone once the text is
+    const int markerMask = ~SC_MASK_FOLDERS;
+    for (sptr_t line = markerNext(0, markerMask); line != -1; line = markerNext(line + 1, markerMask)) {
+        state->markers.insert(static_cast<int>(line), static_cast<int>(markerGet(line)) & markerMask);
+    }
+
+    // The fold levels come back from the lexer but which folds were contracted does not
+    for (sptr_t line = contractedFoldNext(0); line != -1; line = contractedFoldNext(line + 1)) {
+        state->contractedFolds.append(static_cast<int>(line));
+    }
+
+    // This covers the lines inside contracted folds as well as ones that were hidden directly
+    if (!allLinesVisible()) {
+        const int lines = static_cast<int>(lineCount());
+
+        for (int line = 0; line < lines; ++line) {
+            if (!lineVisible(line)) {
+                const int first = line;
+
+                while (line + 1 < lines && !lineVisible(line + 1)) {
+                    ++line;
+                }
+
+                state->hiddenLines.append(qMakePair(first, line));
+            }
+        }
+    }
+
+    // If the file on disk is exactly what is in the editor it can be read back in later, anything else gets spilled
+    const bool canReadFromDisk = bufferType == BufferType::File && !temporary && !state->modified && modifiedTime == fileTimestamp();
+
+    if (canReadFromDisk) {
+        // fileTimestamp() has just refreshed the file info
+        state->fileSize = fileInfo.size();
+        state->fileTimestamp = modifiedTime;
+    }
+
+    if (!canReadFromDisk) {
+        if (state->length > std::numeric_limits<int>::max()) {
+            qInfo("\"%s\" is too large to spill", qUtf8Printable(name));
+            return false;
+        }
+
+        QTemporaryFile spill(QDir::temp().filePath(QStringLiteral("NotepadNext-XXXXXX.spill")));
+        spill.setAutoRemove(false);
+
+        const QByteArray data = qCompress(textCopy());
+
+        if (!spill.open() || spill.write(data) != data.size()) {
+            qWarning("Failed to spill \"%s\": %s", qUtf8Printable(name), qUtf8Printable(spill.errorString()));
+            spill.remove();
+            return false;
+        }
+
+        state->spillFilePath = spill.fileName();
+    }
+
+    {
+        const QSignalBlocker blocker(this);
+
+        setReadOnly(false);
+        setUndoCollection(false);
+        clearAll();
+        emptyUndoBuffer();
+        setUndoCollection(true);
+
+        // Nothing refers to the mapping once the document is empty so this only closes it
+        detachMappedFile();
+
+        // Nothing typed into the empty document could be kept once the text comes back
+        setReadOnly(true);
+
+        // The save point has to stay unreachable so a modified buffer doesn't look saved
+        if (state->modified) {
+            setUndoSavePoint(-1);
+        }
+    }
+
+    qInfo("Hibernated \"%s\", %lld bytes %s", qUtf8Printable(name), state->length, canReadFromDisk ? "can be read from disk" : "spilled");
+
+    hibernation.reset(state.take());
+
+    emit hibernated();
+
+    return true;
+}
+
+void ScintillaNext::hibernateWithLoader(qint64 length, const std::function<QByteArray()> &loader)
+{
+    Q_ASSERT(!hibernation && this->length() == 0);
+
+    QScopedPointer<HibernationState> state(new HibernationState);
+    state->length = length;
+    state->readOnly = readOnly();
+    state->loader = loader;
+
+    setReadOnly(true);
+    hibernation.reset(state.take());
+}
+
+bool ScintillaNext::wake()
+{
+    if (!hibernation) {
+        return true;
+    }
+
+    qInfo(Q_FUNC_INFO);
+
+    QScopedPointer<HibernationState> state(hibernation.take());
+
+    if (state->readsFromFile()) {
+        // Reading the file back in is only the same text if the file is still what was hibernated. If it
+        // isn't, stay hibernating so the change gets reported and the user decides whether to reload
+        const QDateTime timestamp = fileTimestamp();
+
+        if (!fileInfo.exists() || fileInfo.size() != state->fileSize || timestamp != state->fileTimestamp) {
+            qWarning("\"%s\" changed on disk while hibernating", qUtf8Printable(fileInfo.filePath()));
+            hibernation.reset(state.take());
+            return false;
+        }
+
+        QFile f(fileInfo.canonicalFilePath());
+
+        setReadOnly(false);
+
+        if (!readFromDisk(f)) {
+            qWarning("Failed to read \"%s\" back in", qUtf8Printable(f.fileName()));
+
+            // Don't leave part of the file behind looking like the whole thing
+            {
+                const QSignalBlocker blocker(this);
+                setUndoCollection(false);
+                clearAll();
+                emptyUndoBuffer();
+                setUndoCollection(true);
+                setReadOnly(true);
+            }
+
+            hibernation.reset(state.take());
+            return false;
+        }
+
+        setSavePoint();
+
+        // The file itself may have turned read-only since it was hibernated
+        setReadOnly(state->readOnly || readOnly());
+    }
+    else {
+        const QByteArray text = state->loader ? state->loader() : readSpillFile(state->spillFilePath);
+
+        // Rather than lose the text, stay hibernating and hope it can be read later
+        if (text.size() != state->length) {
+            qWarning("Hibernated text of \"%s\" is not valid", qUtf8Printable(name));
+            hibernation.reset(state.take());
+            return false;
+        }
+
+        {
+            const QSignalBlocker blocker(this);
+            setReadOnly(false);
+            setUndoCollection(false);
+            appendText(text.size(), text.constData());
+            setUndoCollection(true);
+            setReadOnly(state->readOnly);
+        }
+
+        if (!state->spillFilePath.isEmpty()) {
+            QFile::remove(state->spillFilePath);
+        }
+    }
+
+    for (auto it = state->markers.constBegin(); it != state->markers.constEnd(); ++it) {
+        markerAddSet(it.key(), it.value());
+    }
+
+    if (!state->contractedFolds.isEmpty()) {
+        // A line becoming a fold header gets expanded, so the lexer has to be past them first
+        colourise(0, lineEndPosition(state->contractedFolds.last() + 1));
+
+        for (const int line : qAsConst(state->contractedFolds)) {
+            setFoldExpanded(line, false);
+        }
+    }
+
+    for (const auto &range : qAsConst(state->hiddenLines)) {
+        hideLines(range.first, range.second);
+    }
+
+    setSelection(state->currentPos, state->anchor);
+    setFirstVisibleLine(state->firstVisibleLine);
+
+    emit woken();
+
+    return true;
+}
+
+QByteArray ScintillaNext::hibernatedText() const
+{
+    if (!hibernation || hibernation->readsFromFile()) {
+        return QByteArray();
+    }
+
+    return hibernation->loader ? hibernation->loader() : readSpillFile(hibernation->spillFilePath);
+}
+
+qint64 ScintillaNext::idleTime() const
+{
+    if (isVisible() || !hiddenTimer.isValid()) {
+        return 0;
+    }
+
+    return hiddenTimer.elapsed();
+}
+
+qint64 ScintillaNext::totalMemoryUsage() const
+{
+    qint64 total = 0;
+
+    for (int category = SC_MEMORY_TEXT; category <= SC_MEMORY_POSITION_CACHE; ++category) {
+        total += memoryUsage(category);
+    }
+
+    return total;
+}
+
+void ScintillaNext::dropViewCaches()
+{
+    // Hidden editors have already given theirs up
+    if (viewCachesReleased) {
+        return;
+    }
+
+    const int layout = layoutCache();
+
+    setLayoutCache(SC_CACHE_NONE);
+    setLayoutCache(layout);
+
+    // Setting the size empties it even when it doesn't change
+    setPositionCache(positionCache());
+}
+
+void ScintillaNext::clearUndoHistory()
+{
+    const bool wasModified = modify();
+
+    emptyUndoBuffer();
+
+    // The save point has to stay unreachable so a modified buffer doesn't look saved
+    if (wasModified) {
+        setUndoSavePoint(-1);
+    }
+}
+
+void ScintillaNext::resetLayoutThreads(int maximum)
+{
+    layoutThreadsLimit = qMax(1, maximum);
+    tunedWrapDuration = wrapDuration(false);
+    tunedWrapElapsed = wrapDuration(true);
+
+    setLayoutThreads(layoutThreadsLimit);
+}
+
+void ScintillaNext::tuneLayoutThreads()
+{
+    const sptr_t duration = wrapDuration(false);
+    const sptr_t elapsed = wrapDuration(true);
+
+    // The averages only change when something has been wrapped
+    if (elapsed <= 0 || (duration == tunedWrapDuration && elapsed == tunedWrapElapsed)) {
+        return;
+    }
+
+    tunedWrapDuration = duration;
+    tunedWrapElapsed = elapsed;
+
+    // Wrapping that does not run in parallel, e.g. when the platform can't measure text
+    // on other threads, takes as long as it would on a single thread
+    const int threads = static_cast<int>(layoutThreads());
+    const double speedup = static_cast<double>(duration) / elapsed;
+    int wanted = threads;
+
+    if (speedup < threads * 0.5) {
+        // Most of the threads are only waiting, keep enough for the speedup being seen and
+        // don't try going past that again
+        wanted = qBound(1, static_cast<int>(std::ceil(speedup)), threads);
+        layoutThreadsLimit = wanted;
+    }
+    else if (speedup >= threads * 0.75) {
+        // Nearly linear so more threads should still help
+        wanted = qMin(threads * 2, layoutThreadsLimit);
+    }
+
+    if (wanted != threads) {
+        qInfo("\"%s\" wraps in %lld ns/KB, %lld ns/KB on all threads, using %d layout threads instead of %d",
+              qUtf8Printable(name), static_cast<long long>(elapsed), static_cast<long long>(duration), wanted, threads);
+
+        setLayoutThreads(wanted);
+    }
+}
+
 QFileDevice::FileError ScintillaNext::save()
 {
     qInfo(Q_FUNC_INFO);
 
     Q_ASSERT(isFile());
 
+    // A paged view can't be modified, and writing it out would truncate the file to the window
+    if (pagedView) {
+        return QFileDevice::NoError;
+    }
+
+    if (!wake()) {
+        return QFileDevice::ReadError;
+    }
+
     emit aboutToSave();
 
-    QFileDevice::FileError writeSuccessful = writeToDisk(QByteArray::fromRawData((char*)characterPointer(), textLength()), fileInfo.filePath());
+    QFileDevice::FileError writeSuccessful = writeTextToDisk(fileInfo.filePath());
 
     if (writeSuccessful == QFileDevice::NoError) {
         updateTimestamp();
@@ -332,6 +808,25 @@ void ScintillaNext::reload()
         return;
     }
 
+    // The paged view reads the file itself
+    if (pagedView) {
+        updateTimestamp();
+        setTemporary(false);
+
+        emit reloaded();
+        return;
+    }
+
+    // The text is about to be replaced anyway
+    if (hibernation) {
+        if (!hibernation->spillFilePath.isEmpty()) {
+            QFile::remove(hibernation->spillFilePath);
+        }
+
+        setReadOnly(hibernation->readOnly);
+        hibernation.reset();
+    }
+
     // Remove all the text
     {
         const QSignalBlocker blocker(this);
@@ -361,6 +856,11 @@ void ScintillaNext::reload()
 
 void ScintillaNext::omitModifications()
 {
+    // There is no text loaded to keep instead, so the change stays reported until the file is reloaded
+    if (hibernation && hibernation->readsFromFile()) {
+        return;
+    }
+
     // If file modifications will be omitted just update file timestamp
     // so pop-up will be displayed only once per file modifications.
     updateTimestamp();
@@ -373,9 +873,14 @@ QFileDevice::FileError ScintillaNext::saveAs(const QString &newFilePath)
 {
     bool isRenamed = bufferType == ScintillaNext::New || fileInfo.canonicalFilePath() != newFilePath;
 
+    if (!wake()) {
+        return QFileDevice::ReadError;
+    }
+
     emit aboutToSave();
 
-    QFileDevice::FileError saveSuccessful = writeToDisk(QByteArray::fromRawData((char*)characterPointer(), textLength()), newFilePath);
+    // A paged view only has part of the file loaded
+    QFileDevice::FileError saveSuccessful = pagedView ? copyOnDisk(fileInfo.filePath(), newFilePath) : writeTextToDisk(newFilePath);
 
     if (saveSuccessful == QFileDevice::NoError) {
         setFileInfo(newFilePath);
@@ -396,7 +901,15 @@ QFileDevice::FileError ScintillaNext::saveAs(const QString &newFilePath)
 
 QFileDevice::FileError ScintillaNext::saveCopyAs(const QString &filePath)
 {
-    return writeToDisk(QByteArray::fromRawData((char*)characterPointer(), textLength()), filePath);
+    if (pagedView) {
+        return copyOnDisk(fileInfo.filePath(), filePath);
+    }
+
+    if (!wake()) {
+        return QFileDevice::ReadError;
+    }
+
+    return writeTextToDisk(filePath);
 }
 
 bool ScintillaNext::rename(const QString &newFilePath)
@@ -559,6 +1072,69 @@ void ScintillaNext::dropEvent(QDropEvent *event)
     ScintillaEdit::dropEvent(event);
 }
 
+void ScintillaNext::showEvent(QShowEvent *event)
+{
+    // Make sure there is something to show
+    wake();
+
+    hiddenTimer.invalidate();
+    restoreViewCaches();
+
+    ScintillaEdit::showEvent(event);
+}
+
+void ScintillaNext::hideEvent(QHideEvent *event)
+{
+    // Minimizing the window doesn't make the editor idle
+    if (!event->spontaneous()) {
+        hiddenTimer.start();
+        releaseViewCaches();
+    }
+
+    ScintillaEdit::hideEvent(event);
+}
+
+void ScintillaNext::releaseViewCaches()
+{
+    if (viewCachesReleased) {
+        return;
+    }
+
+    // Text measurements are only needed to draw the editor. With lots of tabs open, the caches of all
+    // the hidden ones add up to far more than the visible ones ever use.
+    savedLayoutCache = layoutCache();
+    savedPositionCache = positionCache();
+
+    setLayoutCache(SC_CACHE_NONE);
+    setPositionCache(0);
+
+    viewCachesReleased = true;
+}
+
+void ScintillaNext::restoreViewCaches()
+{
+    if (!viewCachesReleased) {
+        return;
+    }
+
+    setLayoutCache(savedLayoutCache);
+    setPositionCache(savedPositionCache);
+
+    viewCachesReleased = false;
+}
+
+void ScintillaNext::enableLargeFileMode()
+{
+    // Storing styles as runs instead of a byte for every byte of text keeps them small for
+    // languages that can lex large files, and a piece table lets the text refer to a mapping
+    // of the file instead of copying it
+    const sptr_t doc = createDocument(0, SC_DOCUMENTOPTION_STYLES_RUNS | SC_DOCUMENTOPTION_TEXT_LARGE | SC_DOCUMENTOPTION_PIECE_TABLE);
+    setDocPointer(doc);
+    releaseDocument(doc); // The editor holds its own reference
+
+    largeFile = true;
+}
+
 bool ScintillaNext::readFromDisk(QFile &file)
 {
     if (!file.exists()) {
@@ -571,6 +1147,26 @@ bool ScintillaNext::readFromDisk(QFile &file)
         return false;
     }
 
+    // Assume it is UTF-8 unless detected otherwise
+    encoding.clear();
+
+    // Any earlier mapping would otherwise be kept if the file is read instead of mapped this time
+    detachMappedFile();
+
+    if (readMappedFromDisk(file)) {
+        file.close();
+
+        // Signals were blocked so the text changes were not counted
+        ++modificationCount;
+
+        if (!QFileInfo(file).isWritable()) {
+            qInfo("Setting file as read-only");
+            setReadOnly(true);
+        }
+
+        return true;
+    }
+
     // TODO: figure out what to do if "size" is too big
     allocate(file.size());
 
@@ -584,13 +1180,28 @@ bool ScintillaNext::readFromDisk(QFile &file)
     qint64 bytesRead;
     QTextCodec *codec = Q_NULLPTR;
     QTextCodec::ConverterState state;
+    Transcoder transcoder;
+
+    // Most files are UTF-8 (or plain ASCII) which can go straight into the buffer without any conversion
+    Utf8Validator validator;
+    bool isUtf8 = false;
+
+    // Keep track of where the time goes
+    QElapsedTimer phaseTimer;
+    qint64 readTime = 0;
+    qint64 detectTime = 0;
+    qint64 decodeTime = 0;
+    qint64 insertTime = 0;
 
     bool first_read = true;
+    bool linesAllocated = false;
     do {
         // Try to read as much as possible
+        phaseTimer.start();
         chunk.resize(CHUNK_SIZE);
         bytesRead = file.read(chunk.data(), CHUNK_SIZE);
         chunk.resize(bytesRead);
+        readTime += phaseTimer.nsecsElapsed();
 
         qDebug("Read %lld bytes", bytesRead);
 
@@ -600,6 +1211,11 @@ bool ScintillaNext::readFromDisk(QFile &file)
         // - determine space vs tabs
         // - determine indentation size
 
+        phaseTimer.start();
+
+        // The start of a sequence that the previous chunk ended partway through, it was appended as is
+        const int pendingBytes = validator.pendingBytes();
+
         if (first_read) {
             first_read = false;
 
@@ -609,6 +1225,10 @@ bool ScintillaNext::readFromDisk(QFile &file)
             if (codec != Q_NULLPTR) {
                 qDebug("BOM mark found");
             }
+            else if (validator.validate(chunk.constData(), chunk.size())) {
+                qDebug("BOM mark not found, first %lld bytes are valid %s", bytesRead, validator.isAscii() ? "ASCII" : "UTF-8");
+                isUtf8 = true;
+            }
             else {
                 qDebug("BOM mark not found, using uchardet");
 
@@ -629,20 +1249,87 @@ bool ScintillaNext::readFromDisk(QFile &file)
                 uchardet_delete(encodingDetector);
             }
 
-            qDebug("Using codec: '%s'", codec ? codec->name().constData() : "");
+            // Encodings the transcoder can handle are converted directly to UTF-8 instead of via QString
+            if (codec) {
+                transcoder = Transcoder(codec->name());
+                encoding = transcoder.name();
+            }
+
+            qDebug("Using codec: '%s'", isUtf8 ? "UTF-8 (no conversion)" : transcoder.isValid() ? "transcoder" : codec ? codec->name().constData() : "");
+        }
+        else if (isUtf8 && !validator.validate(chunk.constData(), chunk.size())) {
+            // The sample looked like UTF-8 but something later on does not. Fall back to converting the rest of
+            // the file, which replaces the invalid bytes the same way as if it had been detected up front.
+            qWarning("Invalid UTF-8 found after the first %lld bytes, converting the remainder", file.pos() - bytesRead);
+            isUtf8 = false;
+            codec = QTextCodec::codecForName("UTF-8");
+
+            // The codec has to see all of a sequence split between the chunks
+            if (pendingBytes > 0) {
+                chunk.prepend(takeTrailingBytes(this, pendingBytes));
+            }
         }
 
-        if (codec) {
+        detectTime += phaseTimer.nsecsElapsed();
+
+        if (transcoder.isValid()) {
+            phaseTimer.start();
+            QByteArray utf8_data = transcoder.toUtf8(chunk.constData(), chunk.size());
+            if (file.atEnd()) {
+                utf8_data += transcoder.finish();
+            }
+            decodeTime += phaseTimer.nsecsElapsed();
+
+            phaseTimer.start();
+            appendText(utf8_data.size(), utf8_data.constData());
+            insertTime += phaseTimer.nsecsElapsed();
+        }
+        else if (codec && !isUtf8) {
+            phaseTimer.start();
             const QByteArray utf8_data = codec->toUnicode(chunk.constData(), chunk.size(), &state).toUtf8();
+            decodeTime += phaseTimer.nsecsElapsed();
+
+            phaseTimer.start();
             appendText(utf8_data.size(), utf8_data.constData());
+            insertTime += phaseTimer.nsecsElapsed();
         }
         else {
+            phaseTimer.start();
             appendText(chunk.size(), chunk.constData());
+            insertTime += phaseTimer.nsecsElapsed();
+        }
+
+        // The first chunk is a good sample of how many lines the whole file has. Allocating the line starts
+        // for all of them now saves growing them over and over on files with millions of short lines.
+        if (!linesAllocated) {
+            linesAllocated = true;
+
+            if (!file.atEnd() && file.pos() > 0) {
+                allocateLines(lineCount() * file.size() / file.pos());
+            }
         }
     } while (!file.atEnd() && status() == SC_STATUS_OK);
 
+    // A file that ends partway through a sequence gets the same replacement characters as it would
+    // have if it had been converted. The codec silently holds on to the bytes so they need adding.
+    if (isUtf8 && validator.isIncomplete()) {
+        const QByteArray tail = takeTrailingBytes(this, validator.pendingBytes());
+        const QByteArray utf8_data = QTextCodec::codecForName("UTF-8")->toUnicode(tail).toUtf8();
+
+        appendText(utf8_data.size(), utf8_data.constData());
+    }
+    else if (codec && !isUtf8 && !transcoder.isValid() && state.remainingChars > 0) {
+        appendText(3, "\xEF\xBF\xBD");
+    }
+
+    qInfo("Loaded \"%s\": read %.1f ms, detect %.1f ms, decode %.1f ms, insert %.1f ms", qUtf8Printable(file.fileName()),
+          readTime / 1e6, detectTime / 1e6, decodeTime / 1e6, insertTime / 1e6);
+
     file.close();
 
+    // Signals were blocked so the text changes were not counted
+    ++modificationCount;
+
     // Restore it back
     this->blockSignals(false);
     setUndoCollection(true);
@@ -666,6 +1353,142 @@ bool ScintillaNext::readFromDisk(QFile &file)
     return true;
 }
 
+bool ScintillaNext::readMappedFromDisk(QFile &file)
+{
+    if (!(documentOptions() & SC_DOCUMENTOPTION_PIECE_TABLE) || length() != 0) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // The file could be changed while it is being validated, so it is only kept mapped if it looks the same afterwards
+    const QFileInfo before(file);
+    const qint64 sizeBefore = before.size();
+    const QDateTime modifiedBefore = before.lastModified();
+
+    MappedFile *mapped = new MappedFile(file.fileName());
+
+    if (!mapped->map()) {
+        mapped->Release();
+        return false;
+    }
+
+    // Only text that needs no conversion can be referred to directly, anything else is read a chunk at a time.
+    // Validating touches every page of the file but nothing is copied.
+    const QByteArray start = QByteArray::fromRawData(mapped->Data(), static_cast<int>(qMin<Sci_Position>(mapped->Length(), 4)));
+    Utf8Validator validator;
+
+    if (QTextCodec::codecForUtfText(start, Q_NULLPTR) != Q_NULLPTR
+            || !validator.validate(mapped->Data(), mapped->Length()) || validator.isIncomplete()) {
+        qInfo("\"%s\" is not plain UTF-8, reading it instead of mapping it", qUtf8Printable(file.fileName()));
+        mapped->Release();
+        return false;
+    }
+
+    const QFileInfo after(file);
+    if (after.size() != sizeBefore || after.size() != mapped->Length() || after.lastModified() != modifiedBefore) {
+        qInfo("\"%s\" changed while it was mapped, reading it instead", qUtf8Printable(file.fileName()));
+        mapped->Release();
+        return false;
+    }
+
+    // The document takes ownership of the mapping, even if it ends up copying the text
+    setUndoCollection(false);
+    blockSignals(true);
+    setMappedText(reinterpret_cast<sptr_t>(mapped));
+    blockSignals(false);
+    setUndoCollection(true);
+
+    if (status() != SC_STATUS_OK) {
+        qWarning("something bad happened in setMappedText() %ld", status());
+        return false;
+    }
+
+    mappedFilePath = after.canonicalFilePath();
+
+    qInfo("Mapped \"%s\" in %.1f ms", qUtf8Printable(file.fileName()), timer.nsecsElapsed() / 1e6);
+
+    return true;
+}
+
+void ScintillaNext::detachMappedFile()
+{
+    if (mappedFilePath.isEmpty()) {
+        return;
+    }
+
+    if (detachMappedText()) {
+        qInfo("Copied the text of \"%s\" out of its mapping", qUtf8Printable(mappedFilePath));
+    }
+
+    mappedFilePath.clear();
+}
+
+QFileDevice::FileError ScintillaNext::writeTextToDisk(const QString &path)
+{
+    // The mapping would keep the file from being replaced on some platforms
+    if (!mappedFilePath.isEmpty() && QFileInfo(path).canonicalFilePath() == mappedFilePath) {
+        detachMappedFile();
+    }
+
+    qInfo(Q_FUNC_INFO);
+
+    // Write the text out a chunk at a time rather than joining it all into one copy with characterPointer().
+    // Other encodings are converted a chunk at a time too
+    QSaveFile file(path);
+
+    if (file.open(QIODevice::WriteOnly)) {
+        bool written = false;
+        qsizetype unmappable = 0;
+
+        if (encoding.isEmpty()) {
+            written = forEachTextChunk([&file](const char *data, Sci_Position length) {
+                return file.write(data, length) == length;
+            });
+        }
+        else {
+            const Transcoder transcoder(encoding);
+            bool first = true;
+            QByteArray carried; // Start of a character that was split between chunks
+
+            auto writeEncoded = [&](const QByteArray &utf8) {
+                const QByteArray data = transcoder.fromUtf8(utf8.constData(), utf8.size(), &unmappable, first);
+                first = false;
+
+                // Rather than lose data it gets saved as UTF-8 instead
+                return unmappable == 0 && file.write(data) == data.size();
+            };
+
+            written = forEachTextChunk([&](const char *data, Sci_Position length) {
+                QByteArray utf8 = carried;
+                utf8.append(data, length);
+
+                const qsizetype complete = Utf8Validator::completeLength(utf8.constData(), utf8.size());
+                carried = utf8.mid(complete);
+                utf8.truncate(complete);
+
+                return writeEncoded(utf8);
+            }) && (carried.isEmpty() || writeEncoded(carried));
+        }
+
+        if (unmappable > 0) {
+            qWarning("%lld characters cannot be represented in %s, saving as UTF-8", static_cast<long long>(unmappable), encoding.constData());
+            file.cancelWriting();
+            encoding.clear();
+            return writeTextToDisk(path);
+        }
+
+        if (written && file.commit()) {
+            return QFileDevice::NoError;
+        }
+    }
+
+    // If it got to this point there was an error
+    qWarning("writeTextToDisk() failure code %d: %s", file.error(), qPrintable(file.errorString()));
+    return file.error() != QFileDevice::NoError ? file.error() : QFileDevice::WriteError;
+}
+
 QDateTime ScintillaNext::fileTimestamp()
 {
     Q_ASSERT(bufferType != ScintillaNext::New);
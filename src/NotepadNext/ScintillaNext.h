@@ -24,8 +24,14 @@
 #include "ScintillaEdit.h"
 
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QMap>
+#include <QScopedPointer>
+#include <QVector>
+
+#include <functional>
 
 
 
@@ -43,7 +49,12 @@ public:
     explicit ScintillaNext(QString name, QWidget *parent = Q_NULLPTR);
     virtual ~ScintillaNext();
 
-    static ScintillaNext *fromFile(const QString &filePath, bool tryToCreate=false);
+    // Files of at least largeFileSize bytes are opened in large file mode, a value of 0 disables it
+    static ScintillaNext *fromFile(const QString &filePath, bool tryToCreate=false, qint64 largeFileSize=0);
+    // Creates a read-only editor without any text, a PagedView loads it a piece at a time
+    static ScintillaNext *pagedFromFile(const QString &filePath);
+    // Creates a hibernating editor, the file is only read once the editor is woken up
+    static ScintillaNext *hibernatedFromFile(const QString &filePath, qint64 largeFileSize=0);
     static QString eolModeToString(int eolMode);
     static int stringToEolMode(QString eolMode);
 
@@ -63,6 +74,16 @@ public:
 
     void goToRange(const Sci_CharacterRange &range);
 
+    // Copies of the text that, unlike characterPointer(), don't need the document to join it into one piece first.
+    // Ranges too large for a QByteArray give an empty copy
+    QByteArray textCopy() const { return textCopy(0, textLength()); }
+    QByteArray textCopy(Sci_Position start, Sci_Position end) const;
+
+    // Calls callback(const char *data, Sci_Position length) with the text a chunk at a time. Stops early,
+    // returning false, if the callback returns false
+    template<typename Func>
+    bool forEachTextChunk(Func callback) const;
+
     QByteArray eolString() const;
 
     bool lineIsEmpty(int line);
@@ -108,10 +129,59 @@ public:
     };
 
     bool isTemporary() const { return temporary; }
+    bool isLargeFile() const { return largeFile; }
+    bool isPagedView() const { return pagedView; }
     void setTemporary(bool temp);
 
     void setFoldMarkers(const QString &type);
 
+    // What is kept while the editor is hibernating, the document itself is empty
+    struct HibernationState {
+        qint64 length = 0;
+        bool modified = false;
+        Sci_Position firstVisibleLine = 0;
+        Sci_Position currentPos = 0;
+        Sci_Position anchor = 0;
+        bool readOnly = false;
+        QMap<int, int> markers; // Line to marker mask
+        QVector<int> contractedFolds; // Fold header lines
+        QVector<QPair<int, int>> hiddenLines; // First and last line of each hidden range
+        QString spillFilePath; // Compressed copy of the text when it can't be read back from the file
+        std::function<QByteArray()> loader; // Provides text that was never loaded, e.g. from a restored session
+        // What the file looked like when it was hibernated, it is only read back in if it still does
+        qint64 fileSize = 0;
+        QDateTime fileTimestamp;
+
+        bool readsFromFile() const { return spillFilePath.isEmpty() && !loader; }
+    };
+
+    // Releases the text, styles and undo history. Returns false if the editor can't be hibernated
+    bool hibernate();
+    // Hibernates an editor that has no text yet, the loader provides it the first time the editor is woken up
+    void hibernateWithLoader(qint64 length, const std::function<QByteArray()> &loader);
+    bool isHibernating() const { return !hibernation.isNull(); }
+    const HibernationState *hibernationState() const { return hibernation.data(); }
+    HibernationState *hibernationState() { return hibernation.data(); }
+    // The text the editor had before it was hibernated, not available when it can be read back from the file
+    QByteArray hibernatedText() const;
+    // Milliseconds since the editor was last hidden, or 0 if it is showing
+    qint64 idleTime() const;
+
+    // Bytes used by the document and this view's caches, see SCI_GETMEMORYUSAGE for the categories
+    qint64 totalMemoryUsage() const;
+    // The caches only speed up drawing and get rebuilt as needed
+    void dropViewCaches();
+    // Forgets the undo history but the buffer stays modified if it was
+    void clearUndoHistory();
+
+    // Starts automatic layout thread tuning over again with up to maximum threads
+    void resetLayoutThreads(int maximum);
+    // Moves the layout threads towards what the wrap timings since the last call say pays off
+    void tuneLayoutThreads();
+
+    // Incremented any time text is inserted or deleted. Useful to cheaply tell if the buffer has changed since some point in time
+    quint64 modificationCounter() const { return modificationCount; }
+
     QString languageName;
     QByteArray languageSingleLineComment;
 
@@ -120,6 +190,7 @@ public:
 
 public slots:
     void close();
+    bool wake();
     QFileDevice::FileError save();
     void reload();
     void omitModifications();
@@ -145,9 +216,14 @@ signals:
     void lexerChanged();
     void reloaded();
 
+    void hibernated();
+    void woken();
+
 protected:
     void dragEnterEvent(QDragEnterEvent *event) override;
     void dropEvent(QDropEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private:
     QString name;
@@ -157,8 +233,39 @@ private:
     RangeAllocator indicatorResources;
 
     bool temporary = false; // Temporary file loaded from a session. It can either be a 'New' file or actual 'File'
-
+    quint64 modificationCount = 0;
+    bool largeFile = false; // Document stores styles as runs and supports positions past 2GB
+    bool pagedView = false; // Only part of the file is in the document
+
+    // Encoding of the file on disk if it is not UTF-8
+    QByteArray encoding;
+
+    // Canonical path of the file the document's text still refers to through a mapping, if any
+    QString mappedFilePath;
+
+    QScopedPointer<HibernationState> hibernation;
+    QElapsedTimer hiddenTimer;
+
+    // Layout and position cache settings to put back once a hidden editor is shown again
+    bool viewCachesReleased = false;
+    sptr_t savedLayoutCache = SC_CACHE_CARET;
+    sptr_t savedPositionCache = 0;
+
+    // Wrap timings seen by the last tuneLayoutThreads() so it only acts on new measurements
+    sptr_t tunedWrapDuration = 0;
+    sptr_t tunedWrapElapsed = 0;
+    // Tuning never goes above this, it drops once more threads have been seen not to help
+    int layoutThreadsLimit = 1;
+
+    void enableLargeFileMode();
+    // Every tab keeps its own editor widget, while hidden it gives up what is only needed for drawing
+    void releaseViewCaches();
+    void restoreViewCaches();
     bool readFromDisk(QFile &file);
+    bool readMappedFromDisk(QFile &file);
+    // Copies the text out of the mapping so the file can be replaced without the text changing underneath it
+    void detachMappedFile();
+    QFileDevice::FileError writeTextToDisk(const QString &path);
     QDateTime fileTimestamp();
     void updateTimestamp();
 
@@ -189,4 +296,28 @@ void ScintillaNext::forEachMatchInRange(const QByteArray &text, Func callback, S
     }
 }
 
+template<typename Func>
+bool ScintillaNext::forEachTextChunk(Func callback) const
+{
+    const Sci_Position chunkSize = 4 * 1024 * 1024;
+    const Sci_Position length = textLength();
+    QByteArray chunk(static_cast<int>(qMin(chunkSize, length)) + 1, Qt::Uninitialized);
+
+    for (Sci_Position position = 0; position < length; position += chunkSize) {
+        const Sci_Position chunkLength = qMin(chunkSize, length - position);
+
+        Sci_TextRangeFull range;
+        range.chrg.cpMin = position;
+        range.chrg.cpMax = position + chunkLength;
+        range.lpstrText = chunk.data();
+        send(SCI_GETTEXTRANGEFULL, 0, reinterpret_cast<sptr_t>(&range));
+
+        if (!callback(chunk.constData(), chunkLength)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 #endif // SCINTILLANEXT_H
@@ -24,9 +24,12 @@
 #include "EditorManager.h"
 #include "NotepadNextApplication.h"
 
+#include <QCryptographicHash>
 #include <QDir>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QUuid>
+#include <QtEndian>
 
 
 static QString RandomSessionFileName()
@@ -34,17 +37,13 @@ static QString RandomSessionFileName()
     return QUuid::createUuid().toString(QUuid::WithoutBraces);
 }
 
-// QList<int> cannot be automatically serialized to/from QSettings (i.e. QVariant) so turn it to a QVariantList
-static QVariantList QListToQVariantList(const QList<int> intList)
-{
-    QVariantList vl;
-    for (const int i : intList){
-        vl.append(i);
-    }
-    return vl;
-}
+// Small buffers are cheaper to embed directly in the session store than to track as separate files
+const qint64 EMBED_THRESHOLD = 64 * 1024;
+
+// qCompress() needs the whole buffer in one QByteArray, anything larger is written uncompressed a chunk at a time
+const qint64 COMPRESS_LIMIT = 1024LL * 1024 * 1024;
 
-// Do the opposite of the function above
+// Older versions stored bookmarks in the settings as a QVariantList
 static QList<int> QVariantListToQList(const QVariantList &variantList) {
     QList<int> intList;
     for (const QVariant &variant : variantList) {
@@ -53,10 +52,66 @@ static QList<int> QVariantListToQList(const QVariantList &variantList) {
     return intList;
 }
 
+// The editor starts out hibernating, the text is only loaded once it is first shown
+static ScintillaNext *HibernatedEditor(const QString &name, qint64 length, const std::function<QByteArray()> &loader)
+{
+    ScintillaNext *editor = new ScintillaNext(name);
+
+    editor->hibernateWithLoader(length, loader);
+
+    return editor;
+}
+
+static QByteArray ReadSessionFile(const QString &filePath, bool compressed)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning("Cannot read session file \"%s\": %s", qUtf8Printable(filePath), qUtf8Printable(file.errorString()));
+        return QByteArray();
+    }
+
+    return compressed ? qUncompress(file.readAll()) : file.readAll();
+}
+
+static QByteArray BufferContents(ScintillaNext *editor)
+{
+    // A hibernating editor is empty, but it can still provide its text
+    if (editor->isHibernating()) {
+        return editor->hibernatedText();
+    }
+
+    return editor->textCopy();
+}
+
+static QVector<QByteArray> BufferChunks(ScintillaNext *editor)
+{
+    if (editor->isHibernating()) {
+        return {editor->hibernatedText()};
+    }
+
+    // A chunk at a time so buffers too large for one QByteArray can still be written out
+    QVector<QByteArray> chunks;
+    editor->forEachTextChunk([&chunks](const char *data, Sci_Position length) {
+        chunks.append(QByteArray(data, static_cast<int>(length)));
+        return true;
+    });
+
+    return chunks;
+}
+
 SessionManager::SessionManager(NotepadNextApplication *app, SessionFileTypes types)
     : app(app)
 {
     setSessionFileTypes(types);
+
+    // Keep the writes serialized so a session file is never written by two threads at once
+    writerPool.setMaxThreadCount(1);
+}
+
+SessionManager::~SessionManager()
+{
+    waitForPendingWrites();
 }
 
 void SessionManager::setSessionFileTypes(SessionFileTypes types)
@@ -74,9 +129,219 @@ QDir SessionManager::sessionDirectory() const
     return d;
 }
 
-void SessionManager::saveIntoSessionDirectory(ScintillaNext *editor, const QString &sessionFileName) const
+QString SessionManager::sessionStorePath() const
+{
+    QDir d(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+
+    d.mkpath(".");
+
+    return d.filePath("session.dat");
+}
+
+void SessionManager::storeBufferContents(ScintillaNext *editor, SessionStore::Record &record)
+{
+    const qint64 length = editor->isHibernating() ? editor->hibernationState()->length : editor->length();
+
+    if (length < EMBED_THRESHOLD) {
+        record.contents = BufferContents(editor);
+        record.compressed = app->getSettings()->compressSessionFiles();
+    }
+    else {
+        const SessionFileEntry &entry = saveIntoSessionDirectory(editor);
+
+        record.sessionFileName = entry.sessionFileName;
+        record.compressed = entry.compressed;
+    }
+}
+
+const SessionManager::SessionFileEntry &SessionManager::saveIntoSessionDirectory(ScintillaNext *editor)
+{
+    const qint64 length = editor->isHibernating() ? editor->hibernationState()->length : editor->length();
+    const bool compress = app->getSettings()->compressSessionFiles() && length < COMPRESS_LIMIT;
+
+    auto it = sessionFiles.find(editor);
+    if (it == sessionFiles.end()) {
+        it = sessionFiles.insert(editor, SessionFileEntry{RandomSessionFileName(), compress});
+
+        // Make sure a new editor that happens to reuse the address does not pick up this entry
+        QObject::connect(editor, &ScintillaNext::closed, editor, [=]() {
+            sessionFiles.remove(editor);
+        });
+    }
+    else if (it->written && it->writtenModificationCounter == editor->modificationCounter() && it->writtenCompressed == compress) {
+        qDebug("  session file \"%s\" is up to date", qUtf8Printable(it->sessionFileName));
+        return it.value();
+    }
+
+    // The entry describes the file once the write below is done. It is only marked as written when
+    // that succeeds, so a failed write is tried again on the next save
+    it->compressed = compress;
+
+    // Take a snapshot of the buffer so the (potentially slow) write can happen in the background
+    const QVector<QByteArray> data = BufferChunks(editor);
+    const QString sessionFileName = it->sessionFileName;
+    const QString filePath = sessionDirectory().filePath(sessionFileName);
+    const quint64 modificationCounter = editor->modificationCounter();
+    const ScintillaNext *writtenEditor = editor;
+
+    writerPool.start([=]() {
+        if (writeSessionFile(filePath, data, compress)) {
+            QMetaObject::invokeMethod(&writeResultContext, [=]() {
+                sessionFileWritten(writtenEditor, sessionFileName, modificationCounter, compress);
+            }, Qt::QueuedConnection);
+        }
+    });
+
+    return it.value();
+}
+
+bool SessionManager::writeSessionFile(const QString &filePath, const QVector<QByteArray> &chunks, bool compress)
+{
+    // The compression flag is part of the hash so toggling it forces the file to be rewritten
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    hasher.addData(compress ? QByteArrayLiteral("1") : QByteArrayLiteral("0"));
+    for (const QByteArray &chunk : chunks) {
+        hasher.addData(chunk);
+    }
+    const QByteArray hash = hasher.result();
+
+    {
+        QMutexLocker locker(&writtenHashesMutex);
+
+        if (writtenHashes.value(filePath) == hash) {
+            qDebug("Session file \"%s\" has identical contents, skipping", qUtf8Printable(filePath));
+            return true;
+        }
+    }
+
+    QSaveFile file(filePath);
+
+    if (file.open(QIODevice::WriteOnly)) {
+        bool written = true;
+
+        if (compress) {
+            // Only buffers below COMPRESS_LIMIT are compressed so they fit in one QByteArray
+            QByteArray data;
+            for (const QByteArray &chunk : chunks) {
+                data.append(chunk);
+            }
+
+            const QByteArray contents = qCompress(data);
+            written = file.write(contents) == contents.size();
+        }
+        else {
+            for (const QByteArray &chunk : chunks) {
+                if (file.write(chunk) != chunk.size()) {
+                    written = false;
+                    break;
+                }
+            }
+        }
+
+        if (written && file.commit()) {
+            QMutexLocker locker(&writtenHashesMutex);
+            writtenHashes.insert(filePath, hash);
+            return true;
+        }
+    }
+
+    qWarning("Failed to write session file \"%s\": %s", qUtf8Printable(filePath), qUtf8Printable(file.errorString()));
+
+    return false;
+}
+
+void SessionManager::sessionFileWritten(const ScintillaNext *editor, const QString &sessionFileName, quint64 modificationCounter, bool compressed)
+{
+    // The editor may have been closed, and its address reused, since the write was queued
+    auto it = sessionFiles.find(editor);
+    if (it == sessionFiles.end() || it->sessionFileName != sessionFileName) {
+        return;
+    }
+
+    // Writes finish in the order they were queued so this is the latest one on disk
+    it->written = true;
+    it->writtenModificationCounter = modificationCounter;
+    it->writtenCompressed = compressed;
+}
+
+void SessionManager::trackSessionFile(ScintillaNext *editor, const QString &sessionFileName, bool compressed)
 {
-    editor->saveCopyAs(sessionDirectory().filePath(sessionFileName));
+    // The file was just loaded from so it is known to match the editor
+    sessionFiles.insert(editor, SessionFileEntry{sessionFileName, compressed, true, editor->modificationCounter(), compressed});
+
+    QObject::connect(editor, &ScintillaNext::closed, editor, [=]() {
+        sessionFiles.remove(editor);
+    });
+}
+
+void SessionManager::removeStaleSessionFiles(const QSet<QString> &sessionFileNames)
+{
+    const QString sessionPath = sessionDirectory().absolutePath();
+
+    // Queue it up behind any pending writes
+    writerPool.start([=]() {
+        QDir d(sessionPath);
+
+        for (const QString &f : d.entryList(QDir::Files)) {
+            if (!sessionFileNames.contains(f)) {
+                qDebug("Removing stale session file \"%s\"", qUtf8Printable(f));
+                d.remove(f);
+
+                QMutexLocker locker(&writtenHashesMutex);
+                writtenHashes.remove(d.filePath(f));
+            }
+        }
+    });
+}
+
+void SessionManager::waitForPendingWrites()
+{
+    writerPool.waitForDone();
+}
+
+ScintillaNext *SessionManager::editorFromRecord(SessionStore &store, const SessionStore::Record &record) const
+{
+    // Embedded contents are small, so they are read now and the store doesn't have to stay open
+    if (record.hasEmbeddedContents()) {
+        const QByteArray data = store.readContents(record);
+
+        return HibernatedEditor(record.fileName, data.size(), [data]() { return data; });
+    }
+
+    const QString sessionFilePath = sessionDirectory().filePath(record.sessionFileName);
+
+    qDebug("  temp loc: \"%s\"", qUtf8Printable(sessionFilePath));
+
+    if (record.sessionFileName.isEmpty() || !QFileInfo::exists(sessionFilePath)) {
+        qDebug("  session file no longer exists on disk, ignoring");
+        return Q_NULLPTR;
+    }
+
+    QFile file(sessionFilePath);
+    const qint64 largeFileSize = app->getEditorManager()->largeFileSize();
+    qint64 length = file.size();
+
+    if (record.compressed) {
+        // qCompress() puts the uncompressed size up front
+        const QByteArray header = file.open(QIODevice::ReadOnly) ? file.read(4) : QByteArray();
+
+        if (header.size() != 4) {
+            qWarning("Cannot read session file \"%s\": %s", qUtf8Printable(sessionFilePath), qUtf8Printable(file.errorString()));
+            return Q_NULLPTR;
+        }
+
+        length = qFromBigEndian<quint32>(header.constData());
+    }
+    else if ((largeFileSize > 0 && length >= largeFileSize) || length > std::numeric_limits<int>::max()) {
+        // Too large to hand over in one piece, it gets read the same way as any other file
+        return ScintillaNext::fromFile(sessionFilePath, false, largeFileSize);
+    }
+
+    const bool compressed = record.compressed;
+
+    return HibernatedEditor(record.fileName, length, [sessionFilePath, compressed]() {
+        return ReadSessionFile(sessionFilePath, compressed);
+    });
 }
 
 SessionManager::SessionFileType SessionManager::determineType(ScintillaNext *editor) const
@@ -103,22 +368,26 @@ void SessionManager::clear() const
 {
     clearSettings();
     clearDirectory();
+
+    QFile::remove(sessionStorePath());
 }
 
 void SessionManager::clearSettings() const
 {
-    ApplicationSettings settings;;
+    ApplicationSettings settings;
 
-    // Clear everything out. There can be left over entries that are no longer needed
-    settings.beginGroup("CurrentSession");
-    settings.remove("");
+    // Older versions stored the session in the settings
+    if (settings.childGroups().contains("CurrentSession")) {
+        settings.beginGroup("CurrentSession");
+        settings.remove("");
+    }
 }
 
 void SessionManager::clearDirectory() const
 {
     QDir d = sessionDirectory();
 
-    for (const QString &f : d.entryList()) {
+    for (const QString &f : d.entryList(QDir::Files)) {
         d.remove(f);
     }
 }
@@ -127,111 +396,174 @@ void SessionManager::saveSession(MainWindow *window)
 {
     qInfo(Q_FUNC_INFO);
 
-    clear();
+    // The session is no longer stored in the settings
+    clearSettings();
 
     // Early out if no flags are set
     if (fileTypes == SessionManager::None) {
+        sessionFiles.clear();
+        removeStaleSessionFiles(QSet<QString>());
+        writeSessionStore(QVector<SessionStore::Record>(), 0);
         return;
     }
 
     const ScintillaNext *currentEditor = window->currentEditor();
     int currentEditorIndex = 0;
-    ApplicationSettings settings;;
-
-    settings.beginGroup("CurrentSession");
-
-    settings.beginWriteArray("OpenedFiles");
+    QVector<SessionStore::Record> records;
+    QSet<const ScintillaNext *> editorsWithSessionFiles;
 
-    int index = 0;
     for (const auto &editor : window->editors()) {
         SessionFileType editorType = determineType(editor);
 
         if (fileTypes.testFlag(editorType)) {
-            settings.setArrayIndex(index);
+            SessionStore::Record record;
+            record.type = editorType;
 
             if (editorType == SessionManager::SavedFile) {
-                storeFileDetails(editor, settings);
+                storeFileDetails(editor, record);
             }
             else if (editorType == SessionManager::UnsavedFile) {
-                storeUnsavedFileDetails(editor, settings);
+                storeUnsavedFileDetails(editor, record);
             }
             else if (editorType == SessionManager::TempFile) {
-                storeTempFile(editor, settings);
+                storeTempFile(editor, record);
             }
             else {
                 qWarning("Unknown SessionFileType %d", editorType);
+                continue;
+            }
+
+            if (!record.sessionFileName.isEmpty()) {
+                editorsWithSessionFiles.insert(editor);
             }
 
             if (currentEditor == editor) {
-                currentEditorIndex = index;
+                currentEditorIndex = records.size();
             }
 
-            ++index;
+            records.append(record);
         }
     }
 
-    settings.endArray();
+    // Forget any editors that no longer need a session file so their files get cleaned up
+    QSet<QString> sessionFileNames;
+    for (auto it = sessionFiles.begin(); it != sessionFiles.end();) {
+        if (editorsWithSessionFiles.contains(it.key())) {
+            sessionFileNames.insert(it->sessionFileName);
+            ++it;
+        }
+        else {
+            it = sessionFiles.erase(it);
+        }
+    }
 
-    settings.setValue("CurrentEditorIndex", currentEditorIndex);
+    removeStaleSessionFiles(sessionFileNames);
 
-    settings.endGroup();
+    writeSessionStore(records, currentEditorIndex);
+}
+
+void SessionManager::writeSessionStore(const QVector<SessionStore::Record> &records, int currentEditorIndex)
+{
+    const QString filePath = sessionStorePath();
+
+    // Queued behind the session file writes, so the store never references a file that has not been written
+    writerPool.start([=]() {
+        SessionStore::write(filePath, records, currentEditorIndex);
+    });
 }
 
 void SessionManager::loadSession(MainWindow *window)
 {
     qInfo(Q_FUNC_INFO);
 
-    ApplicationSettings settings;;
+    SessionStore store;
+    QVector<SessionStore::Record> records;
+    int currentEditorIndex = 0;
 
-    settings.beginGroup("CurrentSession");
+    if (store.open(sessionStorePath())) {
+        records = store.records();
+        currentEditorIndex = store.currentIndex();
+    }
+    else {
+        records = loadLegacySession(currentEditorIndex);
+    }
 
     ScintillaNext *currentEditor = Q_NULLPTR;
-    const int currentEditorIndex = settings.value("CurrentEditorIndex").toInt();
-    const int size = settings.beginReadArray("OpenedFiles");
 
     // NOTE: In theory the fileTypes should determine what is loaded, however if the session fileTypes
-    // change from the last time it was saved then it means the settings were manually altered outside of the app,
+    // change from the last time it was saved then it means the session was manually altered outside of the app,
     // which is non-standard behavior, so just load anything in the file
 
-    for (int index = 0; index < size; ++index) {
-        settings.setArrayIndex(index);
-
+    for (int index = 0; index < records.size(); ++index) {
+        const SessionStore::Record &record = records.at(index);
         ScintillaNext *editor = Q_NULLPTR;
 
-        if (settings.contains("Type")) {
-            const QString type = settings.value("Type").toString();
+        if (record.type == SessionManager::SavedFile) {
+            editor = loadFileDetails(record);
+        }
+        else if (record.type == SessionManager::UnsavedFile) {
+            editor = loadUnsavedFileDetails(store, record);
+        }
+        else if (record.type == SessionManager::TempFile) {
+            editor = loadTempFile(store, record);
+        }
+        else {
+            qDebug("Unknown session entry type %d for index %d", record.type, index);
+        }
 
-            if (type == QStringLiteral("File")) {
-                editor = loadFileDetails(settings);
-            }
-            else if (type == QStringLiteral("UnsavedFile")) {
-                editor = loadUnsavedFileDetails(settings);
-            }
-            else if (type == QStringLiteral("Temp")) {
-                editor = loadTempFile(settings);
-            }
-            else {
-                qDebug("Unknown session entry type: %s", qUtf8Printable(type));
-            }
+        if (editor && currentEditorIndex == index) {
+            currentEditor = editor;
+        }
+    }
 
-            if (editor) {
-                 if (currentEditorIndex == index) {
-                    currentEditor = editor;
-                }
-            }
+    if (currentEditor) {
+        window->switchToEditor(currentEditor);
+    }
+}
+
+QVector<SessionStore::Record> SessionManager::loadLegacySession(int &currentEditorIndex) const
+{
+    ApplicationSettings settings;
+    QVector<SessionStore::Record> records;
+
+    settings.beginGroup("CurrentSession");
+
+    currentEditorIndex = settings.value("CurrentEditorIndex").toInt();
+    const int size = settings.beginReadArray("OpenedFiles");
+
+    for (int index = 0; index < size; ++index) {
+        settings.setArrayIndex(index);
+
+        SessionStore::Record record;
+        const QString type = settings.value("Type").toString();
+
+        if (type == QStringLiteral("File")) {
+            record.type = SessionManager::SavedFile;
         }
-        else {
-            qDebug("Unknown session entry type for index %d", index);
+        else if (type == QStringLiteral("UnsavedFile")) {
+            record.type = SessionManager::UnsavedFile;
+        }
+        else if (type == QStringLiteral("Temp")) {
+            record.type = SessionManager::TempFile;
         }
+
+        record.filePath = settings.value("FilePath").toString();
+        record.fileName = settings.value("FileName").toString();
+        record.language = settings.value("Language").toString();
+        record.sessionFileName = settings.value("SessionFileName").toString();
+        record.compressed = settings.value("Compressed", false).toBool();
+        record.firstVisibleLine = settings.value("FirstVisibleLine").toInt() - 1; // It was 1-based in the settings
+        record.currentPosition = settings.value("CurrentPosition").toLongLong();
+        record.bookMarkedLines = QVariantListToQList(settings.value("BookMarks").toList());
+
+        records.append(record);
     }
 
     settings.endArray();
 
     settings.endGroup();
 
-    if (currentEditor) {
-        window->switchToEditor(currentEditor);
-    }
+    return records;
 }
 
 bool SessionManager::willFileGetStoredInSession(ScintillaNext *editor) const
@@ -242,19 +574,18 @@ bool SessionManager::willFileGetStoredInSession(ScintillaNext *editor) const
     return fileTypes.testFlag(editorType);
 }
 
-void SessionManager::storeFileDetails(ScintillaNext *editor, QSettings &settings)
+void SessionManager::storeFileDetails(ScintillaNext *editor, SessionStore::Record &record)
 {
-    settings.setValue("Type", "File");
-    settings.setValue("FilePath", editor->getFilePath());
+    record.filePath = editor->getFilePath();
 
-    storeEditorViewDetails(editor, settings);
+    storeEditorViewDetails(editor, record);
 }
 
-ScintillaNext* SessionManager::loadFileDetails(QSettings &settings)
+ScintillaNext* SessionManager::loadFileDetails(const SessionStore::Record &record)
 {
     qInfo(Q_FUNC_INFO);
 
-    const QString filePath = settings.value("FilePath").toString();
+    const QString &filePath = record.filePath;
 
     qDebug("Session file: \"%s\"", qUtf8Printable(filePath));
 
@@ -265,11 +596,9 @@ ScintillaNext* SessionManager::loadFileDetails(QSettings &settings)
     }
 
     if (QFileInfo::exists(filePath)) {
-        editor = ScintillaNext::fromFile(filePath);
-
-        app->getEditorManager()->manageEditor(editor);
+        editor = app->getEditorManager()->createHibernatedEditorFromFile(filePath);
 
-        loadEditorViewDetails(editor, settings);
+        loadEditorViewDetails(editor, record);
 
         return editor;
     }
@@ -279,29 +608,21 @@ ScintillaNext* SessionManager::loadFileDetails(QSettings &settings)
     }
 }
 
-void SessionManager::storeUnsavedFileDetails(ScintillaNext *editor, QSettings &settings)
+void SessionManager::storeUnsavedFileDetails(ScintillaNext *editor, SessionStore::Record &record)
 {
-    const QString sessionFileName = RandomSessionFileName();
-
-    settings.setValue("Type", "UnsavedFile");
-    settings.setValue("FilePath", editor->getFilePath());
-    settings.setValue("SessionFileName", sessionFileName);
+    record.filePath = editor->getFilePath();
 
-    storeEditorViewDetails(editor, settings);
-
-    saveIntoSessionDirectory(editor, sessionFileName);
+    storeBufferContents(editor, record);
+    storeEditorViewDetails(editor, record);
 }
 
-ScintillaNext *SessionManager::loadUnsavedFileDetails(QSettings &settings)
+ScintillaNext *SessionManager::loadUnsavedFileDetails(SessionStore &store, const SessionStore::Record &record)
 {
     qInfo(Q_FUNC_INFO);
 
-    const QString filePath = settings.value("FilePath").toString();
-    const QString sessionFileName = settings.value("SessionFileName").toString();
-    const QString sessionFilePath = sessionDirectory().filePath(sessionFileName);
+    const QString &filePath = record.filePath;
 
     qDebug("Session file: \"%s\"", qUtf8Printable(filePath));
-    qDebug("  temp loc: \"%s\"", qUtf8Printable(sessionFilePath));
 
     ScintillaNext *editor = app->getEditorManager()->getEditorByFilePath(filePath);
     if (editor != Q_NULLPTR) {
@@ -309,98 +630,118 @@ ScintillaNext *SessionManager::loadUnsavedFileDetails(QSettings &settings)
         return Q_NULLPTR;
     }
 
-    if (QFileInfo::exists(filePath) && QFileInfo::exists(sessionFilePath)) {
-        ScintillaNext *editor = ScintillaNext::fromFile(sessionFilePath);
+    if (!QFileInfo::exists(filePath)) {
+        // What if just filePath exists?
+        qDebug("  no longer exists on disk, ignoring this file for session loading");
+        return Q_NULLPTR;
+    }
 
-        // Since this editor has different file path info, treat this as a temporary buffer
-        editor->setFileInfo(filePath);
-        editor->setTemporary(true);
+    editor = editorFromRecord(store, record);
 
-        app->getEditorManager()->manageEditor(editor);
+    if (editor == Q_NULLPTR) {
+        return Q_NULLPTR;
+    }
 
-        loadEditorViewDetails(editor, settings);
+    // Since this editor has different file path info, treat this as a temporary buffer
+    editor->setFileInfo(filePath);
+    editor->setTemporary(true);
 
-        return editor;
-    }
-    else {
-        // What if just filePath exists?
-        qDebug("  no longer exists on disk, ignoring this file for session loading");
-        return Q_NULLPTR;
+    app->getEditorManager()->manageEditor(editor);
+
+    loadEditorViewDetails(editor, record);
+
+    if (!record.hasEmbeddedContents()) {
+        trackSessionFile(editor, record.sessionFileName, record.compressed);
     }
+
+    return editor;
 }
 
-void SessionManager::storeTempFile(ScintillaNext *editor, QSettings &settings)
+void SessionManager::storeTempFile(ScintillaNext *editor, SessionStore::Record &record)
 {
-    const QString sessionFileName = RandomSessionFileName();
-
-    settings.setValue("Type", "Temp");
-    settings.setValue("FileName", editor->getName());
-    settings.setValue("SessionFileName", sessionFileName);
-    settings.setValue("Language", editor->languageName);
+    record.fileName = editor->getName();
+    record.language = editor->languageName;
 
-    storeEditorViewDetails(editor, settings);
-
-    saveIntoSessionDirectory(editor, sessionFileName);
+    storeBufferContents(editor, record);
+    storeEditorViewDetails(editor, record);
 }
 
-ScintillaNext *SessionManager::loadTempFile(QSettings &settings)
+ScintillaNext *SessionManager::loadTempFile(SessionStore &store, const SessionStore::Record &record)
 {
     qInfo(Q_FUNC_INFO);
 
-    const QString fileName = settings.value("FileName").toString();
-    const QString sessionFileName = settings.value("SessionFileName").toString();
-    const QString languageName = settings.value("Language", QString()).toString();
-    const QString fullFilePath = sessionDirectory().filePath(sessionFileName);
+    qDebug("Session temp file: \"%s\"", qUtf8Printable(record.fileName));
+
+    // Buffers recovered from an edit journal are opened first and are newer than anything in the session.
+    // The journal records the name, so only the language is taken from here
+    ScintillaNext *editor = app->getEditorManager()->getTempEditorByName(record.fileName);
+    if (editor != Q_NULLPTR) {
+        qDebug("  buffer is already open, ignoring");
 
-    qDebug("Session temp file: \"%s\"", qUtf8Printable(fullFilePath));
+        if (!record.language.isEmpty()) {
+            app->setEditorLanguage(editor, record.language);
+        }
 
-    if (QFileInfo::exists(fullFilePath)) {
-        ScintillaNext *editor = ScintillaNext::fromFile(fullFilePath, false);
+        return editor;
+    }
 
-        editor->detachFileInfo(fileName);
-        editor->setTemporary(true);
+    editor = editorFromRecord(store, record);
 
-        app->getEditorManager()->manageEditor(editor);
+    if (editor == Q_NULLPTR) {
+        return Q_NULLPTR;
+    }
 
-        loadEditorViewDetails(editor, settings);
+    editor->detachFileInfo(record.fileName);
+    editor->setTemporary(true);
 
-        if (!languageName.isEmpty()) {
-            qDebug("Setting session file language to \"%s\"", qUtf8Printable(languageName));
-            app->setEditorLanguage(editor, languageName);
-        }
+    app->getEditorManager()->manageEditor(editor);
 
-        return editor;
+    loadEditorViewDetails(editor, record);
+
+    if (!record.language.isEmpty()) {
+        qDebug("Setting session file language to \"%s\"", qUtf8Printable(record.language));
+        app->setEditorLanguage(editor, record.language);
     }
-    else {
-        qDebug("  no longer exists on disk, ignoring");
-        return Q_NULLPTR;
+
+    if (!record.hasEmbeddedContents()) {
+        trackSessionFile(editor, record.sessionFileName, record.compressed);
     }
+
+    return editor;
 }
 
-void SessionManager::storeEditorViewDetails(ScintillaNext *editor, QSettings &settings)
+void SessionManager::storeEditorViewDetails(ScintillaNext *editor, SessionStore::Record &record)
 {
-    settings.setValue("FirstVisibleLine", static_cast<int>(editor->firstVisibleLine() + 1)); // Keep it 1-based in the settings just for human-readability
-    settings.setValue("CurrentPosition", static_cast<int>(editor->currentPos()));
+    if (editor->isHibernating()) {
+        record.firstVisibleLine = editor->hibernationState()->firstVisibleLine;
+        record.currentPosition = editor->hibernationState()->currentPos;
+    }
+    else {
+        record.firstVisibleLine = editor->firstVisibleLine();
+        record.currentPosition = editor->currentPos();
+    }
 
     BookMarkDecorator *decorator = editor->findChild<BookMarkDecorator*>(QString(), Qt::FindDirectChildrenOnly);
-    QList<int> bookMarkedLines = decorator->bookMarkedLines();
-    if (bookMarkedLines.length() > 0)
-        settings.setValue("BookMarks", QListToQVariantList(bookMarkedLines));
+    record.bookMarkedLines = decorator->bookMarkedLines();
 }
 
-void SessionManager::loadEditorViewDetails(ScintillaNext *editor, QSettings &settings)
+void SessionManager::loadEditorViewDetails(ScintillaNext *editor, const SessionStore::Record &record)
 {
-    const int firstVisibleLine = settings.value("FirstVisibleLine").toInt() - 1;
-    const int currentPosition = settings.value("CurrentPosition").toInt();
+    // The view is put back once there is text to show
+    if (editor->isHibernating()) {
+        ScintillaNext::HibernationState *state = editor->hibernationState();
 
-    editor->setFirstVisibleLine(firstVisibleLine);
-    editor->setEmptySelection(currentPosition);
-
-    if (settings.contains("BookMarks"))
-    {
-        QList<int> bookMarkedLines = QVariantListToQList(settings.value("BookMarks").toList()); // just using .value<QList<int>>() does not work...possibly a Qt bug?
+        state->firstVisibleLine = record.firstVisibleLine;
+        state->currentPos = record.currentPosition;
+        state->anchor = record.currentPosition;
+    }
+    else {
+        editor->setFirstVisibleLine(record.firstVisibleLine);
+        editor->setEmptySelection(record.currentPosition);
+    }
 
+    if (!record.bookMarkedLines.isEmpty()) {
         BookMarkDecorator *decorator = editor->findChild<BookMarkDecorator*>(QString(), Qt::FindDirectChildrenOnly);
-        decorator->setBookMarkedLines(bookMarkedLines);
+        decorator->setBookMarkedLines(record.bookMarkedLines);
     }
 }
@@ -21,8 +21,14 @@
 #define SESSIONMANAGER_H
 
 
+#include "SessionStore.h"
+
 #include <QDir>
-#include <QSettings>
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
 
 
 class ScintillaNext;
@@ -42,6 +48,7 @@ public:
 
 
     SessionManager(NotepadNextApplication *app, SessionFileTypes types = SessionFileTypes());
+    ~SessionManager();
 
     void setSessionFileTypes(SessionFileTypes types);
 
@@ -52,30 +59,65 @@ public:
 
     bool willFileGetStoredInSession(ScintillaNext *editor) const;
 
+    void waitForPendingWrites();
+
 private:
+    struct SessionFileEntry {
+        QString sessionFileName;
+        bool compressed = false;
+
+        // What is known to be on disk, only updated once a write has succeeded
+        bool written = false;
+        quint64 writtenModificationCounter = 0;
+        bool writtenCompressed = false;
+    };
+
     QDir sessionDirectory() const;
+    QString sessionStorePath() const;
 
-    void saveIntoSessionDirectory(ScintillaNext *editor, const QString &sessionFileName) const;
+    void storeBufferContents(ScintillaNext *editor, SessionStore::Record &record);
+    const SessionFileEntry &saveIntoSessionDirectory(ScintillaNext *editor);
+    bool writeSessionFile(const QString &filePath, const QVector<QByteArray> &chunks, bool compress);
+    void sessionFileWritten(const ScintillaNext *editor, const QString &sessionFileName, quint64 modificationCounter, bool compressed);
+    void trackSessionFile(ScintillaNext *editor, const QString &sessionFileName, bool compressed);
+    void removeStaleSessionFiles(const QSet<QString> &sessionFileNames);
+    ScintillaNext *editorFromRecord(SessionStore &store, const SessionStore::Record &record) const;
+
+    void writeSessionStore(const QVector<SessionStore::Record> &records, int currentEditorIndex);
+    QVector<SessionStore::Record> loadLegacySession(int &currentEditorIndex) const;
 
     SessionFileType determineType(ScintillaNext *editor) const;
 
     void clearSettings() const;
     void clearDirectory() const;
 
-    void storeFileDetails(ScintillaNext *editor, QSettings &settings);
-    ScintillaNext *loadFileDetails(QSettings &settings);
+    void storeFileDetails(ScintillaNext *editor, SessionStore::Record &record);
+    ScintillaNext *loadFileDetails(const SessionStore::Record &record);
 
-    void storeUnsavedFileDetails(ScintillaNext *editor, QSettings &settings);
-    ScintillaNext *loadUnsavedFileDetails(QSettings &settings);
+    void storeUnsavedFileDetails(ScintillaNext *editor, SessionStore::Record &record);
+    ScintillaNext *loadUnsavedFileDetails(SessionStore &store, const SessionStore::Record &record);
 
-    void storeTempFile(ScintillaNext *editor, QSettings &settings);
-    ScintillaNext *loadTempFile(QSettings &settings);
+    void storeTempFile(ScintillaNext *editor, SessionStore::Record &record);
+    ScintillaNext *loadTempFile(SessionStore &store, const SessionStore::Record &record);
 
-    void storeEditorViewDetails(ScintillaNext *editor, QSettings &settings);
-    void loadEditorViewDetails(ScintillaNext *editor, QSettings &settings);
+    void storeEditorViewDetails(ScintillaNext *editor, SessionStore::Record &record);
+    void loadEditorViewDetails(ScintillaNext *editor, const SessionStore::Record &record);
 
     NotepadNextApplication *app;
     SessionFileTypes fileTypes;
+
+    // Session files are kept between saves and only rewritten when the editor has changed since it was last written
+    QHash<const ScintillaNext *, SessionFileEntry> sessionFiles;
+
+    // Writes happen on a single background thread. The mutex guards the hashes, which both that
+    // thread and the main thread access when files are cleared or removed
+    QThreadPool writerPool;
+    QMutex writtenHashesMutex;
+    QHash<QString, QByteArray> writtenHashes;
+
+    // Successful writes are reported back to the main thread through this. Any still queued when
+    // the manager is destroyed are dropped along with it
+    QObject writeResultContext;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(SessionManager::SessionFileTypes)
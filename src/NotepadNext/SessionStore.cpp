@@ -0,0 +1,225 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "SessionStore.h"
+
+#include <QDataStream>
+#include <QSaveFile>
+
+
+const quint32 SESSION_STORE_MAGIC = 0x4E4E5353; // NNSS
+// Version 1 stored the first visible line and current position as 32-bit ints
+const quint16 SESSION_STORE_VERSION = 2;
+const QDataStream::Version STREAM_VERSION = QDataStream::Qt_5_15;
+
+// The smallest a record can be on disk: the type, four empty strings, the flag, the two positions (32-bit
+// in version 1), an empty list and the two contents fields. Used to reject counts that the file is too small to hold
+const qint64 MIN_RECORD_SIZE = 1 + 4 * 4 + 1 + 2 * 4 + 4 + 2 * 8;
+
+// Same format as streaming a QList<int>, but a corrupt count is rejected instead of being reserved
+static void ReadLineList(QDataStream &stream, QList<int> &lines)
+{
+    quint32 n = 0;
+    stream >> n;
+
+    const QIODevice *device = stream.device();
+    if (n > static_cast<quint64>(device->size() - device->pos()) / sizeof(qint32)) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return;
+    }
+
+    lines.clear();
+    lines.reserve(static_cast<int>(n));
+
+    for (quint32 i = 0; i < n && stream.status() == QDataStream::Ok; ++i) {
+        qint32 line = 0;
+        stream >> line;
+        lines.append(line);
+    }
+}
+
+
+bool SessionStore::write(const QString &filePath, const QVector<Record> &records, int currentIndex)
+{
+    qInfo(Q_FUNC_INFO);
+
+    QSaveFile saveFile(filePath);
+
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        qWarning("Cannot open session store \"%s\": %s", qUtf8Printable(filePath), qUtf8Printable(saveFile.errorString()));
+        return false;
+    }
+
+    QDataStream stream(&saveFile);
+    stream.setVersion(STREAM_VERSION);
+
+    stream << SESSION_STORE_MAGIC << SESSION_STORE_VERSION << static_cast<qint32>(records.size()) << static_cast<qint32>(currentIndex);
+
+    // The offsets are relative to the end of the table so they can be calculated up front
+    qint64 offset = 0;
+    QVector<QByteArray> blobs;
+
+    for (const Record &record : records) {
+        qint64 contentsOffset = -1;
+        qint64 contentsSize = 0;
+
+        if (record.sessionFileName.isEmpty()) {
+            blobs.append(record.compressed ? qCompress(record.contents) : record.contents);
+
+            contentsOffset = offset;
+            contentsSize = blobs.last().size();
+            offset += contentsSize;
+        }
+
+        stream << record.type
+               << record.filePath
+               << record.fileName
+               << record.language
+               << record.sessionFileName
+               << record.compressed
+               << record.firstVisibleLine
+               << record.currentPosition
+               << record.bookMarkedLines
+               << contentsOffset
+               << contentsSize;
+    }
+
+    for (const QByteArray &blob : qAsConst(blobs)) {
+        stream.writeRawData(blob.constData(), blob.size());
+    }
+
+    if (stream.status() != QDataStream::Ok || !saveFile.commit()) {
+        qWarning("Failed writing session store \"%s\": %s", qUtf8Printable(filePath), qUtf8Printable(saveFile.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+bool SessionStore::open(const QString &filePath)
+{
+    close();
+
+    file.setFileName(filePath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(STREAM_VERSION);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint32 count = 0;
+    qint32 currentIndex = 0;
+
+    stream >> magic >> version >> count >> currentIndex;
+
+    if (stream.status() != QDataStream::Ok || magic != SESSION_STORE_MAGIC || version < 1 || version > SESSION_STORE_VERSION || count < 0) {
+        qWarning("\"%s\" is not a supported session store", qUtf8Printable(filePath));
+        close();
+        return false;
+    }
+
+    // Don't trust the count of a corrupt or foreign file, it has to fit in what is left of the file
+    if (count > (file.size() - file.pos()) / MIN_RECORD_SIZE) {
+        qWarning("Session store \"%s\" is corrupt", qUtf8Printable(filePath));
+        close();
+        return false;
+    }
+
+    recordTable.reserve(count);
+
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Record record;
+
+        stream >> record.type
+               >> record.filePath
+               >> record.fileName
+               >> record.language
+               >> record.sessionFileName
+               >> record.compressed;
+
+        if (version == 1) {
+            qint32 firstVisibleLine = 0;
+            qint32 currentPosition = 0;
+            stream >> firstVisibleLine >> currentPosition;
+
+            record.firstVisibleLine = firstVisibleLine;
+            record.currentPosition = currentPosition;
+        }
+        else {
+            stream >> record.firstVisibleLine >> record.currentPosition;
+        }
+
+        ReadLineList(stream, record.bookMarkedLines);
+
+        stream >> record.contentsOffset
+               >> record.contentsSize;
+
+        recordTable.append(record);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning("Session store \"%s\" is corrupt", qUtf8Printable(filePath));
+        close();
+        return false;
+    }
+
+    contentsStart = file.pos();
+    current = currentIndex;
+
+    return true;
+}
+
+void SessionStore::close()
+{
+    file.close();
+    recordTable.clear();
+    contentsStart = 0;
+    current = 0;
+}
+
+QByteArray SessionStore::readContents(const Record &record)
+{
+    if (!record.hasEmbeddedContents() || !file.isOpen()) {
+        return QByteArray();
+    }
+
+    // The offset and size come from the file so they have to be checked against it before allocating anything
+    const qint64 contentsLength = file.size() - contentsStart;
+    if (record.contentsSize < 0 || record.contentsOffset > contentsLength || record.contentsSize > contentsLength - record.contentsOffset) {
+        qWarning("Session store contents are out of range");
+        return QByteArray();
+    }
+
+    if (!file.seek(contentsStart + record.contentsOffset)) {
+        return QByteArray();
+    }
+
+    const QByteArray data = file.read(record.contentsSize);
+
+    if (data.size() != record.contentsSize) {
+        qWarning("Session store contents are truncated");
+        return QByteArray();
+    }
+
+    return record.compressed ? qUncompress(data) : data;
+}
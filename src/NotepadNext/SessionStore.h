@@ -0,0 +1,76 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+
+// A single binary file holding the session. The layout is a small header, followed by a table with
+// one record per editor, followed by any embedded buffer contents. Opening the store only reads the
+// header and the record table, the buffer contents are read on demand.
+class SessionStore
+{
+public:
+    struct Record {
+        quint8 type = 0;
+        QString filePath;
+        QString fileName;
+        QString language;
+
+        // The buffer contents are either in a separate session file or embedded in the store
+        QString sessionFileName;
+        bool compressed = false;
+
+        qint64 firstVisibleLine = 0;
+        qint64 currentPosition = 0;
+        QList<int> bookMarkedLines;
+
+        // Only used when writing
+        QByteArray contents;
+
+        // Only used when reading, relative to the start of the embedded contents
+        qint64 contentsOffset = -1;
+        qint64 contentsSize = 0;
+
+        bool hasEmbeddedContents() const { return contentsOffset >= 0; }
+    };
+
+    static bool write(const QString &filePath, const QVector<Record> &records, int currentIndex);
+
+    bool open(const QString &filePath);
+    void close();
+
+    int currentIndex() const { return current; }
+    const QVector<Record> &records() const { return recordTable; }
+
+    QByteArray readContents(const Record &record);
+
+private:
+    QFile file;
+    QVector<Record> recordTable;
+    qint64 contentsStart = 0;
+    int current = 0;
+};
+
+#endif // SESSIONSTORE_H
@@ -0,0 +1,413 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Transcoder.h"
+#include "TranscoderTables.h"
+#include "Utf8Validator.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TRANSCODER_SSE2
+#endif
+
+
+const char32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+
+static char *AppendUtf8(char *dst, char32_t cp)
+{
+    if (cp < 0x80) {
+        *dst++ = static_cast<char>(cp);
+    }
+    else if (cp < 0x800) {
+        *dst++ = static_cast<char>(0xC0 | (cp >> 6));
+        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        *dst++ = static_cast<char>(0xE0 | (cp >> 12));
+        *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else {
+        *dst++ = static_cast<char>(0xF0 | (cp >> 18));
+        *dst++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+
+    return dst;
+}
+
+// Decodes one character, returning how many bytes it used or 0 if the byte at data is not valid UTF-8
+static int DecodeUtf8(const unsigned char *data, qsizetype available, char32_t &cp)
+{
+    const unsigned char c = data[0];
+    int length;
+
+    if (c < 0x80) {
+        cp = c;
+        return 1;
+    }
+    else if (c >= 0xC2 && c <= 0xDF) {
+        length = 2;
+        cp = c & 0x1F;
+    }
+    else if (c >= 0xE0 && c <= 0xEF) {
+        length = 3;
+        cp = c & 0x0F;
+    }
+    else if (c >= 0xF0 && c <= 0xF4) {
+        length = 4;
+        cp = c & 0x07;
+    }
+    else {
+        return 0;
+    }
+
+    if (available < length) {
+        return 0;
+    }
+
+    for (int i = 1; i < length; ++i) {
+        if ((data[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        cp = (cp << 6) | (data[i] & 0x3F);
+    }
+
+    // Overlongs, surrogates, and anything past the end of Unicode
+    if ((length == 3 && cp < 0x800) || (length == 4 && (cp < 0x10000 || cp > 0x10FFFF)) || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return 0;
+    }
+
+    return length;
+}
+
+static const CodePage *FindCodePage(const QByteArray &upperName)
+{
+    for (const CodePage &codePage : CODE_PAGES) {
+        if (upperName == codePage.name) {
+            return &codePage;
+        }
+    }
+
+    return Q_NULLPTR;
+}
+
+Transcoder::Transcoder(const QByteArray &name)
+    : encodingName(name.toUpper())
+{
+    if (encodingName == "UTF-16LE") {
+        kind = Utf16LE;
+    }
+    else if (encodingName == "UTF-16BE") {
+        kind = Utf16BE;
+    }
+    else if (const CodePage *codePage = FindCodePage(encodingName)) {
+        kind = SingleByte;
+
+        for (int i = 0; i < 128; ++i) {
+            const char16_t cp = codePage->upperHalf[i];
+            char *end = AppendUtf8(reinterpret_cast<char *>(upperHalfUtf8[i] + 1), cp);
+
+            // The first byte holds the length
+            upperHalfUtf8[i][0] = static_cast<unsigned char>(end - reinterpret_cast<char *>(upperHalfUtf8[i] + 1));
+
+            if (cp != REPLACEMENT_CHARACTER) {
+                reverseTable.insert(cp, static_cast<char>(0x80 + i));
+            }
+        }
+    }
+    else {
+        encodingName.clear();
+    }
+}
+
+bool Transcoder::isSupported(const QByteArray &encodingName)
+{
+    return Transcoder(encodingName).isValid();
+}
+
+QByteArray Transcoder::toUtf8(const char *data, qsizetype length)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    if (kind == SingleByte) {
+        return singleByteToUtf8(bytes, length);
+    }
+    else if (kind == Utf16LE || kind == Utf16BE) {
+        return utf16ToUtf8(bytes, length);
+    }
+
+    return QByteArray();
+}
+
+QByteArray Transcoder::finish()
+{
+    QByteArray out;
+
+    // Anything left over is an incomplete character
+    if (pendingByte != -1 || pendingHighSurrogate != 0) {
+        char buffer[4];
+        out = QByteArray(buffer, AppendUtf8(buffer, REPLACEMENT_CHARACTER) - buffer);
+    }
+
+    reset();
+
+    return out;
+}
+
+void Transcoder::reset()
+{
+    atStart = true;
+    pendingByte = -1;
+    pendingHighSurrogate = 0;
+}
+
+QByteArray Transcoder::singleByteToUtf8(const unsigned char *data, qsizetype length) const
+{
+    // Worst case every byte turns into 3 bytes
+    QByteArray out(length * 3, Qt::Uninitialized);
+    char *dst = out.data();
+
+    qsizetype i = 0;
+    while (i < length) {
+        const qsizetype ascii = Utf8Validator::asciiPrefixLength(reinterpret_cast<const char *>(data + i), length - i);
+        memcpy(dst, data + i, ascii);
+        dst += ascii;
+        i += ascii;
+
+        while (i < length && data[i] >= 0x80) {
+            const unsigned char *utf8 = upperHalfUtf8[data[i] - 0x80];
+            memcpy(dst, utf8 + 1, utf8[0]);
+            dst += utf8[0];
+            ++i;
+        }
+    }
+
+    out.resize(dst - out.data());
+    return out;
+}
+
+char *Transcoder::appendUtf16Unit(char *dst, char16_t unit)
+{
+    if (pendingHighSurrogate != 0) {
+        if (unit >= 0xDC00 && unit <= 0xDFFF) {
+            const char32_t cp = 0x10000 + ((pendingHighSurrogate - 0xD800) << 10) + (unit - 0xDC00);
+            pendingHighSurrogate = 0;
+            return AppendUtf8(dst, cp);
+        }
+
+        // Unpaired high surrogate
+        pendingHighSurrogate = 0;
+        dst = AppendUtf8(dst, REPLACEMENT_CHARACTER);
+    }
+
+    if (unit >= 0xD800 && unit <= 0xDBFF) {
+        pendingHighSurrogate = unit;
+        return dst;
+    }
+    else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+        return AppendUtf8(dst, REPLACEMENT_CHARACTER);
+    }
+
+    // The byte order mark is not part of the text
+    if (atStart && unit == 0xFEFF) {
+        atStart = false;
+        return dst;
+    }
+
+    atStart = false;
+    return AppendUtf8(dst, unit);
+}
+
+QByteArray Transcoder::utf16ToUtf8(const unsigned char *data, qsizetype length)
+{
+    const bool bigEndian = kind == Utf16BE;
+
+    // Each unit turns into at most 3 bytes. A surrogate pair (2 units) is 4 bytes
+    QByteArray out((length / 2 + 2) * 3, Qt::Uninitialized);
+    char *dst = out.data();
+    qsizetype i = 0;
+
+    if (pendingByte != -1 && length > 0) {
+        const char16_t unit = bigEndian ? (pendingByte << 8) | data[0] : (data[0] << 8) | pendingByte;
+        pendingByte = -1;
+        dst = appendUtf16Unit(dst, unit);
+        i = 1;
+    }
+
+    while (i + 1 < length) {
+#if defined(TRANSCODER_SSE2)
+        // Runs of ASCII get narrowed 8 units at a time
+        if (pendingHighSurrogate == 0 && !atStart) {
+            const __m128i asciiMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+            const __m128i zero = _mm_setzero_si128();
+
+            while (i + 16 <= length) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+
+                if (bigEndian) {
+                    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+                }
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, asciiMask), zero)) != 0xFFFF) {
+                    break;
+                }
+
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(v, v));
+                dst += 8;
+                i += 16;
+            }
+
+            if (i + 1 >= length) {
+                break;
+            }
+        }
+#endif
+
+        const char16_t unit = bigEndian ? (data[i] << 8) | data[i + 1] : (data[i + 1] << 8) | data[i];
+        dst = appendUtf16Unit(dst, unit);
+        i += 2;
+    }
+
+    if (i < length) {
+        pendingByte = data[i];
+    }
+
+    out.resize(dst - out.data());
+    return out;
+}
+
+QByteArray Transcoder::fromUtf8(const char *data, qsizetype length, qsizetype *unmappable, bool byteOrderMark) const
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    qsizetype failures = 0;
+    QByteArray out;
+
+    if (kind == SingleByte) {
+        out.resize(length);
+        char *dst = out.data();
+        qsizetype i = 0;
+
+        while (i < length) {
+            const qsizetype ascii = Utf8Validator::asciiPrefixLength(data + i, length - i);
+            memcpy(dst, data + i, ascii);
+            dst += ascii;
+            i += ascii;
+
+            if (i == length) {
+                break;
+            }
+
+            char32_t cp;
+            const int sequenceLength = DecodeUtf8(bytes + i, length - i, cp);
+            const auto it = sequenceLength > 0 ? reverseTable.constFind(cp) : reverseTable.constEnd();
+
+            if (it != reverseTable.constEnd()) {
+                *dst++ = it.value();
+            }
+            else {
+                *dst++ = '?';
+                ++failures;
+            }
+
+            i += qMax(sequenceLength, 1);
+        }
+
+        out.resize(dst - out.data());
+    }
+    else if (kind == Utf16LE || kind == Utf16BE) {
+        const bool bigEndian = kind == Utf16BE;
+
+        // Every byte turns into at most 2 units, plus the byte order mark
+        out.resize(length * 2 + 2);
+        char *dst = out.data();
+
+        auto appendUnit = [&](char16_t unit) {
+            *dst++ = static_cast<char>(bigEndian ? unit >> 8 : unit & 0xFF);
+            *dst++ = static_cast<char>(bigEndian ? unit & 0xFF : unit >> 8);
+        };
+
+        if (byteOrderMark) {
+            appendUnit(0xFEFF);
+        }
+
+        qsizetype i = 0;
+        while (i < length) {
+#if defined(TRANSCODER_SSE2)
+            // Runs of ASCII get widened 16 characters at a time
+            const __m128i zero = _mm_setzero_si128();
+
+            while (i + 16 <= length) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+
+                if (_mm_movemask_epi8(v) != 0) {
+                    break;
+                }
+
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+                if (bigEndian) {
+                    lo = _mm_slli_epi16(lo, 8);
+                    hi = _mm_slli_epi16(hi, 8);
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), hi);
+                dst += 32;
+                i += 16;
+            }
+
+            if (i == length) {
+                break;
+            }
+#endif
+
+            char32_t cp;
+            const int sequenceLength = DecodeUtf8(bytes + i, length - i, cp);
+
+            if (sequenceLength == 0) {
+                cp = REPLACEMENT_CHARACTER;
+                ++failures;
+            }
+
+            if (cp >= 0x10000) {
+                appendUnit(static_cast<char16_t>(0xD800 + ((cp - 0x10000) >> 10)));
+                appendUnit(static_cast<char16_t>(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+            }
+            else {
+                appendUnit(static_cast<char16_t>(cp));
+            }
+
+            i += qMax(sequenceLength, 1);
+        }
+
+        out.resize(dst - out.data());
+    }
+
+    if (unmappable) {
+        *unmappable = failures;
+    }
+
+    return out;
+}
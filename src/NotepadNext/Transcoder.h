@@ -0,0 +1,71 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+
+
+// Converts between UTF-8 and single byte code pages (Windows-125x, ISO-8859-x, KOI8) or UTF-16
+// directly with lookup tables, without going through a UTF-16 QString. Decoding is streaming, so a
+// character split across two chunks is carried over to the next call.
+class Transcoder
+{
+public:
+    explicit Transcoder(const QByteArray &encodingName = QByteArray());
+
+    static bool isSupported(const QByteArray &encodingName);
+
+    bool isValid() const { return kind != Invalid; }
+    QByteArray name() const { return encodingName; }
+
+    QByteArray toUtf8(const char *data, qsizetype length);
+    QByteArray finish();
+
+    // Characters that cannot be represented are replaced and counted in unmappable. When encoding a
+    // chunk at a time only the first should have a byte order mark
+    QByteArray fromUtf8(const char *data, qsizetype length, qsizetype *unmappable = Q_NULLPTR, bool byteOrderMark = true) const;
+
+    void reset();
+
+private:
+    enum Kind {
+        Invalid,
+        SingleByte,
+        Utf16LE,
+        Utf16BE,
+    };
+
+    QByteArray singleByteToUtf8(const unsigned char *data, qsizetype length) const;
+    QByteArray utf16ToUtf8(const unsigned char *data, qsizetype length);
+    char *appendUtf16Unit(char *dst, char16_t unit);
+
+    Kind kind = Invalid;
+    QByteArray encodingName;
+
+    // UTF-8 for each byte in the upper half of a single byte code page, and the reverse mapping
+    unsigned char upperHalfUtf8[128][4];
+    QHash<uint, char> reverseTable;
+
+    // Decoding state for UTF-16
+    bool atStart = true;
+    int pendingByte = -1;
+    char16_t pendingHighSurrogate = 0;
+};
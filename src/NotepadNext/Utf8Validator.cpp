@@ -0,0 +1,184 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "Utf8Validator.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define UTF8_VALIDATOR_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define UTF8_VALIDATOR_NEON
+#endif
+
+
+qsizetype Utf8Validator::asciiPrefixLength(const char *chars, qsizetype length)
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(chars);
+    qsizetype i = 0;
+
+#if defined(UTF8_VALIDATOR_SSE2)
+    for (; i + 32 <= length; i += 32) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 16));
+
+        if (_mm_movemask_epi8(_mm_or_si128(a, b)) != 0) {
+            break;
+        }
+    }
+    for (; i + 16 <= length; i += 16) {
+        if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))) != 0) {
+            break;
+        }
+    }
+#elif defined(UTF8_VALIDATOR_NEON)
+    for (; i + 16 <= length; i += 16) {
+        if (vmaxvq_u8(vld1q_u8(data + i)) >= 0x80) {
+            break;
+        }
+    }
+#endif
+
+    while (i < length && data[i] < 0x80) {
+        ++i;
+    }
+
+    return i;
+}
+
+// Returns the length of the sequence at the start of data, 0 if it is invalid, or -1 if it is
+// valid so far but needs more bytes than are available
+static int SequenceLength(const unsigned char *data, qsizetype available)
+{
+    const unsigned char c = data[0];
+
+    int length;
+    unsigned char secondMin = 0x80;
+    unsigned char secondMax = 0xBF;
+
+    if (c < 0x80) {
+        return 1;
+    }
+    else if (c >= 0xC2 && c <= 0xDF) {
+        length = 2;
+    }
+    else if (c >= 0xE0 && c <= 0xEF) {
+        length = 3;
+        if (c == 0xE0) secondMin = 0xA0; // Overlong
+        if (c == 0xED) secondMax = 0x9F; // Surrogates
+    }
+    else if (c >= 0xF0 && c <= 0xF4) {
+        length = 4;
+        if (c == 0xF0) secondMin = 0x90; // Overlong
+        if (c == 0xF4) secondMax = 0x8F; // Above U+10FFFF
+    }
+    else {
+        return 0;
+    }
+
+    for (int i = 1; i < length; ++i) {
+        if (i >= available) {
+            return -1;
+        }
+
+        const unsigned char min = i == 1 ? secondMin : 0x80;
+        const unsigned char max = i == 1 ? secondMax : 0xBF;
+
+        if (data[i] < min || data[i] > max) {
+            return 0;
+        }
+    }
+
+    return length;
+}
+
+qsizetype Utf8Validator::completeLength(const char *data, qsizetype length)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    // A cut off sequence starts in one of the last 3 bytes
+    for (qsizetype start = length - 1; start >= 0 && start >= length - 3; --start) {
+        if ((bytes[start] & 0xC0) != 0x80) {
+            return SequenceLength(bytes + start, length - start) == -1 ? start : length;
+        }
+    }
+
+    return length;
+}
+
+bool Utf8Validator::validate(const char *data, qsizetype length)
+{
+    if (!valid) {
+        return false;
+    }
+
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    qsizetype i = 0;
+
+    // Finish off the sequence that was split by the previous call
+    if (pendingLength > 0) {
+        while (pendingLength < 4 && i < length) {
+            pending[pendingLength++] = bytes[i++];
+
+            const int sequenceLength = SequenceLength(pending, pendingLength);
+            if (sequenceLength == 0) {
+                valid = false;
+                return false;
+            }
+            else if (sequenceLength > 0) {
+                pendingLength = 0;
+                break;
+            }
+        }
+    }
+
+    while (i < length) {
+        i += asciiPrefixLength(data + i, length - i);
+
+        if (i == length) {
+            break;
+        }
+
+        ascii = false;
+
+        const int sequenceLength = SequenceLength(bytes + i, length - i);
+        if (sequenceLength == 0) {
+            valid = false;
+            return false;
+        }
+        else if (sequenceLength == -1) {
+            pendingLength = static_cast<int>(length - i);
+            for (int j = 0; j < pendingLength; ++j) {
+                pending[j] = bytes[i + j];
+            }
+            break;
+        }
+
+        i += sequenceLength;
+    }
+
+    return true;
+}
+
+void Utf8Validator::reset()
+{
+    valid = true;
+    ascii = true;
+    pendingLength = 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QtGlobal>
+
+
+// Streaming UTF-8 validator. Runs of ASCII are skipped 16 bytes at a time with SIMD, anything else
+// is checked with a scalar decoder. A multi-byte sequence split across calls is carried over.
+class Utf8Validator
+{
+public:
+    bool validate(const char *data, qsizetype length);
+
+    bool isValid() const { return valid; }
+    bool isAscii() const { return ascii; }
+    bool isIncomplete() const { return pendingLength > 0; }
+    // Bytes at the end of what has been validated so far that start a sequence which isn't finished yet
+    int pendingBytes() const { return pendingLength; }
+
+    void reset();
+
+    // Length of the leading run of ASCII characters
+    static qsizetype asciiPrefixLength(const char *data, qsizetype length);
+    // Length of data without a multi-byte sequence that is cut off at its end, so text can be split into chunks
+    static qsizetype completeLength(const char *data, qsizetype length);
+
+private:
+    bool valid = true;
+    bool ascii = true;
+
+    // Bytes of an unfinished sequence from the end of the previous call
+    unsigned char pending[4];
+    int pendingLength = 0;
+};
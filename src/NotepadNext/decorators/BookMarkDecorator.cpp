@@ -98,6 +98,19 @@ QList<int> BookMarkDecorator::bookMarkedLines() const
 {
     QList<int> bookMarkedLines;
 
+    // The markers are gone while hibernating, but the editor remembers where they were
+    if (editor->isHibernating()) {
+        const QMap<int, int> &markers = editor->hibernationState()->markers;
+
+        for (auto it = markers.constBegin(); it != markers.constEnd(); ++it) {
+            if (it.value() & (1 << MARK_BOOKMARK)) {
+                bookMarkedLines.append(it.key());
+            }
+        }
+
+        return bookMarkedLines;
+    }
+
     int line = 0;
     forever {
         line = editor->markerNext(line, 1 << MARK_BOOKMARK);
@@ -116,6 +129,28 @@ QList<int> BookMarkDecorator::bookMarkedLines() const
 
 void BookMarkDecorator::setBookMarkedLines(QList<int> &lines)
 {
+    // There are no lines to put markers on yet, so they are added when the editor wakes up
+    if (editor->isHibernating()) {
+        QMap<int, int> &markers = editor->hibernationState()->markers;
+
+        for (auto it = markers.begin(); it != markers.end();) {
+            it.value() &= ~(1 << MARK_BOOKMARK);
+
+            if (it.value() == 0) {
+                it = markers.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        for (const int line : lines) {
+            markers[line] |= 1 << MARK_BOOKMARK;
+        }
+
+        return;
+    }
+
     // Make sure they are all clear first
     clearAllBookmarks();
 
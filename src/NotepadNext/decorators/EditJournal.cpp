@@ -0,0 +1,412 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "EditJournal.h"
+
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QUuid>
+
+#include <limits>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+const quint32 BASE_MAGIC = 0x4E4E4A42; // NNJB
+const quint32 JOURNAL_MAGIC = 0x4E4E4A4A; // NNJJ
+const QDataStream::Version STREAM_VERSION = QDataStream::Qt_5_15;
+
+// The base is read back into the editor this much at a time rather than in one piece
+const qint64 RECOVERY_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// Don't bother compacting small journals, else compact once the journal is bigger than the document itself
+const qint64 MIN_COMPACTION_SIZE = 16 * 1024 * 1024;
+
+// QFile::flush() only hands the data to the OS, which can still lose it if the machine goes down
+static bool SyncToDisk(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())));
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+
+EditJournal::EditJournal(ScintillaNext *editor) :
+    EditorDecorator(editor),
+    id(QUuid::createUuid().toString(QUuid::WithoutBraces)),
+    flushTimer(new QTimer(this))
+{
+    journal.setVersion(STREAM_VERSION);
+
+    // Batch up the writes instead of hitting the disk on every keystroke. At most this much editing
+    // is lost if the machine goes down
+    flushTimer->setInterval(1000);
+    flushTimer->setSingleShot(true);
+    connect(flushTimer, &QTimer::timeout, this, &EditJournal::flush);
+
+    // Nothing is written until the first edit, which writes the base before the edit is made. Editors
+    // that are never changed never cost anything
+    connect(this, &EditorDecorator::stateChanged, this, &EditJournal::discard);
+
+    // After these the editor matches what is on disk, so there is nothing to recover until it is edited again
+    connect(editor, &ScintillaNext::reloaded, this, &EditJournal::discard);
+    connect(editor, &ScintillaNext::saved, this, &EditJournal::discard);
+
+    // The name and path are stored in the base
+    connect(editor, &ScintillaNext::renamed, this, [=]() { if (journalFile.isOpen()) compact(); });
+
+    // A clean exit means there is nothing to recover
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &EditJournal::discard);
+}
+
+EditJournal::~EditJournal()
+{
+    discard();
+}
+
+QDir EditJournal::journalDirectory()
+{
+    QDir d(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+
+    d.mkpath("journal");
+    d.cd("journal");
+
+    return d;
+}
+
+QList<ScintillaNext *> EditJournal::recoverEditors()
+{
+    qInfo(Q_FUNC_INFO);
+
+    QList<ScintillaNext *> editors;
+    QDir d = journalDirectory();
+
+    // Anything left in the directory is from a previous instance that did not exit cleanly
+    for (const QString &baseFileName : d.entryList({QStringLiteral("*.base")}, QDir::Files)) {
+        const QString journalFileName = QFileInfo(baseFileName).completeBaseName() + QStringLiteral(".journal");
+
+        ScintillaNext *editor = recoverEditor(d.filePath(baseFileName), d.filePath(journalFileName));
+        if (editor) {
+            editors.append(editor);
+        }
+    }
+
+    for (const QString &f : d.entryList(QDir::Files)) {
+        d.remove(f);
+    }
+
+    return editors;
+}
+
+void EditJournal::notify(const Scintilla::NotificationData *pscn)
+{
+    if (pscn->nmhdr.code != Scintilla::Notification::Modified) {
+        return;
+    }
+
+    // The base is the text before the first edit, so an unmodified file is only referenced, not copied
+    if (!journalFile.isOpen() && FlagSet(pscn->modificationType, Scintilla::ModificationFlags::BeforeInsert | Scintilla::ModificationFlags::BeforeDelete)) {
+        compact();
+        return;
+    }
+
+    if (!journalFile.isOpen()) {
+        return;
+    }
+
+    if (FlagSet(pscn->modificationType, Scintilla::ModificationFlags::InsertText)) {
+        journal << static_cast<quint8>(Insert) << static_cast<qint64>(pscn->position) << static_cast<qint64>(pscn->length);
+        journal.writeRawData(pscn->text, static_cast<int>(pscn->length));
+    }
+    else if (FlagSet(pscn->modificationType, Scintilla::ModificationFlags::DeleteText)) {
+        journal << static_cast<quint8>(Delete) << static_cast<qint64>(pscn->position) << static_cast<qint64>(pscn->length);
+    }
+    else {
+        return;
+    }
+
+    if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
+
+void EditJournal::flush()
+{
+    if (!journalFile.isOpen()) {
+        return;
+    }
+
+    if (!SyncToDisk(journalFile)) {
+        qWarning("Cannot sync journal \"%s\": %s", qUtf8Printable(journalFile.fileName()), qUtf8Printable(journalFile.errorString()));
+    }
+
+    if (journalFile.size() > qMax(MIN_COMPACTION_SIZE, static_cast<qint64>(editor->length()))) {
+        qInfo("Compacting journal for \"%s\"", qUtf8Printable(editor->getName()));
+        compact();
+    }
+}
+
+void EditJournal::compact()
+{
+    flushTimer->stop();
+    journalFile.close();
+
+    // The generation ties the journal to its base. If this gets interrupted after the new base is written
+    // the old journal is ignored, which is correct since the new base already contains those changes.
+    ++generation;
+
+    if (!writeBase()) {
+        return;
+    }
+
+    journalFile.setFileName(journalPath());
+    if (!journalFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Cannot open journal \"%s\": %s", qUtf8Printable(journalFile.fileName()), qUtf8Printable(journalFile.errorString()));
+        return;
+    }
+
+    journal.setDevice(&journalFile);
+    journal << JOURNAL_MAGIC << generation;
+    SyncToDisk(journalFile);
+}
+
+void EditJournal::discard()
+{
+    flushTimer->stop();
+    journal.setDevice(Q_NULLPTR);
+    journalFile.close();
+
+    QFile::remove(journalPath());
+    QFile::remove(basePath());
+}
+
+QString EditJournal::basePath() const
+{
+    return journalDirectory().filePath(id + QStringLiteral(".base"));
+}
+
+QString EditJournal::journalPath() const
+{
+    return journalDirectory().filePath(id + QStringLiteral(".journal"));
+}
+
+bool EditJournal::writeBase()
+{
+    QSaveFile file(basePath());
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Cannot open journal base \"%s\": %s", qUtf8Printable(file.fileName()), qUtf8Printable(file.errorString()));
+        return false;
+    }
+
+    QDataStream base(&file);
+    base.setVersion(STREAM_VERSION);
+
+    // If the editor matches what is on disk then there is no need to copy the text, just reference the file
+    const QFileInfo fileInfo = editor->isFile() ? editor->getFileInfo() : QFileInfo();
+    const bool baseIsFile = editor->isFile() && editor->isSavedToDisk() && fileInfo.size() == editor->length();
+
+    // The name and path are what the session matches against to skip the buffers that get recovered
+    base << BASE_MAGIC << generation << editor->getName() << (editor->isFile() ? fileInfo.absoluteFilePath() : QString()) << baseIsFile;
+
+    if (baseIsFile) {
+        base << fileInfo.size() << fileInfo.lastModified();
+    }
+    else {
+        // Written the same way as a QByteArray, but a chunk at a time so the text is never joined into one copy
+        const Sci_Position length = editor->length();
+
+        if (length >= std::numeric_limits<quint32>::max()) {
+            qWarning("\"%s\" is too large for a journal base", qUtf8Printable(editor->getName()));
+            return false;
+        }
+
+        base << static_cast<quint32>(length);
+
+        editor->forEachTextChunk([&base](const char *data, Sci_Position chunkLength) {
+            return base.writeRawData(data, static_cast<int>(chunkLength)) == chunkLength;
+        });
+    }
+
+    if (base.status() != QDataStream::Ok || !file.commit()) {
+        qWarning("Failed writing journal base \"%s\": %s", qUtf8Printable(file.fileName()), qUtf8Printable(file.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+ScintillaNext *EditJournal::recoverEditor(const QString &basePath, const QString &journalPath)
+{
+    qInfo("Recovering \"%s\"", qUtf8Printable(basePath));
+
+    QFile baseFile(basePath);
+    if (!baseFile.open(QIODevice::ReadOnly)) {
+        return Q_NULLPTR;
+    }
+
+    QDataStream base(&baseFile);
+    base.setVersion(STREAM_VERSION);
+
+    quint32 magic = 0;
+    quint32 generation = 0;
+    QString name;
+    QString filePath;
+    bool baseIsFile = false;
+
+    base >> magic >> generation >> name >> filePath >> baseIsFile;
+
+    if (magic != BASE_MAGIC) {
+        qWarning("  not a journal base, ignoring");
+        return Q_NULLPTR;
+    }
+
+    // Either the file itself or the text stored after the header, in both cases it is copied into the
+    // editor a chunk at a time
+    QFile file(filePath);
+    QIODevice *content = &baseFile;
+    qint64 length = 0;
+
+    if (baseIsFile) {
+        qint64 size = 0;
+        QDateTime lastModified;
+        base >> size >> lastModified;
+
+        const QFileInfo fileInfo(filePath);
+        if (!fileInfo.exists() || fileInfo.size() != size || fileInfo.lastModified() != lastModified) {
+            qWarning("  \"%s\" has changed on disk, cannot recover", qUtf8Printable(filePath));
+            return Q_NULLPTR;
+        }
+
+        if (!file.open(QIODevice::ReadOnly)) {
+            return Q_NULLPTR;
+        }
+
+        content = &file;
+        length = size;
+    }
+    else {
+        // Written the same way as a QByteArray
+        quint32 size = 0;
+        base >> size;
+        length = size;
+    }
+
+    if (base.status() != QDataStream::Ok || length > content->size() - content->pos()) {
+        qWarning("  journal base is corrupt, ignoring");
+        return Q_NULLPTR;
+    }
+
+    ScintillaNext *editor = new ScintillaNext(name);
+    editor->setUndoCollection(false);
+
+    QByteArray chunk;
+    while (length > 0) {
+        chunk = content->read(qMin(length, RECOVERY_CHUNK_SIZE));
+
+        if (chunk.isEmpty()) {
+            qWarning("  cannot read \"%s\": %s", qUtf8Printable(baseIsFile ? filePath : basePath), qUtf8Printable(content->errorString()));
+            delete editor;
+            return Q_NULLPTR;
+        }
+
+        editor->appendText(chunk.size(), chunk.constData());
+        length -= chunk.size();
+    }
+    chunk.clear();
+    file.close();
+
+    QFile journalFile(journalPath);
+    if (journalFile.open(QIODevice::ReadOnly)) {
+        QDataStream journal(&journalFile);
+        journal.setVersion(STREAM_VERSION);
+
+        quint32 journalMagic = 0;
+        quint32 journalGeneration = 0;
+        journal >> journalMagic >> journalGeneration;
+
+        if (journalMagic == JOURNAL_MAGIC && journalGeneration == generation) {
+            int operations = 0;
+
+            // A partially written record at the end is expected if the crash happened mid-write
+            while (!journal.atEnd()) {
+                quint8 operation = 0;
+                qint64 position = 0;
+                qint64 length = 0;
+                journal >> operation >> position >> length;
+
+                if (journal.status() != QDataStream::Ok || position < 0 || length < 0 || position > editor->length()) {
+                    break;
+                }
+
+                if (operation == Insert) {
+                    if (length > journalFile.size()) {
+                        break;
+                    }
+
+                    QByteArray text(static_cast<int>(length), Qt::Uninitialized);
+                    if (journal.readRawData(text.data(), text.size()) != text.size()) {
+                        break;
+                    }
+
+                    editor->setTargetRange(position, position);
+                    editor->replaceTarget(text.size(), text.constData());
+                }
+                else if (operation == Delete) {
+                    if (position + length > editor->length()) {
+                        break;
+                    }
+
+                    editor->deleteRange(position, length);
+                }
+                else {
+                    break;
+                }
+
+                ++operations;
+            }
+
+            qInfo("  replayed %d operations", operations);
+        }
+    }
+
+    editor->setUndoCollection(true);
+
+    if (!filePath.isEmpty() && QFileInfo::exists(filePath)) {
+        editor->setFileInfo(filePath);
+    }
+
+    // It is not what is on disk (or never was on disk), so make sure it gets treated as unsaved
+    editor->setTemporary(true);
+
+    return editor;
+}
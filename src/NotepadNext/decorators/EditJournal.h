@@ -0,0 +1,72 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include "EditorDecorator.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+
+class QTimer;
+
+
+// Records every insertion and deletion to an append-only file so unsaved changes can be
+// recovered after a crash. The journal is periodically compacted into a base snapshot, so the
+// cost of keeping it up to date is proportional to the amount of editing, not the document size.
+class EditJournal : public EditorDecorator
+{
+    Q_OBJECT
+
+public:
+    explicit EditJournal(ScintillaNext *editor);
+    ~EditJournal();
+
+    static QDir journalDirectory();
+    static QList<ScintillaNext *> recoverEditors();
+
+public slots:
+    void notify(const Scintilla::NotificationData *pscn) override;
+
+    void flush();
+    void compact();
+    void discard();
+
+private:
+    enum Operation : quint8 {
+        Insert = 1,
+        Delete = 2,
+    };
+
+    static ScintillaNext *recoverEditor(const QString &basePath, const QString &journalPath);
+
+    QString basePath() const;
+    QString journalPath() const;
+    bool writeBase();
+
+    QString id;
+    quint32 generation = 0;
+    QFile journalFile;
+    QDataStream journal;
+    QTimer *flushTimer;
+};
+
+#endif // EDITJOURNAL_H
@@ -81,8 +81,19 @@ void HTMLAutoCompleteDecorator::notify(const Scintilla::NotificationData *pscn)
             if (tag[0] == '!') return; // <!-- and <!doctype
             if (voidTags.contains(tag)) return; // Some tags are not expected to have closing tags
 
-            // All good to go now, wrap it and insert it
             tag.prepend("</");
+
+            // Skip if the element is already closed, e.g. when retyping the start tag
+            const int matchPos = editor->tagMatch(tagStartPos, true);
+            if (matchPos >= 0) {
+                const QByteArray closingTag = editor->get_text_range(matchPos, matchPos + tag.size() + 1);
+                if (closingTag.size() > tag.size() && qstrnicmp(closingTag.constData(), tag.constData(), tag.size()) == 0) {
+                    const int after = static_cast<unsigned char>(closingTag.at(tag.size()));
+                    if (after == '>' || std::isspace(after) != 0) return;
+                }
+            }
+
+            // All good to go now, wrap it and insert it
             tag.append('>');
 
             const UndoAction ua(editor);
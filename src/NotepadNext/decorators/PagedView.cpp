@@ -0,0 +1,288 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <QEvent>
+#include <QSignalBlocker>
+#include <QTimer>
+
+#include "PagedView.h"
+
+
+using namespace Scintilla;
+
+// How much of the file is in the editor at once
+const qint64 WINDOW_SIZE = 4 * 1024 * 1024;
+
+// Resolution of the scroll bar, which covers the whole file
+const int SCROLL_RANGE = 1 << 20;
+
+static int CountDigits(qint64 x)
+{
+    int digits = 1;
+
+    while (x >= 10) {
+        x /= 10;
+        ++digits;
+    }
+
+    return digits;
+}
+
+PagedView::PagedView(ScintillaNext *editor) :
+    EditorDecorator(editor),
+    file(new PagedFile(editor->getFilePath(), this)),
+    scrollBar(new QScrollBar(Qt::Vertical, editor))
+{
+    // Scintilla's scroll bar would only cover the window, so it is replaced by one covering the whole
+    // file. It sits on top of the right side of the text area, which the right margin keeps clear.
+    editor->setVScrollBar(false);
+    editor->setMarginRight(scrollBar->sizeHint().width());
+    editor->viewport()->installEventFilter(this);
+
+    scrollBar->setRange(0, SCROLL_RANGE);
+    scrollBar->show();
+
+    // Line numbers in the editor are relative to the window, so the real ones are filled in as text
+    editor->setMarginTypeN(0, SC_MARGIN_RTEXT);
+
+    connect(scrollBar, &QScrollBar::valueChanged, this, [=](int value) {
+        goToPosition(value * file->size() / SCROLL_RANGE);
+    });
+
+    connect(file, &PagedFile::indexProgress, this, &PagedView::updateLineNumbers);
+    connect(file, &PagedFile::indexFinished, this, &PagedView::updateLineNumbers);
+    connect(editor, &ScintillaNext::reloaded, this, &PagedView::reopen);
+
+    reopen();
+}
+
+bool PagedView::goToLine(qint64 line)
+{
+    const qint64 position = file->lineStart(line);
+
+    if (position < 0) {
+        return false;
+    }
+
+    showPosition(position);
+
+    editor->gotoPos(position - windowStartPosition);
+    editor->verticalCentreCaret();
+
+    return true;
+}
+
+void PagedView::goToPosition(qint64 position)
+{
+    showPosition(position);
+
+    editor->setFirstVisibleLine(editor->lineFromPosition(position - windowStartPosition));
+}
+
+bool PagedView::find(const QByteArray &text, bool forward, bool wrap)
+{
+    // Start from the selection so a repeated search moves on to the next match
+    const qint64 from = windowStartPosition + (forward ? editor->selectionEnd() : editor->selectionStart());
+
+    qint64 match = file->find(text, from, forward);
+
+    if (match < 0 && wrap) {
+        match = file->find(text, forward ? 0 : file->size(), forward);
+    }
+
+    if (match < 0) {
+        return false;
+    }
+
+    // The whole match has to end up in the window
+    if (match < windowStartPosition || match + text.size() > windowEndPosition) {
+        loadWindow(match);
+    }
+
+    editor->setSel(match - windowStartPosition, match + text.size() - windowStartPosition);
+    editor->verticalCentreCaret();
+
+    return true;
+}
+
+void PagedView::notify(const NotificationData *pscn)
+{
+    if (pscn->nmhdr.code == Notification::UpdateUI && FlagSet(pscn->updated, Update::VScroll)) {
+        updateScrollBar();
+        updateLineNumbers();
+
+        // This gets sent while painting, so wait to replace the text
+        if (!windowCheckPending) {
+            windowCheckPending = true;
+            QTimer::singleShot(0, this, &PagedView::checkWindow);
+        }
+    }
+    else if (pscn->nmhdr.code == Notification::Zoom) {
+        updateLineNumbers();
+    }
+}
+
+bool PagedView::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == editor->viewport() && event->type() == QEvent::Resize) {
+        layoutScrollBar();
+    }
+
+    return EditorDecorator::eventFilter(watched, event);
+}
+
+void PagedView::reopen()
+{
+    const qint64 position = windowStartPosition;
+
+    file->close();
+
+    if (!file->open()) {
+        return;
+    }
+
+    // Make sure the window gets reloaded even if it is at the same spot
+    windowEndPosition = -1;
+
+    loadWindow(qMin(position, file->size()));
+}
+
+void PagedView::loadWindow(qint64 position)
+{
+    qInfo(Q_FUNC_INFO);
+
+    const qint64 start = file->alignToLineStart(position - WINDOW_SIZE / 2);
+    const qint64 end = qMax(start, file->alignToLineStart(start + WINDOW_SIZE));
+
+    if (start == windowStartPosition && end == windowEndPosition) {
+        return;
+    }
+
+    {
+        const QSignalBlocker blocker(editor);
+
+        editor->setReadOnly(false);
+        editor->setUndoCollection(false);
+        editor->clearAll();
+        editor->appendText(end - start, file->data() + start);
+        editor->setUndoCollection(true);
+        editor->emptyUndoBuffer();
+        editor->setSavePoint();
+        editor->setReadOnly(true);
+    }
+
+    windowStartPosition = start;
+    windowEndPosition = end;
+    windowStartLine = file->lineFromPosition(start);
+
+    editor->marginTextClearAll();
+    updateLineNumbers();
+}
+
+void PagedView::showPosition(qint64 position)
+{
+    position = qBound(Q_INT64_C(0), position, file->size());
+
+    // The very end of the window is only usable if it is also the end of the file
+    const bool inWindow = position >= windowStartPosition && (position < windowEndPosition || position == file->size());
+
+    if (!inWindow) {
+        loadWindow(position);
+    }
+}
+
+void PagedView::checkWindow()
+{
+    windowCheckPending = false;
+
+    const Sci_Position linesOnScreen = editor->linesOnScreen();
+    const Sci_Position lineCount = editor->lineCount();
+    const Sci_Position topLine = editor->firstVisibleLine();
+
+    // If the lines are extremely long there is no point trying to keep a few screens around
+    if (lineCount < linesOnScreen * 8) {
+        return;
+    }
+
+    const bool nearStart = windowStartPosition > 0 && topLine < linesOnScreen * 2;
+    const bool nearEnd = windowEndPosition < file->size() && topLine + linesOnScreen * 3 > lineCount;
+
+    if (nearStart || nearEnd) {
+        const qint64 topPosition = windowStartPosition + editor->positionFromLine(topLine);
+        const qint64 caret = windowStartPosition + editor->currentPos();
+        const qint64 anchor = windowStartPosition + editor->anchor();
+
+        loadWindow(topPosition);
+
+        editor->setFirstVisibleLine(editor->lineFromPosition(topPosition - windowStartPosition));
+
+        // Keep the selection if it is still in the window, without scrolling to it
+        if (qMin(caret, anchor) >= windowStartPosition && qMax(caret, anchor) <= windowEndPosition) {
+            editor->setSelection(caret - windowStartPosition, anchor - windowStartPosition);
+        }
+    }
+}
+
+void PagedView::updateScrollBar()
+{
+    if (file->size() == 0) {
+        return;
+    }
+
+    const Sci_Position topLine = editor->firstVisibleLine();
+    const qint64 topPosition = windowStartPosition + editor->positionFromLine(topLine);
+    const qint64 bottomPosition = windowStartPosition + editor->positionFromLine(topLine + editor->linesOnScreen());
+
+    const QSignalBlocker blocker(scrollBar);
+    scrollBar->setPageStep(qMax(Q_INT64_C(1), (bottomPosition - topPosition) * SCROLL_RANGE / file->size()));
+    scrollBar->setValue(topPosition * SCROLL_RANGE / file->size());
+}
+
+void PagedView::updateLineNumbers()
+{
+    // The line the window starts at may not have been scanned yet
+    if (windowStartLine < 0) {
+        windowStartLine = file->lineFromPosition(windowStartPosition);
+
+        if (windowStartLine < 0) {
+            return;
+        }
+    }
+
+    const int pixelWidth = 8 + qMax(CountDigits(windowStartLine + editor->lineCount()), 3) * editor->textWidth(STYLE_LINENUMBER, "8");
+    editor->setMarginWidthN(0, pixelWidth);
+
+    const Sci_Position firstLine = editor->firstVisibleLine();
+    const Sci_Position endLine = qMin(firstLine + editor->linesOnScreen() + 1, editor->lineCount());
+
+    for (Sci_Position line = firstLine; line < endLine; ++line) {
+        editor->marginSetText(line, QByteArray::number(windowStartLine + line + 1).constData());
+        editor->marginSetStyle(line, STYLE_LINENUMBER);
+    }
+}
+
+void PagedView::layoutScrollBar()
+{
+    const QRect area = editor->viewport()->geometry();
+    const int width = scrollBar->sizeHint().width();
+
+    scrollBar->setGeometry(area.right() - width + 1, area.top(), width, area.height());
+    scrollBar->raise();
+}
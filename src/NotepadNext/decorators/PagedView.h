@@ -0,0 +1,73 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef PAGEDVIEW_H
+#define PAGEDVIEW_H
+
+#include <QScrollBar>
+
+#include "EditorDecorator.h"
+#include "PagedFile.h"
+
+
+// Shows a file that is too big to load by only putting a window of it into the editor. The window
+// moves as the editor gets scrolled near either end of it. The scroll bar, line numbers, go to line
+// and searching all work with positions in the whole file.
+class PagedView : public EditorDecorator
+{
+    Q_OBJECT
+
+public:
+    explicit PagedView(ScintillaNext *editor);
+
+    const PagedFile *pagedFile() const { return file; }
+
+    qint64 windowStart() const { return windowStartPosition; }
+    qint64 currentPosition() const { return windowStartPosition + editor->currentPos(); }
+
+    bool goToLine(qint64 line);
+    void goToPosition(qint64 position);
+    bool find(const QByteArray &text, bool forward, bool wrap);
+
+public slots:
+    void notify(const Scintilla::NotificationData *pscn) override;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void reopen();
+    void loadWindow(qint64 position);
+    void showPosition(qint64 position);
+    void checkWindow();
+    void updateScrollBar();
+    void updateLineNumbers();
+    void layoutScrollBar();
+
+    PagedFile *file;
+    QScrollBar *scrollBar;
+
+    qint64 windowStartPosition = 0;
+    qint64 windowEndPosition = 0;
+    qint64 windowStartLine = -1; // Not known until the scan gets that far
+    bool windowCheckPending = false;
+};
+
+#endif // PAGEDVIEW_H
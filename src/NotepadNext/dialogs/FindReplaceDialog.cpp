@@ -27,6 +27,7 @@
 
 #include "ScintillaNext.h"
 #include "MainWindow.h"
+#include "PagedView.h"
 
 
 static void convertToExtended(QString &str)
@@ -135,6 +136,8 @@ FindReplaceDialog::FindReplaceDialog(ISearchResultsHandler *searchResults, MainW
         MainWindow *window = qobject_cast<MainWindow *>(parent());
 
         for(ScintillaNext *editor : window->editors()) {
+            // Hibernated editors have no text to search
+            editor->wake();
             setEditor(editor);
             count += finder->replaceAll(replaceText);
         }
@@ -224,6 +227,11 @@ void FindReplaceDialog::find()
 {
     qInfo(Q_FUNC_INFO);
 
+    if (editor->isPagedView()) {
+        findInPagedView();
+        return;
+    }
+
     prepareToPerformSearch();
 
     Sci_CharacterRange range;
@@ -251,6 +259,32 @@ void FindReplaceDialog::find()
     }
 }
 
+void FindReplaceDialog::findInPagedView()
+{
+    qInfo(Q_FUNC_INFO);
+
+    prepareToPerformSearch();
+
+    // The search goes straight over the file on disk, so only exact matches are supported
+    const int flags = computeSearchFlags();
+    if ((flags & (SCFIND_REGEXP | SCFIND_WHOLEWORD)) || !(flags & SCFIND_MATCHCASE)) {
+        showMessage(tr("Paged views only support case sensitive Normal or Extended searches."), "red");
+        return;
+    }
+
+    QString text = findString();
+    if (ui->radioExtendedSearch->isChecked()) {
+        convertToExtended(text);
+    }
+
+    PagedView *view = editor->findChild<PagedView *>(QString(), Qt::FindDirectChildrenOnly);
+    const bool forward = !ui->checkBoxBackwardsDirection->isChecked();
+
+    if (!view->find(text.toUtf8(), forward, ui->checkBoxWrapAround->isChecked())) {
+        showMessage(tr("No matches found."), "red");
+    }
+}
+
 void FindReplaceDialog::findAllInCurrentDocument()
 {
     qInfo(Q_FUNC_INFO);
@@ -288,6 +322,8 @@ void FindReplaceDialog::findAllInDocuments()
     MainWindow *window = qobject_cast<MainWindow *>(parent());
 
     for(ScintillaNext *editor : window->editors()) {
+        // Hibernated editors have no text to search
+        editor->wake();
         setEditor(editor);
         findAllInCurrentDocument();
     }
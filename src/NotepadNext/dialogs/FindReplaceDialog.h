@@ -88,6 +88,7 @@ private slots:
 
 private:
     QString findString();
+    void findInPagedView();
     void prepareToPerformSearch(bool replace=false);
     void loadSettings();
     void saveSettings();
@@ -21,6 +21,7 @@
 #include "BookMarkDecorator.h"
 #include "DefaultDirectoryManager.h"
 #include "MarkerAppDecorator.h"
+#include "PagedView.h"
 #include "URLFinder.h"
 #include "SessionManager.h"
 #include "UndoAction.h"
@@ -33,6 +34,7 @@
 #include <QStandardPaths>
 #include <QWindow>
 #include <QPushButton>
+#include <QSharedPointer>
 #include <QTimer>
 #include <QInputDialog>
 #include <QPrintPreviewDialog>
@@ -67,6 +69,7 @@
 #include "DebugLogDock.h"
 #include "HexViewerDock.h"
 #include "FileListDock.h"
+#include "MemoryUsageDock.h"
 
 #include "FindReplaceDialog.h"
 #include "MacroRunDialog.h"
@@ -366,6 +369,26 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
 
     connect(ui->actionGoToLine, &QAction::triggered, this, [=]() {
         ScintillaNext *editor = currentEditor();
+
+        // The editor only has part of the file, so lines are looked up in the whole file
+        if (editor->isPagedView()) {
+            PagedView *view = editor->findChild<PagedView *>(QString(), Qt::FindDirectChildrenOnly);
+            const PagedFile *file = view->pagedFile();
+            const int currentLine = qMax(file->lineFromPosition(view->currentPosition()), Q_INT64_C(0)) + 1;
+            const int maxLine = qMin(file->lineCount(), Q_INT64_C(INT_MAX));
+            const QString label = file->isIndexed() ? tr("Line Number (1 - %1)").arg(maxLine) : tr("Line Number (1 - %1, still counting lines)").arg(maxLine);
+            bool ok;
+
+            QInputDialog d = QInputDialog(this);
+            Qt::WindowFlags flags = d.windowFlags() & ~Qt::WindowContextHelpButtonHint;
+            int lineToGoTo = d.getInt(this, tr("Go to line"), label, currentLine, 1, maxLine, 1, &ok, flags);
+
+            if (ok) {
+                view->goToLine(lineToGoTo - 1);
+            }
+
+            return;
+        }
         const int currentLine = editor->lineFromPosition(editor->currentPos()) + 1;
         const int maxLine = editor->lineCount();
         bool ok;
@@ -856,12 +879,17 @@ MainWindow::MainWindow(NotepadNextApplication *app) :
     hexViewerDock->hide();
     addDockWidget(Qt::RightDockWidgetArea, hexViewerDock);
 
+    MemoryUsageDock *memoryUsageDock = new MemoryUsageDock(this);
+    memoryUsageDock->hide();
+    addDockWidget(Qt::RightDockWidgetArea, memoryUsageDock);
+
     ui->menuHelp->insertActions(ui->menuHelp->actions().at(0), {
                                     luaConsoleDock->toggleViewAction(),
                                     languageInspectorDock->toggleViewAction(),
                                     editorInspectorDock->toggleViewAction(),
                                     debugLogDock->toggleViewAction(),
-                                    hexViewerDock->toggleViewAction()
+                                    hexViewerDock->toggleViewAction(),
+                                    memoryUsageDock->toggleViewAction()
                                 });
 
     FolderAsWorkspaceDock *fawDock = new FolderAsWorkspaceDock(this);
@@ -1747,6 +1775,16 @@ void MainWindow::detectLanguage(ScintillaNext *editor)
         const QString language_name = app->detectLanguage(editor);
 
         setLanguage(editor, language_name);
+
+        // An editor restored from a session has no text to look at until it is first shown
+        if (editor->isHibernating() && language_name == QStringLiteral("Text")) {
+            QSharedPointer<QMetaObject::Connection> connection(new QMetaObject::Connection);
+
+            *connection = connect(editor, &ScintillaNext::woken, this, [=]() {
+                disconnect(*connection);
+                detectLanguage(editor);
+            });
+        }
     }
 
     return;
@@ -1756,6 +1794,9 @@ void MainWindow::activateEditor(ScintillaNext *editor)
 {
     qInfo(Q_FUNC_INFO);
 
+    // Normally already done when it was shown, but everything below needs the text
+    editor->wake();
+
     checkFileForModification(editor);
     updateGui(editor);
 
@@ -21,6 +21,8 @@
 
 #include "MainWindow.h"
 
+#include <QLocale>
+
 
 static inline QString toBool(int b) {
     return b ? QStringLiteral("True") : QStringLiteral("False");
@@ -82,6 +84,7 @@ EditorInspectorDock::EditorInspectorDock(MainWindow *parent) :
 
     newItem(documentInfo, tr("Length"), [](ScintillaNext *editor) { return QString::number(editor->length()); });
     newItem(documentInfo, tr("Line Count"), [](ScintillaNext *editor) { return QString::number(editor->lineCount()); });
+    newItem(documentInfo, tr("Undo Memory"), [](ScintillaNext *editor) { return QLocale().formattedDataSize(editor->undoMemoryUsage()); });
 
 
     QTreeWidgetItem *viewInfo = new QTreeWidgetItem(ui->treeWidget);
@@ -91,6 +94,9 @@ EditorInspectorDock::EditorInspectorDock(MainWindow *parent) :
     newItem(viewInfo, tr("Lines on Screen"), [](ScintillaNext *editor) { return QString::number(editor->linesOnScreen()); });
     newItem(viewInfo, tr("First Visible Line"), [](ScintillaNext *editor) { return QString::number(editor->firstVisibleLine() + 1); });
     newItem(viewInfo, tr("X Offset"), [](ScintillaNext *editor) { return QString::number(editor->xOffset()); });
+    newItem(viewInfo, tr("Layout Threads"), [](ScintillaNext *editor) { return QString::number(editor->layoutThreads()); });
+    newItem(viewInfo, tr("Wrap Time (ns/KB)"), [](ScintillaNext *editor) { return QString::number(editor->wrapDuration(true)); });
+    newItem(viewInfo, tr("Wrap Time, All Threads (ns/KB)"), [](ScintillaNext *editor) { return QString::number(editor->wrapDuration(false)); });
 
 
     QTreeWidgetItem *foldInfo = new QTreeWidgetItem(ui->treeWidget);
@@ -16,7 +16,7 @@
  * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <QFontDatabase>
+#include <algorithm>
 
 #include "MainWindow.h"
 #include "ScintillaNext.h"
@@ -24,8 +24,6 @@
 #include "HexViewerDock.h"
 #include "ui_HexViewerDock.h"
 
-#include "EditorHexViewerTableModel.h"
-
 
 HexViewerDock::HexViewerDock(MainWindow *parent) :
     QDockWidget(parent),
@@ -33,9 +31,7 @@ HexViewerDock::HexViewerDock(MainWindow *parent) :
 {
     ui->setupUi(this);
 
-    // Set the font of the table to a monospaced font...not sure how best to do this
-    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont).family();
-    ui->tblHexView->setFont(font);
+    connect(ui->editFind, &QLineEdit::returnPressed, this, &HexViewerDock::find);
 
     connect(this, &QDockWidget::visibilityChanged, this, [=](bool visible) {
         if (visible) {
@@ -56,13 +52,29 @@ HexViewerDock::~HexViewerDock()
 
 void HexViewerDock::connectToEditor(ScintillaNext *editor)
 {
-    if (auto model = ui->tblHexView->model()) {
-        model->deleteLater();
+    ui->hexView->setEditor(editor);
+    ui->labelResult->clear();
+}
+
+void HexViewerDock::find()
+{
+    QByteArray bytes;
+
+    if (ui->checkBoxHex->isChecked()) {
+        const QByteArray hex = ui->editFind->text().toLatin1().replace(' ', QByteArray());
+
+        if (hex.size() % 2 != 0 || !std::all_of(hex.cbegin(), hex.cend(), [](char c) { return isxdigit(static_cast<unsigned char>(c)); })) {
+            ui->labelResult->setText(tr("Invalid hex"));
+            return;
+        }
+
+        bytes = QByteArray::fromHex(hex);
     }
+    else {
+        bytes = ui->editFind->text().toUtf8();
+    }
+
+    const bool found = ui->hexView->find(bytes);
 
-    EditorHexViewerTableModel *model = new EditorHexViewerTableModel(this);
-    model->setEditor(editor);
-    ui->tblHexView->setModel(model);
-    ui->tblHexView->resizeColumnsToContents();
-    ui->tblHexView->resizeRowsToContents();
+    ui->labelResult->setText(found ? QString() : tr("Not found"));
 }
@@ -38,6 +38,7 @@ public:
 
 private slots:
     void connectToEditor(ScintillaNext *editor);
+    void find();
 
 private:
 
@@ -0,0 +1,225 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "MemoryUsageDock.h"
+#include "ui_MemoryUsageDock.h"
+
+#include "MainWindow.h"
+#include "NotepadNextApplication.h"
+#include "EditorManager.h"
+#include "LuaState.h"
+
+#include <QLocale>
+#include <QScrollBar>
+#include <QSet>
+
+// How often the numbers are refreshed while the dock is visible
+const int REFRESH_INTERVAL = 2000;
+
+static const QVector<QPair<int, const char *>> Categories = {
+    {SC_MEMORY_TEXT, QT_TRANSLATE_NOOP("MemoryUsageDock", "Text")},
+    {SC_MEMORY_STYLES, QT_TRANSLATE_NOOP("MemoryUsageDock", "Styles")},
+    {SC_MEMORY_LINE_INDEX, QT_TRANSLATE_NOOP("MemoryUsageDock", "Line Index")},
+    {SC_MEMORY_LINE_DATA, QT_TRANSLATE_NOOP("MemoryUsageDock", "Markers, Folding and Annotations")},
+    {SC_MEMORY_UNDO, QT_TRANSLATE_NOOP("MemoryUsageDock", "Undo History")},
+    {SC_MEMORY_CHANGE_HISTORY, QT_TRANSLATE_NOOP("MemoryUsageDock", "Change History")},
+    {SC_MEMORY_DECORATIONS, QT_TRANSLATE_NOOP("MemoryUsageDock", "Indicators")},
+    {SC_MEMORY_LAYOUT_CACHE, QT_TRANSLATE_NOOP("MemoryUsageDock", "Layout Cache")},
+    {SC_MEMORY_POSITION_CACHE, QT_TRANSLATE_NOOP("MemoryUsageDock", "Position Cache")},
+};
+
+static QString FormatBytes(qint64 bytes)
+{
+    return QLocale().formattedDataSize(bytes);
+}
+
+static ScintillaNext *EditorFromItem(const QTreeWidgetItem *item)
+{
+    // Selecting one of the categories counts as selecting the editor
+    const QTreeWidgetItem *editorItem = item->parent() ? item->parent() : item;
+
+    return editorItem->data(0, Qt::UserRole).value<ScintillaNext *>();
+}
+
+static qint64 LuaMemory(LuaState *luaState)
+{
+    return qint64(lua_gc(luaState->L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(luaState->L, LUA_GCCOUNTB, 0);
+}
+
+MemoryUsageDock::MemoryUsageDock(MainWindow *parent) :
+    QDockWidget(parent),
+    ui(new Ui::MemoryUsageDock),
+    window(parent)
+{
+    qInfo(Q_FUNC_INFO);
+
+    ui->setupUi(this);
+
+    refreshTimer.setInterval(REFRESH_INTERVAL);
+    connect(&refreshTimer, &QTimer::timeout, this, &MemoryUsageDock::refresh);
+
+    connect(this, &QDockWidget::visibilityChanged, this, [=](bool visible) {
+        // Measuring walks the per-line data of every document, so only do it when someone is looking
+        if (visible) {
+            refresh();
+            refreshTimer.start();
+        }
+        else {
+            refreshTimer.stop();
+            ui->treeWidget->clear();
+        }
+    });
+
+    connect(ui->btnRefresh, &QToolButton::clicked, this, &MemoryUsageDock::refresh);
+    connect(ui->btnDropCaches, &QToolButton::clicked, this, &MemoryUsageDock::dropCaches);
+    connect(ui->btnClearUndo, &QToolButton::clicked, this, &MemoryUsageDock::clearUndo);
+    connect(ui->treeWidget, &QTreeWidget::itemSelectionChanged, this, &MemoryUsageDock::updateButtons);
+
+    connect(ui->treeWidget, &QTreeWidget::itemDoubleClicked, this, [=](QTreeWidgetItem *item) {
+        ScintillaNext *editor = EditorFromItem(item);
+
+        if (window->editors().contains(editor)) {
+            window->switchToEditor(editor);
+        }
+    });
+
+    updateButtons();
+}
+
+MemoryUsageDock::~MemoryUsageDock()
+{
+    delete ui;
+}
+
+void MemoryUsageDock::refresh()
+{
+    NotepadNextApplication *app = qobject_cast<NotepadNextApplication *>(qApp);
+
+    // Rebuilding the tree loses its state, so remember what was expanded and selected
+    QSet<const ScintillaNext *> expanded;
+    QSet<const ScintillaNext *> selected;
+
+    for (int i = 0; i < ui->treeWidget->topLevelItemCount(); ++i) {
+        const QTreeWidgetItem *item = ui->treeWidget->topLevelItem(i);
+        const ScintillaNext *editor = EditorFromItem(item);
+
+        if (item->isExpanded()) {
+            expanded.insert(editor);
+        }
+        if (item->isSelected()) {
+            selected.insert(editor);
+        }
+    }
+
+    // The biggest documents are the interesting ones so they go first
+    QVector<QPair<qint64, ScintillaNext *>> editors;
+    qint64 documentsTotal = 0;
+
+    for (ScintillaNext *editor : window->editors()) {
+        const qint64 total = editor->totalMemoryUsage();
+
+        editors.append(qMakePair(total, editor));
+        documentsTotal += total;
+    }
+
+    std::sort(editors.begin(), editors.end(), [](const QPair<qint64, ScintillaNext *> &a, const QPair<qint64, ScintillaNext *> &b) {
+        return a.first > b.first;
+    });
+
+    const int scrollPosition = ui->treeWidget->verticalScrollBar()->value();
+    const QSignalBlocker blocker(ui->treeWidget);
+    ui->treeWidget->clear();
+
+    for (const auto &pair : qAsConst(editors)) {
+        ScintillaNext *editor = pair.second;
+
+        QTreeWidgetItem *item = new QTreeWidgetItem(ui->treeWidget);
+        item->setText(0, editor->isHibernating() ? tr("%1 (hibernating)").arg(editor->getName()) : editor->getName());
+        item->setText(1, FormatBytes(pair.first));
+        item->setToolTip(0, editor->isFile() ? editor->getFilePath() : editor->getName());
+        item->setData(0, Qt::UserRole, QVariant::fromValue(editor));
+
+        for (const auto &category : Categories) {
+            QTreeWidgetItem *child = new QTreeWidgetItem(item);
+            child->setText(0, tr(category.second));
+            child->setText(1, FormatBytes(editor->memoryUsage(category.first)));
+        }
+
+        item->setExpanded(expanded.contains(editor));
+        item->setSelected(selected.contains(editor));
+    }
+
+    ui->treeWidget->resizeColumnToContents(0);
+    ui->treeWidget->verticalScrollBar()->setValue(scrollPosition);
+
+    ui->lblSummary->setText(tr("Documents: %1, Lua: %2, Released by hibernation: %3")
+                                .arg(FormatBytes(documentsTotal),
+                                     FormatBytes(LuaMemory(app->getLuaState())),
+                                     FormatBytes(app->getEditorManager()->reclaimedBytes())));
+
+    updateButtons();
+}
+
+void MemoryUsageDock::dropCaches()
+{
+    qInfo(Q_FUNC_INFO);
+
+    for (ScintillaNext *editor : selectedEditors()) {
+        editor->dropViewCaches();
+    }
+
+    refresh();
+}
+
+void MemoryUsageDock::clearUndo()
+{
+    qInfo(Q_FUNC_INFO);
+
+    for (ScintillaNext *editor : selectedEditors()) {
+        editor->clearUndoHistory();
+    }
+
+    refresh();
+}
+
+void MemoryUsageDock::updateButtons()
+{
+    const bool hasSelection = !ui->treeWidget->selectedItems().isEmpty();
+
+    ui->btnDropCaches->setEnabled(hasSelection);
+    ui->btnClearUndo->setEnabled(hasSelection);
+}
+
+QList<ScintillaNext *> MemoryUsageDock::selectedEditors() const
+{
+    // The tree is only as fresh as the last refresh, so make sure the editors are still open
+    const QVector<ScintillaNext *> openEditors = window->editors();
+    QList<ScintillaNext *> editors;
+
+    for (const QTreeWidgetItem *item : ui->treeWidget->selectedItems()) {
+        ScintillaNext *editor = EditorFromItem(item);
+
+        if (openEditors.contains(editor) && !editors.contains(editor)) {
+            editors.append(editor);
+        }
+    }
+
+    return editors;
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef MEMORYUSAGEDOCK_H
+#define MEMORYUSAGEDOCK_H
+
+#include <QDockWidget>
+#include <QTimer>
+
+namespace Ui {
+class MemoryUsageDock;
+}
+
+class MainWindow;
+class ScintillaNext;
+
+class MemoryUsageDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryUsageDock(MainWindow *parent);
+    ~MemoryUsageDock();
+
+private slots:
+    void refresh();
+    void dropCaches();
+    void clearUndo();
+    void updateButtons();
+
+private:
+    QList<ScintillaNext *> selectedEditors() const;
+
+    Ui::MemoryUsageDock *ui;
+    MainWindow *window;
+    QTimer refreshTimer;
+};
+
+#endif // MEMORYUSAGEDOCK_H
@@ -0,0 +1,75 @@
+local L = {}
+
+L.lexer = "log"
+
+-- Lexes fast enough to still be used for files opened in large file mode
+L.largeFiles = true
+
+L.extensions = {
+	"log",
+}
+
+L.properties = {
+	["fold.log.request"] = "1",
+}
+
+L.keywords = {
+	[0] = "fatal critical crit emerg emergency alert panic",
+	[1] = "error err severe failure",
+	[2] = "warning warn",
+	[3] = "info information notice",
+	[4] = "debug trace verbose fine finer finest",
+	[5] = "request_id requestid req_id req trace_id traceid correlation_id thread tid",
+}
+
+L.styles = {
+	["DEFAULT"] = {
+		id = 0,
+		fgColor = rgb(0x000000),
+		bgColor = rgb(0xFFFFFF),
+	},
+	["TIMESTAMP"] = {
+		id = 1,
+		fgColor = rgb(0x808080),
+		bgColor = rgb(0xFFFFFF),
+	},
+	["FATAL"] = {
+		id = 2,
+		fgColor = rgb(0xFFFFFF),
+		bgColor = rgb(0xC00000),
+		fontStyle = 1,
+	},
+	["ERROR"] = {
+		id = 3,
+		fgColor = rgb(0xFF0000),
+		bgColor = rgb(0xFFFFFF),
+		fontStyle = 1,
+	},
+	["WARNING"] = {
+		id = 4,
+		fgColor = rgb(0xFF8000),
+		bgColor = rgb(0xFFFFFF),
+		fontStyle = 1,
+	},
+	["INFO"] = {
+		id = 5,
+		fgColor = rgb(0x0000FF),
+		bgColor = rgb(0xFFFFFF),
+	},
+	["DEBUG"] = {
+		id = 6,
+		fgColor = rgb(0x808080),
+		bgColor = rgb(0xFFFFFF),
+	},
+	["IDENTIFIER"] = {
+		id = 7,
+		fgColor = rgb(0x8000FF),
+		bgColor = rgb(0xFFFFFF),
+	},
+	["CONTINUATION"] = {
+		id = 8,
+		fgColor = rgb(0x804000),
+		bgColor = rgb(0xFFFFFF),
+	},
+}
+return L
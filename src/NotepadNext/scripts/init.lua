@@ -145,6 +145,7 @@ languages["JSON"] = require("json")
 languages["KiXtart"] = require("kix")
 languages["LISP"] = require("lisp")
 languages["LaTeX"] = require("latex")
+languages["Log file"] = require("log")
 languages["Lua"] = require("lua")
 languages["Less"] = require("less")
 languages["Makefile"] = require("makefile")
@@ -0,0 +1,549 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <QFontDatabase>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+#include "HexView.h"
+#include "ByteArrayUtils.h"
+#include "PagedView.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define HEXVIEW_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HEXVIEW_NEON
+#endif
+
+
+using namespace Scintilla;
+
+const int BYTES_PER_ROW = 16;
+
+// Width in characters of the parts of a row: address, gap, hex bytes (with an extra space in the middle), gap, text
+const int ADDRESS_GAP = 2;
+const int HEX_WIDTH = BYTES_PER_ROW * 3 + 1;
+const int TEXT_GAP = 1;
+const int MAX_LINE_LENGTH = 16 + ADDRESS_GAP + HEX_WIDTH + TEXT_GAP + BYTES_PER_ROW;
+
+// Pixels to the left of the address
+const int MARGIN = 4;
+
+// Keeps the scroll bar within an int for very large data
+const qint64 MAX_SCROLL_STEPS = 1 << 30;
+
+// Amount of the document copied at a time when searching it
+const qint64 SEARCH_WINDOW = 4 * 1024 * 1024;
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+// Same as ByteArrayUtils::find() but the document is copied a window at a time, with enough overlap
+// for a match across two windows, instead of being joined into one piece with characterPointer()
+static qint64 FindInEditor(const ScintillaNext *editor, qint64 size, const QByteArray &bytes, qint64 from, bool forward)
+{
+    const qint64 overlap = bytes.size() - 1;
+
+    if (forward) {
+        for (qint64 start = qBound(Q_INT64_C(0), from, size); start < size; start += SEARCH_WINDOW) {
+            const QByteArray window = editor->textCopy(start, qMin(size, start + SEARCH_WINDOW + overlap));
+            const qint64 match = ByteArrayUtils::find(window.constData(), window.size(), bytes, 0, true);
+
+            if (match >= 0) {
+                return start + match;
+            }
+        }
+    }
+    else {
+        for (qint64 end = qBound(Q_INT64_C(0), from, size); end > 0; end -= SEARCH_WINDOW) {
+            const qint64 start = qMax(Q_INT64_C(0), end - SEARCH_WINDOW - overlap);
+            const QByteArray window = editor->textCopy(start, end);
+            const qint64 match = ByteArrayUtils::find(window.constData(), window.size(), bytes, window.size(), false);
+
+            if (match >= 0) {
+                return start + match;
+            }
+        }
+    }
+
+    return -1;
+}
+
+static constexpr int HexColumn(int addressDigits, int index)
+{
+    return addressDigits + ADDRESS_GAP + index * 3 + (index >= BYTES_PER_ROW / 2 ? 1 : 0);
+}
+
+static constexpr int TextColumn(int addressDigits, int index)
+{
+    return addressDigits + ADDRESS_GAP + HEX_WIDTH + TEXT_GAP + index;
+}
+
+// Writes two hex digits for every byte
+static void ToHex(const uchar *bytes, int length, char *out)
+{
+    int i = 0;
+
+#if defined(HEXVIEW_SSE2)
+    const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i letterOffset = _mm_set1_epi8('A' - '0' - 10);
+
+    for (; i + 16 <= length; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask);
+        const __m128i low = _mm_and_si128(v, nibbleMask);
+
+        // Interleave them so each byte's high digit comes first
+        __m128i first = _mm_unpacklo_epi8(high, low);
+        __m128i second = _mm_unpackhi_epi8(high, low);
+
+        first = _mm_add_epi8(_mm_add_epi8(first, zero), _mm_and_si128(_mm_cmpgt_epi8(first, nine), letterOffset));
+        second = _mm_add_epi8(_mm_add_epi8(second, zero), _mm_and_si128(_mm_cmpgt_epi8(second, nine), letterOffset));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2), first);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 2 + 16), second);
+    }
+#elif defined(HEXVIEW_NEON)
+    const uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t *>(HEX_DIGITS));
+
+    for (; i + 16 <= length; i += 16) {
+        const uint8x16_t v = vld1q_u8(bytes + i);
+        uint8x16x2_t hex;
+
+        hex.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(v, 4));
+        hex.val[1] = vqtbl1q_u8(digits, vandq_u8(v, vdupq_n_u8(0x0F)));
+
+        // Stores them interleaved
+        vst2q_u8(reinterpret_cast<uint8_t *>(out + i * 2), hex);
+    }
+#endif
+
+    for (; i < length; ++i) {
+        out[i * 2] = HEX_DIGITS[bytes[i] >> 4];
+        out[i * 2 + 1] = HEX_DIGITS[bytes[i] & 0x0F];
+    }
+}
+
+// Printable ASCII is kept as is, everything else becomes a '.'
+static void ToPrintable(const uchar *bytes, int length, char *out)
+{
+    int i = 0;
+
+#if defined(HEXVIEW_SSE2)
+    const __m128i space = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i dot = _mm_set1_epi8('.');
+
+    for (; i + 16 <= length; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+
+        // These are signed compares, so 0x80 and up are less than a space
+        const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, space), _mm_cmplt_epi8(v, del));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_or_si128(_mm_and_si128(printable, v), _mm_andnot_si128(printable, dot)));
+    }
+#elif defined(HEXVIEW_NEON)
+    for (; i + 16 <= length; i += 16) {
+        const uint8x16_t v = vld1q_u8(bytes + i);
+        const uint8x16_t printable = vandq_u8(vcgeq_u8(v, vdupq_n_u8(0x20)), vcltq_u8(v, vdupq_n_u8(0x7F)));
+
+        vst1q_u8(reinterpret_cast<uint8_t *>(out + i), vbslq_u8(printable, v, vdupq_n_u8('.')));
+    }
+#endif
+
+    for (; i < length; ++i) {
+        out[i] = (bytes[i] >= 0x20 && bytes[i] < 0x7F) ? static_cast<char>(bytes[i]) : '.';
+    }
+}
+
+static int FormatRow(char *line, qint64 address, int addressDigits, const uchar *bytes, int length)
+{
+    const int lineLength = TextColumn(addressDigits, BYTES_PER_ROW);
+    memset(line, ' ', lineLength);
+
+    uchar addressBytes[8];
+    char addressHex[16];
+    for (int i = 0; i < 8; ++i) {
+        addressBytes[i] = static_cast<uchar>(address >> (56 - i * 8));
+    }
+    ToHex(addressBytes, 8, addressHex);
+    memcpy(line, addressHex + 16 - addressDigits, addressDigits);
+
+    char hex[BYTES_PER_ROW * 2];
+    ToHex(bytes, length, hex);
+    for (int i = 0; i < length; ++i) {
+        memcpy(line + HexColumn(addressDigits, i), hex + i * 2, 2);
+    }
+
+    ToPrintable(bytes, length, line + TextColumn(addressDigits, 0));
+
+    return lineLength;
+}
+
+HexView::HexView(QWidget *parent) :
+    QAbstractScrollArea(parent)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    updateMetrics();
+}
+
+void HexView::setEditor(ScintillaNext *e)
+{
+    if (editor) {
+        disconnect(editor, Q_NULLPTR, this, Q_NULLPTR);
+    }
+
+    editor = e;
+    file = Q_NULLPTR;
+    topRow = 0;
+    cursor = 0;
+    lowNibble = false;
+
+    if (editor) {
+        // A paged view has the whole file mapped, the editor itself only has a small part of it
+        if (editor->isPagedView()) {
+            file = editor->findChild<PagedView *>(QString(), Qt::FindDirectChildrenOnly)->pagedFile();
+        }
+
+        connect(editor, &ScintillaNext::notify, this, [=](Scintilla::NotificationData *pscn) {
+            if (pscn->nmhdr.code == Notification::Modified && FlagSet(pscn->modificationType, ModificationFlags::InsertText | ModificationFlags::DeleteText)) {
+                updateScrollBars();
+                viewport()->update();
+            }
+        });
+        connect(editor, &ScintillaNext::reloaded, this, [=]() {
+            updateMetrics();
+            updateScrollBars();
+            setCursorPosition(cursor);
+        });
+    }
+
+    updateMetrics();
+    updateScrollBars();
+    viewport()->update();
+}
+
+void HexView::setCursorPosition(qint64 position)
+{
+    cursor = qBound(Q_INT64_C(0), position, qMax(Q_INT64_C(0), dataSize() - 1));
+    lowNibble = false;
+
+    ensureCursorVisible();
+    viewport()->update();
+}
+
+bool HexView::isEditable() const
+{
+    return editor && file == Q_NULLPTR && !editor->readOnly();
+}
+
+bool HexView::find(const QByteArray &bytes, bool forward)
+{
+    if (!editor || bytes.isEmpty()) {
+        return false;
+    }
+
+    // Directly searching the bytes allows any of them, including nulls
+    const qint64 size = dataSize();
+    const qint64 from = forward ? cursor + 1 : cursor + bytes.size() - 1;
+
+    auto search = [&](qint64 position) {
+        return file ? ByteArrayUtils::find(file->data(), size, bytes, position, forward) : FindInEditor(editor, size, bytes, position, forward);
+    };
+
+    qint64 match = search(from);
+
+    if (match < 0) {
+        match = search(forward ? 0 : size);
+    }
+
+    if (match < 0) {
+        return false;
+    }
+
+    setCursorPosition(match);
+
+    return true;
+}
+
+void HexView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    if (!editor) {
+        return;
+    }
+
+    QPainter painter(viewport());
+    painter.setFont(font());
+
+    // Only the rows that can be seen are ever looked at
+    const int rows = visibleRowCount() + 1;
+    const qint64 start = topRow * BYTES_PER_ROW;
+    const qint64 length = qBound(Q_INT64_C(0), dataSize() - start, qint64(rows) * BYTES_PER_ROW);
+    const uchar *bytes = length > 0 ? rangePointer(start, length) : Q_NULLPTR;
+
+    const int x = MARGIN - horizontalScrollBar()->value();
+    const int ascent = fontMetrics().ascent();
+    const QColor addressColor = palette().color(QPalette::Disabled, QPalette::Text);
+    const QColor textColor = palette().color(QPalette::Text);
+    const QColor cursorColor = palette().color(hasFocus() ? QPalette::Active : QPalette::Inactive, QPalette::Highlight);
+
+    char line[MAX_LINE_LENGTH];
+
+    for (int i = 0; i < rows; ++i) {
+        const qint64 offset = qint64(i) * BYTES_PER_ROW;
+
+        // Always show the first row, even if there is nothing in it
+        if (offset >= length && i > 0) {
+            break;
+        }
+
+        const int count = static_cast<int>(qMin(qint64(BYTES_PER_ROW), length - offset));
+        const int y = i * rowHeight;
+
+        if (cursor >= start + offset && cursor < start + offset + count) {
+            const int index = static_cast<int>(cursor - start - offset);
+            const int hexX = x + HexColumn(addressDigits, index) * charWidth;
+
+            painter.fillRect(hexX, y, 2 * charWidth, rowHeight, cursorColor);
+            painter.fillRect(x + TextColumn(addressDigits, index) * charWidth, y, charWidth, rowHeight, cursorColor);
+
+            // Show that the next digit typed goes into the low nibble
+            if (lowNibble) {
+                painter.fillRect(hexX + charWidth, y + rowHeight - 2, charWidth, 2, textColor);
+            }
+        }
+
+        const int lineLength = FormatRow(line, start + offset, addressDigits, bytes + offset, count);
+
+        painter.setPen(addressColor);
+        painter.drawText(x, y + ascent, QString::fromLatin1(line, addressDigits));
+        painter.setPen(textColor);
+        painter.drawText(x + addressDigits * charWidth, y + ascent, QString::fromLatin1(line + addressDigits, lineLength - addressDigits));
+    }
+}
+
+void HexView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+
+    updateScrollBars();
+}
+
+void HexView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx)
+
+    if (dy != 0) {
+        topRow = verticalScrollBar()->value() * rowsPerScrollStep;
+    }
+
+    viewport()->update();
+}
+
+void HexView::keyPressEvent(QKeyEvent *event)
+{
+    const qint64 rowStart = cursor - cursor % BYTES_PER_ROW;
+    const qint64 page = qint64(visibleRowCount()) * BYTES_PER_ROW;
+    const bool control = event->modifiers().testFlag(Qt::ControlModifier);
+
+    switch (event->key()) {
+    case Qt::Key_Left:
+        setCursorPosition(cursor - 1);
+        break;
+    case Qt::Key_Right:
+        setCursorPosition(cursor + 1);
+        break;
+    case Qt::Key_Up:
+        setCursorPosition(cursor - BYTES_PER_ROW);
+        break;
+    case Qt::Key_Down:
+        setCursorPosition(cursor + BYTES_PER_ROW);
+        break;
+    case Qt::Key_PageUp:
+        setCursorPosition(cursor - page);
+        break;
+    case Qt::Key_PageDown:
+        setCursorPosition(cursor + page);
+        break;
+    case Qt::Key_Home:
+        setCursorPosition(control ? 0 : rowStart);
+        break;
+    case Qt::Key_End:
+        setCursorPosition(control ? dataSize() - 1 : rowStart + BYTES_PER_ROW - 1);
+        break;
+    default: {
+        const QString text = event->text().toUpper();
+        const int value = text.size() == 1 ? QString::fromLatin1(HEX_DIGITS).indexOf(text.at(0)) : -1;
+
+        if (value >= 0 && isEditable()) {
+            editNibble(value);
+        }
+        else {
+            QAbstractScrollArea::keyPressEvent(event);
+        }
+        break;
+    }
+    }
+}
+
+void HexView::mousePressEvent(QMouseEvent *event)
+{
+    const qint64 position = positionAt(event->pos());
+
+    if (position >= 0) {
+        setCursorPosition(position);
+    }
+
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void HexView::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange) {
+        updateMetrics();
+        updateScrollBars();
+    }
+
+    QAbstractScrollArea::changeEvent(event);
+}
+
+qint64 HexView::dataSize() const
+{
+    if (!editor) {
+        return 0;
+    }
+
+    return file ? file->size() : editor->length();
+}
+
+const uchar *HexView::rangePointer(qint64 position, qint64 length) const
+{
+    if (file) {
+        return reinterpret_cast<const uchar *>(file->data()) + position;
+    }
+
+    // Unlike characterPointer() this only moves the gap if the range spans it
+    return reinterpret_cast<const uchar *>(editor->rangePointer(position, length));
+}
+
+qint64 HexView::rowCount() const
+{
+    return qMax(Q_INT64_C(1), (dataSize() + BYTES_PER_ROW - 1) / BYTES_PER_ROW);
+}
+
+int HexView::visibleRowCount() const
+{
+    return qMax(1, viewport()->height() / rowHeight);
+}
+
+void HexView::setTopRow(qint64 row)
+{
+    topRow = qBound(Q_INT64_C(0), row, qMax(Q_INT64_C(0), rowCount() - visibleRowCount()));
+
+    const QSignalBlocker blocker(verticalScrollBar());
+    verticalScrollBar()->setValue(static_cast<int>(topRow / rowsPerScrollStep));
+
+    viewport()->update();
+}
+
+void HexView::ensureCursorVisible()
+{
+    const qint64 row = cursor / BYTES_PER_ROW;
+
+    if (row < topRow) {
+        setTopRow(row);
+    }
+    else if (row >= topRow + visibleRowCount()) {
+        setTopRow(row - visibleRowCount() + 1);
+    }
+}
+
+void HexView::updateMetrics()
+{
+    addressDigits = dataSize() > 0xFFFFFFFF ? 16 : 8;
+    charWidth = qMax(1, fontMetrics().horizontalAdvance(QLatin1Char('0')));
+    rowHeight = qMax(1, fontMetrics().height());
+}
+
+void HexView::updateScrollBars()
+{
+    const qint64 scrollRows = qMax(Q_INT64_C(0), rowCount() - visibleRowCount());
+    rowsPerScrollStep = scrollRows / MAX_SCROLL_STEPS + 1;
+
+    {
+        const QSignalBlocker blocker(verticalScrollBar());
+        verticalScrollBar()->setRange(0, static_cast<int>(scrollRows / rowsPerScrollStep));
+        verticalScrollBar()->setPageStep(static_cast<int>(qMax(Q_INT64_C(1), visibleRowCount() / rowsPerScrollStep)));
+    }
+
+    // Keeps the top row in range if the data got smaller
+    setTopRow(topRow);
+
+    const int lineWidth = 2 * MARGIN + TextColumn(addressDigits, BYTES_PER_ROW) * charWidth;
+    horizontalScrollBar()->setRange(0, qMax(0, lineWidth - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+}
+
+qint64 HexView::positionAt(const QPoint &point) const
+{
+    const int column = (point.x() + horizontalScrollBar()->value() - MARGIN) / charWidth;
+    const qint64 row = topRow + point.y() / rowHeight;
+
+    for (int i = 0; i < BYTES_PER_ROW; ++i) {
+        const int hexColumn = HexColumn(addressDigits, i);
+
+        if ((column >= hexColumn && column < hexColumn + 2) || column == TextColumn(addressDigits, i)) {
+            const qint64 position = row * BYTES_PER_ROW + i;
+
+            return position < dataSize() ? position : -1;
+        }
+    }
+
+    return -1;
+}
+
+void HexView::editNibble(int value)
+{
+    if (cursor >= dataSize()) {
+        return;
+    }
+
+    const uchar current = *rangePointer(cursor, 1);
+    const char byte = static_cast<char>(lowNibble ? (current & 0xF0) | value : (value << 4) | (current & 0x0F));
+
+    editor->setTargetRange(cursor, cursor + 1);
+    editor->replaceTarget(1, &byte);
+
+    if (lowNibble) {
+        setCursorPosition(cursor + 1);
+    }
+    else {
+        lowNibble = true;
+        viewport()->update();
+    }
+}
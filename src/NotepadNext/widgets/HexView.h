@@ -0,0 +1,87 @@
+/*
+ * This file is part of Notepad Next.
+ * Copyright 2022 Justin Dailey
+ *
+ * Notepad Next is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Notepad Next is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Notepad Next.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef HEXVIEW_H
+#define HEXVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QPointer>
+
+#include "ScintillaNext.h"
+
+class PagedFile;
+
+
+// Hex view of an editor's bytes. Rows are painted straight from the editor's buffer (or the file mapping
+// for a paged view) and only the visible rows ever get formatted, so the size of the data does not matter.
+class HexView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit HexView(QWidget *parent = Q_NULLPTR);
+
+    void setEditor(ScintillaNext *editor);
+
+    qint64 cursorPosition() const { return cursor; }
+    void setCursorPosition(qint64 position);
+
+    bool isEditable() const;
+
+    // Searches starting after the cursor and wraps around, returns false if nothing was found
+    bool find(const QByteArray &bytes, bool forward = true);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void changeEvent(QEvent *event) override;
+
+private:
+    qint64 dataSize() const;
+    const uchar *rangePointer(qint64 position, qint64 length) const;
+
+    qint64 rowCount() const;
+    int visibleRowCount() const;
+    void setTopRow(qint64 row);
+    void ensureCursorVisible();
+    void updateMetrics();
+    void updateScrollBars();
+
+    qint64 positionAt(const QPoint &point) const;
+    void editNibble(int value);
+
+    QPointer<ScintillaNext> editor;
+    const PagedFile *file = Q_NULLPTR;
+    QMetaObject::Connection editorConnection;
+
+    qint64 topRow = 0;
+    qint64 rowsPerScrollStep = 1;
+    qint64 cursor = 0;
+    bool lowNibble = false;
+
+    int addressDigits = 8;
+    int charWidth = 1;
+    int rowHeight = 1;
+};
+
+#endif // HEXVIEW_H
@@ -153,6 +153,7 @@
 #define SCLEX_DART 138
 #define SCLEX_ZIG 139
 #define SCLEX_NIX 140
+#define SCLEX_LOG 141
 #define SCLEX_AUTOMATIC 1000
 #define SCE_P_DEFAULT 0
 #define SCE_P_COMMENTLINE 1
@@ -2188,6 +2189,15 @@
 #define SCE_NIX_KEYWORD3 14
 #define SCE_NIX_KEYWORD4 15
 #define SCE_NIX_STRINGEOL 16
+#define SCE_LOG_DEFAULT 0
+#define SCE_LOG_TIMESTAMP 1
+#define SCE_LOG_FATAL 2
+#define SCE_LOG_ERROR 3
+#define SCE_LOG_WARNING 4
+#define SCE_LOG_INFO 5
+#define SCE_LOG_DEBUG 6
+#define SCE_LOG_IDENTIFIER 7
+#define SCE_LOG_CONTINUATION 8
 /* --Autogenerated -- end of section automatically generated from Scintilla.iface */
 
 #endif
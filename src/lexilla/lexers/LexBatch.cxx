@@ -643,4 +643,4 @@ const char *const batchWordListDesc[] = {
 
 }
 
-extern const LexerModule lmBatch(SCLEX_BATCH, ColouriseBatchDoc, "batch", nullptr, batchWordListDesc);
+extern const LexerModule lmBatch(SCLEX_BATCH, ColouriseBatchDoc, "batch", nullptr, batchWordListDesc, nullptr, 0, Scintilla::lcLineStart);
@@ -852,6 +852,7 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 		}
 	}
 
+	styler.DirectAccess(startPos, length);
 	StyleContext sc(startPos, length, initStyle, styler);
 	LinePPState preproc = vlls.ForLine(lineCurrent);
 
@@ -1495,6 +1496,7 @@ void SCI_METHOD LexerCPP::Fold(Sci_PositionU startPos, Sci_Position length, int
 		return;
 
 	LexAccessor styler(pAccess);
+	styler.DirectAccess(startPos, length);
 
 	const Sci_PositionU endPos = startPos + length;
 	int visibleChars = 0;
@@ -152,4 +152,4 @@ const char *const emptyWordListDesc[] = {
 
 }
 
-extern const LexerModule lmDiff(SCLEX_DIFF, ColouriseDiffDoc, "diff", FoldDiffDoc, emptyWordListDesc);
+extern const LexerModule lmDiff(SCLEX_DIFF, ColouriseDiffDoc, "diff", FoldDiffDoc, emptyWordListDesc, nullptr, 0, Scintilla::lcLineStart);
@@ -428,4 +428,4 @@ const char *const emptyWordListDesc[] = {
 
 }
 
-extern const LexerModule lmErrorList(SCLEX_ERRORLIST, ColouriseErrorListDoc, "errorlist", nullptr, emptyWordListDesc);
+extern const LexerModule lmErrorList(SCLEX_ERRORLIST, ColouriseErrorListDoc, "errorlist", nullptr, emptyWordListDesc, nullptr, 0, Scintilla::lcLineStart);
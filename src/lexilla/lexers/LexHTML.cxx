@@ -1217,6 +1217,7 @@ void SCI_METHOD LexerHTML::Lex(Sci_PositionU startPos, Sci_Position length, int
 			state = isPHPScript ? SCE_HPHP_DEFAULT : SCE_H_DEFAULT;
 		}
 	}
+	styler.DirectAccess(startPos, length);
 	styler.StartAt(startPos);
 
 	/* Nothing handles getting out of these, so we need not start in any of them.
@@ -280,6 +280,7 @@ void SCI_METHOD LexerJSON::Lex(Sci_PositionU startPos,
 							   int initStyle,
 							   IDocument *pAccess) {
 	LexAccessor styler(pAccess);
+	styler.DirectAccess(startPos, length);
 	StyleContext context(startPos, length, initStyle, styler);
 	int stringStyleBefore = SCE_JSON_STRING;
 	while (context.More()) {
@@ -461,6 +462,7 @@ void SCI_METHOD LexerJSON::Fold(Sci_PositionU startPos,
 		return;
 	}
 	LexAccessor styler(pAccess);
+	styler.DirectAccess(startPos, length);
 	Sci_PositionU currLine = styler.GetLine(startPos);
 	Sci_PositionU endPos = startPos + length;
 	int currLevel = SC_FOLDLEVELBASE;
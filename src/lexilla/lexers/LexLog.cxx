@@ -0,0 +1,854 @@
+// Scintilla source code edit control
+/** @file LexLog.cxx
+ ** Lexer for log files.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+// Each line is classified on its own: a header line may start with a timestamp followed by thread
+// or request ids and a severity, while lines starting with white space or "Caused by:" continue the
+// message above such as a stack trace. Only the start of a header line is examined so the message
+// text is styled without being scanned. Text is read straight from document memory when the
+// document allows it. Vector comparisons of 16 bytes at a time find line ends and, once the
+// severity is known, the next delimiter that can start a span. Timestamp patterns are compiled to
+// masks of digits, letters and literal characters which are checked against the classes of 16
+// bytes at a time. Words are only looked up when their first character and length may be in a
+// list.
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+
+#include "WordList.h"
+#include "LexAccessor.h"
+#include "CharacterSet.h"
+#include "LexerModule.h"
+#include "OptionSet.h"
+#include "DefaultLexer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define LEXLOG_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LEXLOG_NEON
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace Scintilla;
+using namespace Lexilla;
+
+namespace {
+
+// '#' matches a digit, '@' a letter, '?' any character, '*' any run of fractional seconds and zone
+// characters and other characters match themselves. Alternatives are separated by '|'.
+constexpr std::string_view defaultTimestamps =
+	"####-##-##?##:##:##*|####/##/##?##:##:##*|@@@ ?# ##:##:##*|##:##:##*";
+
+constexpr int lineStateContinuation = 1;
+constexpr int lineStateIdShift = 1;
+constexpr unsigned int maxId = 0x3FFFFFFF;
+
+// Styles are sent to the document in batches of this size.
+constexpr size_t styleBatchSize = 0x10000;
+
+// Longest word checked against the severity and key lists.
+constexpr size_t maxWordLength = 31;
+
+constexpr bool IsWordChar(char ch) noexcept {
+	return IsAlphaNumeric(ch) || ch == '_';
+}
+
+constexpr bool IsIdEnd(char ch) noexcept {
+	return isspacechar(ch) || AnyOf(ch, ',', ';', ']', ')', '"');
+}
+
+constexpr bool IsZoneChar(char ch) noexcept {
+	return IsADigit(ch) || AnyOf(ch, '.', ',', ':', '+', '-', 'Z');
+}
+
+bool StartsWith(std::string_view text, std::string_view prefix) noexcept {
+	return text.substr(0, prefix.length()) == prefix;
+}
+
+constexpr size_t vectorSize = 16;
+
+// Position of the lowest set bit of a mask that is not 0.
+unsigned int LowestBit(unsigned int mask) noexcept {
+	assert(mask);
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+	unsigned long index = 0;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	unsigned int index = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+#if defined(LEXLOG_SSE2)
+
+using Vector = __m128i;
+
+Vector Load(const char *s) noexcept {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+}
+
+Vector Splat(char ch) noexcept {
+	return _mm_set1_epi8(ch);
+}
+
+// Bytes of v with unsigned values from low to high.
+Vector Within(Vector v, unsigned char low, unsigned char high) noexcept {
+	const __m128i offset = _mm_sub_epi8(v, Splat(static_cast<char>(low)));
+	const __m128i range = Splat(static_cast<char>(high - low));
+	return _mm_cmpeq_epi8(_mm_min_epu8(offset, range), offset);
+}
+
+Vector Equal(Vector a, Vector b) noexcept {
+	return _mm_cmpeq_epi8(a, b);
+}
+
+Vector Either(Vector a, Vector b) noexcept {
+	return _mm_or_si128(a, b);
+}
+
+unsigned int MoveMask(Vector v) noexcept {
+	return _mm_movemask_epi8(v);
+}
+
+#elif defined(LEXLOG_NEON)
+
+using Vector = uint8x16_t;
+
+Vector Load(const char *s) noexcept {
+	return vld1q_u8(reinterpret_cast<const uint8_t *>(s));
+}
+
+Vector Splat(char ch) noexcept {
+	return vdupq_n_u8(static_cast<unsigned char>(ch));
+}
+
+Vector Within(Vector v, unsigned char low, unsigned char high) noexcept {
+	return vcleq_u8(vsubq_u8(v, Splat(static_cast<char>(low))), Splat(static_cast<char>(high - low)));
+}
+
+Vector Equal(Vector a, Vector b) noexcept {
+	return vceqq_u8(a, b);
+}
+
+Vector Either(Vector a, Vector b) noexcept {
+	return vorrq_u8(a, b);
+}
+
+// Each byte of v is 0 or 0xFF so keeping a different bit of each half's bytes and adding them
+// gives the mask of the half.
+unsigned int MoveMask(Vector v) noexcept {
+	static constexpr uint8_t bitValues[vectorSize] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	const uint8x16_t bits = vandq_u8(v, vld1q_u8(bitValues));
+	return vaddv_u8(vget_low_u8(bits)) | (vaddv_u8(vget_high_u8(bits)) << 8);
+}
+
+#endif
+
+// Classes of 16 bytes with bit n of each mask set when byte n is in the class.
+struct ByteClasses {
+	unsigned int digits = 0;
+	unsigned int letters = 0;
+	// Bytes that are the same as the bytes they are compared with
+	unsigned int same = 0;
+};
+
+// Classify the 16 bytes at s and compare them with the 16 bytes at t.
+ByteClasses ClassifyBytes(const char *s, const char *t) noexcept {
+	ByteClasses classes;
+#if defined(LEXLOG_SSE2) || defined(LEXLOG_NEON)
+	const Vector v = Load(s);
+	classes.digits = MoveMask(Within(v, '0', '9'));
+	// Setting bit 5 makes upper case letters lower case
+	classes.letters = MoveMask(Within(Either(v, Splat(0x20)), 'a', 'z'));
+	classes.same = MoveMask(Equal(v, Load(t)));
+#else
+	for (unsigned int i = 0; i < vectorSize; i++) {
+		const unsigned int bit = 1U << i;
+		classes.digits |= IsADigit(s[i]) ? bit : 0;
+		classes.letters |= IsUpperOrLowerCase(s[i]) ? bit : 0;
+		classes.same |= (s[i] == t[i]) ? bit : 0;
+	}
+#endif
+	return classes;
+}
+
+// The 16 bytes of text from start. Bytes after text may be past the end of the document so when
+// there are fewer than 16 the rest are copied to padded followed by NULs, which are in no class.
+const char *VectorAt(std::string_view text, size_t start, char (&padded)[vectorSize]) noexcept {
+	if (start + vectorSize <= text.length()) {
+		return text.data() + start;
+	}
+	std::fill(std::begin(padded), std::end(padded), '\0');
+	if (start < text.length()) {
+		memcpy(padded, text.data() + start, text.length() - start);
+	}
+	return padded;
+}
+
+#if defined(LEXLOG_SSE2) || defined(LEXLOG_NEON)
+
+// Bytes of v that are any of the characters.
+template <char first, char... rest>
+Vector EqualAny(Vector v) noexcept {
+	if constexpr (sizeof...(rest) == 0) {
+		return Equal(v, Splat(first));
+	} else {
+		return Either(Equal(v, Splat(first)), EqualAny<rest...>(v));
+	}
+}
+
+#endif
+
+// Position of the first byte of text that is one of the characters or the length of text when
+// there is none. Compares 16 bytes at a time with every character.
+template <char... characters>
+size_t FindAny(std::string_view text) noexcept {
+	size_t i = 0;
+#if defined(LEXLOG_SSE2) || defined(LEXLOG_NEON)
+	for (; i + vectorSize <= text.length(); i += vectorSize) {
+		const unsigned int found = MoveMask(EqualAny<characters...>(Load(text.data() + i)));
+		if (found) {
+			return i + LowestBit(found);
+		}
+	}
+#endif
+	for (; i < text.length(); i++) {
+		if (((text[i] == characters) || ...)) {
+			break;
+		}
+	}
+	return i;
+}
+
+// Return the length of text matched by pattern or 0.
+size_t MatchPattern(std::string_view pattern, std::string_view text) noexcept {
+	size_t pos = 0;
+	for (const char p : pattern) {
+		if (p == '*') {
+			while (pos < text.length() && IsZoneChar(text[pos])) {
+				pos++;
+			}
+			continue;
+		}
+		if (pos >= text.length()) {
+			return 0;
+		}
+		const char ch = text[pos];
+		const bool matched = (p == '#') ? IsADigit(ch) :
+			(p == '@') ? IsUpperOrLowerCase(ch) :
+			(p == '?') ? true : (p == ch);
+		if (!matched) {
+			return 0;
+		}
+		pos++;
+	}
+	return pos;
+}
+
+// A timestamp pattern split at each '*' into pieces of fixed length. Each piece is matched 16
+// bytes at a time by checking the classes of the bytes and the bytes themselves against masks
+// made from the piece.
+class TimestampPattern {
+	struct Piece {
+		size_t length = 0;
+		// Characters of the piece padded with NULs to a multiple of 16
+		std::string characters;
+		uint64_t digits = 0;
+		uint64_t letters = 0;
+		// Positions of characters matching themselves
+		uint64_t literals = 0;
+		bool zoneAfter = false;
+	};
+	std::string pattern;
+	std::vector<Piece> pieces;
+	// Patterns with pieces longer than the 64 bits of a mask are matched byte by byte
+	bool masked = true;
+public:
+	explicit TimestampPattern(std::string_view pattern_);
+	size_t Match(std::string_view text, size_t start) const noexcept;
+};
+
+TimestampPattern::TimestampPattern(std::string_view pattern_) : pattern(pattern_) {
+	pieces.emplace_back();
+	for (const char p : pattern) {
+		Piece &piece = pieces.back();
+		if (p == '*') {
+			piece.zoneAfter = true;
+			pieces.emplace_back();
+			continue;
+		}
+		if (piece.length >= 64) {
+			masked = false;
+			return;
+		}
+		const uint64_t bit = UINT64_C(1) << piece.length;
+		if (p == '#') {
+			piece.digits |= bit;
+		} else if (p == '@') {
+			piece.letters |= bit;
+		} else if (p != '?') {
+			piece.literals |= bit;
+		}
+		piece.characters.push_back(p);
+		piece.length++;
+	}
+	for (Piece &piece : pieces) {
+		piece.characters.resize((piece.length + vectorSize - 1) / vectorSize * vectorSize);
+	}
+}
+
+// Return the length of text matched from start or 0, the same as MatchPattern.
+size_t TimestampPattern::Match(std::string_view text, size_t start) const noexcept {
+	if (!masked) {
+		return MatchPattern(pattern, text.substr(start));
+	}
+	constexpr uint64_t vectorMask = 0xFFFF;
+	size_t pos = start;
+	for (const Piece &piece : pieces) {
+		if (piece.length > text.length() - pos) {
+			return 0;
+		}
+		for (size_t offset = 0; offset < piece.length; offset += vectorSize) {
+			char padded[vectorSize];
+			const char *bytes = VectorAt(text, pos + offset, padded);
+			const ByteClasses classes = ClassifyBytes(bytes, piece.characters.data() + offset);
+			const unsigned int digits = static_cast<unsigned int>((piece.digits >> offset) & vectorMask);
+			const unsigned int letters = static_cast<unsigned int>((piece.letters >> offset) & vectorMask);
+			const unsigned int literals = static_cast<unsigned int>((piece.literals >> offset) & vectorMask);
+			if (((classes.digits & digits) != digits) || ((classes.letters & letters) != letters) ||
+				((classes.same & literals) != literals)) {
+				return 0;
+			}
+		}
+		pos += piece.length;
+		if (piece.zoneAfter) {
+			while (pos < text.length() && IsZoneChar(text[pos])) {
+				pos++;
+			}
+		}
+	}
+	return pos - start;
+}
+
+// FNV-1a hash of an id reduced to a non-zero value that fits in a line state.
+int HashId(std::string_view id) noexcept {
+	unsigned int hash = 2166136261U;
+	for (const char ch : id) {
+		hash ^= static_cast<unsigned char>(ch);
+		hash *= 16777619U;
+	}
+	return static_cast<int>(hash % maxId) + 1;
+}
+
+// Lengths of the words of a word list by their first character in either case, so most words that
+// are not in the list are rejected without being lowered and looked up. A list with '^' prefix
+// words may contain any word.
+class WordFilter {
+	// Bit n is set when a word of length n starts with the character
+	uint32_t lengths[256] {};
+	bool prefixes = false;
+	static_assert(maxWordLength < 32);
+public:
+	void Set(const WordList &wordList) noexcept {
+		std::fill(std::begin(lengths), std::end(lengths), 0);
+		prefixes = false;
+		for (int i = 0; i < wordList.Length(); i++) {
+			const std::string_view word = wordList.WordAt(i);
+			if (!word.empty() && word.front() == '^') {
+				prefixes = true;
+			} else if (!word.empty() && word.length() <= maxWordLength) {
+				const uint32_t bit = 1U << word.length();
+				lengths[static_cast<unsigned char>(MakeLowerCase(word.front()))] |= bit;
+				lengths[static_cast<unsigned char>(MakeUpperCase(word.front()))] |= bit;
+			}
+		}
+	}
+	bool MayContain(std::string_view word) const noexcept {
+		return !word.empty() && word.length() <= maxWordLength &&
+			(prefixes || ((lengths[static_cast<unsigned char>(word.front())] >> word.length()) & 1));
+	}
+};
+
+constexpr bool IsContinuation(int lineState) noexcept {
+	return (lineState & lineStateContinuation) != 0;
+}
+
+constexpr int IdOf(int lineState) noexcept {
+	return lineState >> lineStateIdShift;
+}
+
+struct OptionsLog {
+	std::string timestamp;
+	int headerWidth = 160;
+	bool severityLine = false;
+	bool fold = false;
+	bool foldRequest = false;
+};
+
+const char *const logWordListDesc[] = {
+	"Fatal severities",
+	"Error severities",
+	"Warning severities",
+	"Information severities",
+	"Debug and trace severities",
+	"Thread and request id keys",
+	nullptr
+};
+
+struct OptionSetLog : public OptionSet<OptionsLog> {
+	OptionSetLog() {
+		DefineProperty("lexer.log.timestamp", &OptionsLog::timestamp,
+			"Timestamp patterns matched at the start of a line, separated by '|'. "
+			"'#' matches a digit, '@' a letter, '?' any character and '*' fractional seconds and time zone. "
+			"When empty, common ISO 8601, syslog and time only forms are recognised.");
+
+		DefineProperty("lexer.log.header.width", &OptionsLog::headerWidth,
+			"Number of characters at the start of a line searched for severities and ids. Default is 160.");
+
+		DefineProperty("lexer.log.severity.line", &OptionsLog::severityLine,
+			"Set to 1 to style the whole message in the style of its severity.");
+
+		DefineProperty("fold", &OptionsLog::fold);
+
+		DefineProperty("fold.log.request", &OptionsLog::foldRequest,
+			"Set to 1 to fold consecutive lines with the same thread or request id under the first.");
+
+		DefineWordListSets(logWordListDesc);
+	}
+};
+
+LexicalClass lexicalClasses[] = {
+	// Lexer Log SCLEX_LOG SCE_LOG_:
+	0, "SCE_LOG_DEFAULT", "default", "Message text",
+	1, "SCE_LOG_TIMESTAMP", "literal", "Timestamp",
+	2, "SCE_LOG_FATAL", "error", "Fatal severity",
+	3, "SCE_LOG_ERROR", "error", "Error severity",
+	4, "SCE_LOG_WARNING", "keyword", "Warning severity",
+	5, "SCE_LOG_INFO", "keyword", "Information severity",
+	6, "SCE_LOG_DEBUG", "keyword", "Debug and trace severity",
+	7, "SCE_LOG_IDENTIFIER", "identifier", "Thread or request id",
+	8, "SCE_LOG_CONTINUATION", "comment", "Stack trace or other continuation of a message",
+};
+
+struct Span {
+	size_t start;
+	size_t end;
+	int style;
+};
+
+// Header line classification results: spans and severity styles relative to the line start.
+struct LineClass {
+	std::vector<Span> spans;
+	int severity = SCE_LOG_DEFAULT;
+	int id = 0;
+	bool continuation = false;
+};
+
+class LexerLog : public DefaultLexer {
+	OptionsLog options;
+	OptionSetLog osLog;
+	// Severity lists from fatal to debug give styles SCE_LOG_FATAL to SCE_LOG_DEBUG.
+	WordList severities[SCE_LOG_DEBUG - SCE_LOG_FATAL + 1];
+	WordList idKeys;
+	std::vector<TimestampPattern> timestamps;
+	// Quick rejection of words that can not be in each list before lowering and looking them up.
+	WordFilter severityFilters[SCE_LOG_DEBUG - SCE_LOG_FATAL + 1];
+	WordFilter idKeyFilter;
+
+	void SetTimestamps();
+	void SetFilters();
+	int SeverityStyle(std::string_view word) const noexcept;
+	size_t MatchTimestamp(std::string_view text) const noexcept;
+	size_t IdValueEnd(std::string_view text, std::string_view word, size_t end, LineClass &lc) const;
+	void Classify(std::string_view text, LineClass &lc) const;
+
+public:
+	LexerLog() :
+		DefaultLexer("log", SCLEX_LOG, lexicalClasses, std::size(lexicalClasses)) {
+		SetTimestamps();
+	}
+	// Deleted so LexerLog objects can not be copied.
+	LexerLog(const LexerLog &) = delete;
+	LexerLog(LexerLog &&) = delete;
+	void operator=(const LexerLog &) = delete;
+	void operator=(LexerLog &&) = delete;
+	~LexerLog() override = default;
+
+	void SCI_METHOD Release() override {
+		delete this;
+	}
+	const char *SCI_METHOD PropertyNames() override {
+		return osLog.PropertyNames();
+	}
+	int SCI_METHOD PropertyType(const char *name) override {
+		return osLog.PropertyType(name);
+	}
+	const char *SCI_METHOD DescribeProperty(const char *name) override {
+		return osLog.DescribeProperty(name);
+	}
+	Sci_Position SCI_METHOD PropertySet(const char *key, const char *val) override;
+	const char *SCI_METHOD PropertyGet(const char *key) override {
+		return osLog.PropertyGet(key);
+	}
+	const char *SCI_METHOD DescribeWordListSets() override {
+		return osLog.DescribeWordListSets();
+	}
+	Sci_Position SCI_METHOD WordListSet(int n, const char *wl) override;
+
+	void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess) override;
+	void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess) override;
+
+	// Lines are lexed independently so ranges can be lexed concurrently.
+	int SCI_METHOD Checkpoint() override {
+		return lcLineStart;
+	}
+
+	static ILexer5 *LexerFactoryLog() {
+		return new LexerLog();
+	}
+};
+
+Sci_Position SCI_METHOD LexerLog::PropertySet(const char *key, const char *val) {
+	if (osLog.PropertySet(&options, key, val)) {
+		SetTimestamps();
+		return 0;
+	}
+	return -1;
+}
+
+Sci_Position SCI_METHOD LexerLog::WordListSet(int n, const char *wl) {
+	WordList *wordListN = nullptr;
+	if (n >= 0 && n < static_cast<int>(std::size(severities))) {
+		wordListN = &severities[n];
+	} else if (n == static_cast<int>(std::size(severities))) {
+		wordListN = &idKeys;
+	}
+	Sci_Position firstModification = -1;
+	if (wordListN && wordListN->Set(wl, true)) {
+		firstModification = 0;
+		SetFilters();
+	}
+	return firstModification;
+}
+
+void LexerLog::SetFilters() {
+	for (size_t i = 0; i < std::size(severities); i++) {
+		severityFilters[i].Set(severities[i]);
+	}
+	idKeyFilter.Set(idKeys);
+}
+
+void LexerLog::SetTimestamps() {
+	timestamps.clear();
+	std::string_view patterns = options.timestamp.empty() ? defaultTimestamps : options.timestamp;
+	while (!patterns.empty()) {
+		const size_t separator = std::min(patterns.find('|'), patterns.length());
+		if (separator > 0) {
+			timestamps.emplace_back(patterns.substr(0, separator));
+		}
+		patterns.remove_prefix(std::min(separator + 1, patterns.length()));
+	}
+}
+
+int LexerLog::SeverityStyle(std::string_view word) const noexcept {
+	char lowered[maxWordLength + 1];
+	std::string_view sv;
+	for (size_t i = 0; i < std::size(severities); i++) {
+		if (severityFilters[i].MayContain(word)) {
+			if (sv.empty()) {
+				for (size_t j = 0; j < word.length(); j++) {
+					lowered[j] = MakeLowerCase(word[j]);
+				}
+				sv = std::string_view(lowered, word.length());
+			}
+			if (severities[i].InList(sv)) {
+				return SCE_LOG_FATAL + static_cast<int>(i);
+			}
+		}
+	}
+	return SCE_LOG_DEFAULT;
+}
+
+size_t LexerLog::MatchTimestamp(std::string_view text) const noexcept {
+	const bool bracketed = !text.empty() && text.front() == '[';
+	const size_t start = bracketed ? 1 : 0;
+	for (const TimestampPattern &pattern : timestamps) {
+		const size_t matched = pattern.Match(text, start);
+		if (matched) {
+			if (!bracketed) {
+				return matched;
+			}
+			if (start + matched < text.length() && text[start + matched] == ']') {
+				return matched + 2;
+			}
+		}
+	}
+	return 0;
+}
+
+// When word is an id key followed by '=' or ':' at end, add a span for its value and return the
+// end of the value, otherwise return end.
+size_t LexerLog::IdValueEnd(std::string_view text, std::string_view word, size_t end, LineClass &lc) const {
+	if (end >= text.length() || (text[end] != '=' && text[end] != ':') || !idKeyFilter.MayContain(word)) {
+		return end;
+	}
+	char lowered[maxWordLength + 1];
+	for (size_t i = 0; i < word.length(); i++) {
+		lowered[i] = MakeLowerCase(word[i]);
+	}
+	if (!idKeys.InList(std::string_view(lowered, word.length()))) {
+		return end;
+	}
+	const size_t valueStart = end + 1;
+	size_t valueEnd = valueStart;
+	while (valueEnd < text.length() && !IsIdEnd(text[valueEnd])) {
+		valueEnd++;
+	}
+	if (valueEnd == valueStart) {
+		return end;
+	}
+	lc.spans.push_back({valueStart, valueEnd, SCE_LOG_IDENTIFIER});
+	if (!lc.id) {
+		lc.id = HashId(text.substr(valueStart, valueEnd - valueStart));
+	}
+	return valueEnd;
+}
+
+void LexerLog::Classify(std::string_view text, LineClass &lc) const {
+	lc.spans.clear();
+	lc.severity = SCE_LOG_DEFAULT;
+	lc.id = 0;
+	lc.continuation = !text.empty() &&
+		(isspacechar(text.front()) || StartsWith(text, "Caused by:") || StartsWith(text, "Traceback "));
+	if (lc.continuation) {
+		lc.spans.push_back({0, text.length(), SCE_LOG_CONTINUATION});
+		return;
+	}
+
+	size_t pos = MatchTimestamp(text);
+	if (pos) {
+		lc.spans.push_back({0, pos, SCE_LOG_TIMESTAMP});
+	}
+
+	const size_t headerEnd = std::min(text.length(), static_cast<size_t>(std::max(options.headerWidth, 0)));
+	// An id key starting inside the header may end after it
+	const size_t delimiterEnd = std::min(text.length(), headerEnd + maxWordLength + 1);
+	while (pos < headerEnd) {
+		if (lc.severity != SCE_LOG_DEFAULT) {
+			// Skip over words that can not be id keys straight to the next delimiter
+			const size_t delimiter = pos + FindAny<'[', '=', ':'>(text.substr(pos, delimiterEnd - pos));
+			if (delimiter >= delimiterEnd) {
+				break;
+			}
+			size_t wordStart = delimiter;
+			while (wordStart > pos && IsWordChar(text[wordStart - 1])) {
+				wordStart--;
+			}
+			if (wordStart >= headerEnd) {
+				break;
+			}
+			if (text[delimiter] == '[') {
+				if (delimiter >= headerEnd) {
+					break;
+				}
+				pos = delimiter;
+			} else {
+				// The word before the delimiter is already known so only check whether it is a key
+				pos = std::max(IdValueEnd(text, text.substr(wordStart, delimiter - wordStart), delimiter, lc), delimiter + 1);
+				continue;
+			}
+		}
+		const char ch = text[pos];
+		if (ch == '[') {
+			const void *close = memchr(text.data() + pos, ']', text.length() - pos);
+			if (!close) {
+				break;
+			}
+			const size_t end = static_cast<const char *>(close) - text.data() + 1;
+			const std::string_view inside = text.substr(pos + 1, end - pos - 2);
+			int style = SCE_LOG_IDENTIFIER;
+			if (lc.severity == SCE_LOG_DEFAULT) {
+				const int severity = SeverityStyle(inside);
+				if (severity != SCE_LOG_DEFAULT) {
+					lc.severity = severity;
+					style = severity;
+				}
+			}
+			lc.spans.push_back({pos, end, style});
+			pos = end;
+		} else if (IsWordChar(ch)) {
+			size_t end = pos + 1;
+			while (end < text.length() && IsWordChar(text[end])) {
+				end++;
+			}
+			const std::string_view word = text.substr(pos, end - pos);
+			if (lc.severity == SCE_LOG_DEFAULT) {
+				const int severity = SeverityStyle(word);
+				if (severity != SCE_LOG_DEFAULT) {
+					lc.severity = severity;
+					lc.spans.push_back({pos, end, severity});
+				}
+			}
+			pos = IdValueEnd(text, word, end, lc);
+		} else {
+			pos++;
+		}
+	}
+}
+
+void SCI_METHOD LexerLog::Lex(Sci_PositionU startPos, Sci_Position length, int, IDocument *pAccess) {
+	if (length <= 0) {
+		return;
+	}
+	// Read document memory directly when possible, otherwise copy the range.
+	const char *text = nullptr;
+	if (pAccess->Version() >= dvRelease5) {
+		text = static_cast<IDocument5 *>(pAccess)->RangePointer(startPos, length);
+	}
+	std::string copy;
+	if (!text) {
+		copy.resize(length);
+		pAccess->GetCharRange(copy.data(), startPos, length);
+		text = copy.data();
+	}
+
+	const Sci_Position endPos = startPos + length;
+	// Styles are filled in place in a buffer that only grows for lines longer than a batch.
+	std::string styles(styleBatchSize, '\0');
+	size_t styled = 0;
+	pAccess->StartStyling(startPos);
+
+	LineClass lc;
+	Sci_Position line = pAccess->LineFromPosition(startPos);
+	Sci_Position lineStart = startPos;
+	while (lineStart < endPos) {
+		// Lines ending with a lone CR are rare, so the document is only asked where a line ends
+		// when the first line end byte is a CR that is not part of CR LF.
+		const std::string_view rest(text + (lineStart - startPos), endPos - lineStart);
+		const size_t lineEndByte = FindAny<'\r', '\n'>(rest);
+		Sci_Position lineEnd = endPos;
+		if (lineEndByte < rest.length()) {
+			if (rest[lineEndByte] == '\n') {
+				lineEnd = lineStart + lineEndByte + 1;
+			} else if ((lineEndByte + 1 < rest.length()) && (rest[lineEndByte + 1] == '\n')) {
+				lineEnd = lineStart + lineEndByte + 2;
+			} else {
+				lineEnd = std::min<Sci_Position>(pAccess->LineStart(line + 1), endPos);
+			}
+		}
+		std::string_view lineText = rest.substr(0, lineEnd - lineStart);
+		const size_t lineLength = lineText.length();
+		while (!lineText.empty() && (lineText.back() == '\n' || lineText.back() == '\r')) {
+			lineText.remove_suffix(1);
+		}
+
+		Classify(lineText, lc);
+		if (styled + lineLength > styles.length()) {
+			styles.resize(styled + lineLength);
+		}
+		char *lineStyles = styles.data() + styled;
+		const int filler = options.severityLine ? lc.severity : SCE_LOG_DEFAULT;
+		size_t pos = 0;
+		for (const Span &span : lc.spans) {
+			memset(lineStyles + pos, filler, span.start - pos);
+			memset(lineStyles + span.start, span.style, span.end - span.start);
+			pos = span.end;
+		}
+		memset(lineStyles + pos, filler, lineText.length() - pos);
+		memset(lineStyles + lineText.length(), SCE_LOG_DEFAULT, lineLength - lineText.length());
+		styled += lineLength;
+
+		pAccess->SetLineState(line, (lc.id << lineStateIdShift) | (lc.continuation ? lineStateContinuation : 0));
+
+		if (styled >= styleBatchSize) {
+			pAccess->SetStyles(styled, styles.data());
+			styled = 0;
+		}
+		lineStart = lineEnd;
+		line++;
+	}
+	if (styled) {
+		pAccess->SetStyles(styled, styles.data());
+	}
+}
+
+void SCI_METHOD LexerLog::Fold(Sci_PositionU startPos, Sci_Position length, int, IDocument *pAccess) {
+	if (!options.fold || length <= 0) {
+		return;
+	}
+	const Sci_Position lineLastDocument = pAccess->LineFromPosition(pAccess->Length());
+	const Sci_Position lineLast = pAccess->LineFromPosition(startPos + length - 1);
+	Sci_Position line = pAccess->LineFromPosition(startPos);
+	// The first line may make the line before it a fold header
+	if (line > 0) {
+		line--;
+	}
+
+	// Header line level and id of the group continued by the line before the range.
+	int headerLevel = SC_FOLDLEVELBASE;
+	int groupId = 0;
+	if (line > 0) {
+		const int statePrevious = pAccess->GetLineState(line - 1);
+		const int levelPrevious = pAccess->GetLevel(line - 1) & SC_FOLDLEVELNUMBERMASK;
+		headerLevel = IsContinuation(statePrevious) ? levelPrevious - 1 : levelPrevious;
+		Sci_Position lineHeader = line - 1;
+		while (lineHeader > 0 && IsContinuation(pAccess->GetLineState(lineHeader))) {
+			lineHeader--;
+		}
+		groupId = IdOf(pAccess->GetLineState(lineHeader));
+	}
+
+	auto levelOfLine = [&](Sci_Position lineLevel) {
+		const int lineState = pAccess->GetLineState(lineLevel);
+		if (IsContinuation(lineState)) {
+			return headerLevel + 1;
+		}
+		const int id = IdOf(lineState);
+		const bool inGroup = options.foldRequest && id && (id == groupId);
+		headerLevel = inGroup ? SC_FOLDLEVELBASE + 1 : SC_FOLDLEVELBASE;
+		groupId = id;
+		return headerLevel;
+	};
+
+	int level = levelOfLine(line);
+	for (; line <= lineLast; line++) {
+		const int levelNext = (line < lineLastDocument) ? levelOfLine(line + 1) : SC_FOLDLEVELBASE;
+		int lev = level;
+		if (levelNext > level) {
+			lev |= SC_FOLDLEVELHEADERFLAG;
+		}
+		if (lev != pAccess->GetLevel(line)) {
+			pAccess->SetLevel(line, lev);
+		}
+		level = levelNext;
+	}
+}
+
+}
+
+extern const LexerModule lmLog(SCLEX_LOG, LexerLog::LexerFactoryLog, "log", logWordListDesc);
@@ -38,4 +38,4 @@ static void ColouriseNullDoc(Sci_PositionU startPos, Sci_Position length, int, W
 	}
 }
 
-extern const LexerModule lmNull(SCLEX_NULL, ColouriseNullDoc, "null");
+extern const LexerModule lmNull(SCLEX_NULL, ColouriseNullDoc, "null", nullptr, nullptr, nullptr, 0, Scintilla::lcLineStart);
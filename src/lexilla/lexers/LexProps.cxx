@@ -170,4 +170,4 @@ const char *const emptyWordListDesc[] = {
 
 }
 
-extern const LexerModule lmProps(SCLEX_PROPERTIES, ColourisePropsDoc, "props", FoldPropsDoc, emptyWordListDesc);
+extern const LexerModule lmProps(SCLEX_PROPERTIES, ColourisePropsDoc, "props", FoldPropsDoc, emptyWordListDesc, nullptr, 0, Scintilla::lcLineStart);
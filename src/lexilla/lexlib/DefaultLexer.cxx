@@ -42,7 +42,7 @@ void SCI_METHOD DefaultLexer::Release() {
 }
 
 int SCI_METHOD DefaultLexer::Version() const {
-	return Scintilla::lvRelease5;
+	return Scintilla::lvRelease6;
 }
 
 const char * SCI_METHOD DefaultLexer::PropertyNames() {
@@ -142,3 +142,8 @@ int SCI_METHOD DefaultLexer::GetIdentifier() {
 const char *SCI_METHOD DefaultLexer::PropertyGet(const char * /* key */) {
 	return nullptr;
 }
+
+// ILexer6 methods
+int SCI_METHOD DefaultLexer::Checkpoint() {
+	return Scintilla::lcNone;
+}
@@ -13,7 +13,7 @@
 namespace Lexilla {
 
 // A simple lexer with no state
-class DefaultLexer : public Scintilla::ILexer5 {
+class DefaultLexer : public Scintilla::ILexer6 {
 	const char *languageName;
 	int language;
 	const LexicalClass *lexClasses;
@@ -51,6 +51,8 @@ public:
 	const char * SCI_METHOD GetName() override;
 	int SCI_METHOD GetIdentifier() override;
 	const char *SCI_METHOD PropertyGet(const char *key) override;
+	// ILexer6 methods
+	int SCI_METHOD Checkpoint() override;
 };
 
 }
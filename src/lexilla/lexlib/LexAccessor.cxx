@@ -20,6 +20,54 @@ using namespace Lexilla;
 
 namespace Lexilla {
 
+void LexAccessor::Fill(Sci_Position position) {
+	if (direct && position >= startDirect && position < endDirect) {
+		data = direct;
+		startPos = startDirect;
+		endPos = endDirect;
+		return;
+	}
+	data = buf;
+	startPos = position - slopSize;
+	if (startPos + bufferSize > lenDoc)
+		startPos = lenDoc - bufferSize;
+	if (startPos < 0)
+		startPos = 0;
+	endPos = startPos + bufferSize;
+	if (endPos > lenDoc)
+		endPos = lenDoc;
+
+	pAccess->GetCharRange(buf, startPos, endPos-startPos);
+	buf[endPos-startPos] = '\0';
+}
+
+bool LexAccessor::DirectAccess(Sci_PositionU start, Sci_Position length) {
+	if (documentVersion < Scintilla::dvRelease5) {
+		return false;
+	}
+	const Sci_Position first = std::max<Sci_Position>(start - slopSize, 0);
+	const Sci_Position last = std::min<Sci_Position>(start + length + slopSize, lenDoc);
+	if (last <= first) {
+		return false;
+	}
+	Scintilla::IDocument5 *pAccess5 = static_cast<Scintilla::IDocument5 *>(pAccess);
+	direct = pAccess5->RangePointer(first, last - first);
+	if (!direct) {
+		return false;
+	}
+	startDirect = first;
+	endDirect = last;
+	if (length > bufferSize) {
+		// Ranges that fit in styleBuf do not need a batch
+		Flush();
+		styleBatch.resize(styleBatchSize);
+		styles = styleBatch.data();
+		stylesSize = styleBatchSize;
+	}
+	Fill(first);
+	return true;
+}
+
 bool LexAccessor::MatchIgnoreCase(Sci_Position pos, const char *s) {
 	assert(s);
 	for (; *s; s++, pos++) {
@@ -38,7 +86,7 @@ void LexAccessor::GetRange(Sci_PositionU startPos_, Sci_PositionU endPos_, char
 	endPos_ = std::min(endPos_, static_cast<Sci_PositionU>(lenDoc));
 	len = endPos_ - startPos_;
 	if (startPos_ >= static_cast<Sci_PositionU>(startPos) && endPos_ <= static_cast<Sci_PositionU>(endPos)) {
-		const char * const p = buf + (startPos_ - startPos);
+		const char * const p = data + (startPos_ - startPos);
 		memcpy(s, p, len);
 	} else {
 		pAccess->GetCharRange(s, startPos_, len);
@@ -21,41 +21,43 @@ private:
 	 * @a slopSize positions the buffer before the desired position
 	 * in case there is some backtracking. */
 	enum {bufferSize=4000, slopSize=bufferSize/8};
+	/** With direct access, styles are sent in batches of @a styleBatchSize. */
+	enum {styleBatchSize=0x10000};
 	char buf[bufferSize+1];
+	// Text from startPos to endPos is at data which is either buf or document memory.
+	const char *data;
 	Sci_Position startPos;
 	Sci_Position endPos;
 	int codePage;
 	enum EncodingType encodingType;
 	Sci_Position lenDoc;
 	char styleBuf[bufferSize];
+	// Styles are collected in styles which is either styleBuf or styleBatch.
+	char *styles;
+	Sci_PositionU stylesSize;
+	std::string styleBatch;
 	Sci_Position validLen;
 	Sci_PositionU startSeg;
 	Sci_Position startPosStyling;
 	int documentVersion;
+	// Range of document memory at direct when DirectAccess succeeded.
+	const char *direct;
+	Sci_Position startDirect;
+	Sci_Position endDirect;
 
-	void Fill(Sci_Position position) {
-		startPos = position - slopSize;
-		if (startPos + bufferSize > lenDoc)
-			startPos = lenDoc - bufferSize;
-		if (startPos < 0)
-			startPos = 0;
-		endPos = startPos + bufferSize;
-		if (endPos > lenDoc)
-			endPos = lenDoc;
-
-		pAccess->GetCharRange(buf, startPos, endPos-startPos);
-		buf[endPos-startPos] = '\0';
-	}
+	void Fill(Sci_Position position);
 
 public:
 	explicit LexAccessor(Scintilla::IDocument *pAccess_) :
-		pAccess(pAccess_), startPos(extremePosition), endPos(0),
+		pAccess(pAccess_), data(buf), startPos(extremePosition), endPos(0),
 		codePage(pAccess->CodePage()),
 		encodingType(EncodingType::eightBit),
 		lenDoc(pAccess->Length()),
+		styles(styleBuf), stylesSize(bufferSize),
 		validLen(0),
 		startSeg(0), startPosStyling(0),
-		documentVersion(pAccess->Version()) {
+		documentVersion(pAccess->Version()),
+		direct(nullptr), startDirect(0), endDirect(0) {
 		// Prevent warnings by static analyzers about uninitialized buf and styleBuf.
 		buf[0] = 0;
 		styleBuf[0] = 0;
@@ -74,11 +76,22 @@ public:
 			break;
 		}
 	}
+	// Deleted so LexAccessor objects can not be copied as data and styles may point into the object.
+	LexAccessor(const LexAccessor &) = delete;
+	LexAccessor(LexAccessor &&) = delete;
+	LexAccessor &operator=(const LexAccessor &) = delete;
+	LexAccessor &operator=(LexAccessor &&) = delete;
+	~LexAccessor() = default;
+	/** Read text directly from document memory for a range about to be lexed and send styles in
+	 * larger batches. Only used when the document can provide a pointer to the range that stays valid
+	 * while lexing; otherwise the accessor continues to copy text into its buffer.
+	 * Call before styling starts. Positions outside the range are still read through the buffer. */
+	bool DirectAccess(Sci_PositionU start, Sci_Position length);
 	char operator[](Sci_Position position) {
 		if (position < startPos || position >= endPos) {
 			Fill(position);
 		}
-		return buf[position - startPos];
+		return data[position - startPos];
 	}
 	Scintilla::IDocument *MultiByteAccess() const noexcept {
 		return pAccess;
@@ -92,7 +105,7 @@ public:
 				return chDefault;
 			}
 		}
-		return buf[position - startPos];
+		return data[position - startPos];
 	}
 	bool IsLeadByte(char ch) const {
 		const unsigned char uch = ch;
@@ -134,7 +147,7 @@ public:
 	int BufferStyleAt(Sci_Position position) const {
 		const Sci_Position index = position - startPosStyling;
 		if (index >= 0 && index < validLen) {
-			const unsigned char style = styleBuf[index];
+			const unsigned char style = styles[index];
 			return style;
 		}
 		const unsigned char style = pAccess->StyleAt(position);
@@ -157,7 +170,7 @@ public:
 	}
 	void Flush() {
 		if (validLen > 0) {
-			pAccess->SetStyles(validLen, styleBuf);
+			pAccess->SetStyles(validLen, styles);
 			startPosStyling += validLen;
 			validLen = 0;
 		}
@@ -187,16 +200,16 @@ public:
 				return;
 			}
 
-			if (validLen + (pos - startSeg + 1) >= bufferSize)
+			if (validLen + (pos - startSeg + 1) >= stylesSize)
 				Flush();
 			const unsigned char attr = chAttr & 0xffU;
-			if (validLen + (pos - startSeg + 1) >= bufferSize) {
+			if (validLen + (pos - startSeg + 1) >= stylesSize) {
 				// Too big for buffer so send directly
 				pAccess->SetStyleFor(pos - startSeg + 1, attr);
 			} else {
 				for (Sci_PositionU i = startSeg; i <= pos; i++) {
 					assert((startPosStyling + validLen) < Length());
-					styleBuf[validLen++] = attr;
+					styles[validLen++] = attr;
 				}
 			}
 		}
@@ -47,7 +47,7 @@ void SCI_METHOD LexerBase::Release() {
 }
 
 int SCI_METHOD LexerBase::Version() const {
-	return Scintilla::lvRelease5;
+	return Scintilla::lvRelease6;
 }
 
 const char * SCI_METHOD LexerBase::PropertyNames() {
@@ -154,3 +154,9 @@ const char *SCI_METHOD LexerBase::GetName() {
 int SCI_METHOD LexerBase::GetIdentifier() {
 	return SCLEX_AUTOMATIC;
 }
+
+// ILexer6 methods
+
+int SCI_METHOD LexerBase::Checkpoint() {
+	return Scintilla::lcNone;
+}
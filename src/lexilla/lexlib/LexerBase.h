@@ -11,7 +11,7 @@
 namespace Lexilla {
 
 // A simple lexer with no state
-class LexerBase : public Scintilla::ILexer5 {
+class LexerBase : public Scintilla::ILexer6 {
 protected:
 	const LexicalClass *lexClasses;
 	size_t nClasses;
@@ -50,6 +50,8 @@ public:
 	const char * SCI_METHOD GetName() override;
 	int SCI_METHOD GetIdentifier() override;
 	const char *SCI_METHOD PropertyGet(const char *key) override;
+	// ILexer6 methods
+	int SCI_METHOD Checkpoint() override;
 };
 
 }
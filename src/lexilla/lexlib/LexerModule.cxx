@@ -31,7 +31,8 @@ LexerModule::LexerModule(int language_,
 	LexerFunction fnFolder_,
 	const char *const wordListDescriptions_[],
 	const LexicalClass *lexClasses_,
-	size_t nClasses_) noexcept :
+	size_t nClasses_,
+	int checkpoint_) noexcept :
 	language(language_),
 	fnLexer(fnLexer_),
 	fnFolder(fnFolder_),
@@ -39,6 +40,7 @@ LexerModule::LexerModule(int language_,
 	wordListDescriptions(wordListDescriptions_),
 	lexClasses(lexClasses_),
 	nClasses(nClasses_),
+	checkpoint(checkpoint_),
 	languageName(languageName_) {
 }
 
@@ -53,6 +55,7 @@ LexerModule::LexerModule(int language_,
 	wordListDescriptions(wordListDescriptions_),
 	lexClasses(nullptr),
 	nClasses(0),
+	checkpoint(Scintilla::lcNone),
 	languageName(languageName_) {
 }
 
@@ -91,6 +94,10 @@ size_t LexerModule::NamedStyles() const noexcept {
 	return nClasses;
 }
 
+int LexerModule::Checkpoint() const noexcept {
+	return checkpoint;
+}
+
 Scintilla::ILexer5 *LexerModule::Create() const {
 	if (fnFactory)
 		return fnFactory();
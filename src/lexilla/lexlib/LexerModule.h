@@ -33,6 +33,7 @@ protected:
 	const char * const * wordListDescriptions;
 	const LexicalClass *lexClasses;
 	size_t nClasses;
+	int checkpoint;
 
 public:
 	const char *languageName;
@@ -43,7 +44,8 @@ public:
 		LexerFunction fnFolder_= nullptr,
 		const char * const wordListDescriptions_[]=nullptr,
 		const LexicalClass *lexClasses_=nullptr,
-		size_t nClasses_=0) noexcept;
+		size_t nClasses_=0,
+		int checkpoint_=Scintilla::lcNone) noexcept;
 	LexerModule(
 		int language_,
 		LexerFactoryFunction fnFactory_,
@@ -56,6 +58,8 @@ public:
 	const char *GetWordListDescription(int index) const noexcept;
 	const LexicalClass *LexClasses() const noexcept;
 	size_t NamedStyles() const noexcept;
+	// Where the lexing function can restart, from the lcNone, lcLineStart, and lcLineState values
+	int Checkpoint() const noexcept;
 
 	Scintilla::ILexer5 *Create() const;
 
@@ -60,3 +60,7 @@ const char * SCI_METHOD LexerSimple::GetName() {
 int SCI_METHOD LexerSimple::GetIdentifier() {
 	return lexerModule->GetLanguage();
 }
+
+int SCI_METHOD LexerSimple::Checkpoint() {
+	return lexerModule->Checkpoint();
+}
@@ -22,6 +22,8 @@ public:
 	// ILexer5 methods
 	const char * SCI_METHOD GetName() override;
 	int SCI_METHOD  GetIdentifier() override;
+	// ILexer6 methods
+	int SCI_METHOD Checkpoint() override;
 };
 
 }
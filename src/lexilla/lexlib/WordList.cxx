@@ -70,10 +70,23 @@ bool cmpWords(const char *a, const char *b) noexcept {
 	return strcmp(a, b) < 0;
 }
 
+// FNV-1a
+constexpr unsigned int hashBasis = 2166136261U;
+constexpr unsigned int hashPrime = 16777619U;
+
+constexpr unsigned int HashByte(unsigned int hash, char ch) noexcept {
+	return (hash ^ static_cast<unsigned char>(ch)) * hashPrime;
+}
+
 }
 
+struct WordList::Slot {
+	unsigned int hash;
+	int index;	///< Into words or -1 when empty
+};
+
 WordList::WordList(bool onlyLineEnds_) noexcept :
-	words(nullptr), list(nullptr), len(0), onlyLineEnds(onlyLineEnds_) {
+	words(nullptr), list(nullptr), len(0), onlyLineEnds(onlyLineEnds_), slots(nullptr), slotMask(0) {
 	// Prevent warnings by static analyzers about uninitialized starts.
 	starts[0] = -1;
 }
@@ -105,6 +118,9 @@ void WordList::Clear() noexcept {
 	list = nullptr;
 	delete []words;
 	words = nullptr;
+	delete []slots;
+	slots = nullptr;
+	slotMask = 0;
 	len = 0;
 }
 
@@ -134,10 +150,35 @@ bool WordList::Set(const char *s, bool lowerCase) {
 		}
 	}
 
+	// Table is at most half full so probe sequences stay short
+	size_t slotCount = 0;
+	std::unique_ptr<Slot[]> slotsTemp;
+	if (lenTemp > 0) {
+		slotCount = 4;
+		while (slotCount < lenTemp * 2) {
+			slotCount *= 2;
+		}
+		slotsTemp = std::make_unique<Slot[]>(slotCount);
+		std::fill(slotsTemp.get(), slotsTemp.get() + slotCount, Slot{ 0, -1 });
+		for (size_t i = 0; i < lenTemp; i++) {
+			unsigned int hash = hashBasis;
+			for (const char *p = wordsTemp[i]; *p; p++) {
+				hash = HashByte(hash, *p);
+			}
+			size_t slot = hash & (slotCount - 1);
+			while (slotsTemp[slot].index >= 0) {
+				slot = (slot + 1) & (slotCount - 1);
+			}
+			slotsTemp[slot] = Slot{ hash, static_cast<int>(i) };
+		}
+	}
+
 	Clear();
 	words = wordsTemp.release();
 	list = listTemp.release();
 	len = lenTemp;
+	slots = slotsTemp.release();
+	slotMask = slotCount - 1;
 	std::fill(starts, std::end(starts), -1);
 	for (int l = static_cast<int>(len - 1); l >= 0; l--) {
 		unsigned char const indexChar = words[l][0];
@@ -146,6 +187,18 @@ bool WordList::Set(const char *s, bool lowerCase) {
 	return true;
 }
 
+bool WordList::InTable(const char *s, size_t length, unsigned int hash) const noexcept {
+	for (size_t slot = hash & slotMask; slots[slot].index >= 0; slot = (slot + 1) & slotMask) {
+		if (slots[slot].hash == hash) {
+			const char *word = words[slots[slot].index];
+			if ((strncmp(word, s, length) == 0) && !word[length]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 /** Check whether a string is in the list.
  * List elements are either exact matches or prefixes.
  * Prefix elements start with '^' and match all strings that start with the rest of the element
@@ -154,25 +207,17 @@ bool WordList::Set(const char *s, bool lowerCase) {
 bool WordList::InList(const char *s) const noexcept {
 	if (!words)
 		return false;
-	const char first = s[0];
-	const unsigned char firstChar = first;
-	int j = starts[firstChar];
-	if (j >= 0) {
-		while (words[j][0] == first) {
-			if (s[1] == words[j][1]) {
-				const char *a = words[j] + 1;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					b++;
-				}
-				if (!*a && !*b)
-					return true;
-			}
-			j++;
+	const unsigned char firstChar = s[0];
+	if (starts[firstChar] >= 0) {
+		unsigned int hash = hashBasis;
+		size_t length = 0;
+		for (; s[length]; length++) {
+			hash = HashByte(hash, s[length]);
 		}
+		if (InTable(s, length, hash))
+			return true;
 	}
-	j = starts[static_cast<unsigned int>('^')];
+	int j = starts[static_cast<unsigned int>('^')];
 	if (j >= 0) {
 		while (words[j][0] == '^') {
 			const char *a = words[j] + 1;
@@ -195,14 +240,14 @@ bool WordList::InList(const char *s) const noexcept {
 bool WordList::InList(std::string_view sv) const noexcept {
 	if (!words || sv.empty())
 		return false;
-	const char first = sv[0];
-	const unsigned char firstChar = first;
-	if (int j = starts[firstChar]; j >= 0) {
-		const std::string_view after = sv.substr(1);
-		for (; words[j][0] == first; j++) {
-			if (std::string_view(words[j] + 1) == after) {
-				return true;
-			}
+	const unsigned char firstChar = sv[0];
+	if (starts[firstChar] >= 0) {
+		unsigned int hash = hashBasis;
+		for (const char ch : sv) {
+			hash = HashByte(hash, ch);
+		}
+		if (InTable(sv.data(), sv.length(), hash)) {
+			return true;
 		}
 	}
 	if (int j = starts[static_cast<unsigned int>('^')]; j >= 0) {
@@ -19,6 +19,11 @@ class WordList {
 	size_t len;
 	bool onlyLineEnds;	///< Delimited by any white space or only line ends
 	int starts[256];
+	// Open addressing hash table of all words built by Set so InList does not scan a bucket of words.
+	struct Slot;
+	Slot *slots;
+	size_t slotMask;
+	bool InTable(const char *s, size_t length, unsigned int hash) const noexcept;
 public:
 	explicit WordList(bool onlyLineEnds_ = false) noexcept;
 	// Deleted so WordList objects can not be copied.
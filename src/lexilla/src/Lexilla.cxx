@@ -93,6 +93,7 @@ extern const LexerModule lmKVIrc;
 extern const LexerModule lmLatex;
 extern const LexerModule lmLISP;
 extern const LexerModule lmLiterateHaskell;
+extern const LexerModule lmLog;
 extern const LexerModule lmLot;
 extern const LexerModule lmLout;
 extern const LexerModule lmLua;
@@ -246,6 +247,7 @@ void AddEachLexer() {
 		&lmLatex,
 		&lmLISP,
 		&lmLiterateHaskell,
+		&lmLog,
 		&lmLot,
 		&lmLout,
 		&lmLua,
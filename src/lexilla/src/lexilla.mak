@@ -151,6 +151,7 @@ LEX_OBJS=\
 	$(DIR_O)\LexKVIrc.obj \
 	$(DIR_O)\LexLaTeX.obj \
 	$(DIR_O)\LexLisp.obj \
+	$(DIR_O)\LexLog.obj \
 	$(DIR_O)\LexLout.obj \
 	$(DIR_O)\LexLua.obj \
 	$(DIR_O)\LexMagik.obj \
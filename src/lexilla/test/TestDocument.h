@@ -10,13 +10,14 @@
 
 std::u32string UTF32FromUTF8(std::string_view svu8);
 
-class TestDocument : public Scintilla::IDocument {
+class TestDocument : public Scintilla::IDocument5 {
 	std::string text;
 	std::string textStyles;
 	std::vector<Sci_Position> lineStarts;
 	std::vector<int> lineStates;
 	std::vector<int> lineLevels;
 	Sci_Position endStyled=0;
+	size_t CheckedStyleRange(Sci_Position length) const;
 public:
 	void Set(std::string_view sv);
 	TestDocument() = default;
@@ -53,6 +54,7 @@ public:
 	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override;
 	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override;
 	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override;
+	const char *SCI_METHOD RangePointer(Sci_Position position, Sci_Position rangeLength) override;
 };
 
 #endif
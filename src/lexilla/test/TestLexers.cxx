@@ -6,6 +6,8 @@
  // The License.txt file describes the conditions under which this software may be distributed.
 
 #include <cassert>
+#include <cstddef>
+#include <cstdlib>
 
 #include <string>
 #include <string_view>
@@ -13,6 +15,9 @@
 #include <map>
 #include <optional>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
 
 #include <iostream>
 #include <sstream>
@@ -29,6 +34,93 @@
 
 namespace {
 
+// Heap use is counted for benchmarks by replacing the global allocation functions.
+// Each block starts with a header holding its size so that the bytes in use can be tracked.
+// When Lexilla is a shared library on Windows, allocations inside the library are not seen.
+
+struct HeapCounts {
+	std::atomic<size_t> allocations = 0;
+	std::atomic<size_t> bytes = 0;
+	std::atomic<size_t> peak = 0;
+};
+HeapCounts heapCounts;
+
+constexpr size_t heapHeader = alignof(std::max_align_t);
+static_assert(heapHeader >= sizeof(size_t));
+
+void *HeapAllocate(size_t size) noexcept {
+	if (size == 0) {
+		size = 1;
+	}
+	void *block = std::malloc(size + heapHeader);
+	if (!block) {
+		return nullptr;
+	}
+	*static_cast<size_t *>(block) = size;
+	heapCounts.allocations++;
+	const size_t bytes = heapCounts.bytes += size;
+	size_t peak = heapCounts.peak;
+	while ((bytes > peak) && !heapCounts.peak.compare_exchange_weak(peak, bytes)) {
+	}
+	return static_cast<char *>(block) + heapHeader;
+}
+
+void HeapFree(void *p) noexcept {
+	if (p) {
+		void *block = static_cast<char *>(p) - heapHeader;
+		heapCounts.bytes -= *static_cast<size_t *>(block);
+		std::free(block);
+	}
+}
+
+}
+
+void *operator new(size_t size) {
+	void *p = HeapAllocate(size);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	return HeapAllocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return HeapAllocate(size);
+}
+
+void operator delete(void *p) noexcept {
+	HeapFree(p);
+}
+
+void operator delete[](void *p) noexcept {
+	HeapFree(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	HeapFree(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+	HeapFree(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+	HeapFree(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+	HeapFree(p);
+}
+
+namespace {
+
 constexpr char MakeLowerCase(char c) noexcept {
 	if (c >= 'A' && c <= 'Z') {
 		return c - 'A' + 'a';
@@ -684,8 +776,13 @@ void TestILexer(Scintilla::ILexer5 *plex) {
 	// Some methods are tested later (Release, Lex, Fold).
 	// PrivateCall performs arbitrary actions so is not safe to call.
 
-	[[maybe_unused]] const int version = plex->Version();
-	assert(version == Scintilla::lvRelease5);
+	const int version = plex->Version();
+	assert(version == Scintilla::lvRelease5 || version == Scintilla::lvRelease6);
+
+	if (version >= Scintilla::lvRelease6) {
+		[[maybe_unused]] const int checkpoint = static_cast<Scintilla::ILexer6 *>(plex)->Checkpoint();
+		assert(checkpoint >= Scintilla::lcNone && checkpoint <= Scintilla::lcLineState);
+	}
 
 	[[maybe_unused]] const char *language = plex->GetName();
 	assert(language);
@@ -922,13 +1019,17 @@ bool TestFile(const std::filesystem::path &path, const PropertyMap &propertyMap)
 	return success;
 }
 
+bool IsExampleFile(const std::filesystem::path &path) {
+	const std::string extension = path.extension().string();
+	return extension != ".properties" && extension != suffixStyled && extension != ".new" &&
+		extension != suffixFolded;
+}
+
 bool TestDirectory(std::filesystem::path directory, std::filesystem::path basePath) {
 	bool success = true;
 	for (auto &p : std::filesystem::directory_iterator(directory)) {
 		if (!p.is_directory()) {
-			const std::string extension = p.path().extension().string();
-			if (extension != ".properties" && extension != suffixStyled && extension != ".new" &&
-				extension != suffixFolded) {
+			if (IsExampleFile(p.path())) {
 				const std::filesystem::path relativePath = p.path().lexically_relative(basePath);
 				std::cout << "Lexing " << relativePath.string() << '\n';
 				PropertyMap properties;
@@ -961,6 +1062,299 @@ bool AccessLexilla(std::filesystem::path basePath) {
 	return success;
 }
 
+// Benchmarking: each example is repeated to make a large document which is lexed and then folded
+// several times with the fastest times reported. Other directories with SciTE.properties files
+// can be benchmarked to measure large real files.
+
+struct BenchmarkOptions {
+	bool enabled = false;
+	size_t size = 10 * 1024 * 1024;
+	int repeat = 3;
+	std::filesystem::path json;
+	std::filesystem::path compare;
+	double threshold = 10.0;	// Percent slower that is reported as a regression
+};
+
+struct BenchmarkResult {
+	std::string file;
+	std::string language;
+	size_t bytes = 0;
+	double lexSeconds = 0.0;
+	double foldSeconds = 0.0;
+	size_t allocations = 0;
+	size_t peakBytes = 0;
+};
+
+constexpr double megaByte = 1024.0 * 1024.0;
+
+double MBPerSecond(size_t bytes, double seconds) noexcept {
+	return (seconds > 0.0) ? bytes / megaByte / seconds : 0.0;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) noexcept {
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+	return duration.count();
+}
+
+std::string RepeatToSize(const std::string &text, size_t size) {
+	std::string repeated;
+	repeated.reserve(size + text.length() + 1);
+	while (repeated.length() < size) {
+		repeated += text;
+		if (!text.ends_with('\n')) {
+			repeated += '\n';
+		}
+	}
+	return repeated;
+}
+
+std::optional<BenchmarkResult> BenchmarkFile(const std::filesystem::path &path, const std::filesystem::path &basePath,
+	const PropertyMap &propertyMap, const BenchmarkOptions &options) {
+	std::optional<std::string> language = propertyMap.GetPropertyForFile(lexerPrefix, path.filename().string());
+	if (!language) {
+		return {};
+	}
+	Scintilla::ILexer5 *plex = Lexilla::MakeLexer(*language);
+	if (!plex) {
+		return {};
+	}
+	if (!SetProperties(plex, *language, propertyMap, path)) {
+		plex->Release();
+		return {};
+	}
+
+	std::string text = ReadFile(path);
+	if (text.starts_with(BOM)) {
+		text.erase(0, BOM.length());
+	}
+	if (text.empty()) {
+		plex->Release();
+		return {};
+	}
+
+	BenchmarkResult result;
+	result.file = path.lexically_relative(basePath).generic_string();
+	result.language = *language;
+
+	TestDocument doc;
+	doc.Set(RepeatToSize(text, options.size));
+	Scintilla::IDocument *pdoc = &doc;
+	result.bytes = pdoc->Length();
+	for (int i = 0; i < options.repeat; i++) {
+		// Heap use is measured on the first run as later runs may reuse memory
+		const size_t allocationsStart = heapCounts.allocations;
+		const size_t bytesStart = heapCounts.bytes;
+		heapCounts.peak = bytesStart;
+
+		const std::chrono::steady_clock::time_point startLex = std::chrono::steady_clock::now();
+		plex->Lex(0, pdoc->Length(), 0, pdoc);
+		const double lexSeconds = SecondsSince(startLex);
+		const std::chrono::steady_clock::time_point startFold = std::chrono::steady_clock::now();
+		plex->Fold(0, pdoc->Length(), 0, pdoc);
+		const double foldSeconds = SecondsSince(startFold);
+
+		if (i == 0) {
+			result.lexSeconds = lexSeconds;
+			result.foldSeconds = foldSeconds;
+			result.allocations = heapCounts.allocations - allocationsStart;
+			result.peakBytes = heapCounts.peak - bytesStart;
+		} else {
+			result.lexSeconds = std::min(result.lexSeconds, lexSeconds);
+			result.foldSeconds = std::min(result.foldSeconds, foldSeconds);
+		}
+	}
+
+	plex->Release();
+	return result;
+}
+
+void BenchmarkDirectory(std::filesystem::path directory, std::filesystem::path basePath,
+	const BenchmarkOptions &options, std::vector<BenchmarkResult> &results) {
+	for (auto &p : std::filesystem::directory_iterator(directory)) {
+		if (!p.is_directory() && IsExampleFile(p.path())) {
+			PropertyMap properties;
+			properties.properties["FileNameExt"] = p.path().filename().string();
+			properties.ReadFromFile(directory / "SciTE.properties");
+			std::optional<BenchmarkResult> result = BenchmarkFile(p.path(), basePath, properties, options);
+			if (result) {
+				std::cout << "Benchmark " << result->file << " " << result->language << std::fixed << std::setprecision(1) <<
+					" lex " << MBPerSecond(result->bytes, result->lexSeconds) << " MB/s" <<
+					" fold " << MBPerSecond(result->bytes, result->foldSeconds) << " MB/s" <<
+					" allocations " << result->allocations <<
+					" peak " << result->peakBytes << "\n";
+				results.push_back(*result);
+			}
+		}
+	}
+}
+
+std::string JSONString(std::string_view sv) {
+	std::ostringstream os;
+	os << '"';
+	for (const char ch : sv) {
+		if (ch == '"' || ch == '\\') {
+			os << '\\' << ch;
+		} else if (static_cast<unsigned char>(ch) < 0x20) {
+			os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(ch) << std::dec;
+		} else {
+			os << ch;
+		}
+	}
+	os << '"';
+	return os.str();
+}
+
+// Each result is written on its own line so that ReadBenchmark can find them without a JSON parser.
+void WriteBenchmark(const std::filesystem::path &path, const std::vector<BenchmarkResult> &results, const BenchmarkOptions &options) {
+	std::map<std::string, BenchmarkResult> languages;
+	for (const BenchmarkResult &result : results) {
+		BenchmarkResult &total = languages[result.language];
+		total.language = result.language;
+		total.bytes += result.bytes;
+		total.lexSeconds += result.lexSeconds;
+		total.foldSeconds += result.foldSeconds;
+		total.allocations += result.allocations;
+		total.peakBytes = std::max(total.peakBytes, result.peakBytes);
+	}
+	const auto writeResult = [](std::ofstream &ofs, const BenchmarkResult &result) {
+		ofs << "{";
+		if (!result.file.empty()) {
+			ofs << "\"file\": " << JSONString(result.file) << ", ";
+		}
+		ofs << "\"language\": " << JSONString(result.language) <<
+			", \"bytes\": " << result.bytes <<
+			std::fixed << std::setprecision(6) <<
+			", \"lexSeconds\": " << result.lexSeconds <<
+			", \"foldSeconds\": " << result.foldSeconds <<
+			std::setprecision(2) <<
+			", \"lexMBps\": " << MBPerSecond(result.bytes, result.lexSeconds) <<
+			", \"foldMBps\": " << MBPerSecond(result.bytes, result.foldSeconds) <<
+			", \"allocations\": " << result.allocations <<
+			", \"peakBytes\": " << result.peakBytes << "}";
+	};
+	std::ofstream ofs(path);
+	ofs << "{\n\"size\": " << options.size << ",\n\"repeat\": " << options.repeat << ",\n\"files\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		writeResult(ofs, results[i]);
+		ofs << ((i + 1 < results.size()) ? ",\n" : "\n");
+	}
+	ofs << "],\n\"languages\": [\n";
+	size_t count = 0;
+	for (auto const &[language, total] : languages) {
+		writeResult(ofs, total);
+		ofs << ((++count < languages.size()) ? ",\n" : "\n");
+	}
+	ofs << "]\n}\n";
+}
+
+std::optional<std::string> JSONValue(std::string_view line, std::string_view key) {
+	const std::string quotedKey = "\"" + std::string(key) + "\": ";
+	const size_t start = line.find(quotedKey);
+	if (start == std::string_view::npos) {
+		return {};
+	}
+	std::string_view value = line.substr(start + quotedKey.length());
+	if (value.starts_with('"')) {
+		value.remove_prefix(1);
+		std::string unescaped;
+		while (!value.empty() && value.front() != '"') {
+			if (value.front() == '\\' && value.length() > 1) {
+				value.remove_prefix(1);
+			}
+			unescaped.push_back(value.front());
+			value.remove_prefix(1);
+		}
+		return unescaped;
+	}
+	return std::string(value.substr(0, value.find_first_of(",}")));
+}
+
+std::map<std::string, BenchmarkResult> ReadBenchmark(const std::filesystem::path &path) {
+	std::map<std::string, BenchmarkResult> results;
+	std::ifstream ifs(path);
+	std::string line;
+	while (std::getline(ifs, line)) {
+		const std::optional<std::string> file = JSONValue(line, "file");
+		const std::optional<std::string> bytes = JSONValue(line, "bytes");
+		const std::optional<std::string> lexSeconds = JSONValue(line, "lexSeconds");
+		const std::optional<std::string> foldSeconds = JSONValue(line, "foldSeconds");
+		if (file && bytes && lexSeconds && foldSeconds) {
+			BenchmarkResult &result = results[*file];
+			result.file = *file;
+			result.bytes = std::stoull(*bytes);
+			result.lexSeconds = std::stod(*lexSeconds);
+			result.foldSeconds = std::stod(*foldSeconds);
+		}
+	}
+	return results;
+}
+
+bool CompareBenchmark(const std::vector<BenchmarkResult> &results, const BenchmarkOptions &options) {
+	const std::map<std::string, BenchmarkResult> baseline = ReadBenchmark(options.compare);
+	if (baseline.empty()) {
+		std::cout << "No benchmark results in " << options.compare.string() << "\n";
+		return false;
+	}
+	bool success = true;
+	// Percentage change in speed, ignoring times too short to measure reliably
+	constexpr double minimumSeconds = 0.001;
+	const auto change = [](size_t bytesBefore, double before, size_t bytesAfter, double after) noexcept {
+		if ((before < minimumSeconds) || (after < minimumSeconds)) {
+			return 0.0;
+		}
+		const double speedBefore = MBPerSecond(bytesBefore, before);
+		return (MBPerSecond(bytesAfter, after) - speedBefore) / speedBefore * 100.0;
+	};
+	std::cout << "\nCompared to " << options.compare.string() << "\n";
+	for (const BenchmarkResult &result : results) {
+		const std::map<std::string, BenchmarkResult>::const_iterator it = baseline.find(result.file);
+		if (it == baseline.end()) {
+			continue;
+		}
+		const double lexChange = change(it->second.bytes, it->second.lexSeconds, result.bytes, result.lexSeconds);
+		const double foldChange = change(it->second.bytes, it->second.foldSeconds, result.bytes, result.foldSeconds);
+		const bool regressed = (lexChange < -options.threshold) || (foldChange < -options.threshold);
+		std::cout << (regressed ? "Regression " : "Compare ") << result.file << std::fixed << std::setprecision(1) << std::showpos <<
+			" lex " << lexChange << "%" <<
+			" fold " << foldChange << "%" << std::noshowpos << "\n";
+		if (regressed) {
+			success = false;
+		}
+	}
+	return success;
+}
+
+bool BenchmarkLexilla(std::filesystem::path basePath, const BenchmarkOptions &options) {
+	if (!std::filesystem::exists(basePath)) {
+		std::cout << "No examples at " << basePath.string() << "\n";
+		return false;
+	}
+
+	std::vector<BenchmarkResult> results;
+	// Examples may be directly in basePath when it is a single language's directory
+	BenchmarkDirectory(basePath, basePath, options, results);
+	for (auto &p : std::filesystem::recursive_directory_iterator(basePath)) {
+		if (p.is_directory()) {
+			BenchmarkDirectory(p, basePath, options, results);
+		}
+	}
+	if (!options.json.empty()) {
+		WriteBenchmark(options.json, results, options);
+	}
+	if (!options.compare.empty()) {
+		return CompareBenchmark(results, options);
+	}
+	return true;
+}
+
+bool ReadOption(std::string_view arg, std::string_view name, std::string &value) {
+	if (arg.starts_with(name) && (arg.length() > name.length()) && (arg[name.length()] == '=')) {
+		value = arg.substr(name.length() + 1);
+		return true;
+	}
+	return false;
+}
+
 std::filesystem::path FindLexillaDirectory(std::filesystem::path startDirectory) {
 	// Search up from startDirectory for a directory named "lexilla" or containing a "bin" subdirectory
 	std::filesystem::path directory = startDirectory;
@@ -1004,12 +1398,32 @@ int main(int argc, char **argv) {
 		}
 #endif
 		std::filesystem::path examplesDirectory = baseDirectory / "test" / "examples";
+		BenchmarkOptions benchmark;
 		for (int i = 1; i < argc; i++) {
-			if (argv[i][0] != '-') {
+			const std::string_view arg = argv[i];
+			std::string value;
+			if (arg[0] != '-') {
 				examplesDirectory = argv[i];
+			} else if (arg == "--benchmark") {
+				benchmark.enabled = true;
+			} else if (ReadOption(arg, "--size", value)) {
+				// Size of each benchmark document in megabytes
+				benchmark.size = std::stoull(value) * 1024 * 1024;
+			} else if (ReadOption(arg, "--repeat", value)) {
+				benchmark.repeat = std::max(std::stoi(value), 1);
+			} else if (ReadOption(arg, "--json", value)) {
+				benchmark.json = value;
+			} else if (ReadOption(arg, "--compare", value)) {
+				benchmark.compare = value;
+			} else if (ReadOption(arg, "--threshold", value)) {
+				benchmark.threshold = std::stod(value);
 			}
 		}
-		success = AccessLexilla(examplesDirectory);
+		if (benchmark.enabled) {
+			success = BenchmarkLexilla(examplesDirectory, benchmark);
+		} else {
+			success = AccessLexilla(examplesDirectory);
+		}
 	}
 	return success ? 0 : 1;
 }
@@ -26,8 +26,11 @@ all: $(EXE)
 test: $(EXE)
 	$(EXE)
 
+benchmark: $(EXE)
+	$(EXE) --benchmark --json=benchmark.json
+
 clean:
-	$(DEL) *.o *.obj *.exe
+	$(DEL) *.o *.obj *.exe benchmark.json
 
 $(EXE): $(OBJS) $(LIBS)
 	$(CXX) $(CXXFLAGS) $(LIBS) /Fe$@ $**
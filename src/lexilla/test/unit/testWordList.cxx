@@ -9,6 +9,8 @@
 #include <string_view>
 #include <vector>
 #include <map>
+#include <chrono>
+#include <iostream>
 
 #include "WordList.h"
 #include "CharacterSet.h"
@@ -73,6 +75,32 @@ TEST_CASE("WordList") {
 		REQUIRE(wl.InList("\xd1\x81\xd1\x8b\xd1\x80"));
 	}
 
+	SECTION("InListMany") {
+		// Enough words to fill many slots of the hash table
+		std::string list;
+		for (int i = 0; i < 1000; i++) {
+			list += "w" + std::to_string(i * 7) + " ";
+		}
+		list += "w0 ^pre";
+		wl.Set(list.c_str());
+		REQUIRE(1002 == wl.Length());
+		for (int i = 0; i < 7000; i++) {
+			const std::string word = "w" + std::to_string(i);
+			const bool expected = (i % 7) == 0;
+			REQUIRE(wl.InList(word.c_str()) == expected);
+			REQUIRE(wl.InList(std::string_view(word)) == expected);
+		}
+		REQUIRE(!wl.InList("w"));
+		REQUIRE(!wl.InList(""));
+		REQUIRE(!wl.InList("w00"));
+		REQUIRE(wl.InList("prefixed"));
+		REQUIRE(wl.InList("^pre"));
+		// string_view need not be terminated
+		const std::string_view svLonger = "w14x";
+		REQUIRE(wl.InList(svLonger.substr(0, 3)));
+		REQUIRE(!wl.InList(svLonger));
+	}
+
 	SECTION("Set") {
 		// Check whether Set returns whether it has changed correctly
 		const bool changed = wl.Set("else struct");
@@ -139,6 +167,52 @@ TEST_CASE("WordList") {
 	}
 }
 
+// Time InList against the first character scan still used by InListAbbreviated which, with no
+// markers in the list, finds the same words. Hidden so only run with: unitTest [benchmark]
+
+TEST_CASE("WordListBenchmark", "[.benchmark]") {
+
+	// Large list like SQL keywords with many words sharing first characters
+	std::vector<std::string> keywords;
+	for (const char *stem : { "alter", "create", "drop", "select", "insert", "update", "delete", "grant",
+		"revoke", "commit", "rollback", "savepoint", "sys", "current", "column", "constraint" }) {
+		for (int i = 0; i < 40; i++) {
+			keywords.push_back(std::string(stem) + "_" + std::to_string(i));
+		}
+	}
+	std::string list;
+	for (const std::string &keyword : keywords) {
+		list += keyword + " ";
+	}
+	WordList wl;
+	wl.Set(list.c_str());
+
+	// Half the identifiers looked up are keywords
+	std::vector<std::string> identifiers;
+	for (size_t i = 0; i < keywords.size(); i++) {
+		identifiers.push_back((i % 2) ? keywords[i] : keywords[i] + "x");
+	}
+
+	constexpr int repeats = 2000;
+	const auto time = [&](auto lookup) {
+		size_t found = 0;
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++) {
+			for (const std::string &identifier : identifiers) {
+				if (lookup(identifier.c_str())) {
+					found++;
+				}
+			}
+		}
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		REQUIRE(found == identifiers.size() / 2 * repeats);
+		return duration.count() * 1.0e9 / (repeats * identifiers.size());
+	};
+	const double nsHash = time([&wl](const char *s) noexcept { return wl.InList(s); });
+	const double nsScan = time([&wl](const char *s) noexcept { return wl.InListAbbreviated(s, '~'); });
+	std::cout << "WordList " << wl.Length() << " words: InList " << nsHash << " ns, first character scan " << nsScan << " ns\n";
+}
+
 // Test WordClassifier.
 
 TEST_CASE("WordClassifier") {
@@ -53,7 +53,11 @@ SOURCES += \
     $$PWD/scintilla/src/CaseConvert.cxx \
     $$PWD/scintilla/src/CallTip.cxx \
     $$PWD/scintilla/src/AutoComplete.cxx \
+    $$PWD/scintilla/src/BackgroundStyler.cxx \
+    $$PWD/scintilla/src/BackgroundWrapper.cxx \
+    $$PWD/scintilla/src/BraceIndex.cxx \
     $$PWD/scintilla/src/ChangeHistory.cxx \
+    $$PWD/scintilla/src/PieceTable.cxx \
     $$PWD/scintilla/src/UndoHistory.cxx
 
 HEADERS  += \
@@ -871,6 +871,22 @@ std::string ScintillaCall::UndoActionText(int action) {
 	return CallReturnString(Message::GetUndoActionText, action);
 }
 
+void ScintillaCall::SetUndoMemoryLimit(Position bytes) {
+	Call(Message::SetUndoMemoryLimit, bytes);
+}
+
+Position ScintillaCall::UndoMemoryLimit() {
+	return Call(Message::GetUndoMemoryLimit);
+}
+
+Position ScintillaCall::UndoMemoryUsage() {
+	return Call(Message::GetUndoMemoryUsage);
+}
+
+Position ScintillaCall::MemoryUsage(Scintilla::MemoryCategory category) {
+	return Call(Message::GetMemoryUsage, static_cast<uintptr_t>(category));
+}
+
 void ScintillaCall::IndicSetStyle(int indicator, Scintilla::IndicatorStyle indicatorStyle) {
 	Call(Message::IndicSetStyle, indicator, static_cast<intptr_t>(indicatorStyle));
 }
@@ -1691,6 +1707,10 @@ void ScintillaCall::FoldAll(Scintilla::FoldAction action) {
 	Call(Message::FoldAll, static_cast<uintptr_t>(action));
 }
 
+void ScintillaCall::FoldAllAtLevel(Scintilla::FoldLevel level, Scintilla::FoldAction action) {
+	Call(Message::FoldAllAtLevel, static_cast<uintptr_t>(level), static_cast<intptr_t>(action));
+}
+
 void ScintillaCall::EnsureVisible(Line line) {
 	Call(Message::EnsureVisible, line);
 }
@@ -1755,6 +1775,14 @@ IdleStyling ScintillaCall::IdleStyling() {
 	return static_cast<Scintilla::IdleStyling>(Call(Message::GetIdleStyling));
 }
 
+void ScintillaCall::SetBackgroundStyling(bool backgroundStyling) {
+	Call(Message::SetBackgroundStyling, backgroundStyling);
+}
+
+bool ScintillaCall::BackgroundStyling() {
+	return Call(Message::GetBackgroundStyling);
+}
+
 void ScintillaCall::SetWrapMode(Scintilla::Wrap wrapMode) {
 	Call(Message::SetWrapMode, static_cast<uintptr_t>(wrapMode));
 }
@@ -2183,6 +2211,18 @@ Position ScintillaCall::BraceMatchNext(Position pos, Position startPos) {
 	return Call(Message::BraceMatchNext, pos, startPos);
 }
 
+Position ScintillaCall::TagMatch(Position pos, bool html) {
+	return Call(Message::TagMatch, pos, html);
+}
+
+void ScintillaCall::SetBackgroundIndexing(bool backgroundIndexing) {
+	Call(Message::SetBackgroundIndexing, backgroundIndexing);
+}
+
+bool ScintillaCall::BackgroundIndexing() {
+	return Call(Message::GetBackgroundIndexing);
+}
+
 bool ScintillaCall::ViewEOL() {
 	return Call(Message::GetViewEOL);
 }
@@ -2767,6 +2807,18 @@ int ScintillaCall::LayoutThreads() {
 	return static_cast<int>(Call(Message::GetLayoutThreads));
 }
 
+int ScintillaCall::WrapDuration(bool elapsed) {
+	return static_cast<int>(Call(Message::GetWrapDuration, elapsed));
+}
+
+void ScintillaCall::SetBackgroundWrapping(bool backgroundWrapping) {
+	Call(Message::SetBackgroundWrapping, backgroundWrapping);
+}
+
+bool ScintillaCall::BackgroundWrapping() {
+	return Call(Message::GetBackgroundWrapping);
+}
+
 void ScintillaCall::CopyAllowLine() {
 	Call(Message::CopyAllowLine);
 }
@@ -3251,6 +3303,14 @@ void *ScintillaCall::CreateLoader(Position bytes, Scintilla::DocumentOption docu
 	return reinterpret_cast<void *>(Call(Message::CreateLoader, bytes, static_cast<intptr_t>(documentOptions)));
 }
 
+Position ScintillaCall::SetMappedText(void *mappedText) {
+	return CallPointer(Message::SetMappedText, 0, mappedText);
+}
+
+bool ScintillaCall::DetachMappedText() {
+	return Call(Message::DetachMappedText);
+}
+
 void ScintillaCall::FindIndicatorShow(Position start, Position end) {
 	Call(Message::FindIndicatorShow, start, end);
 }
@@ -700,7 +700,7 @@ void ScintillaGTK::Init() {
 		caret.period = 0;
 	}
 
-	for (size_t tr = static_cast<size_t>(TickReason::caret); tr <= static_cast<size_t>(TickReason::dwell); tr++) {
+	for (size_t tr = static_cast<size_t>(TickReason::caret); tr <= static_cast<size_t>(TickReason::index); tr++) {
 		timers[tr].reason = static_cast<TickReason>(tr);
 		timers[tr].scintilla = this;
 	}
@@ -714,7 +714,7 @@ void ScintillaGTK::Init() {
 }
 
 void ScintillaGTK::Finalise() {
-	for (size_t tr = static_cast<size_t>(TickReason::caret); tr <= static_cast<size_t>(TickReason::dwell); tr++) {
+	for (size_t tr = static_cast<size_t>(TickReason::caret); tr <= static_cast<size_t>(TickReason::index); tr++) {
 		FineTickerCancel(static_cast<TickReason>(tr));
 	}
 	if (accessible) {
@@ -114,6 +114,83 @@ AutoComplete.o: \
 	../src/CharacterType.h \
 	../src/Position.h \
 	../src/AutoComplete.h
+BackgroundStyler.o: \
+	../src/BackgroundStyler.cxx \
+	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/PieceTable.h \
+	../src/CellBuffer.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/BackgroundStyler.h \
+	../src/UniConversion.h
+BackgroundWrapper.o: \
+	../src/BackgroundWrapper.cxx \
+	../include/ScintillaTypes.h \
+	../include/ScintillaMessages.h \
+	../include/ScintillaStructures.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/Geometry.h \
+	../src/Platform.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/UniqueString.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/ContractionState.h \
+	../src/CellBuffer.h \
+	../src/PerLine.h \
+	../src/KeyMap.h \
+	../src/Indicator.h \
+	../src/LineMarker.h \
+	../src/Style.h \
+	../src/ViewStyle.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/UniConversion.h \
+	../src/Selection.h \
+	../src/PositionCache.h \
+	../src/EditModel.h \
+	../src/MarginView.h \
+	../src/EditView.h \
+	../src/BackgroundWrapper.h
+BraceIndex.o: \
+	../src/BraceIndex.cxx \
+	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/PieceTable.h \
+	../src/CellBuffer.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/BraceIndex.h
 CallTip.o: \
 	../src/CallTip.cxx \
 	../include/ScintillaTypes.h \
@@ -135,6 +212,8 @@ CaseFolder.o: \
 CellBuffer.o: \
 	../src/CellBuffer.cxx \
 	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
 	../src/Debugging.h \
 	../src/Position.h \
 	../src/SplitVector.h \
@@ -142,6 +221,7 @@ CellBuffer.o: \
 	../src/RunStyles.h \
 	../src/SparseVector.h \
 	../src/ChangeHistory.h \
+	../src/PieceTable.h \
 	../src/CellBuffer.h \
 	../src/UndoHistory.h \
 	../src/UniConversion.h
@@ -200,12 +280,15 @@ Document.o: \
 	../src/SplitVector.h \
 	../src/Partitioning.h \
 	../src/RunStyles.h \
+	../src/PieceTable.h \
 	../src/CellBuffer.h \
 	../src/PerLine.h \
 	../src/CharClassify.h \
 	../src/Decoration.h \
 	../src/CaseFolder.h \
 	../src/Document.h \
+	../src/BackgroundStyler.h \
+	../src/BraceIndex.h \
 	../src/RESearch.h \
 	../src/UniConversion.h \
 	../src/ElapsedPeriod.h
@@ -275,6 +358,7 @@ Editor.o: \
 	../src/EditModel.h \
 	../src/MarginView.h \
 	../src/EditView.h \
+	../src/BackgroundWrapper.h \
 	../src/Editor.h \
 	../src/ElapsedPeriod.h
 EditView.o: \
@@ -387,6 +471,15 @@ PerLine.o: \
 	../src/Partitioning.h \
 	../src/CellBuffer.h \
 	../src/PerLine.h
+PieceTable.o: \
+	../src/PieceTable.cxx \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../src/Debugging.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/PieceTable.h
 PositionCache.o: \
 	../src/PositionCache.cxx \
 	../include/ScintillaTypes.h \
@@ -12,7 +12,7 @@
 
 namespace Scintilla {
 
-enum { dvRelease4=2 };
+enum { dvRelease4=2, dvRelease5=3 };
 
 class IDocument {
 public:
@@ -42,7 +42,12 @@ public:
 	virtual int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const = 0;
 };
 
-enum { lvRelease4=2, lvRelease5=3 };
+class IDocument5 : public IDocument {
+public:
+	virtual const char * SCI_METHOD RangePointer(Sci_Position position, Sci_Position rangeLength) = 0;
+};
+
+enum { lvRelease4=2, lvRelease5=3, lvRelease6=4 };
 
 class ILexer4 {
 public:
@@ -80,6 +85,16 @@ public:
 	virtual const char * SCI_METHOD PropertyGet(const char *key) = 0;
 };
 
+// Where lexing can restart without lexing the text before it, so ranges may be lexed concurrently.
+// lcLineStart: all state is reset at each line start.
+// lcLineState: state at a line start is the style of the previous character and the previous line state.
+enum { lcNone=0, lcLineStart=1, lcLineState=2 };
+
+class ILexer6 : public ILexer5 {
+public:
+	virtual int SCI_METHOD Checkpoint() = 0;
+};
+
 }
 
 #endif
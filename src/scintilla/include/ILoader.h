@@ -21,6 +21,15 @@ public:
 	virtual void * SCI_METHOD ConvertToDocument() = 0;
 };
 
+// Text owned by the application, commonly a memory mapped file, that a piece table document
+// refers to instead of copying. It must stay valid and unchanged until Release is called.
+class IMappedText {
+public:
+	virtual const char * SCI_METHOD Data() = 0;
+	virtual Sci_Position SCI_METHOD Length() = 0;
+	virtual void SCI_METHOD Release() = 0;
+};
+
 static constexpr int deRelease0 = 0;
 
 class IDocumentEditable {
@@ -368,6 +368,19 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETUNDOACTIONTYPE 2802
 #define SCI_GETUNDOACTIONPOSITION 2803
 #define SCI_GETUNDOACTIONTEXT 2804
+#define SCI_SETUNDOMEMORYLIMIT 2818
+#define SCI_GETUNDOMEMORYLIMIT 2819
+#define SCI_GETUNDOMEMORYUSAGE 2820
+#define SC_MEMORY_TEXT 0
+#define SC_MEMORY_STYLES 1
+#define SC_MEMORY_LINE_INDEX 2
+#define SC_MEMORY_LINE_DATA 3
+#define SC_MEMORY_UNDO 4
+#define SC_MEMORY_CHANGE_HISTORY 5
+#define SC_MEMORY_DECORATIONS 6
+#define SC_MEMORY_LAYOUT_CACHE 7
+#define SC_MEMORY_POSITION_CACHE 8
+#define SCI_GETMEMORYUSAGE 2821
 #define INDIC_PLAIN 0
 #define INDIC_SQUIGGLE 1
 #define INDIC_TT 2
@@ -649,6 +662,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_FOLDCHILDREN 2238
 #define SCI_EXPANDCHILDREN 2239
 #define SCI_FOLDALL 2662
+#define SCI_FOLDALLATLEVEL 2825
 #define SCI_ENSUREVISIBLE 2232
 #define SC_AUTOMATICFOLD_NONE 0x0000
 #define SC_AUTOMATICFOLD_SHOW 0x0001
@@ -681,6 +695,8 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SC_IDLESTYLING_ALL 3
 #define SCI_SETIDLESTYLING 2692
 #define SCI_GETIDLESTYLING 2693
+#define SCI_SETBACKGROUNDSTYLING 2823
+#define SCI_GETBACKGROUNDSTYLING 2824
 #define SC_WRAP_NONE 0
 #define SC_WRAP_WORD 1
 #define SC_WRAP_CHAR 2
@@ -818,6 +834,9 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_BRACEBADLIGHTINDICATOR 2499
 #define SCI_BRACEMATCH 2353
 #define SCI_BRACEMATCHNEXT 2369
+#define SCI_TAGMATCH 2830
+#define SCI_SETBACKGROUNDINDEXING 2831
+#define SCI_GETBACKGROUNDINDEXING 2832
 #define SCI_GETVIEWEOL 2355
 #define SCI_SETVIEWEOL 2356
 #define SCI_GETDOCPOINTER 2357
@@ -849,7 +868,9 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETZOOM 2374
 #define SC_DOCUMENTOPTION_DEFAULT 0
 #define SC_DOCUMENTOPTION_STYLES_NONE 0x1
+#define SC_DOCUMENTOPTION_STYLES_RUNS 0x2
 #define SC_DOCUMENTOPTION_TEXT_LARGE 0x100
+#define SC_DOCUMENTOPTION_PIECE_TABLE 0x200
 #define SCI_CREATEDOCUMENT 2375
 #define SCI_ADDREFDOCUMENT 2376
 #define SCI_RELEASEDOCUMENT 2377
@@ -1002,6 +1023,9 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETPOSITIONCACHE 2515
 #define SCI_SETLAYOUTTHREADS 2775
 #define SCI_GETLAYOUTTHREADS 2776
+#define SCI_GETWRAPDURATION 2826
+#define SCI_SETBACKGROUNDWRAPPING 2827
+#define SCI_GETBACKGROUNDWRAPPING 2828
 #define SCI_COPYALLOWLINE 2519
 #define SCI_CUTALLOWLINE 2810
 #define SCI_SETCOPYSEPARATOR 2811
@@ -1135,6 +1159,8 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_SETTECHNOLOGY 2630
 #define SCI_GETTECHNOLOGY 2631
 #define SCI_CREATELOADER 2632
+#define SCI_SETMAPPEDTEXT 2822
+#define SCI_DETACHMAPPEDTEXT 2829
 #define SCI_FINDINDICATORSHOW 2640
 #define SCI_FINDINDICATORFLASH 2641
 #define SCI_FINDINDICATORHIDE 2642
@@ -263,6 +263,10 @@ public:
 	Position UndoActionPosition(int action);
 	int UndoActionText(int action, char *text);
 	std::string UndoActionText(int action);
+	void SetUndoMemoryLimit(Position bytes);
+	Position UndoMemoryLimit();
+	Position UndoMemoryUsage();
+	Position MemoryUsage(Scintilla::MemoryCategory category);
 	void IndicSetStyle(int indicator, Scintilla::IndicatorStyle indicatorStyle);
 	Scintilla::IndicatorStyle IndicGetStyle(int indicator);
 	void IndicSetFore(int indicator, Colour fore);
@@ -468,6 +472,7 @@ public:
 	void FoldChildren(Line line, Scintilla::FoldAction action);
 	void ExpandChildren(Line line, Scintilla::FoldLevel level);
 	void FoldAll(Scintilla::FoldAction action);
+	void FoldAllAtLevel(Scintilla::FoldLevel level, Scintilla::FoldAction action);
 	void EnsureVisible(Line line);
 	void SetAutomaticFold(Scintilla::AutomaticFold automaticFold);
 	Scintilla::AutomaticFold AutomaticFold();
@@ -484,6 +489,8 @@ public:
 	bool IsRangeWord(Position start, Position end);
 	void SetIdleStyling(Scintilla::IdleStyling idleStyling);
 	Scintilla::IdleStyling IdleStyling();
+	void SetBackgroundStyling(bool backgroundStyling);
+	bool BackgroundStyling();
 	void SetWrapMode(Scintilla::Wrap wrapMode);
 	Scintilla::Wrap WrapMode();
 	void SetWrapVisualFlags(Scintilla::WrapVisualFlag wrapVisualFlags);
@@ -591,6 +598,9 @@ public:
 	void BraceBadLightIndicator(bool useSetting, int indicator);
 	Position BraceMatch(Position pos, int maxReStyle);
 	Position BraceMatchNext(Position pos, Position startPos);
+	Position TagMatch(Position pos, bool html);
+	void SetBackgroundIndexing(bool backgroundIndexing);
+	bool BackgroundIndexing();
 	bool ViewEOL();
 	void SetViewEOL(bool visible);
 	IDocumentEditable *DocPointer();
@@ -737,6 +747,9 @@ public:
 	int PositionCache();
 	void SetLayoutThreads(int threads);
 	int LayoutThreads();
+	int WrapDuration(bool elapsed);
+	void SetBackgroundWrapping(bool backgroundWrapping);
+	bool BackgroundWrapping();
 	void CopyAllowLine();
 	void CutAllowLine();
 	void SetCopySeparator(const char *separator);
@@ -858,6 +871,8 @@ public:
 	void SetTechnology(Scintilla::Technology technology);
 	Scintilla::Technology Technology();
 	void *CreateLoader(Position bytes, Scintilla::DocumentOption documentOptions);
+	Position SetMappedText(void *mappedText);
+	bool DetachMappedText();
 	void FindIndicatorShow(Position start, Position end);
 	void FindIndicatorFlash(Position start, Position end);
 	void FindIndicatorHide();
@@ -188,6 +188,10 @@ enum class Message {
 	GetUndoActionType = 2802,
 	GetUndoActionPosition = 2803,
 	GetUndoActionText = 2804,
+	SetUndoMemoryLimit = 2818,
+	GetUndoMemoryLimit = 2819,
+	GetUndoMemoryUsage = 2820,
+	GetMemoryUsage = 2821,
 	IndicSetStyle = 2080,
 	IndicGetStyle = 2081,
 	IndicSetFore = 2082,
@@ -387,6 +391,7 @@ enum class Message {
 	FoldChildren = 2238,
 	ExpandChildren = 2239,
 	FoldAll = 2662,
+	FoldAllAtLevel = 2825,
 	EnsureVisible = 2232,
 	SetAutomaticFold = 2663,
 	GetAutomaticFold = 2664,
@@ -403,6 +408,8 @@ enum class Message {
 	IsRangeWord = 2691,
 	SetIdleStyling = 2692,
 	GetIdleStyling = 2693,
+	SetBackgroundStyling = 2823,
+	GetBackgroundStyling = 2824,
 	SetWrapMode = 2268,
 	GetWrapMode = 2269,
 	SetWrapVisualFlags = 2460,
@@ -509,6 +516,9 @@ enum class Message {
 	BraceBadLightIndicator = 2499,
 	BraceMatch = 2353,
 	BraceMatchNext = 2369,
+	TagMatch = 2830,
+	SetBackgroundIndexing = 2831,
+	GetBackgroundIndexing = 2832,
 	GetViewEOL = 2355,
 	SetViewEOL = 2356,
 	GetDocPointer = 2357,
@@ -650,6 +660,9 @@ enum class Message {
 	GetPositionCache = 2515,
 	SetLayoutThreads = 2775,
 	GetLayoutThreads = 2776,
+	GetWrapDuration = 2826,
+	SetBackgroundWrapping = 2827,
+	GetBackgroundWrapping = 2828,
 	CopyAllowLine = 2519,
 	CutAllowLine = 2810,
 	SetCopySeparator = 2811,
@@ -766,6 +779,8 @@ enum class Message {
 	SetTechnology = 2630,
 	GetTechnology = 2631,
 	CreateLoader = 2632,
+	SetMappedText = 2822,
+	DetachMappedText = 2829,
 	FindIndicatorShow = 2640,
 	FindIndicatorFlash = 2641,
 	FindIndicatorHide = 2642,
@@ -209,6 +209,18 @@ enum class Layer {
 	OverText = 2,
 };
 
+enum class MemoryCategory {
+	Text = 0,
+	Styles = 1,
+	LineIndex = 2,
+	LineData = 3,
+	Undo = 4,
+	ChangeHistory = 5,
+	Decorations = 6,
+	LayoutCache = 7,
+	PositionCache = 8,
+};
+
 enum class IndicatorStyle {
 	Plain = 0,
 	Squiggle = 1,
@@ -424,7 +436,9 @@ enum class PopUp {
 enum class DocumentOption {
 	Default = 0,
 	StylesNone = 0x1,
+	StylesRuns = 0x2,
 	TextLarge = 0x100,
+	PieceTable = 0x200,
 };
 
 enum class Status {
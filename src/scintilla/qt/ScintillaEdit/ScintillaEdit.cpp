@@ -764,6 +764,22 @@ QByteArray ScintillaEdit::undoActionText(sptr_t action) const {
     return TextReturner(SCI_GETUNDOACTIONTEXT, action);
 }
 
+void ScintillaEdit::setUndoMemoryLimit(sptr_t bytes) {
+    send(SCI_SETUNDOMEMORYLIMIT, bytes, 0);
+}
+
+sptr_t ScintillaEdit::undoMemoryLimit() const {
+    return send(SCI_GETUNDOMEMORYLIMIT, 0, 0);
+}
+
+sptr_t ScintillaEdit::undoMemoryUsage() const {
+    return send(SCI_GETUNDOMEMORYUSAGE, 0, 0);
+}
+
+sptr_t ScintillaEdit::memoryUsage(sptr_t category) const {
+    return send(SCI_GETMEMORYUSAGE, category, 0);
+}
+
 void ScintillaEdit::indicSetStyle(sptr_t indicator, sptr_t indicatorStyle) {
     send(SCI_INDICSETSTYLE, indicator, indicatorStyle);
 }
@@ -1536,6 +1552,10 @@ void ScintillaEdit::foldAll(sptr_t action) {
     send(SCI_FOLDALL, action, 0);
 }
 
+void ScintillaEdit::foldAllAtLevel(sptr_t level, sptr_t action) {
+    send(SCI_FOLDALLATLEVEL, level, action);
+}
+
 void ScintillaEdit::ensureVisible(sptr_t line) {
     send(SCI_ENSUREVISIBLE, line, 0);
 }
@@ -1600,6 +1620,14 @@ sptr_t ScintillaEdit::idleStyling() const {
     return send(SCI_GETIDLESTYLING, 0, 0);
 }
 
+void ScintillaEdit::setBackgroundStyling(bool backgroundStyling) {
+    send(SCI_SETBACKGROUNDSTYLING, backgroundStyling, 0);
+}
+
+bool ScintillaEdit::backgroundStyling() const {
+    return send(SCI_GETBACKGROUNDSTYLING, 0, 0);
+}
+
 void ScintillaEdit::setWrapMode(sptr_t wrapMode) {
     send(SCI_SETWRAPMODE, wrapMode, 0);
 }
@@ -2024,6 +2052,18 @@ sptr_t ScintillaEdit::braceMatchNext(sptr_t pos, sptr_t startPos) {
     return send(SCI_BRACEMATCHNEXT, pos, startPos);
 }
 
+sptr_t ScintillaEdit::tagMatch(sptr_t pos, bool html) {
+    return send(SCI_TAGMATCH, pos, html);
+}
+
+void ScintillaEdit::setBackgroundIndexing(bool backgroundIndexing) {
+    send(SCI_SETBACKGROUNDINDEXING, backgroundIndexing, 0);
+}
+
+bool ScintillaEdit::backgroundIndexing() const {
+    return send(SCI_GETBACKGROUNDINDEXING, 0, 0);
+}
+
 bool ScintillaEdit::viewEOL() const {
     return send(SCI_GETVIEWEOL, 0, 0);
 }
@@ -2588,6 +2628,18 @@ sptr_t ScintillaEdit::layoutThreads() const {
     return send(SCI_GETLAYOUTTHREADS, 0, 0);
 }
 
+sptr_t ScintillaEdit::wrapDuration(bool elapsed) const {
+    return send(SCI_GETWRAPDURATION, elapsed, 0);
+}
+
+void ScintillaEdit::setBackgroundWrapping(bool backgroundWrapping) {
+    send(SCI_SETBACKGROUNDWRAPPING, backgroundWrapping, 0);
+}
+
+bool ScintillaEdit::backgroundWrapping() const {
+    return send(SCI_GETBACKGROUNDWRAPPING, 0, 0);
+}
+
 void ScintillaEdit::copyAllowLine() {
     send(SCI_COPYALLOWLINE, 0, 0);
 }
@@ -3052,6 +3104,14 @@ sptr_t ScintillaEdit::createLoader(sptr_t bytes, sptr_t documentOptions) {
     return send(SCI_CREATELOADER, bytes, documentOptions);
 }
 
+sptr_t ScintillaEdit::setMappedText(sptr_t mappedText) {
+    return send(SCI_SETMAPPEDTEXT, 0, mappedText);
+}
+
+bool ScintillaEdit::detachMappedText() {
+    return send(SCI_DETACHMAPPEDTEXT, 0, 0);
+}
+
 void ScintillaEdit::findIndicatorShow(sptr_t start, sptr_t end) {
     send(SCI_FINDINDICATORSHOW, start, end);
 }
@@ -229,6 +229,10 @@ public:
 	sptr_t undoActionType(sptr_t action) const;
 	sptr_t undoActionPosition(sptr_t action) const;
 	QByteArray undoActionText(sptr_t action) const;
+	void setUndoMemoryLimit(sptr_t bytes);
+	sptr_t undoMemoryLimit() const;
+	sptr_t undoMemoryUsage() const;
+	sptr_t memoryUsage(sptr_t category) const;
 	void indicSetStyle(sptr_t indicator, sptr_t indicatorStyle);
 	sptr_t indicStyle(sptr_t indicator) const;
 	void indicSetFore(sptr_t indicator, sptr_t fore);
@@ -422,6 +426,7 @@ public:
 	void foldChildren(sptr_t line, sptr_t action);
 	void expandChildren(sptr_t line, sptr_t level);
 	void foldAll(sptr_t action);
+	void foldAllAtLevel(sptr_t level, sptr_t action);
 	void ensureVisible(sptr_t line);
 	void setAutomaticFold(sptr_t automaticFold);
 	sptr_t automaticFold() const;
@@ -438,6 +443,8 @@ public:
 	bool isRangeWord(sptr_t start, sptr_t end);
 	void setIdleStyling(sptr_t idleStyling);
 	sptr_t idleStyling() const;
+	void setBackgroundStyling(bool backgroundStyling);
+	bool backgroundStyling() const;
 	void setWrapMode(sptr_t wrapMode);
 	sptr_t wrapMode() const;
 	void setWrapVisualFlags(sptr_t wrapVisualFlags);
@@ -544,6 +551,9 @@ public:
 	void braceBadLightIndicator(bool useSetting, sptr_t indicator);
 	sptr_t braceMatch(sptr_t pos, sptr_t maxReStyle);
 	sptr_t braceMatchNext(sptr_t pos, sptr_t startPos);
+	sptr_t tagMatch(sptr_t pos, bool html);
+	void setBackgroundIndexing(bool backgroundIndexing);
+	bool backgroundIndexing() const;
 	bool viewEOL() const;
 	void setViewEOL(bool visible);
 	sptr_t docPointer() const;
@@ -685,6 +695,9 @@ public:
 	sptr_t positionCache() const;
 	void setLayoutThreads(sptr_t threads);
 	sptr_t layoutThreads() const;
+	sptr_t wrapDuration(bool elapsed) const;
+	void setBackgroundWrapping(bool backgroundWrapping);
+	bool backgroundWrapping() const;
 	void copyAllowLine();
 	void cutAllowLine();
 	void setCopySeparator(const char * separator);
@@ -801,6 +814,8 @@ public:
 	void setTechnology(sptr_t technology);
 	sptr_t technology() const;
 	sptr_t createLoader(sptr_t bytes, sptr_t documentOptions);
+	sptr_t setMappedText(sptr_t mappedText);
+	bool detachMappedText();
 	void findIndicatorShow(sptr_t start, sptr_t end);
 	void findIndicatorFlash(sptr_t start, sptr_t end);
 	void findIndicatorHide();
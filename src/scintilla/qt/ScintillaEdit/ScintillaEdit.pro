@@ -32,6 +32,7 @@ SOURCES += \
     ../../src/RunStyles.cxx \
     ../../src/RESearch.cxx \
     ../../src/PositionCache.cxx \
+    ../../src/PieceTable.cxx \
     ../../src/PerLine.cxx \
     ../../src/MarginView.cxx \
     ../../src/LineMarker.cxx \
@@ -53,6 +54,9 @@ SOURCES += \
     ../../src/CaseFolder.cxx \
     ../../src/CaseConvert.cxx \
     ../../src/CallTip.cxx \
+    ../../src/BraceIndex.cxx \
+    ../../src/BackgroundWrapper.cxx \
+    ../../src/BackgroundStyler.cxx \
     ../../src/AutoComplete.cxx
 
 HEADERS  += \
@@ -27,6 +27,7 @@
 #include <QPaintEngine>
 #include <QWidget>
 #include <QPixmap>
+#include <QImage>
 #include <QPainter>
 #include <QPainterPath>
 #include <QMenu>
@@ -191,6 +192,19 @@ SurfaceImpl::SurfaceImpl(int width, int height, SurfaceMode mode_)
 	mode = mode_;
 }
 
+// For measuring text on a worker thread: unlike a pixmap, an image may be used off the GUI
+// thread and it is given the resolution of the device so text measures the same.
+SurfaceImpl::SurfaceImpl(const QPaintDevice *resolution, SurfaceMode mode_)
+{
+	QImage *image = new QImage(1, 1, QImage::Format_ARGB32_Premultiplied);
+	image->setDotsPerMeterX(qRound(resolution->logicalDpiX() / 0.0254));
+	image->setDotsPerMeterY(qRound(resolution->logicalDpiY() / 0.0254));
+	image->setDevicePixelRatio(resolution->devicePixelRatioF());
+	deviceOwned = true;
+	device = image;
+	mode = mode_;
+}
+
 SurfaceImpl::~SurfaceImpl()
 {
 	Clear();
@@ -85,6 +85,7 @@ private:
 public:
 	SurfaceImpl();
 	SurfaceImpl(int width, int height, SurfaceMode mode_);
+	SurfaceImpl(const QPaintDevice *resolution, SurfaceMode mode_);
 	virtual ~SurfaceImpl() override;
 
 	void Init(WindowID wid) override;
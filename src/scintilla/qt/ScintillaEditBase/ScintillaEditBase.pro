@@ -30,6 +30,7 @@ SOURCES += \
     ../../src/RunStyles.cxx \
     ../../src/RESearch.cxx \
     ../../src/PositionCache.cxx \
+    ../../src/PieceTable.cxx \
     ../../src/PerLine.cxx \
     ../../src/MarginView.cxx \
     ../../src/LineMarker.cxx \
@@ -51,6 +52,9 @@ SOURCES += \
     ../../src/CaseFolder.cxx \
     ../../src/CaseConvert.cxx \
     ../../src/CallTip.cxx \
+    ../../src/BraceIndex.cxx \
+    ../../src/BackgroundWrapper.cxx \
+    ../../src/BackgroundStyler.cxx \
     ../../src/AutoComplete.cxx
 
 HEADERS  += \
@@ -69,6 +73,7 @@ HEADERS  += \
     ../../src/RESearch.h \
     ../../src/PositionCache.h \
     ../../src/Platform.h \
+    ../../src/PieceTable.h \
     ../../src/PerLine.h \
     ../../src/Partitioning.h \
     ../../src/LineMarker.h \
@@ -87,6 +92,9 @@ HEADERS  += \
     ../../src/CaseFolder.h \
     ../../src/CaseConvert.h \
     ../../src/CallTip.h \
+    ../../src/BraceIndex.h \
+    ../../src/BackgroundWrapper.h \
+    ../../src/BackgroundStyler.h \
     ../../src/AutoComplete.h \
     ../../include/Scintilla.h \
     ../../include/ILexer.h
@@ -19,6 +19,7 @@
 #include <QMimeData>
 #include <QMenu>
 #include <QTextCodec>
+#include <QFontDatabase>
 #include <QScrollBar>
 #include <QTimer>
 
@@ -272,6 +273,17 @@ std::string ScintillaQt::EncodedFromUTF8(std::string_view utf8) const {
 	}
 }
 
+std::unique_ptr<Surface> ScintillaQt::CreateWorkerSurface() const
+{
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	if (!QFontDatabase::supportsThreadedFontRendering())
+		return {};
+#endif
+	if (!wMain.GetID())
+		return {};
+	return std::make_unique<SurfaceImpl>(static_cast<QWidget *>(wMain.GetID()), CurrentSurfaceMode());
+}
+
 void ScintillaQt::ScrollText(Sci::Line linesToMove)
 {
 	int dy = vs.lineHeight * (linesToMove);
@@ -465,7 +477,7 @@ void ScintillaQt::FineTickerStart(TickReason reason, int millis, int /* toleranc
 // called during destruction.
 void ScintillaQt::CancelTimers()
 {
-	for (size_t tr = static_cast<size_t>(TickReason::caret); tr <= static_cast<size_t>(TickReason::dwell); tr++) {
+	for (size_t tr = static_cast<size_t>(TickReason::caret); tr <= static_cast<size_t>(TickReason::index); tr++) {
 		if (timers[tr]) {
 			killTimer(timers[tr]);
 			timers[tr] = 0;
@@ -865,7 +877,7 @@ void ScintillaQt::DropUrls(const QMimeData *data)
 
 void ScintillaQt::timerEvent(QTimerEvent *event)
 {
-	for (size_t tr=static_cast<size_t>(TickReason::caret); tr<=static_cast<size_t>(TickReason::dwell); tr++) {
+	for (size_t tr=static_cast<size_t>(TickReason::caret); tr<=static_cast<size_t>(TickReason::index); tr++) {
 		if (timers[tr] == event->timerId()) {
 			TickFor(static_cast<TickReason>(tr));
 		}
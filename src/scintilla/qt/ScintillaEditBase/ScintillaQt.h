@@ -111,6 +111,7 @@ private:
 	bool ValidCodePage(int codePage) const override;
 	std::string UTF8FromEncoded(std::string_view encoded) const override;
 	std::string EncodedFromUTF8(std::string_view utf8) const override;
+	std::unique_ptr<Surface> CreateWorkerSurface() const override;
 
 private:
 	void ScrollText(Sci::Line linesToMove) override;
@@ -128,7 +129,7 @@ private:
 	void NotifyFocus(bool focus) override;
 	void NotifyParent(Scintilla::NotificationData scn) override;
 	void NotifyURIDropped(const char *uri);
-	int timers[static_cast<size_t>(TickReason::dwell)+1]{};
+	int timers[static_cast<size_t>(TickReason::index)+1]{};
 	bool FineTickerRunning(TickReason reason) override;
 	void FineTickerStart(TickReason reason, int millis, int tolerance) override;
 	void CancelTimers();
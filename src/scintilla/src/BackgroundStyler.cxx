@@ -0,0 +1,549 @@
+// Scintilla source code edit control
+/** @file BackgroundStyler.cxx
+ ** Runs a lexer on another thread against a snapshot of a document.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <future>
+
+#include "ScintillaTypes.h"
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+
+#include "CharacterType.h"
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "PieceTable.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "BackgroundStyler.h"
+#include "UniConversion.h"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace {
+
+// Lexing is published in chunks of about this size so results appear progressively and
+// stopping the worker never waits long.
+constexpr Sci::Position chunkSize = 0x40000;
+
+// Lexers that back up to a safe start may restyle this much before a concurrently lexed piece.
+constexpr Sci::Position pieceLookBehind = 0x10000;
+// Text after the end of the range lets lexers that look ahead see what they would in the document.
+constexpr Sci::Position pieceLookAhead = 0x10000;
+
+}
+
+SnapshotText::SnapshotText(const Document &document, Sci::Position length) :
+	text(length, '\0'),
+	codePage(document.dbcsCodePage),
+	tabInChars(document.tabInChars),
+	unicodeLineEnds(document.GetLineEndTypesActive() == LineEndType::Unicode) {
+	document.GetCharRange(text.data(), 0, length);
+	const Sci::Line lines = document.SciLineFromPosition(length) + 1;
+	lineStarts.reserve(lines);
+	for (Sci::Line line = 0; line < lines; line++) {
+		lineStarts.push_back(document.LineStart(line));
+	}
+}
+
+StyleSnapshot::StyleSnapshot(const Document &document, std::shared_ptr<const SnapshotText> source_,
+	Sci::Position stylesStart_, Sci::Position end, bool copyState) :
+	source(std::move(source_)),
+	stylesStart(stylesStart_),
+	styles(end - stylesStart_, '\0'),
+	linesStart(document.SciLineFromPosition(stylesStart_)) {
+	// Include the line after the end as folders set its level
+	const Sci::Line linesEnd = std::min<Sci::Line>(document.SciLineFromPosition(end) + 2, Lines());
+	levels.assign(linesEnd - linesStart, static_cast<int>(FoldLevel::Base));
+	lineStates.assign(linesEnd - linesStart, 0);
+	if (copyState) {
+		document.GetStyleRange(reinterpret_cast<unsigned char *>(styles.data()), stylesStart, end - stylesStart);
+		for (Sci::Line line = linesStart; line < linesEnd; line++) {
+			levels[line - linesStart] = document.GetLevel(line);
+			lineStates[line - linesStart] = document.GetLineState(line);
+		}
+	}
+}
+
+unsigned char StyleSnapshot::UCharAt(Sci::Position position) const noexcept {
+	if ((position < 0) || (position >= Length())) {
+		return 0;
+	}
+	return source->text[position];
+}
+
+bool StyleSnapshot::HoldsLine(Sci::Line line) const noexcept {
+	return (line >= linesStart) && (line < linesStart + static_cast<Sci::Line>(levels.size()));
+}
+
+void StyleSnapshot::Styled(Sci::Position first, Sci::Position end) noexcept {
+	if (first >= end) {
+		return;
+	}
+	if (styledFirst < 0) {
+		styledFirst = first;
+		styledEnd = end;
+	} else {
+		styledFirst = std::min(styledFirst, first);
+		styledEnd = std::max(styledEnd, end);
+	}
+}
+
+void StyleSnapshot::LineChanged(Sci::Line line) noexcept {
+	if (lineFirst < 0) {
+		lineFirst = line;
+		lineLast = line;
+	} else {
+		lineFirst = std::min(lineFirst, line);
+		lineLast = std::max(lineLast, line);
+	}
+}
+
+Sci::Line StyleSnapshot::Lines() const noexcept {
+	return source->lineStarts.size();
+}
+
+StyledChunk StyleSnapshot::TakeChunk() {
+	StyledChunk chunk = std::move(pending);
+	pending = StyledChunk();
+	if (styledFirst >= 0) {
+		chunk.position = styledFirst;
+		chunk.styles = styles.substr(styledFirst - stylesStart, styledEnd - styledFirst);
+	}
+	if (lineFirst >= 0) {
+		chunk.line = lineFirst;
+		chunk.levels.assign(levels.begin() + (lineFirst - linesStart), levels.begin() + (lineLast - linesStart + 1));
+		chunk.lineStates.assign(lineStates.begin() + (lineFirst - linesStart), lineStates.begin() + (lineLast - linesStart + 1));
+	}
+	styledFirst = -1;
+	styledEnd = -1;
+	lineFirst = -1;
+	lineLast = -1;
+	return chunk;
+}
+
+int SCI_METHOD StyleSnapshot::Version() const noexcept {
+	return Scintilla::dvRelease5;
+}
+
+void SCI_METHOD StyleSnapshot::SetErrorStatus(int status) noexcept {
+	pending.errorStatus = status;
+}
+
+Sci_Position SCI_METHOD StyleSnapshot::Length() const noexcept {
+	return source->text.length();
+}
+
+void SCI_METHOD StyleSnapshot::GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const noexcept {
+	if ((position >= 0) && (lengthRetrieve >= 0) && (position + lengthRetrieve <= Length())) {
+		memcpy(buffer, source->text.data() + position, lengthRetrieve);
+		return;
+	}
+	for (Sci_Position i = 0; i < lengthRetrieve; i++) {
+		buffer[i] = UCharAt(position + i);
+	}
+}
+
+char SCI_METHOD StyleSnapshot::StyleAt(Sci_Position position) const noexcept {
+	if ((position < stylesStart) || (position >= stylesStart + static_cast<Sci::Position>(styles.length()))) {
+		return 0;
+	}
+	return styles[position - stylesStart];
+}
+
+Sci_Position SCI_METHOD StyleSnapshot::LineFromPosition(Sci_Position position) const noexcept {
+	if (position <= 0) {
+		return 0;
+	}
+	const std::vector<Sci::Position> &lineStarts = source->lineStarts;
+	const std::vector<Sci::Position>::const_iterator it = std::upper_bound(lineStarts.begin(), lineStarts.end(), position);
+	return (it - lineStarts.begin()) - 1;
+}
+
+Sci_Position SCI_METHOD StyleSnapshot::LineStart(Sci_Position line) const noexcept {
+	if (line < 0) {
+		return 0;
+	}
+	if (line >= Lines()) {
+		return Length();
+	}
+	return source->lineStarts[line];
+}
+
+int SCI_METHOD StyleSnapshot::GetLevel(Sci_Position line) const noexcept {
+	if (!HoldsLine(line)) {
+		return static_cast<int>(FoldLevel::Base);
+	}
+	return levels[line - linesStart];
+}
+
+int SCI_METHOD StyleSnapshot::SetLevel(Sci_Position line, int level) noexcept {
+	if (!HoldsLine(line)) {
+		return 0;
+	}
+	const int previous = levels[line - linesStart];
+	levels[line - linesStart] = level;
+	LineChanged(line);
+	return previous;
+}
+
+int SCI_METHOD StyleSnapshot::GetLineState(Sci_Position line) const noexcept {
+	if (!HoldsLine(line)) {
+		return 0;
+	}
+	return lineStates[line - linesStart];
+}
+
+int SCI_METHOD StyleSnapshot::SetLineState(Sci_Position line, int state) noexcept {
+	if (!HoldsLine(line)) {
+		return 0;
+	}
+	const int previous = lineStates[line - linesStart];
+	lineStates[line - linesStart] = state;
+	LineChanged(line);
+	return previous;
+}
+
+void SCI_METHOD StyleSnapshot::StartStyling(Sci_Position position) noexcept {
+	endStyling = position;
+}
+
+bool SCI_METHOD StyleSnapshot::SetStyleFor(Sci_Position length, char style) noexcept {
+	// Styles outside the copied span can not be changed
+	const Sci::Position first = std::max(endStyling, stylesStart);
+	const Sci::Position end = std::min<Sci::Position>(endStyling + length, stylesStart + styles.length());
+	for (Sci::Position position = first; position < end; position++) {
+		styles[position - stylesStart] = style;
+	}
+	Styled(first, end);
+	endStyling += length;
+	return true;
+}
+
+bool SCI_METHOD StyleSnapshot::SetStyles(Sci_Position length, const char *styles_) noexcept {
+	const Sci::Position first = std::max(endStyling, stylesStart);
+	const Sci::Position end = std::min<Sci::Position>(endStyling + length, stylesStart + styles.length());
+	for (Sci::Position position = first; position < end; position++) {
+		styles[position - stylesStart] = styles_[position - endStyling];
+	}
+	Styled(first, end);
+	endStyling += length;
+	return true;
+}
+
+void SCI_METHOD StyleSnapshot::DecorationSetCurrentIndicator(int indicator) noexcept {
+	currentIndicator = indicator;
+}
+
+void SCI_METHOD StyleSnapshot::DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) {
+	pending.fills.push_back({currentIndicator, position, value, fillLength});
+}
+
+void SCI_METHOD StyleSnapshot::ChangeLexerState(Sci_Position start, Sci_Position end) noexcept {
+	if (pending.lexerStateStart < 0) {
+		pending.lexerStateStart = start;
+		pending.lexerStateEnd = end;
+	} else {
+		pending.lexerStateStart = std::min(pending.lexerStateStart, start);
+		pending.lexerStateEnd = std::max(pending.lexerStateEnd, end);
+	}
+}
+
+int SCI_METHOD StyleSnapshot::CodePage() const noexcept {
+	return source->codePage;
+}
+
+bool SCI_METHOD StyleSnapshot::IsDBCSLeadByte(char) const noexcept {
+	return false;
+}
+
+const char *SCI_METHOD StyleSnapshot::BufferPointer() noexcept {
+	return source->text.c_str();
+}
+
+int SCI_METHOD StyleSnapshot::GetLineIndentation(Sci_Position line) noexcept {
+	int indent = 0;
+	if ((line >= 0) && (line < Lines())) {
+		for (Sci::Position i = LineStart(line); i < Length(); i++) {
+			const char ch = source->text[i];
+			if (ch == ' ')
+				indent++;
+			else if (ch == '\t')
+				indent = ((indent / source->tabInChars) + 1) * source->tabInChars;
+			else
+				return indent;
+		}
+	}
+	return indent;
+}
+
+Sci_Position SCI_METHOD StyleSnapshot::LineEnd(Sci_Position line) const noexcept {
+	if (line >= Lines() - 1) {
+		return LineStart(line + 1);
+	}
+	Sci::Position position = LineStart(line + 1);
+	if (source->unicodeLineEnds) {
+		const unsigned char bytes[] = {
+			UCharAt(position - 3),
+			UCharAt(position - 2),
+			UCharAt(position - 1),
+		};
+		if (UTF8IsSeparator(bytes)) {
+			return position - UTF8SeparatorLength;
+		}
+		if (UTF8IsNEL(bytes + 1)) {
+			return position - UTF8NELLength;
+		}
+	}
+	position--; // Back over CR or LF
+	// When line terminator is CR+LF, may need to go back one more
+	if ((position > LineStart(line)) && (UCharAt(position - 1) == '\r')) {
+		position--;
+	}
+	return position;
+}
+
+Sci_Position SCI_METHOD StyleSnapshot::GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const noexcept {
+	Sci::Position pos = positionStart;
+	if (source->codePage == CpUtf8) {
+		while (characterOffset > 0) {
+			if (pos >= Length())
+				return Sci::invalidPosition;
+			Sci_Position width = 1;
+			GetCharacterAndWidth(pos, &width);
+			pos += width;
+			characterOffset--;
+		}
+		while (characterOffset < 0) {
+			if (pos <= 0)
+				return Sci::invalidPosition;
+			// Back over trail bytes to a lead byte whose character ends at pos
+			Sci::Position posPrevious = pos - 1;
+			for (Sci::Position back = pos - 1; (back >= 0) && (back >= pos - UTF8MaxBytes); back--) {
+				if (!UTF8IsTrailByte(UCharAt(back))) {
+					Sci_Position width = 1;
+					GetCharacterAndWidth(back, &width);
+					if (back + width == pos)
+						posPrevious = back;
+					break;
+				}
+			}
+			pos = posPrevious;
+			characterOffset++;
+		}
+	} else {
+		pos = positionStart + characterOffset;
+		if ((pos < 0) || (pos > Length()))
+			return Sci::invalidPosition;
+	}
+	return pos;
+}
+
+int SCI_METHOD StyleSnapshot::GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const noexcept {
+	int bytesInCharacter = 1;
+	const unsigned char leadByte = UCharAt(position);
+	int character = leadByte;
+	if ((source->codePage == CpUtf8) && !UTF8IsAscii(leadByte)) {
+		const int widthCharBytes = UTF8BytesOfLead[leadByte];
+		unsigned char charBytes[UTF8MaxBytes] = {leadByte,0,0,0};
+		for (int b=1; b<widthCharBytes; b++)
+			charBytes[b] = UCharAt(position+b);
+		const int utf8status = UTF8Classify(charBytes, widthCharBytes);
+		if (utf8status & UTF8MaskInvalid) {
+			// Report as singleton surrogate values which are invalid Unicode
+			character =  0xDC80 + leadByte;
+		} else {
+			bytesInCharacter = utf8status & UTF8MaskWidth;
+			character = UnicodeFromUTF8(charBytes);
+		}
+	}
+	if (pWidth) {
+		*pWidth = bytesInCharacter;
+	}
+	return character;
+}
+
+const char *SCI_METHOD StyleSnapshot::RangePointer(Sci_Position position, Sci_Position rangeLength) noexcept {
+	if ((position < 0) || (rangeLength < 0) || (position + rangeLength > Length())) {
+		return nullptr;
+	}
+	return source->text.c_str() + position;
+}
+
+BackgroundStyler::BackgroundStyler(std::unique_ptr<StyleSnapshot> snapshot_, Sci::Position start_, Sci::Position end_) :
+	snapshot(std::move(snapshot_)), start(start_), end(end_), limit(snapshot->Length()) {
+}
+
+BackgroundStyler::~BackgroundStyler() {
+	Cancel();
+	Wait();
+}
+
+void BackgroundStyler::Run(ILexer5 *instance) {
+	try {
+		Sci::Position position = start;
+		while ((position < end) && !stopping && !cancelled) {
+			Sci::Position chunkEnd = std::min(position + chunkSize, end);
+			if (chunkEnd < end) {
+				// End chunks at line starts, the same way that styling on the main thread proceeds
+				chunkEnd = std::min<Sci::Position>(end, snapshot->LineStart(snapshot->LineFromPosition(chunkEnd) + 1));
+			}
+			const Sci::Position length = chunkEnd - position;
+			int styleStart = 0;
+			if (position > 0)
+				styleStart = snapshot->StyleAt(position - 1);
+			instance->Lex(position, length, styleStart, snapshot.get());
+			instance->Fold(position, length, styleStart, snapshot.get());
+			StyledChunk chunk = snapshot->TakeChunk();
+			{
+				std::lock_guard<std::mutex> guard(mutexChunks);
+				chunks.push_back(std::move(chunk));
+			}
+			position = chunkEnd;
+		}
+	} catch (...) {
+		// Whatever was not published is left for the main thread to style
+	}
+}
+
+void BackgroundStyler::Start(ILexer5 *instance) {
+	worker = std::async(std::launch::async, [this, instance]() {
+		Run(instance);
+	});
+}
+
+bool BackgroundStyler::Running() const {
+	return worker.valid() && (worker.wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+}
+
+Sci::Position BackgroundStyler::Limit() const noexcept {
+	return limit;
+}
+
+void BackgroundStyler::Stop() noexcept {
+	stopping = true;
+}
+
+void BackgroundStyler::Cancel() noexcept {
+	cancelled = true;
+}
+
+bool BackgroundStyler::Cancelled() const noexcept {
+	return cancelled;
+}
+
+void BackgroundStyler::Wait() const {
+	if (worker.valid()) {
+		worker.wait();
+	}
+}
+
+std::vector<StyledChunk> BackgroundStyler::TakeChunks() {
+	std::vector<StyledChunk> taken;
+	std::lock_guard<std::mutex> guard(mutexChunks);
+	taken.swap(chunks);
+	if (cancelled) {
+		// Results from a stale snapshot are discarded
+		taken.clear();
+	}
+	return taken;
+}
+
+ConcurrentStyler::ConcurrentStyler(const Document &document, Sci::Position start, Sci::Position end, size_t count) {
+	const Sci::Position lengthDoc = document.Length();
+	const Sci::Line lineLast = document.SciLineFromPosition(std::min(end + pieceLookAhead, lengthDoc));
+	std::shared_ptr<const SnapshotText> source = std::make_shared<SnapshotText>(
+		document, std::min(document.LineStart(lineLast + 1), lengthDoc));
+	Sci::Position pieceStart = start;
+	for (size_t piece = 0; piece < count; piece++) {
+		Sci::Position pieceEnd = end;
+		if (piece < count - 1) {
+			const Sci::Position split = start + static_cast<Sci::Position>((end - start) * (piece + 1) / count);
+			pieceEnd = std::min(document.LineStart(document.SciLineFromPosition(split) + 1), end);
+		}
+		if (pieceEnd > pieceStart) {
+			const Sci::Position stylesStart = document.LineStartPosition(std::max<Sci::Position>(pieceStart - pieceLookBehind, 0));
+			pieces.push_back({pieceStart, pieceEnd,
+				std::make_unique<StyleSnapshot>(document, source, stylesStart, pieceEnd, pieces.empty())});
+			pieceStart = pieceEnd;
+		}
+	}
+}
+
+void ConcurrentStyler::LexPiece(ILexer5 *instance, size_t piece, int initStyle) {
+	const Piece &p = pieces[piece];
+	instance->Lex(p.start, p.end - p.start, initStyle, p.snapshot.get());
+}
+
+void ConcurrentStyler::Lex(ILexer5 *instance, int initStyle) {
+	std::vector<std::future<void>> futures;
+	for (size_t piece = 1; piece < pieces.size(); piece++) {
+		futures.push_back(std::async(std::launch::async, [this, instance, piece]() {
+			LexPiece(instance, piece, 0);
+		}));
+	}
+	LexPiece(instance, 0, initStyle);
+	for (std::future<void> &f : futures) {
+		// Rethrows any exception from the lexer
+		f.get();
+	}
+}
+
+size_t ConcurrentStyler::Pieces() const noexcept {
+	return pieces.size();
+}
+
+Sci::Position ConcurrentStyler::PieceStart(size_t piece) const noexcept {
+	return pieces[piece].start;
+}
+
+Sci::Position ConcurrentStyler::PieceEnd(size_t piece) const noexcept {
+	return pieces[piece].end;
+}
+
+const StyleSnapshot &ConcurrentStyler::Snapshot(size_t piece) const noexcept {
+	return *pieces[piece].snapshot;
+}
+
+StyledChunk ConcurrentStyler::Results(size_t piece, Sci::Position from) {
+	StyledChunk chunk = pieces[piece].snapshot->TakeChunk();
+	if ((from > 0) && !chunk.styles.empty() && (chunk.position < from)) {
+		chunk.styles.erase(0, std::min<size_t>(from - chunk.position, chunk.styles.length()));
+		chunk.position = from;
+	}
+	const Sci::Line lineFrom = pieces[piece].snapshot->LineFromPosition(from);
+	if ((from > 0) && !chunk.levels.empty() && (chunk.line < lineFrom)) {
+		const size_t drop = std::min<size_t>(lineFrom - chunk.line, chunk.levels.size());
+		chunk.levels.erase(chunk.levels.begin(), chunk.levels.begin() + drop);
+		chunk.lineStates.erase(chunk.lineStates.begin(), chunk.lineStates.begin() + drop);
+		chunk.line = lineFrom;
+	}
+	return chunk;
+}
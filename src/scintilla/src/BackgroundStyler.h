@@ -0,0 +1,181 @@
+// Scintilla source code edit control
+/** @file BackgroundStyler.h
+ ** Runs a lexer on another thread against a snapshot of a document.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef BACKGROUNDSTYLER_H
+#define BACKGROUNDSTYLER_H
+
+namespace Scintilla::Internal {
+
+/**
+ * The results of lexing part of a snapshot, to be merged into the document on the main thread.
+ */
+struct StyledChunk {
+	Sci::Position position = 0;	// Start of styles
+	std::string styles;
+	Sci::Line line = 0;	// First line of levels and lineStates
+	std::vector<int> levels;
+	std::vector<int> lineStates;
+	struct Fill {
+		int indicator;
+		Sci::Position position;
+		int value;
+		Sci::Position fillLength;
+	};
+	std::vector<Fill> fills;
+	Sci::Position lexerStateStart = -1;
+	Sci::Position lexerStateEnd = -1;
+	int errorStatus = 0;
+};
+
+/**
+ * The text and line starts of the start of a document, copied so that it can be shared by
+ * snapshots lexed on other threads.
+ */
+struct SnapshotText {
+	std::string text;
+	std::vector<Sci::Position> lineStarts;
+	int codePage;
+	int tabInChars;
+	bool unicodeLineEnds;
+	SnapshotText(const Document &document, Sci::Position length);
+};
+
+/**
+ * A view of shared snapshot text with a copy of the lexical state around the range to be styled,
+ * that a lexer can run against on another thread. Styles, levels, and line states written by the
+ * lexer are kept in the snapshot and collected with TakeChunk.
+ * Only single byte and UTF-8 documents are supported.
+ * Styles are held from stylesStart to the end of the range and levels and line states for the
+ * lines of that span; outside it StyleAt returns 0 and writes are ignored.
+ */
+class StyleSnapshot : public Scintilla::IDocument5 {
+	std::shared_ptr<const SnapshotText> source;
+	Sci::Position stylesStart;
+	std::string styles;
+	Sci::Line linesStart;
+	std::vector<int> levels;
+	std::vector<int> lineStates;
+
+	Sci::Position endStyling = 0;
+	// Ranges written since the last TakeChunk
+	Sci::Position styledFirst = -1;
+	Sci::Position styledEnd = -1;
+	Sci::Line lineFirst = -1;
+	Sci::Line lineLast = -1;
+	int currentIndicator = 0;
+	StyledChunk pending;
+
+	unsigned char UCharAt(Sci::Position position) const noexcept;
+	bool HoldsLine(Sci::Line line) const noexcept;
+	void Styled(Sci::Position first, Sci::Position end) noexcept;
+	void LineChanged(Sci::Line line) noexcept;
+
+public:
+	// When copyState is false the snapshot starts from the default state instead of the document's.
+	StyleSnapshot(const Document &document, std::shared_ptr<const SnapshotText> source_,
+		Sci::Position stylesStart_, Sci::Position end, bool copyState);
+
+	Sci::Line Lines() const noexcept;
+	/// Collect the results written since the last call.
+	StyledChunk TakeChunk();
+
+	int SCI_METHOD Version() const noexcept override;
+	void SCI_METHOD SetErrorStatus(int status) noexcept override;
+	Sci_Position SCI_METHOD Length() const noexcept override;
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const noexcept override;
+	char SCI_METHOD StyleAt(Sci_Position position) const noexcept override;
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const noexcept override;
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const noexcept override;
+	int SCI_METHOD GetLevel(Sci_Position line) const noexcept override;
+	int SCI_METHOD SetLevel(Sci_Position line, int level) noexcept override;
+	int SCI_METHOD GetLineState(Sci_Position line) const noexcept override;
+	int SCI_METHOD SetLineState(Sci_Position line, int state) noexcept override;
+	void SCI_METHOD StartStyling(Sci_Position position) noexcept override;
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) noexcept override;
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles_) noexcept override;
+	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) noexcept override;
+	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
+	void SCI_METHOD ChangeLexerState(Sci_Position start, Sci_Position end) noexcept override;
+	int SCI_METHOD CodePage() const noexcept override;
+	bool SCI_METHOD IsDBCSLeadByte(char ch) const noexcept override;
+	const char *SCI_METHOD BufferPointer() noexcept override;
+	int SCI_METHOD GetLineIndentation(Sci_Position line) noexcept override;
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const noexcept override;
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const noexcept override;
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const noexcept override;
+	const char *SCI_METHOD RangePointer(Sci_Position position, Sci_Position rangeLength) noexcept override;
+};
+
+/**
+ * Lexes and folds a range of a snapshot on a worker thread, a chunk of lines at a time. Each chunk
+ * is published as soon as it is done so the main thread can merge it into the document.
+ * While the worker runs, the lexer instance must not be used by any other thread.
+ */
+class BackgroundStyler {
+	std::unique_ptr<StyleSnapshot> snapshot;
+	Sci::Position start;
+	Sci::Position end;
+	Sci::Position limit;
+	// Stopping keeps the chunks already published while cancelling discards them
+	std::atomic<bool> stopping = false;
+	std::atomic<bool> cancelled = false;
+	std::mutex mutexChunks;
+	std::vector<StyledChunk> chunks;
+	std::future<void> worker;
+
+	void Run(Scintilla::ILexer5 *instance);
+
+public:
+	BackgroundStyler(std::unique_ptr<StyleSnapshot> snapshot_, Sci::Position start_, Sci::Position end_);
+	// Deleted so BackgroundStyler objects can not be copied.
+	BackgroundStyler(const BackgroundStyler &) = delete;
+	BackgroundStyler(BackgroundStyler &&) = delete;
+	BackgroundStyler &operator=(const BackgroundStyler &) = delete;
+	BackgroundStyler &operator=(BackgroundStyler &&) = delete;
+	~BackgroundStyler();
+
+	void Start(Scintilla::ILexer5 *instance);
+	bool Running() const;
+	/// Changes to the document before this position make the snapshot stale.
+	Sci::Position Limit() const noexcept;
+	void Stop() noexcept;
+	void Cancel() noexcept;
+	bool Cancelled() const noexcept;
+	void Wait() const;
+	std::vector<StyledChunk> TakeChunks();
+};
+
+/**
+ * Lexes a range split at line starts into pieces that are lexed concurrently, each against its
+ * own snapshot. Only for lexers with a checkpoint, which must allow concurrent calls to Lex.
+ * The first piece starts from the document's state and the others from the default state so
+ * the caller must check that the lexer reaches that state before using their results.
+ */
+class ConcurrentStyler {
+	struct Piece {
+		Sci::Position start;
+		Sci::Position end;
+		std::unique_ptr<StyleSnapshot> snapshot;
+	};
+	std::vector<Piece> pieces;
+
+	void LexPiece(Scintilla::ILexer5 *instance, size_t piece, int initStyle);
+
+public:
+	ConcurrentStyler(const Document &document, Sci::Position start, Sci::Position end, size_t count);
+
+	void Lex(Scintilla::ILexer5 *instance, int initStyle);
+	size_t Pieces() const noexcept;
+	Sci::Position PieceStart(size_t piece) const noexcept;
+	Sci::Position PieceEnd(size_t piece) const noexcept;
+	const StyleSnapshot &Snapshot(size_t piece) const noexcept;
+	/// Collect the results of a piece dropping any before from, unless from is 0.
+	StyledChunk Results(size_t piece, Sci::Position from);
+};
+
+}
+
+#endif
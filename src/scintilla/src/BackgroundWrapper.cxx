@@ -0,0 +1,215 @@
+// Scintilla source code edit control
+/** @file BackgroundWrapper.cxx
+ ** Wraps lines on another thread against a snapshot of a document.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+#include <cmath>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <forward_list>
+#include <optional>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <future>
+
+#include "ScintillaTypes.h"
+#include "ScintillaMessages.h"
+#include "ScintillaStructures.h"
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+#include "Geometry.h"
+#include "Platform.h"
+
+#include "CharacterType.h"
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "KeyMap.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "UniConversion.h"
+#include "Selection.h"
+#include "PositionCache.h"
+#include "EditModel.h"
+#include "MarginView.h"
+#include "EditView.h"
+#include "BackgroundWrapper.h"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace {
+
+// Wrapping is published in chunks of about this size so heights appear progressively and
+// cancelling the worker never waits long.
+constexpr Sci::Position chunkSize = 0x40000;
+
+// Just enough of a model for EditView::LayoutLine: a document holding one chunk of the
+// snapshot at a time and the representations.
+class WrapModel : public EditModel {
+public:
+	Sci::Line TopLineOfMain() const noexcept override {
+		return 0;
+	}
+	Point GetVisibleOriginInMain() const override {
+		return Point(0, 0);
+	}
+	Sci::Line LinesOnScreen() const override {
+		return 0;
+	}
+};
+
+}
+
+BackgroundWrapper::BackgroundWrapper(const Document &document, const ViewStyle &vsSource, const SpecialRepresentations &reprsSource,
+	std::unique_ptr<Surface> surface_, int width_, Sci::Line lineStart_, Sci::Line lineEnd) :
+	lineStart(lineStart_), codePage(document.dbcsCodePage), tabInChars(document.tabInChars),
+	indentInChars(document.indentInChars), reprs(reprsSource), surface(std::move(surface_)), width(width_) {
+	const Sci::Position start = document.LineStart(lineStart);
+	const Sci::Position length = document.LineStart(lineEnd) - start;
+	lineStarts.reserve(lineEnd - lineStart + 1);
+	for (Sci::Line line = lineStart; line <= lineEnd; line++) {
+		lineStarts.push_back(document.LineStart(line) - start);
+	}
+	text.resize(length);
+	document.GetCharRange(text.data(), start, length);
+	styles.resize(length);
+	document.GetStyleRange(reinterpret_cast<unsigned char *>(styles.data()), start, length);
+
+	vs = std::make_unique<ViewStyle>(vsSource);
+	vs->technology = vsSource.technology;
+	// Drop the main thread's fonts so the worker only measures with fonts it made itself
+	vs->ClearFonts();
+}
+
+BackgroundWrapper::~BackgroundWrapper() {
+	Cancel();
+	Wait();
+}
+
+void BackgroundWrapper::Run() {
+	try {
+		vs->Refresh(*surface, tabInChars);
+
+		WrapModel model;
+		Document *pdoc = model.pdoc;
+		pdoc->SetUndoCollection(false);
+		pdoc->SetDBCSCodePage(codePage);
+		pdoc->tabInChars = tabInChars;
+		pdoc->indentInChars = indentInChars;
+		*model.reprs = reprs;
+
+		EditView view;
+		std::shared_ptr<LineLayout> ll = std::make_shared<LineLayout>(-1, 200);
+
+		const Sci::Line lines = static_cast<Sci::Line>(lineStarts.size()) - 1;
+		Sci::Line line = 0;
+		while ((line < lines) && !cancelled) {
+			// Only the lines of one chunk are in the document at once
+			const auto itEnd = std::upper_bound(lineStarts.cbegin() + line + 1, lineStarts.cend() - 1, lineStarts[line] + chunkSize);
+			const Sci::Line lineEndChunk = std::max<Sci::Line>(itEnd - lineStarts.cbegin(), line + 1);
+			const Sci::Position position = lineStarts[line];
+			const Sci::Position length = lineStarts[lineEndChunk] - position;
+			pdoc->InsertString(0, text.data() + position, length);
+			pdoc->StartStyling(0);
+			pdoc->SetStyles(length, styles.data() + position);
+
+			WrappedChunk chunk;
+			chunk.line = lineStart + line;
+			for (Sci::Line lineChunk = 0; (lineChunk < lineEndChunk - line) && !cancelled; lineChunk++) {
+				ll->ReSet(lineChunk, pdoc->LineStart(lineChunk + 1) - pdoc->LineStart(lineChunk));
+				// Fonts may not be shared between threads so LayoutLine must not start more
+				view.LayoutLine(model, surface.get(), *vs, ll.get(), width, true);
+				chunk.subLines.push_back(ll->lines);
+			}
+			pdoc->DeleteChars(0, pdoc->Length());
+
+			{
+				std::lock_guard<std::mutex> guard(mutexChunks);
+				chunks.push_back(std::move(chunk));
+			}
+			line = lineEndChunk;
+		}
+	} catch (...) {
+		// Whatever was not published is left for the main thread to wrap
+	}
+	// The fonts and surface were only used here so are released here
+	vs.reset();
+	surface.reset();
+}
+
+void BackgroundWrapper::Start() {
+	worker = std::async(std::launch::async, [this]() {
+		Run();
+	});
+}
+
+bool BackgroundWrapper::Running() const {
+	return worker.valid() && (worker.wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+}
+
+Sci::Line BackgroundWrapper::LineStart() const noexcept {
+	return lineStart;
+}
+
+Sci::Line BackgroundWrapper::LineEnd() const noexcept {
+	return lineStart + static_cast<Sci::Line>(lineStarts.size()) - 1;
+}
+
+int BackgroundWrapper::Width() const noexcept {
+	return width;
+}
+
+void BackgroundWrapper::Cancel() noexcept {
+	cancelled = true;
+}
+
+bool BackgroundWrapper::Cancelled() const noexcept {
+	return cancelled;
+}
+
+void BackgroundWrapper::Wait() const {
+	if (worker.valid()) {
+		worker.wait();
+	}
+}
+
+std::vector<WrappedChunk> BackgroundWrapper::TakeChunks() {
+	std::vector<WrappedChunk> taken;
+	std::lock_guard<std::mutex> guard(mutexChunks);
+	taken.swap(chunks);
+	if (cancelled) {
+		// Heights from a stale snapshot are discarded
+		taken.clear();
+	}
+	return taken;
+}
@@ -0,0 +1,72 @@
+// Scintilla source code edit control
+/** @file BackgroundWrapper.h
+ ** Wraps lines on another thread against a snapshot of a document.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef BACKGROUNDWRAPPER_H
+#define BACKGROUNDWRAPPER_H
+
+namespace Scintilla::Internal {
+
+/**
+ * The number of sub-lines that each of a run of lines wraps to, not counting annotations.
+ */
+struct WrappedChunk {
+	Sci::Line line = 0;
+	std::vector<int> subLines;
+};
+
+/**
+ * Wraps a range of lines of a snapshot on a worker thread, a chunk of lines at a time. Each chunk
+ * is published as soon as it is done so the main thread can apply the heights.
+ * The worker has its own surface, fonts, and position cache so nothing it measures with is used
+ * by any other thread. Its fonts are made from the copied view style on the worker and the
+ * surface is only used there so must be safe to use from a thread other than the one that made it.
+ * Text is measured with the styles the document had when the snapshot was taken so heights of
+ * lines styled later may differ slightly from a layout on the main thread.
+ */
+class BackgroundWrapper {
+	Sci::Line lineStart;
+	// Text and styles of the lines with their starts relative to the text
+	std::string text;
+	std::string styles;
+	std::vector<Sci::Position> lineStarts;
+	int codePage;
+	int tabInChars;
+	int indentInChars;
+	SpecialRepresentations reprs;
+	std::unique_ptr<ViewStyle> vs;
+	std::unique_ptr<Surface> surface;
+	int width;
+	std::atomic<bool> cancelled = false;
+	std::mutex mutexChunks;
+	std::vector<WrappedChunk> chunks;
+	std::future<void> worker;
+
+	void Run();
+
+public:
+	BackgroundWrapper(const Document &document, const ViewStyle &vsSource, const SpecialRepresentations &reprsSource,
+		std::unique_ptr<Surface> surface_, int width_, Sci::Line lineStart_, Sci::Line lineEnd);
+	// Deleted so BackgroundWrapper objects can not be copied.
+	BackgroundWrapper(const BackgroundWrapper &) = delete;
+	BackgroundWrapper(BackgroundWrapper &&) = delete;
+	BackgroundWrapper &operator=(const BackgroundWrapper &) = delete;
+	BackgroundWrapper &operator=(BackgroundWrapper &&) = delete;
+	~BackgroundWrapper();
+
+	void Start();
+	bool Running() const;
+	Sci::Line LineStart() const noexcept;
+	Sci::Line LineEnd() const noexcept;
+	int Width() const noexcept;
+	void Cancel() noexcept;
+	bool Cancelled() const noexcept;
+	void Wait() const;
+	std::vector<WrappedChunk> TakeChunks();
+};
+
+}
+
+#endif
@@ -0,0 +1,1151 @@
+// Scintilla source code edit control
+/** @file BraceIndex.cxx
+ ** Summarises the braces and tags in blocks of a document so matching braces and tags are found quickly.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <future>
+
+#include "ScintillaTypes.h"
+
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "PieceTable.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "BraceIndex.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define BRACEINDEX_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BRACEINDEX_NEON
+#endif
+
+using namespace Scintilla::Internal;
+
+namespace Scintilla::Internal {
+
+size_t FindEitherByte(std::string_view sv, char a, char b) noexcept {
+	const char *s = sv.data();
+	const size_t length = sv.length();
+	size_t i = 0;
+#if defined(BRACEINDEX_SSE2)
+	{
+		const __m128i va = _mm_set1_epi8(a);
+		const __m128i vb = _mm_set1_epi8(b);
+		for (; i + 16 <= length; i += 16) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+			if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb))) != 0) {
+				break;
+			}
+		}
+	}
+#elif defined(BRACEINDEX_NEON)
+	{
+		const uint8x16_t va = vdupq_n_u8(static_cast<uint8_t>(a));
+		const uint8x16_t vb = vdupq_n_u8(static_cast<uint8_t>(b));
+		for (; i + 16 <= length; i += 16) {
+			const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(s + i));
+			if (vmaxvq_u8(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb))) != 0) {
+				break;
+			}
+		}
+	}
+#endif
+	for (; i < length; i++) {
+		if (s[i] == a || s[i] == b) {
+			return i;
+		}
+	}
+	return length;
+}
+
+}
+
+IndexJob::IndexJob(const void *index_) noexcept : index(index_) {
+}
+
+bool IndexJob::For(const void *index_) const noexcept {
+	return index == index_;
+}
+
+BackgroundIndexer::BackgroundIndexer(std::unique_ptr<IndexJob> job_) : job(std::move(job_)) {
+	worker = std::async(std::launch::async, [job = job.get()]() {
+		try {
+			job->Run();
+		} catch (...) {
+			// Incomplete results are not applied
+			job->cancelled = true;
+		}
+	});
+}
+
+BackgroundIndexer::~BackgroundIndexer() {
+	if (job) {
+		job->cancelled = true;
+	}
+	if (worker.valid()) {
+		worker.wait();
+	}
+}
+
+bool BackgroundIndexer::Running() const {
+	return worker.valid() && (worker.wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+}
+
+std::unique_ptr<IndexJob> BackgroundIndexer::Finish() {
+	if (worker.valid()) {
+		worker.wait();
+	}
+	return std::move(job);
+}
+
+class BraceIndex::Job : public IndexJob {
+public:
+	char chOpen;
+	char chClose;
+	int style;
+	bool unstyled = false;
+	size_t generation;
+	// The blocks copied and where each starts in text, followed by the end
+	std::vector<size_t> blockNumbers;
+	std::vector<size_t> starts;
+	std::string text;
+	std::string styles;
+	std::vector<Summary> summaries;
+
+	Job(const BraceIndex *index, char chOpen_, char chClose_, int style_, size_t generation_) :
+		IndexJob(index), chOpen(chOpen_), chClose(chClose_), style(style_), generation(generation_) {
+		starts.push_back(0);
+	}
+	void Run() override {
+		for (size_t i = 0; (i < blockNumbers.size()) && !cancelled; i++) {
+			const size_t length = starts[i + 1] - starts[i];
+			const std::string_view blockStyles = unstyled ? std::string_view() : std::string_view(styles).substr(starts[i], length);
+			summaries.push_back(SummariseText(std::string_view(text).substr(starts[i], length), blockStyles,
+				chOpen, chClose, style, unstyled));
+		}
+	}
+};
+
+BraceIndex::BraceIndex(const Document &document, char chOpen_, char chClose_, int style_) :
+	chOpen(chOpen_), chClose(chClose_), style(style_) {
+	const Sci::Position length = document.LengthNoExcept();
+	blocks.InsertText(0, length);
+	for (Sci::Position start = blockSize; start < length; start += blockSize) {
+		blocks.InsertPartition(blocks.Partitions(), start);
+	}
+	InsertBlocks(0, BlockCount());
+}
+
+size_t BraceIndex::BlockCount() const noexcept {
+	return blocks.Partitions();
+}
+
+Sci::Position BraceIndex::BlockStart(size_t block) const noexcept {
+	return blocks.PositionFromPartition(static_cast<Sci::Position>(block));
+}
+
+// Blocks before this are entirely styled. BraceMatch checks the style at the end of styling.
+size_t BraceIndex::StyledBlocks(const Document &document) const noexcept {
+	const Sci::Position styledEnd = document.GetEndStyled() + 1;
+	if (styledEnd >= blocks.Length()) {
+		return BlockCount();
+	}
+	return blocks.PartitionFromPosition(styledEnd);
+}
+
+// Blocks from this start after the end of styling.
+size_t BraceIndex::UnstyledStart(const Document &document) const noexcept {
+	const Sci::Position endStyled = document.GetEndStyled();
+	if (endStyled >= blocks.Length()) {
+		return BlockCount();
+	}
+	return blocks.PartitionFromPosition(endStyled) + 1;
+}
+
+void BraceIndex::Reset() {
+	leafBase = 1;
+	while (leafBase < BlockCount()) {
+		leafBase *= 2;
+	}
+	for (Tree *tree : { &styled, &unstyled }) {
+		tree->nodes.assign(leafBase, Summary());
+		tree->nodeValid.assign(leafBase, false);
+	}
+}
+
+void BraceIndex::InsertBlocks(size_t block, size_t count) {
+	for (Tree *tree : { &styled, &unstyled }) {
+		tree->leaves.insert(tree->leaves.begin() + block, count, Summary());
+		tree->leafValid.insert(tree->leafValid.begin() + block, count, false);
+	}
+	Reset();
+}
+
+void BraceIndex::EraseBlocks(size_t block, size_t count) {
+	for (Tree *tree : { &styled, &unstyled }) {
+		tree->leaves.erase(tree->leaves.begin() + block, tree->leaves.begin() + block + count);
+		tree->leafValid.erase(tree->leafValid.begin() + block, tree->leafValid.begin() + block + count);
+	}
+	Reset();
+}
+
+void BraceIndex::InvalidateBlock(Tree &tree, size_t block) noexcept {
+	if (block >= tree.leafValid.size()) {
+		return;
+	}
+	tree.leafValid[block] = false;
+	for (size_t node = (leafBase + block) / 2; node >= 1; node /= 2) {
+		tree.nodeValid[node] = false;
+	}
+}
+
+void BraceIndex::SplitBlock(size_t block) {
+	// Split a grown block into pieces of blockSize
+	const Sci::Position start = BlockStart(block);
+	const Sci::Position end = BlockStart(block + 1);
+	size_t inserted = 0;
+	for (Sci::Position position = start + blockSize; position < end; position += blockSize) {
+		inserted++;
+		blocks.InsertPartition(static_cast<Sci::Position>(block + inserted), position);
+	}
+	InsertBlocks(block + 1, inserted);
+}
+
+bool BraceIndex::Counts(const Document &document, Sci::Position position) const noexcept {
+	return (position > document.GetEndStyled()) || (document.StyleIndexAt(position) == style);
+}
+
+// Count the braces in text, only those of style unless unstyled.
+BraceIndex::Summary BraceIndex::SummariseText(std::string_view text, std::string_view styles, char chOpen, char chClose, int style, bool unstyled) noexcept {
+	Summary summary;
+	int running = 0;
+	for (size_t i = 0; i < text.length(); i++) {
+		i += FindEitherByte(text.substr(i), chOpen, chClose);
+		if (i >= text.length()) {
+			break;
+		}
+		if (unstyled || (static_cast<unsigned char>(styles[i]) == style)) {
+			running += (text[i] == chOpen) ? 1 : -1;
+			summary.minPrefix = std::min(summary.minPrefix, running);
+		}
+	}
+	summary.sum = running;
+	return summary;
+}
+
+BraceIndex::Summary BraceIndex::Summarise(Document &document, size_t block, bool unstyled) const {
+	const Sci::Position start = BlockStart(block);
+	const Sci::Position length = BlockStart(block + 1) - start;
+	const char *text = document.RangePointer(start, length);
+	std::string copy;
+	if (!text) {
+		copy.resize(length);
+		document.GetCharRange(copy.data(), start, length);
+		text = copy.data();
+	}
+	std::string styles;
+	if (!unstyled) {
+		styles.resize(length);
+		document.GetStyleRange(reinterpret_cast<unsigned char *>(styles.data()), start, length);
+	}
+	return SummariseText(std::string_view(text, length), styles, chOpen, chClose, style, unstyled);
+}
+
+const BraceIndex::Summary &BraceIndex::Node(Document &document, bool unstyled, size_t node) {
+	Tree &tree = unstyled ? this->unstyled : styled;
+	if (node >= leafBase) {
+		static const Summary empty;
+		const size_t leaf = node - leafBase;
+		if (leaf >= tree.leaves.size()) {
+			return empty;
+		}
+		if (!tree.leafValid[leaf]) {
+			tree.leaves[leaf] = Summarise(document, leaf, unstyled);
+			tree.leafValid[leaf] = true;
+		}
+		return tree.leaves[leaf];
+	}
+	if (!tree.nodeValid[node]) {
+		const Summary left = Node(document, unstyled, node * 2);
+		const Summary &right = Node(document, unstyled, node * 2 + 1);
+		tree.nodes[node].sum = left.sum + right.sum;
+		tree.nodes[node].minPrefix = std::min(left.minPrefix, left.sum + right.minPrefix);
+		tree.nodeValid[node] = true;
+	}
+	return tree.nodes[node];
+}
+
+// Find the first block in [first, last) where depth, counting unmatched opening braces, reaches 0.
+// Blocks before it are applied to depth.
+size_t BraceIndex::SearchForward(Document &document, bool unstyled, size_t node, size_t lo, size_t hi, size_t first, size_t last, int &depth) {
+	if (hi <= first || lo >= last) {
+		return notFound;
+	}
+	if (first <= lo && hi <= last) {
+		const Summary &summary = Node(document, unstyled, node);
+		if (depth + summary.minPrefix > 0) {
+			depth += summary.sum;
+			return notFound;
+		}
+		if (hi - lo == 1) {
+			return lo;
+		}
+	}
+	const size_t middle = (lo + hi) / 2;
+	const size_t found = SearchForward(document, unstyled, node * 2, lo, middle, first, last, depth);
+	if (found != notFound) {
+		return found;
+	}
+	return SearchForward(document, unstyled, node * 2 + 1, middle, hi, first, last, depth);
+}
+
+// Find the last block in [first, last) where depth, counting unmatched closing braces, reaches 0.
+// Blocks after it are applied to depth.
+size_t BraceIndex::SearchBackward(Document &document, bool unstyled, size_t node, size_t lo, size_t hi, size_t first, size_t last, int &depth) {
+	if (hi <= first || lo >= last) {
+		return notFound;
+	}
+	if (first <= lo && hi <= last) {
+		const Summary &summary = Node(document, unstyled, node);
+		if (depth + summary.minPrefix - summary.sum > 0) {
+			depth -= summary.sum;
+			return notFound;
+		}
+		if (hi - lo == 1) {
+			return lo;
+		}
+	}
+	const size_t middle = (lo + hi) / 2;
+	const size_t found = SearchBackward(document, unstyled, node * 2 + 1, middle, hi, first, last, depth);
+	if (found != notFound) {
+		return found;
+	}
+	return SearchBackward(document, unstyled, node * 2, lo, middle, first, last, depth);
+}
+
+bool BraceIndex::For(char chOpen_, int style_) const noexcept {
+	return (chOpen == chOpen_) && (style == style_);
+}
+
+Sci::Position BraceIndex::Match(Document &document, Sci::Position position, Sci::Position start) {
+	const bool forward = document.CharAt(position) == chOpen;
+	const Sci::Position length = document.LengthNoExcept();
+	const size_t styledBlocks = StyledBlocks(document);
+	const size_t unstyledStart = UnstyledStart(document);
+	int depth = 1;
+	Sci::Position pos = start;
+	while ((pos >= 0) && (pos < length)) {
+		size_t block = blocks.PartitionFromPosition(pos);
+		if ((block < styledBlocks) || (block >= unstyledStart)) {
+			// Skip over summarised blocks where the depth does not reach 0
+			const bool unstyled = block >= unstyledStart;
+			const size_t first = unstyled ? unstyledStart : 0;
+			const size_t last = unstyled ? BlockCount() : styledBlocks;
+			if (forward && (pos == BlockStart(block))) {
+				block = SearchForward(document, unstyled, 1, 0, leafBase, block, last, depth);
+				if (block == notFound) {
+					pos = BlockStart(last);
+					continue;
+				}
+				pos = BlockStart(block);
+			} else if (!forward && (pos == BlockStart(block + 1) - 1)) {
+				block = SearchBackward(document, unstyled, 1, 0, leafBase, first, block + 1, depth);
+				if (block == notFound) {
+					pos = BlockStart(first) - 1;
+					continue;
+				}
+				pos = BlockStart(block + 1) - 1;
+			}
+		}
+		const Sci::Position blockStart = BlockStart(block);
+		const Sci::Position blockEnd = BlockStart(block + 1);
+		const char *text = document.RangePointer(blockStart, blockEnd - blockStart);
+		if (forward) {
+			for (; pos < blockEnd; pos++) {
+				if (text) {
+					pos += FindEitherByte(std::string_view(text + pos - blockStart, blockEnd - pos), chOpen, chClose);
+					if (pos >= blockEnd) {
+						break;
+					}
+				}
+				const char ch = text ? text[pos - blockStart] : document.CharAt(pos);
+				if ((ch == chOpen || ch == chClose) && Counts(document, pos)) {
+					depth += (ch == chOpen) ? 1 : -1;
+					if (depth == 0) {
+						return pos;
+					}
+				}
+			}
+		} else {
+			for (; pos >= blockStart; pos--) {
+				const char ch = text ? text[pos - blockStart] : document.CharAt(pos);
+				if ((ch == chOpen || ch == chClose) && Counts(document, pos)) {
+					depth += (ch == chClose) ? 1 : -1;
+					if (depth == 0) {
+						return pos;
+					}
+				}
+			}
+		}
+	}
+	return -1;
+}
+
+void BraceIndex::InsertText(Sci::Position position, Sci::Position length) {
+	generation++;
+	const size_t block = blocks.PartitionFromPosition(position);
+	blocks.InsertText(static_cast<Sci::Position>(block), length);
+	InvalidateBlock(styled, block);
+	InvalidateBlock(unstyled, block);
+	if (BlockStart(block + 1) - BlockStart(block) > blockSize * 2) {
+		SplitBlock(block);
+	}
+}
+
+void BraceIndex::DeleteText(Sci::Position position, Sci::Position length) {
+	generation++;
+	const size_t block = blocks.PartitionFromPosition(position);
+	// Blocks starting inside the deleted range are merged into the block containing its start
+	size_t merged = 0;
+	while ((block + 1 < BlockCount()) && (BlockStart(block + 1) < position + length)) {
+		blocks.RemovePartition(static_cast<Sci::Position>(block + 1));
+		merged++;
+	}
+	blocks.InsertText(static_cast<Sci::Position>(block), -length);
+	if (merged) {
+		EraseBlocks(block + 1, merged);
+	}
+	InvalidateBlock(styled, block);
+	InvalidateBlock(unstyled, block);
+	if (BlockStart(block + 1) - BlockStart(block) > blockSize * 2) {
+		SplitBlock(block);
+	}
+}
+
+void BraceIndex::ChangeStyle(Sci::Position start, Sci::Position end) noexcept {
+	if (end <= start) {
+		return;
+	}
+	generation++;
+	const size_t last = blocks.PartitionFromPosition(end - 1);
+	for (size_t block = blocks.PartitionFromPosition(start); block <= last; block++) {
+		InvalidateBlock(styled, block);
+	}
+}
+
+bool BraceIndex::Pending(const Document &document) const noexcept {
+	const size_t styledBlocks = StyledBlocks(document);
+	for (size_t block = 0; block < styledBlocks; block++) {
+		if (!styled.leafValid[block]) {
+			return true;
+		}
+	}
+	for (size_t block = UnstyledStart(document); block < BlockCount(); block++) {
+		if (!unstyled.leafValid[block]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool BraceIndex::Build(Document &document, Sci::Position length) {
+	const size_t styledBlocks = StyledBlocks(document);
+	const size_t unstyledStart = UnstyledStart(document);
+	for (size_t block = 0; (block < BlockCount()) && (length > 0); block++) {
+		const bool unstyled = block >= unstyledStart;
+		if ((block < styledBlocks) || unstyled) {
+			Tree &tree = unstyled ? this->unstyled : styled;
+			if (!tree.leafValid[block]) {
+				tree.leaves[block] = Summarise(document, block, unstyled);
+				tree.leafValid[block] = true;
+				length -= BlockStart(block + 1) - BlockStart(block);
+			}
+		}
+	}
+	return Pending(document);
+}
+
+std::unique_ptr<IndexJob> BraceIndex::Prepare(const Document &document, Sci::Position length) const {
+	const size_t styledBlocks = StyledBlocks(document);
+	const size_t unstyledStart = UnstyledStart(document);
+	std::unique_ptr<Job> job = std::make_unique<Job>(this, chOpen, chClose, style, generation);
+	for (size_t block = 0; (block < BlockCount()) && (length > 0); block++) {
+		const bool unstyled = block >= unstyledStart;
+		if ((block < styledBlocks) || unstyled) {
+			const Tree &tree = unstyled ? this->unstyled : styled;
+			if (!tree.leafValid[block]) {
+				// Each job is for one tree
+				if (job->blockNumbers.empty()) {
+					job->unstyled = unstyled;
+				} else if (job->unstyled != unstyled) {
+					break;
+				}
+				const Sci::Position start = BlockStart(block);
+				const Sci::Position blockLength = BlockStart(block + 1) - start;
+				const size_t offset = job->text.length();
+				job->text.resize(offset + blockLength);
+				document.GetCharRange(job->text.data() + offset, start, blockLength);
+				if (!unstyled) {
+					job->styles.resize(offset + blockLength);
+					document.GetStyleRange(reinterpret_cast<unsigned char *>(job->styles.data() + offset), start, blockLength);
+				}
+				job->blockNumbers.push_back(block);
+				job->starts.push_back(offset + blockLength);
+				length -= blockLength;
+			}
+		}
+	}
+	if (job->blockNumbers.empty()) {
+		return {};
+	}
+	return job;
+}
+
+bool BraceIndex::Merge(IndexJob &indexJob) {
+	if (!indexJob.For(this)) {
+		return false;
+	}
+	const Job &job = static_cast<const Job &>(indexJob);
+	if (job.cancelled || (job.generation != generation)) {
+		// Blocks changed so the summaries may be wrong
+		return true;
+	}
+	Tree &tree = job.unstyled ? unstyled : styled;
+	for (size_t i = 0; i < job.summaries.size(); i++) {
+		const size_t block = job.blockNumbers[i];
+		// Inner nodes above a block that was not valid are not valid either
+		if (!tree.leafValid[block]) {
+			tree.leaves[block] = job.summaries[i];
+			tree.leafValid[block] = true;
+		}
+	}
+	return true;
+}
+
+size_t BraceIndex::Blocks() const noexcept {
+	return BlockCount();
+}
+
+namespace {
+
+// Constructs of markup in the low bits of a TagIndex::State
+enum class Phase : unsigned char {
+	text, tag, endTag, bang, bangDash, comment, cdata, instruction, declaration, raw
+};
+
+// Elements that need special treatment in HTML
+enum class Kind : unsigned char {
+	normal, empty, script, style
+};
+
+enum class Quote : unsigned char {
+	none, doubleQuote, singleQuote
+};
+
+constexpr TagIndex::State MakeState(Phase phase, Kind kind, Quote quote) noexcept {
+	// Only tags and raw text depend on the kind and only tags may have an open quote
+	if (phase != Phase::tag) {
+		quote = Quote::none;
+		if (phase != Phase::raw) {
+			kind = Kind::normal;
+		}
+	}
+	return static_cast<TagIndex::State>(static_cast<int>(phase) | (static_cast<int>(kind) << 4) | (static_cast<int>(quote) << 6));
+}
+
+constexpr Phase PhaseOf(TagIndex::State state) noexcept {
+	return static_cast<Phase>(state & 0xf);
+}
+
+constexpr Kind KindOf(TagIndex::State state) noexcept {
+	return static_cast<Kind>((state >> 4) & 0x3);
+}
+
+constexpr Quote QuoteOf(TagIndex::State state) noexcept {
+	return static_cast<Quote>((state >> 6) & 0x3);
+}
+
+constexpr bool IsNameStart(char ch) noexcept {
+	const unsigned char uch = ch;
+	return (uch >= 'a' && uch <= 'z') || (uch >= 'A' && uch <= 'Z') || (uch == '_') || (uch == ':') || (uch >= 0x80);
+}
+
+constexpr bool IsNameCharacter(char ch) noexcept {
+	return IsNameStart(ch) || (ch >= '0' && ch <= '9') || (ch == '-') || (ch == '.');
+}
+
+constexpr char MakeLowerASCII(char ch) noexcept {
+	return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+// Is there a name at position in text that is the lower case name ignoring ASCII case?
+bool NameAt(std::string_view text, size_t position, std::string_view name) noexcept {
+	if (position + name.length() > text.length()) {
+		return false;
+	}
+	for (size_t i = 0; i < name.length(); i++) {
+		if (MakeLowerASCII(text[position + i]) != name[i]) {
+			return false;
+		}
+	}
+	const size_t after = position + name.length();
+	return (after >= text.length()) || !IsNameCharacter(text[after]);
+}
+
+constexpr std::string_view voidElements[] = {
+	"area", "base", "br", "col", "embed", "hr", "img", "input", "link", "meta", "source", "track", "wbr"
+};
+
+Kind ElementKind(std::string_view text, size_t position) noexcept {
+	for (const std::string_view name : voidElements) {
+		if (NameAt(text, position, name)) {
+			return Kind::empty;
+		}
+	}
+	if (NameAt(text, position, "script")) {
+		return Kind::script;
+	}
+	if (NameAt(text, position, "style")) {
+		return Kind::style;
+	}
+	return Kind::normal;
+}
+
+// Run the markup state machine over text from start to end, beginning in state, and call
+// tagFound(position, delta) for each tag decided there. Bytes outside start and end are only read
+// to decide tags near the ends so the state returned depends only on the state at start.
+// Tags are decided by the byte after their '<' or, for "/>", by the '>' and, for the end of
+// script or style text, by the last byte of the name.
+template <typename TagFound>
+TagIndex::State ScanMarkup(std::string_view text, size_t start, size_t end, TagIndex::State state, bool html, TagFound tagFound) {
+	Phase phase = PhaseOf(state);
+	Kind kind = KindOf(state);
+	Quote quote = QuoteOf(state);
+	const auto before = [text](size_t position, size_t back) noexcept {
+		return (position >= back) ? text[position - back] : '\0';
+	};
+	for (size_t i = start; i < end; i++) {
+		const char ch = text[i];
+		switch (phase) {
+		case Phase::text:
+			if (before(i, 1) == '<') {
+				if (IsNameStart(ch)) {
+					kind = html ? ElementKind(text, i) : Kind::normal;
+					if (kind != Kind::empty) {
+						tagFound(i - 1, 1);
+					}
+					phase = Phase::tag;
+					quote = Quote::none;
+				} else if (ch == '/') {
+					tagFound(i - 1, -1);
+					phase = Phase::endTag;
+				} else if (ch == '?') {
+					phase = Phase::instruction;
+				} else if (ch == '!') {
+					phase = Phase::bang;
+				}
+			} else if (ch != '<') {
+				// Nothing is decided before the byte after the next '<'
+				i += FindEitherByte(text.substr(i, end - i), '<', '<');
+			}
+			break;
+		case Phase::tag:
+			if (quote != Quote::none) {
+				const char chQuote = (quote == Quote::doubleQuote) ? '"' : '\'';
+				i += FindEitherByte(text.substr(i, end - i), chQuote, chQuote);
+				if (i < end) {
+					quote = Quote::none;
+				}
+			} else if (ch == '"') {
+				quote = Quote::doubleQuote;
+			} else if (ch == '\'') {
+				quote = Quote::singleQuote;
+			} else if (ch == '>') {
+				if (kind == Kind::script || kind == Kind::style) {
+					// HTML ignores "/>" on these
+					phase = Phase::raw;
+				} else {
+					if ((kind == Kind::normal) && (before(i, 1) == '/')) {
+						tagFound(i - 1, -1);
+					}
+					phase = Phase::text;
+				}
+			}
+			break;
+		case Phase::endTag:
+		case Phase::declaration:
+			i += FindEitherByte(text.substr(i, end - i), '>', '>');
+			if (i < end) {
+				phase = Phase::text;
+			}
+			break;
+		case Phase::bang:
+			phase = (ch == '-') ? Phase::bangDash : (ch == '[') ? Phase::cdata : (ch == '>') ? Phase::text : Phase::declaration;
+			break;
+		case Phase::bangDash:
+			phase = (ch == '-') ? Phase::comment : (ch == '>') ? Phase::text : Phase::declaration;
+			break;
+		case Phase::comment:
+		case Phase::cdata:
+		case Phase::instruction:
+			i += FindEitherByte(text.substr(i, end - i), '>', '>');
+			if (i < end) {
+				if (phase == Phase::comment) {
+					if ((before(i, 1) == '-') && (before(i, 2) == '-')) {
+						phase = Phase::text;
+					}
+				} else if (phase == Phase::cdata) {
+					if ((before(i, 1) == ']') && (before(i, 2) == ']')) {
+						phase = Phase::text;
+					}
+				} else if (before(i, 1) == '?') {
+					phase = Phase::text;
+				}
+			}
+			break;
+		case Phase::raw: {
+				// The end tag is decided by the last byte of its name so look from the earliest
+				// '<' that could be decided here
+				const std::string_view name = (kind == Kind::script) ? "script" : "style";
+				const size_t reach = name.length() + 1;
+				const size_t limit = (end > reach) ? end - reach : 0;
+				size_t candidate = (i > reach) ? i - reach : 0;
+				i = end;
+				while (candidate < limit) {
+					candidate += FindEitherByte(text.substr(candidate, limit - candidate), '<', '<');
+					if (candidate >= limit) {
+						break;
+					}
+					if ((text[candidate + 1] == '/') && NameAt(text, candidate + 2, name)) {
+						tagFound(candidate, -1);
+						phase = Phase::endTag;
+						i = candidate + reach;
+						break;
+					}
+					candidate++;
+				}
+			}
+			break;
+		}
+	}
+	return MakeState(phase, kind, quote);
+}
+
+}
+
+class TagIndex::Job : public IndexJob {
+public:
+	bool html;
+	size_t generation;
+	// The first block and the state it starts in
+	size_t first;
+	State entry;
+	// Text of the blocks with their context and where each block starts in it, followed by the end
+	std::string text;
+	std::vector<size_t> starts;
+	std::vector<Leaf> leaves;
+
+	Job(const TagIndex *index, bool html_, size_t generation_, size_t first_, State entry_) :
+		IndexJob(index), html(html_), generation(generation_), first(first_), entry(entry_) {
+	}
+	void Run() override {
+		// Each block starts in the state the one before it ends in
+		State state = entry;
+		for (size_t i = 0; (i + 1 < starts.size()) && !cancelled; i++) {
+			leaves.push_back(ScanBlock(text, starts[i], starts[i + 1], state, html));
+			state = leaves.back().exit;
+		}
+	}
+};
+
+TagIndex::TagIndex(const Document &document, bool html_) : html(html_) {
+	const Sci::Position length = document.LengthNoExcept();
+	blocks.InsertText(0, length);
+	for (Sci::Position start = blockSize; start < length; start += blockSize) {
+		blocks.InsertPartition(blocks.Partitions(), start);
+	}
+	InsertBlocks(0, BlockCount());
+}
+
+size_t TagIndex::BlockCount() const noexcept {
+	return blocks.Partitions();
+}
+
+Sci::Position TagIndex::BlockStart(size_t block) const noexcept {
+	return blocks.PositionFromPartition(static_cast<Sci::Position>(block));
+}
+
+void TagIndex::Reset() {
+	leafBase = 1;
+	while (leafBase < BlockCount()) {
+		leafBase *= 2;
+	}
+	nodes.assign(leafBase, Summary());
+	nodeValid.assign(leafBase, false);
+}
+
+void TagIndex::InsertBlocks(size_t block, size_t count) {
+	leaves.insert(leaves.begin() + block, count, Leaf());
+	consistent = std::min(consistent, block);
+	Reset();
+}
+
+void TagIndex::EraseBlocks(size_t block, size_t count) {
+	leaves.erase(leaves.begin() + block, leaves.begin() + block + count);
+	consistent = std::min(consistent, block);
+	Reset();
+}
+
+void TagIndex::InvalidateBlock(size_t block) noexcept {
+	if (block >= leaves.size()) {
+		return;
+	}
+	leaves[block].valid = false;
+	consistent = std::min(consistent, block);
+	for (size_t node = (leafBase + block) / 2; node >= 1; node /= 2) {
+		nodeValid[node] = false;
+	}
+}
+
+// Text from start to end changed so tags in blocks within context of it may have changed.
+void TagIndex::InvalidateAround(Sci::Position start, Sci::Position end) noexcept {
+	const Sci::Position lastPosition = std::max<Sci::Position>(blocks.Length() - 1, 0);
+	const size_t first = blocks.PartitionFromPosition(std::max<Sci::Position>(start - context, 0));
+	const size_t last = blocks.PartitionFromPosition(std::min(end + context, lastPosition));
+	for (size_t block = first; block <= last; block++) {
+		InvalidateBlock(block);
+	}
+}
+
+void TagIndex::SplitBlock(size_t block) {
+	// Split a grown block into pieces of blockSize
+	const Sci::Position start = BlockStart(block);
+	const Sci::Position end = BlockStart(block + 1);
+	size_t inserted = 0;
+	for (Sci::Position position = start + blockSize; position < end; position += blockSize) {
+		inserted++;
+		blocks.InsertPartition(static_cast<Sci::Position>(block + inserted), position);
+	}
+	InsertBlocks(block + 1, inserted);
+}
+
+// Copy the text of block with its context into text. Returns where the block starts in text.
+size_t TagIndex::FetchBlock(const Document &document, size_t block) {
+	const Sci::Position start = BlockStart(block);
+	const Sci::Position end = BlockStart(block + 1);
+	const Sci::Position first = std::max<Sci::Position>(start - context, 0);
+	const Sci::Position last = std::min(end + context, document.LengthNoExcept());
+	text.resize(last - first);
+	document.GetCharRange(text.data(), first, last - first);
+	return start - first;
+}
+
+TagIndex::State TagIndex::EntryState(size_t block) const noexcept {
+	return (block == 0) ? MakeState(Phase::text, Kind::normal, Quote::none) : leaves[block - 1].exit;
+}
+
+// Summarise the block from start to end of blockText, which has its context around it.
+TagIndex::Leaf TagIndex::ScanBlock(std::string_view blockText, size_t start, size_t end, State entry, bool html) {
+	Leaf leaf;
+	leaf.entry = entry;
+	Summary summary;
+	int running = 0;
+	leaf.exit = ScanMarkup(blockText, start, end, entry, html, [&summary, &running](size_t, int delta) noexcept {
+		running += delta;
+		summary.minPrefix = std::min(summary.minPrefix, running);
+	});
+	summary.sum = running;
+	leaf.summary = summary;
+	leaf.valid = true;
+	return leaf;
+}
+
+void TagIndex::Summarise(const Document &document, size_t block) {
+	const size_t offset = FetchBlock(document, block);
+	const size_t length = BlockStart(block + 1) - BlockStart(block);
+	leaves[block] = ScanBlock(text, offset, offset + length, EntryState(block), html);
+	for (size_t node = (leafBase + block) / 2; node >= 1; node /= 2) {
+		nodeValid[node] = false;
+	}
+}
+
+// Summarise blocks before last that are not valid or were summarised for a different state.
+void TagIndex::MakeConsistent(const Document &document, size_t last) {
+	for (; consistent < last; consistent++) {
+		const Leaf &leaf = leaves[consistent];
+		if (!leaf.valid || (leaf.entry != EntryState(consistent))) {
+			Summarise(document, consistent);
+		}
+	}
+}
+
+// The tags decided in a block that is consistent.
+std::vector<TagIndex::Tag> TagIndex::Tags(const Document &document, size_t block) {
+	std::vector<Tag> tags;
+	const size_t offset = FetchBlock(document, block);
+	const Sci::Position start = BlockStart(block);
+	const size_t length = BlockStart(block + 1) - start;
+	ScanMarkup(text, offset, offset + length, leaves[block].entry, html, [&tags, start, offset](size_t position, int delta) {
+		tags.push_back({ start + static_cast<Sci::Position>(position) - static_cast<Sci::Position>(offset), delta });
+	});
+	return tags;
+}
+
+const TagIndex::Summary &TagIndex::Node(size_t node) {
+	if (node >= leafBase) {
+		static const Summary empty;
+		const size_t leaf = node - leafBase;
+		return (leaf < leaves.size()) ? leaves[leaf].summary : empty;
+	}
+	if (!nodeValid[node]) {
+		const Summary left = Node(node * 2);
+		const Summary &right = Node(node * 2 + 1);
+		nodes[node].sum = left.sum + right.sum;
+		nodes[node].minPrefix = std::min(left.minPrefix, left.sum + right.minPrefix);
+		nodeValid[node] = true;
+	}
+	return nodes[node];
+}
+
+// Find the first block in [first, last) where depth, counting unmatched start tags, reaches 0.
+// Blocks before it are applied to depth. Blocks searched must be consistent.
+size_t TagIndex::SearchForward(size_t node, size_t lo, size_t hi, size_t first, size_t last, int &depth) {
+	if (hi <= first || lo >= last) {
+		return notFound;
+	}
+	if (first <= lo && hi <= last) {
+		const Summary &summary = Node(node);
+		if (depth + summary.minPrefix > 0) {
+			depth += summary.sum;
+			return notFound;
+		}
+		if (hi - lo == 1) {
+			return lo;
+		}
+	}
+	const size_t middle = (lo + hi) / 2;
+	const size_t found = SearchForward(node * 2, lo, middle, first, last, depth);
+	if (found != notFound) {
+		return found;
+	}
+	return SearchForward(node * 2 + 1, middle, hi, first, last, depth);
+}
+
+// Find the last block in [first, last) where depth, counting unmatched end tags, reaches 0.
+// Blocks after it are applied to depth. Blocks searched must be consistent.
+size_t TagIndex::SearchBackward(size_t node, size_t lo, size_t hi, size_t first, size_t last, int &depth) {
+	if (hi <= first || lo >= last) {
+		return notFound;
+	}
+	if (first <= lo && hi <= last) {
+		const Summary &summary = Node(node);
+		if (depth + summary.minPrefix - summary.sum > 0) {
+			depth -= summary.sum;
+			return notFound;
+		}
+		if (hi - lo == 1) {
+			return lo;
+		}
+	}
+	const size_t middle = (lo + hi) / 2;
+	const size_t found = SearchBackward(node * 2 + 1, middle, hi, first, last, depth);
+	if (found != notFound) {
+		return found;
+	}
+	return SearchBackward(node * 2, lo, middle, first, last, depth);
+}
+
+bool TagIndex::For(bool html_) const noexcept {
+	return html == html_;
+}
+
+Sci::Position TagIndex::Match(const Document &document, Sci::Position position) {
+	const Sci::Position length = document.LengthNoExcept();
+	if ((position < 0) || (position + 1 >= length)) {
+		return -1;
+	}
+	// The tag is decided within context bytes after its start, in its block or the next
+	size_t block = blocks.PartitionFromPosition(position + 1);
+	const size_t lastBlock = blocks.PartitionFromPosition(std::min(position + context, length - 1));
+	std::vector<Tag> tags;
+	auto it = tags.end();
+	for (; block <= lastBlock; block++) {
+		MakeConsistent(document, block + 1);
+		tags = Tags(document, block);
+		it = std::find_if(tags.begin(), tags.end(), [position](const Tag &tag) noexcept {
+			return tag.position == position;
+		});
+		if (it != tags.end()) {
+			break;
+		}
+	}
+	if (it == tags.end()) {
+		return -1;
+	}
+	int depth = 1;
+	if (it->delta > 0) {
+		for (++it; it != tags.end(); ++it) {
+			depth += it->delta;
+			if (depth == 0) {
+				return it->position;
+			}
+		}
+		// Summarise blocks ahead in growing steps so a near match does not summarise the whole document
+		size_t next = block + 1;
+		while (next < BlockCount()) {
+			MakeConsistent(document, std::min(BlockCount(), next + (next - block)));
+			const size_t found = SearchForward(1, 0, leafBase, next, consistent, depth);
+			if (found != notFound) {
+				for (const Tag &tag : Tags(document, found)) {
+					depth += tag.delta;
+					if (depth == 0) {
+						return tag.position;
+					}
+				}
+				return -1;
+			}
+			next = consistent;
+		}
+	} else {
+		while (it != tags.begin()) {
+			--it;
+			depth -= it->delta;
+			if (depth == 0) {
+				return it->position;
+			}
+		}
+		const size_t found = SearchBackward(1, 0, leafBase, 0, block, depth);
+		if (found != notFound) {
+			tags = Tags(document, found);
+			for (auto rit = tags.rbegin(); rit != tags.rend(); ++rit) {
+				depth -= rit->delta;
+				if (depth == 0) {
+					return rit->position;
+				}
+			}
+		}
+	}
+	return -1;
+}
+
+void TagIndex::InsertText(Sci::Position position, Sci::Position length) {
+	generation++;
+	const size_t block = blocks.PartitionFromPosition(position);
+	blocks.InsertText(static_cast<Sci::Position>(block), length);
+	InvalidateAround(position, position + length);
+	if (BlockStart(block + 1) - BlockStart(block) > blockSize * 2) {
+		SplitBlock(block);
+	}
+}
+
+void TagIndex::DeleteText(Sci::Position position, Sci::Position length) {
+	generation++;
+	const size_t block = blocks.PartitionFromPosition(position);
+	// Blocks starting inside the deleted range are merged into the block containing its start
+	size_t merged = 0;
+	while ((block + 1 < BlockCount()) && (BlockStart(block + 1) < position + length)) {
+		blocks.RemovePartition(static_cast<Sci::Position>(block + 1));
+		merged++;
+	}
+	blocks.InsertText(static_cast<Sci::Position>(block), -length);
+	if (merged) {
+		EraseBlocks(block + 1, merged);
+	}
+	InvalidateAround(position, position);
+	if (BlockStart(block + 1) - BlockStart(block) > blockSize * 2) {
+		SplitBlock(block);
+	}
+}
+
+bool TagIndex::Pending() const noexcept {
+	return consistent < BlockCount();
+}
+
+bool TagIndex::Build(const Document &document, Sci::Position length) {
+	for (; (consistent < BlockCount()) && (length > 0); consistent++) {
+		const Leaf &leaf = leaves[consistent];
+		if (!leaf.valid || (leaf.entry != EntryState(consistent))) {
+			Summarise(document, consistent);
+			length -= BlockStart(consistent + 1) - BlockStart(consistent);
+		}
+	}
+	return Pending();
+}
+
+std::unique_ptr<IndexJob> TagIndex::Prepare(const Document &document, Sci::Position length) {
+	// Blocks still summarised for the state before them need no work
+	while ((consistent < BlockCount()) && leaves[consistent].valid && (leaves[consistent].entry == EntryState(consistent))) {
+		consistent++;
+	}
+	if (consistent >= BlockCount()) {
+		return {};
+	}
+	std::unique_ptr<Job> job = std::make_unique<Job>(this, html, generation, consistent, EntryState(consistent));
+	size_t last = consistent;
+	while ((last < BlockCount()) && (length > 0)) {
+		length -= BlockStart(last + 1) - BlockStart(last);
+		last++;
+	}
+	const Sci::Position first = std::max<Sci::Position>(BlockStart(consistent) - context, 0);
+	const Sci::Position end = std::min(BlockStart(last) + context, document.LengthNoExcept());
+	job->text.resize(end - first);
+	document.GetCharRange(job->text.data(), first, end - first);
+	for (size_t block = consistent; block <= last; block++) {
+		job->starts.push_back(BlockStart(block) - first);
+	}
+	return job;
+}
+
+bool TagIndex::Merge(IndexJob &indexJob) {
+	if (!indexJob.For(this)) {
+		return false;
+	}
+	const Job &job = static_cast<const Job &>(indexJob);
+	// The text must be unchanged and the blocks must still be the next to summarise
+	if (job.cancelled || (job.generation != generation) || (job.first != consistent) ||
+		(job.entry != EntryState(consistent))) {
+		return true;
+	}
+	for (const Leaf &leaf : job.leaves) {
+		leaves[consistent] = leaf;
+		for (size_t node = (leafBase + consistent) / 2; node >= 1; node /= 2) {
+			nodeValid[node] = false;
+		}
+		consistent++;
+	}
+	return true;
+}
+
+size_t TagIndex::Blocks() const noexcept {
+	return BlockCount();
+}
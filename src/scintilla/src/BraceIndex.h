@@ -0,0 +1,231 @@
+// Scintilla source code edit control
+/** @file BraceIndex.h
+ ** Summarises the braces and tags in blocks of a document so matching braces and tags are found quickly.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef BRACEINDEX_H
+#define BRACEINDEX_H
+
+namespace Scintilla::Internal {
+
+// Position of the first byte that is either a or b. Returns the length when there is none.
+size_t FindEitherByte(std::string_view sv, char a, char b) noexcept;
+
+/**
+ * Summaries of blocks of a brace or tag index made on a worker thread from a copy of the text
+ * and styles they depend on. The index that prepared the job applies them only if it has not
+ * changed since.
+ */
+class IndexJob {
+	const void *index;
+public:
+	std::atomic<bool> cancelled = false;
+	explicit IndexJob(const void *index_) noexcept;
+	// Deleted so IndexJob objects can not be copied.
+	IndexJob(const IndexJob &) = delete;
+	IndexJob(IndexJob &&) = delete;
+	IndexJob &operator=(const IndexJob &) = delete;
+	IndexJob &operator=(IndexJob &&) = delete;
+	virtual ~IndexJob() = default;
+	virtual void Run() = 0;
+	bool For(const void *index_) const noexcept;
+};
+
+/**
+ * Runs an IndexJob on a worker thread. Destroying it cancels the job and waits for the worker.
+ */
+class BackgroundIndexer {
+	std::unique_ptr<IndexJob> job;
+	std::future<void> worker;
+public:
+	explicit BackgroundIndexer(std::unique_ptr<IndexJob> job_);
+	// Deleted so BackgroundIndexer objects can not be copied.
+	BackgroundIndexer(const BackgroundIndexer &) = delete;
+	BackgroundIndexer(BackgroundIndexer &&) = delete;
+	BackgroundIndexer &operator=(const BackgroundIndexer &) = delete;
+	BackgroundIndexer &operator=(BackgroundIndexer &&) = delete;
+	~BackgroundIndexer();
+	bool Running() const;
+	/// Wait for the worker and take the job from it.
+	std::unique_ptr<IndexJob> Finish();
+};
+
+/**
+ * Counts of the braces of one kind in blocks of a document combined in segment trees so that a
+ * search for a matching brace can skip every block where the nesting depth stays above zero.
+ * BraceMatch counts braces of the same style up to the end of styling and braces of any style
+ * after it so there is a tree for each and the block containing the end of styling is scanned.
+ * Summaries are made on demand or in idle time and kept until the text or styles of their block
+ * change, so edits only cost the blocks they touch.
+ * Not for DBCS documents as bytes in braces may be trail bytes.
+ */
+class BraceIndex {
+	struct Summary {
+		// Opening braces minus closing braces
+		int sum = 0;
+		// Lowest running sum over the block including the empty prefix so at most 0.
+		// The lowest running count of closing minus opening braces from the end is minPrefix - sum.
+		int minPrefix = 0;
+	};
+	struct Tree {
+		// One summary per block
+		std::vector<Summary> leaves;
+		std::vector<bool> leafValid;
+		// Inner nodes from root 1. Node leafBase + n is leaf n.
+		std::vector<Summary> nodes;
+		std::vector<bool> nodeValid;
+	};
+	class Job;
+	char chOpen;
+	char chClose;
+	int style;
+	// Changed by every edit or restyle so results of jobs prepared before it are discarded
+	size_t generation = 0;
+	Partitioning<Sci::Position> blocks;
+	// Braces of the style, for blocks before the end of styling
+	Tree styled;
+	// Braces of any style, for blocks after the end of styling
+	Tree unstyled;
+	size_t leafBase = 1;
+
+	size_t BlockCount() const noexcept;
+	Sci::Position BlockStart(size_t block) const noexcept;
+	size_t StyledBlocks(const Document &document) const noexcept;
+	size_t UnstyledStart(const Document &document) const noexcept;
+	void Reset();
+	void InsertBlocks(size_t block, size_t count);
+	void EraseBlocks(size_t block, size_t count);
+	void InvalidateBlock(Tree &tree, size_t block) noexcept;
+	void SplitBlock(size_t block);
+	bool Counts(const Document &document, Sci::Position position) const noexcept;
+	static Summary SummariseText(std::string_view text, std::string_view styles, char chOpen, char chClose, int style, bool unstyled) noexcept;
+	Summary Summarise(Document &document, size_t block, bool unstyled) const;
+	const Summary &Node(Document &document, bool unstyled, size_t node);
+	size_t SearchForward(Document &document, bool unstyled, size_t node, size_t lo, size_t hi, size_t first, size_t last, int &depth);
+	size_t SearchBackward(Document &document, bool unstyled, size_t node, size_t lo, size_t hi, size_t first, size_t last, int &depth);
+
+public:
+	static constexpr Sci::Position blockSize = 0x4000;
+	static constexpr size_t notFound = static_cast<size_t>(-1);
+
+	BraceIndex(const Document &document, char chOpen_, char chClose_, int style_);
+
+	bool For(char chOpen_, int style_) const noexcept;
+	/// Match the brace at position, which must be chOpen or chClose, starting the search from start.
+	Sci::Position Match(Document &document, Sci::Position position, Sci::Position start);
+	void InsertText(Sci::Position position, Sci::Position length);
+	void DeleteText(Sci::Position position, Sci::Position length);
+	/// Styles from start to end changed.
+	void ChangeStyle(Sci::Position start, Sci::Position end) noexcept;
+	/// Are there blocks still to be summarised?
+	bool Pending(const Document &document) const noexcept;
+	/// Summarise blocks until about length bytes have been examined. Returns true if any remain.
+	bool Build(Document &document, Sci::Position length);
+	/// Copy about length bytes of pending blocks to summarise on another thread or nullptr if none.
+	std::unique_ptr<IndexJob> Prepare(const Document &document, Sci::Position length) const;
+	/// Apply a finished job if it was prepared by this index. Returns whether it was.
+	bool Merge(IndexJob &indexJob);
+	size_t Blocks() const noexcept;
+};
+
+/**
+ * Start and end tags of XML or HTML elements in blocks of a document combined in a segment tree
+ * so that a search for the tag matching another can skip every block where the nesting depth
+ * stays above zero.
+ * Tags are recognised from the text alone so matching does not need styling and works in large
+ * documents that are not styled. Comments, CDATA sections, processing instructions, declarations
+ * and quoted attribute values are skipped. For HTML, void elements have no end tag and script
+ * and style elements contain text up to their end tag.
+ * Whether a block starts inside a tag, comment or other construct depends on the blocks before
+ * it so blocks are summarised in document order for the state the previous block ends in.
+ * Summaries are kept until the text near their block changes and later blocks are only
+ * summarised again when the state at their start changes.
+ * Not for DBCS documents as bytes in markup may be trail bytes.
+ */
+class TagIndex {
+public:
+	// The construct a position is in with the kind of element and any open quote for tags
+	using State = unsigned char;
+	struct Tag {
+		// The '<' of a start or end tag or the '/' of "/>"
+		Sci::Position position;
+		// 1 for a start tag, -1 for an end tag or "/>"
+		int delta;
+	};
+
+private:
+	struct Summary {
+		// Start tags minus end tags
+		int sum = 0;
+		// Lowest running sum over the block including the empty prefix so at most 0.
+		int minPrefix = 0;
+	};
+	struct Leaf {
+		Summary summary;
+		State entry = 0;
+		State exit = 0;
+		bool valid = false;
+	};
+	class Job;
+	bool html;
+	// Changed by every edit so results of jobs prepared before it are discarded
+	size_t generation = 0;
+	Partitioning<Sci::Position> blocks;
+	std::vector<Leaf> leaves;
+	// Inner nodes from root 1. Node leafBase + n is leaf n.
+	std::vector<Summary> nodes;
+	std::vector<bool> nodeValid;
+	size_t leafBase = 1;
+	// Leaves before this are valid and summarised for the state the leaf before them ends in
+	size_t consistent = 0;
+	// Text of the block being scanned with the bytes around it that may decide its tags
+	std::string text;
+
+	size_t BlockCount() const noexcept;
+	Sci::Position BlockStart(size_t block) const noexcept;
+	void Reset();
+	void InsertBlocks(size_t block, size_t count);
+	void EraseBlocks(size_t block, size_t count);
+	void InvalidateBlock(size_t block) noexcept;
+	void InvalidateAround(Sci::Position start, Sci::Position end) noexcept;
+	void SplitBlock(size_t block);
+	size_t FetchBlock(const Document &document, size_t block);
+	State EntryState(size_t block) const noexcept;
+	static Leaf ScanBlock(std::string_view blockText, size_t start, size_t end, State entry, bool html);
+	void Summarise(const Document &document, size_t block);
+	void MakeConsistent(const Document &document, size_t last);
+	std::vector<Tag> Tags(const Document &document, size_t block);
+	const Summary &Node(size_t node);
+	size_t SearchForward(size_t node, size_t lo, size_t hi, size_t first, size_t last, int &depth);
+	size_t SearchBackward(size_t node, size_t lo, size_t hi, size_t first, size_t last, int &depth);
+
+public:
+	static constexpr Sci::Position blockSize = 0x4000;
+	// Bytes before or after a block that may decide whether a tag is in it
+	static constexpr Sci::Position context = 8;
+	static constexpr size_t notFound = static_cast<size_t>(-1);
+
+	TagIndex(const Document &document, bool html_);
+
+	bool For(bool html_) const noexcept;
+	/// Match the tag starting at position, either the '<' of a start or end tag or the '/' of "/>".
+	/// A start tag closed by "/>" matches that '/'.
+	Sci::Position Match(const Document &document, Sci::Position position);
+	void InsertText(Sci::Position position, Sci::Position length);
+	void DeleteText(Sci::Position position, Sci::Position length);
+	/// Are there blocks still to be summarised?
+	bool Pending() const noexcept;
+	/// Summarise blocks until about length bytes have been examined. Returns true if any remain.
+	bool Build(const Document &document, Sci::Position length);
+	/// Copy about length bytes of the blocks to be summarised next so they can be summarised on
+	/// another thread or nullptr if none.
+	std::unique_ptr<IndexJob> Prepare(const Document &document, Sci::Position length);
+	/// Apply a finished job if it was prepared by this index. Returns whether it was.
+	bool Merge(IndexJob &indexJob);
+	size_t Blocks() const noexcept;
+};
+
+}
+
+#endif
@@ -23,6 +23,7 @@
 #include <memory>
 
 #include "ScintillaTypes.h"
+#include "ILoader.h"
 
 #include "Debugging.h"
 
@@ -32,40 +33,24 @@
 #include "RunStyles.h"
 #include "SparseVector.h"
 #include "ChangeHistory.h"
+#include "PieceTable.h"
 #include "CellBuffer.h"
 #include "UndoHistory.h"
 #include "UniConversion.h"
 
-namespace Scintilla::Internal {
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CELLBUFFER_AVX2
+#define CELLBUFFER_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define CELLBUFFER_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CELLBUFFER_NEON
+#endif
 
-struct CountWidths {
-	// Measures the number of characters in a string divided into those
-	// from the Base Multilingual Plane and those from other planes.
-	Sci::Position countBasePlane;
-	Sci::Position countOtherPlanes;
-	explicit CountWidths(Sci::Position countBasePlane_=0, Sci::Position countOtherPlanes_=0) noexcept :
-		countBasePlane(countBasePlane_),
-		countOtherPlanes(countOtherPlanes_) {
-	}
-	CountWidths operator-() const noexcept {
-		return CountWidths(-countBasePlane, -countOtherPlanes);
-	}
-	Sci::Position WidthUTF32() const noexcept {
-		// All code points take one code unit in UTF-32.
-		return countBasePlane + countOtherPlanes;
-	}
-	Sci::Position WidthUTF16() const noexcept {
-		// UTF-16 takes 2 code units for other planes
-		return countBasePlane + 2 * countOtherPlanes;
-	}
-	void CountChar(int lenChar) noexcept {
-		if (lenChar == 4) {
-			countOtherPlanes++;
-		} else {
-			countBasePlane++;
-		}
-	}
-};
+namespace Scintilla::Internal {
 
 class ILineVector {
 public:
@@ -87,6 +72,7 @@ public:
 	virtual bool ReleaseLineCharacterIndex(Scintilla::LineCharacterIndexType lineCharacterIndex) = 0;
 	virtual Sci::Position IndexLineStart(Sci::Line line, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept = 0;
 	virtual Sci::Line LineFromPositionIndex(Sci::Position pos, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept = 0;
+	virtual size_t MemoryUsage() const noexcept = 0;
 	virtual ~ILineVector() {}
 };
 
@@ -329,15 +315,25 @@ public:
 			return line_from_pos_cast(startsUTF16.starts.PartitionFromPosition(pos_cast(pos)));
 		}
 	}
+	size_t MemoryUsage() const noexcept override {
+		return starts.MemoryUsage() + startsUTF16.starts.MemoryUsage() + startsUTF32.starts.MemoryUsage();
+	}
 };
 
-CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_) :
+CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_, bool pieceTable_, bool styleRuns_) :
 	hasStyles(hasStyles_), largeDocument(largeDocument_) {
+	if (hasStyles && styleRuns_) {
+		styleRuns = std::make_unique<RunStyles<Sci::Position, char>>();
+	}
 	readOnly = false;
 	utf8Substance = false;
 	utf8LineEnds = LineEndType::Default;
 	collectingUndo = true;
-	uh = std::make_unique<UndoHistory>();
+	if (pieceTable_) {
+		pieces = std::make_unique<PieceTable>();
+	}
+	// The text of a piece table never changes so undo can refer to it instead of copying
+	uh = std::make_unique<UndoHistory>(pieceTable_);
 	if (largeDocument)
 		plv = std::make_unique<LineVector<Sci::Position>>();
 	else
@@ -347,11 +343,14 @@ CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_) :
 CellBuffer::~CellBuffer() noexcept = default;
 
 char CellBuffer::CharAt(Sci::Position position) const noexcept {
+	if (pieces) {
+		return pieces->ValueAt(position);
+	}
 	return substance.ValueAt(position);
 }
 
 unsigned char CellBuffer::UCharAt(Sci::Position position) const noexcept {
-	return substance.ValueAt(position);
+	return CharAt(position);
 }
 
 void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const {
@@ -359,17 +358,24 @@ void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Positio
 		return;
 	if (position < 0)
 		return;
-	if ((position + lengthRetrieve) > substance.Length()) {
+	if ((position + lengthRetrieve) > Length()) {
 		Platform::DebugPrintf("Bad GetCharRange %.0f for %.0f of %.0f\n",
 				      static_cast<double>(position),
 				      static_cast<double>(lengthRetrieve),
-				      static_cast<double>(substance.Length()));
+				      static_cast<double>(Length()));
+		return;
+	}
+	if (pieces) {
+		pieces->GetRange(buffer, position, lengthRetrieve);
 		return;
 	}
 	substance.GetRange(buffer, position, lengthRetrieve);
 }
 
 char CellBuffer::StyleAt(Sci::Position position) const noexcept {
+	if (styleRuns) {
+		return (position >= 0 && position < styleRuns->Length()) ? styleRuns->ValueAt(position) : '\0';
+	}
 	return hasStyles ? style.ValueAt(position) : '\0';
 }
 
@@ -382,29 +388,53 @@ void CellBuffer::GetStyleRange(unsigned char *buffer, Sci::Position position, Sc
 		std::fill(buffer, buffer + lengthRetrieve, static_cast<unsigned char>(0));
 		return;
 	}
-	if ((position + lengthRetrieve) > style.Length()) {
+	const Sci::Position lengthStyles = styleRuns ? styleRuns->Length() : style.Length();
+	if ((position + lengthRetrieve) > lengthStyles) {
 		Platform::DebugPrintf("Bad GetStyleRange %.0f for %.0f of %.0f\n",
 				      static_cast<double>(position),
 				      static_cast<double>(lengthRetrieve),
-				      static_cast<double>(style.Length()));
+				      static_cast<double>(lengthStyles));
+		return;
+	}
+	if (styleRuns) {
+		const Sci::Position end = position + lengthRetrieve;
+		for (Sci::Position pos = position; pos < end;) {
+			const Sci::Position endRun = std::min(styleRuns->EndRun(pos), end);
+			std::fill(buffer + (pos - position), buffer + (endRun - position),
+				static_cast<unsigned char>(styleRuns->ValueAt(pos)));
+			pos = endRun;
+		}
 		return;
 	}
 	style.GetRange(reinterpret_cast<char *>(buffer), position, lengthRetrieve);
 }
 
 const char *CellBuffer::BufferPointer() {
+	if (pieces) {
+		return pieces->BufferPointer();
+	}
 	return substance.BufferPointer();
 }
 
 const char *CellBuffer::RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept {
+	if (pieces) {
+		return pieces->RangePointer(position, rangeLength);
+	}
 	return substance.RangePointer(position, rangeLength);
 }
 
 Sci::Position CellBuffer::GapPosition() const noexcept {
+	if (pieces) {
+		// Text from the start of the last piece onwards is contiguous
+		return pieces->PieceStart(pieces->Pieces() - 1);
+	}
 	return substance.GapPosition();
 }
 
 SplitView CellBuffer::AllView() const noexcept {
+	if (pieces) {
+		return {};
+	}
 	const size_t length = substance.Length();
 	size_t length1 = substance.GapPosition();
 	if (length1 == 0) {
@@ -419,11 +449,21 @@ SplitView CellBuffer::AllView() const noexcept {
 	};
 }
 
-// The char* returned is to an allocation owned by the undo history
+const PieceTable *CellBuffer::Pieces() const noexcept {
+	return pieces.get();
+}
+
+// The char* returned is to an allocation owned by the undo history or, for a piece table, by the
+// piece table
 const char *CellBuffer::InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool &startSequence) {
 	// InsertString and DeleteChars are the bottleneck though which all changes occur
 	const char *data = s;
 	if (!readOnly) {
+		if (pieces) {
+			// Pieces, undo, and redo all refer to the one stored copy
+			s = pieces->Store(s, insertLength);
+			data = s;
+		}
 		if (collectingUndo) {
 			// Save into the undo/redo stack, but only the characters - not the formatting
 			// This takes up about half load time
@@ -438,10 +478,13 @@ const char *CellBuffer::InsertString(Sci::Position position, const char *s, Sci:
 	return data;
 }
 
-bool CellBuffer::SetStyleAt(Sci::Position position, char styleValue) noexcept {
+bool CellBuffer::SetStyleAt(Sci::Position position, char styleValue) {
 	if (!hasStyles) {
 		return false;
 	}
+	if (styleRuns) {
+		return (position >= 0) && styleRuns->FillRange(position, styleValue, 1).changed;
+	}
 	const char curVal = style.ValueAt(position);
 	if (curVal != styleValue) {
 		style.SetValueAt(position, styleValue);
@@ -451,10 +494,13 @@ bool CellBuffer::SetStyleAt(Sci::Position position, char styleValue) noexcept {
 	}
 }
 
-bool CellBuffer::SetStyleFor(Sci::Position position, Sci::Position lengthStyle, char styleValue) noexcept {
+bool CellBuffer::SetStyleFor(Sci::Position position, Sci::Position lengthStyle, char styleValue) {
 	if (!hasStyles) {
 		return false;
 	}
+	if (styleRuns) {
+		return (position >= 0) && styleRuns->FillRange(position, styleValue, lengthStyle).changed;
+	}
 	bool changed = false;
 	PLATFORM_ASSERT(lengthStyle == 0 ||
 		(lengthStyle > 0 && lengthStyle + position <= style.Length()));
@@ -469,6 +515,39 @@ bool CellBuffer::SetStyleFor(Sci::Position position, Sci::Position lengthStyle,
 	return changed;
 }
 
+bool CellBuffer::SetStyles(Sci::Position position, Sci::Position lengthStyle, const char *styles,
+	Sci::Position &first, Sci::Position &last) {
+	bool changed = false;
+	Sci::Position i = 0;
+	while (i < lengthStyle) {
+		Sci::Position end = i + 1;
+		if (styleRuns) {
+			// Fill each run of equal styles at once rather than splitting runs one character at a time
+			while ((end < lengthStyle) && (styles[end] == styles[i])) {
+				end++;
+			}
+			const FillResult<Sci::Position> fill = (position + i >= 0) ?
+				styleRuns->FillRange(position + i, styles[i], end - i) :
+				FillResult<Sci::Position>{false, 0, 0};
+			if (fill.changed) {
+				if (!changed) {
+					first = fill.position;
+				}
+				last = fill.position + fill.fillLength - 1;
+				changed = true;
+			}
+		} else if (SetStyleAt(position + i, styles[i])) {
+			if (!changed) {
+				first = position + i;
+			}
+			last = position + i;
+			changed = true;
+		}
+		i = end;
+	}
+	return changed;
+}
+
 // The char* returned is to an allocation owned by the undo history
 const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position deleteLength, bool &startSequence) {
 	// InsertString and DeleteChars are the bottleneck though which all changes occur
@@ -477,8 +556,12 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 	if (!readOnly) {
 		if (collectingUndo) {
 			// Save into the undo/redo stack, but only the characters - not the formatting
-			// The gap would be moved to position anyway for the deletion so this doesn't cost extra
-			data = substance.RangePointer(position, deleteLength);
+			// The gap would be moved to position anyway for the deletion so this doesn't cost extra.
+			// A piece table's pieces keep their text so undo refers to it rather than a copy.
+			data = pieces ? pieces->StoreRange(position, deleteLength) : RangePointer(position, deleteLength);
+			if (!data) {
+				throw std::bad_alloc();
+			}
 			data = uh->AppendAction(ActionType::remove, position, data, deleteLength, startSequence);
 		}
 
@@ -493,6 +576,9 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 }
 
 Sci::Position CellBuffer::Length() const noexcept {
+	if (pieces) {
+		return pieces->Length();
+	}
 	return substance.Length();
 }
 
@@ -500,12 +586,28 @@ void CellBuffer::Allocate(Sci::Position newSize) {
 	if (!largeDocument && (newSize > INT32_MAX)) {
 		throw std::runtime_error("CellBuffer::Allocate: size of standard document limited to 2G.");
 	}
-	substance.ReAllocate(newSize);
-	if (hasStyles) {
+	if (!pieces) {
+		substance.ReAllocate(newSize);
+	}
+	if (hasStyles && !styleRuns) {
 		style.ReAllocate(newSize);
 	}
 }
 
+size_t CellBuffer::TextMemoryUsage() const noexcept {
+	if (pieces) {
+		return pieces->MemoryUsage();
+	}
+	return substance.MemoryUsage();
+}
+
+size_t CellBuffer::StyleMemoryUsage() const noexcept {
+	if (styleRuns) {
+		return styleRuns->MemoryUsage();
+	}
+	return style.MemoryUsage();
+}
+
 void CellBuffer::SetUTF8Substance(bool utf8Substance_) noexcept {
 	utf8Substance = utf8Substance_;
 }
@@ -566,6 +668,10 @@ void CellBuffer::AllocateLines(Sci::Line lines) {
 	plv->AllocateLines(lines);
 }
 
+size_t CellBuffer::LineMemoryUsage() const noexcept {
+	return plv->MemoryUsage();
+}
+
 Sci::Position CellBuffer::LineStart(Sci::Line line) const noexcept {
 	if (line < 0)
 		return 0;
@@ -630,6 +736,43 @@ bool CellBuffer::HasStyles() const noexcept {
 	return hasStyles;
 }
 
+bool CellBuffer::HasStyleRuns() const noexcept {
+	return static_cast<bool>(styleRuns);
+}
+
+bool CellBuffer::IsPieceTable() const noexcept {
+	return static_cast<bool>(pieces);
+}
+
+bool CellBuffer::SetMappedText(IMappedText *text) {
+	// Undo history may refer to the current pieces' text so they can only be replaced when empty
+	if (!pieces || readOnly || (Length() != 0) || (uh->Actions() != 0)) {
+		return false;
+	}
+	// Start again to drop any earlier original text and added blocks
+	pieces = std::make_unique<PieceTable>();
+	return pieces->SetOriginal(text);
+}
+
+bool CellBuffer::DetachMappedText() {
+	if (!pieces || pieces->OriginalText().empty()) {
+		return false;
+	}
+	// Nothing can refer to the text of an empty buffer without undo history so there is nothing to copy
+	if ((Length() == 0) && (uh->Actions() == 0)) {
+		pieces = std::make_unique<PieceTable>();
+		return true;
+	}
+	const std::string_view original = pieces->OriginalText();
+	const char *copy = pieces->DetachOriginal();
+	if (!copy) {
+		return false;
+	}
+	// Undo history refers to deleted text that may also be in the original text
+	uh->RelocateText(original.data(), original.length(), copy);
+	return true;
+}
+
 void CellBuffer::SetSavePoint() {
 	uh->SetSavePoint();
 	if (changeHistory) {
@@ -669,10 +812,10 @@ void CellBuffer::RemoveLine(Sci::Line line) {
 
 bool CellBuffer::UTF8LineEndOverlaps(Sci::Position position) const noexcept {
 	const unsigned char bytes[] = {
-		static_cast<unsigned char>(substance.ValueAt(position-2)),
-		static_cast<unsigned char>(substance.ValueAt(position-1)),
-		static_cast<unsigned char>(substance.ValueAt(position)),
-		static_cast<unsigned char>(substance.ValueAt(position+1)),
+		static_cast<unsigned char>(CharAt(position-2)),
+		static_cast<unsigned char>(CharAt(position-1)),
+		static_cast<unsigned char>(CharAt(position)),
+		static_cast<unsigned char>(CharAt(position+1)),
 	};
 	return UTF8IsSeparator(bytes) || UTF8IsSeparator(bytes+1) || UTF8IsNEL(bytes+1);
 }
@@ -686,7 +829,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 			if (posBack < 0) {
 				return false;
 			}
-			back.insert(0, 1, substance.ValueAt(posBack));
+			back.insert(0, 1, CharAt(posBack));
 			if (!UTF8IsTrailByte(back.front())) {
 				if (i > 0) {
 					// Have reached a non-trail
@@ -700,7 +843,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 		}
 	}
 	if (position < Length()) {
-		const unsigned char fore = substance.ValueAt(position);
+		const unsigned char fore = CharAt(position);
 		if (UTF8IsTrailByte(fore)) {
 			return false;
 		}
@@ -721,8 +864,12 @@ void CellBuffer::ResetLineEnds() {
 	constexpr bool atLineStart = true;
 	unsigned char chBeforePrev = 0;
 	unsigned char chPrev = 0;
+	std::optional<PieceView> view;
+	if (pieces) {
+		view.emplace(*pieces);
+	}
 	for (Sci::Position i = 0; i < length; i++) {
-		const unsigned char ch = substance.ValueAt(position + i);
+		const unsigned char ch = view ? view->CharAt(position + i) : substance.ValueAt(position + i);
 		if (ch == '\r') {
 			InsertLine(lineInsert, (position + i) + 1, atLineStart);
 			lineInsert++;
@@ -747,19 +894,352 @@ void CellBuffer::ResetLineEnds() {
 
 namespace {
 
+// Insertions at least this long count their line ends first so the line starts can be allocated at once.
+constexpr Sci::Position bulkInsertionLength = 0x10000;
+
+#if defined(CELLBUFFER_SSE2) || defined(CELLBUFFER_NEON)
+
+// Vector byte counters are incremented once per block so must be summed before they overflow.
+constexpr size_t blocksPerSum = 255;
+
+#endif
+
+#if defined(CELLBUFFER_SSE2)
+
+size_t SumBytes(__m128i counts) noexcept {
+	const __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+	return _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+}
+
+#endif
+
+#if defined(CELLBUFFER_AVX2)
+
+size_t SumBytes(__m256i counts) noexcept {
+	return SumBytes(_mm256_castsi256_si128(counts)) + SumBytes(_mm256_extracti128_si256(counts, 1));
+}
+
+#endif
+
+// Add the widths of the characters in sv to cw. When more text follows sv, stops before a final
+// character that may continue into that text. Returns the number of bytes counted.
+size_t AddCharacterWidthsUTF8(std::string_view sv, bool followed, CountWidths &cw) noexcept {
+	size_t position = 0;
+	while (position < sv.length()) {
+		const std::string_view rest = sv.substr(position);
+		const unsigned char lead = rest.front();
+		if (UTF8IsAscii(lead)) {
+			const size_t ascii = AsciiPrefixLength(rest);
+			cw.countBasePlane += ascii;
+			position += ascii;
+		} else {
+			if (followed && (rest.length() < UTF8BytesOfLead[lead])) {
+				break;
+			}
+			const int lenChar = UTF8Classify(rest) & UTF8MaskWidth;
+			cw.CountChar(lenChar);
+			position += lenChar;
+		}
+	}
+	return position;
+}
+
+}
+
+namespace Scintilla::Internal {
+
+size_t FindLineEndByte(std::string_view sv, bool unicodeLineEnds) noexcept {
+	const unsigned char *us = reinterpret_cast<const unsigned char *>(sv.data());
+	const size_t length = sv.length();
+	size_t i = 0;
+#if defined(CELLBUFFER_AVX2)
+	{
+		const __m256i cr = _mm256_set1_epi8('\r');
+		const __m256i lf = _mm256_set1_epi8('\n');
+		const __m256i nel = _mm256_set1_epi8(static_cast<char>(0x85));
+		// LS and PS end with 0xA8 and 0xA9 so setting the low bit matches both
+		const __m256i one = _mm256_set1_epi8(1);
+		const __m256i separator = _mm256_set1_epi8(static_cast<char>(0xa9));
+		for (; i + 32 <= length; i += 32) {
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(us + i));
+			__m256i found = _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf));
+			if (unicodeLineEnds) {
+				found = _mm256_or_si256(found, _mm256_or_si256(_mm256_cmpeq_epi8(v, nel),
+					_mm256_cmpeq_epi8(_mm256_or_si256(v, one), separator)));
+			}
+			if (_mm256_movemask_epi8(found) != 0) {
+				break;
+			}
+		}
+	}
+#endif
+#if defined(CELLBUFFER_SSE2)
+	{
+		const __m128i cr = _mm_set1_epi8('\r');
+		const __m128i lf = _mm_set1_epi8('\n');
+		const __m128i nel = _mm_set1_epi8(static_cast<char>(0x85));
+		const __m128i one = _mm_set1_epi8(1);
+		const __m128i separator = _mm_set1_epi8(static_cast<char>(0xa9));
+		for (; i + 16 <= length; i += 16) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(us + i));
+			__m128i found = _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf));
+			if (unicodeLineEnds) {
+				found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(v, nel),
+					_mm_cmpeq_epi8(_mm_or_si128(v, one), separator)));
+			}
+			if (_mm_movemask_epi8(found) != 0) {
+				break;
+			}
+		}
+	}
+#elif defined(CELLBUFFER_NEON)
+	{
+		const uint8x16_t cr = vdupq_n_u8('\r');
+		const uint8x16_t lf = vdupq_n_u8('\n');
+		const uint8x16_t nel = vdupq_n_u8(0x85);
+		const uint8x16_t one = vdupq_n_u8(1);
+		const uint8x16_t separator = vdupq_n_u8(0xa9);
+		for (; i + 16 <= length; i += 16) {
+			const uint8x16_t v = vld1q_u8(us + i);
+			uint8x16_t found = vorrq_u8(vceqq_u8(v, cr), vceqq_u8(v, lf));
+			if (unicodeLineEnds) {
+				found = vorrq_u8(found, vorrq_u8(vceqq_u8(v, nel), vceqq_u8(vorrq_u8(v, one), separator)));
+			}
+			if (vmaxvq_u8(found) != 0) {
+				break;
+			}
+		}
+	}
+#endif
+	// Find the exact byte within the block that matched or check the remaining tail
+	for (; i < length; i++) {
+		const unsigned char ch = us[i];
+		if ((ch == '\r') || (ch == '\n')) {
+			break;
+		}
+		if (unicodeLineEnds && ((ch == 0x85) || (ch == 0xa8) || (ch == 0xa9))) {
+			break;
+		}
+	}
+	return i;
+}
+
+Sci::Line CountLineEnds(std::string_view sv) noexcept {
+	if (sv.empty()) {
+		return 0;
+	}
+	const unsigned char *us = reinterpret_cast<const unsigned char *>(sv.data());
+	const size_t length = sv.length();
+	// The first byte has no previous byte to pair with so is examined alone then each block
+	// compares with the same block shifted back one byte to skip the LF of CR+LF.
+	Sci::Line count = (us[0] == '\r') || (us[0] == '\n');
+	size_t i = 1;
+#if defined(CELLBUFFER_AVX2)
+	{
+		const __m256i cr = _mm256_set1_epi8('\r');
+		const __m256i lf = _mm256_set1_epi8('\n');
+		while (i + 32 <= length) {
+			const size_t blocks = std::min((length - i) / 32, blocksPerSum);
+			__m256i counts = _mm256_setzero_si256();
+			for (size_t block = 0; block < blocks; block++, i += 32) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(us + i));
+				const __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(us + i - 1));
+				const __m256i ends = _mm256_or_si256(_mm256_cmpeq_epi8(v, cr),
+					_mm256_andnot_si256(_mm256_cmpeq_epi8(prev, cr), _mm256_cmpeq_epi8(v, lf)));
+				// Matching bytes are -1 so subtracting increments the counter
+				counts = _mm256_sub_epi8(counts, ends);
+			}
+			count += SumBytes(counts);
+		}
+	}
+#endif
+#if defined(CELLBUFFER_SSE2)
+	{
+		const __m128i cr = _mm_set1_epi8('\r');
+		const __m128i lf = _mm_set1_epi8('\n');
+		while (i + 16 <= length) {
+			const size_t blocks = std::min((length - i) / 16, blocksPerSum);
+			__m128i counts = _mm_setzero_si128();
+			for (size_t block = 0; block < blocks; block++, i += 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(us + i));
+				const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i *>(us + i - 1));
+				const __m128i ends = _mm_or_si128(_mm_cmpeq_epi8(v, cr),
+					_mm_andnot_si128(_mm_cmpeq_epi8(prev, cr), _mm_cmpeq_epi8(v, lf)));
+				counts = _mm_sub_epi8(counts, ends);
+			}
+			count += SumBytes(counts);
+		}
+	}
+#elif defined(CELLBUFFER_NEON)
+	{
+		const uint8x16_t cr = vdupq_n_u8('\r');
+		const uint8x16_t lf = vdupq_n_u8('\n');
+		while (i + 16 <= length) {
+			const size_t blocks = std::min((length - i) / 16, blocksPerSum);
+			uint8x16_t counts = vdupq_n_u8(0);
+			for (size_t block = 0; block < blocks; block++, i += 16) {
+				const uint8x16_t v = vld1q_u8(us + i);
+				const uint8x16_t prev = vld1q_u8(us + i - 1);
+				const uint8x16_t ends = vorrq_u8(vceqq_u8(v, cr),
+					vbicq_u8(vceqq_u8(v, lf), vceqq_u8(prev, cr)));
+				counts = vsubq_u8(counts, ends);
+			}
+			count += vaddlvq_u8(counts);
+		}
+	}
+#endif
+	for (; i < length; i++) {
+		count += (us[i] == '\r') || ((us[i] == '\n') && (us[i - 1] != '\r'));
+	}
+	return count;
+}
+
+size_t AsciiPrefixLength(std::string_view sv) noexcept {
+	const unsigned char *us = reinterpret_cast<const unsigned char *>(sv.data());
+	const size_t length = sv.length();
+	size_t i = 0;
+#if defined(CELLBUFFER_AVX2)
+	for (; i + 32 <= length; i += 32) {
+		if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(us + i))) != 0) {
+			break;
+		}
+	}
+#endif
+#if defined(CELLBUFFER_SSE2)
+	for (; i + 16 <= length; i += 16) {
+		if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(us + i))) != 0) {
+			break;
+		}
+	}
+#elif defined(CELLBUFFER_NEON)
+	for (; i + 16 <= length; i += 16) {
+		if (vmaxvq_u8(vld1q_u8(us + i)) >= 0x80) {
+			break;
+		}
+	}
+#endif
+	while ((i < length) && UTF8IsAscii(us[i])) {
+		i++;
+	}
+	return i;
+}
+
 CountWidths CountCharacterWidthsUTF8(std::string_view sv) noexcept {
 	CountWidths cw;
-	size_t remaining = sv.length();
-	while (remaining > 0) {
-		const int utf8Status = UTF8Classify(sv);
-		const int lenChar = utf8Status & UTF8MaskWidth;
-		cw.CountChar(lenChar);
-		sv.remove_prefix(lenChar);
-		remaining -= lenChar;
-	}
+	AddCharacterWidthsUTF8(sv, false, cw);
 	return cw;
 }
 
+CountWidths CountCharacterWidthsValidUTF8(std::string_view sv) noexcept {
+	const unsigned char *us = reinterpret_cast<const unsigned char *>(sv.data());
+	const size_t length = sv.length();
+	// Each character has one byte that is not a trail byte and those outside the Base
+	// Multilingual Plane start with a byte of 0xF0 or more.
+	Sci::Position characters = 0;
+	Sci::Position otherPlanes = 0;
+	size_t i = 0;
+#if defined(CELLBUFFER_AVX2)
+	{
+		// As signed bytes, trail bytes are -128..-65 so all others are greater than -65.
+		// Bytes are at least 0xF0 when the unsigned maximum with 0xF0 leaves them unchanged.
+		const __m256i lastTrail = _mm256_set1_epi8(-65);
+		const __m256i fourByteLead = _mm256_set1_epi8(static_cast<char>(0xf0));
+		while (i + 32 <= length) {
+			const size_t blocks = std::min((length - i) / 32, blocksPerSum);
+			__m256i countsCharacters = _mm256_setzero_si256();
+			__m256i countsOtherPlanes = _mm256_setzero_si256();
+			for (size_t block = 0; block < blocks; block++, i += 32) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(us + i));
+				countsCharacters = _mm256_sub_epi8(countsCharacters, _mm256_cmpgt_epi8(v, lastTrail));
+				countsOtherPlanes = _mm256_sub_epi8(countsOtherPlanes, _mm256_cmpeq_epi8(_mm256_max_epu8(v, fourByteLead), v));
+			}
+			characters += SumBytes(countsCharacters);
+			otherPlanes += SumBytes(countsOtherPlanes);
+		}
+	}
+#endif
+#if defined(CELLBUFFER_SSE2)
+	{
+		const __m128i lastTrail = _mm_set1_epi8(-65);
+		const __m128i fourByteLead = _mm_set1_epi8(static_cast<char>(0xf0));
+		while (i + 16 <= length) {
+			const size_t blocks = std::min((length - i) / 16, blocksPerSum);
+			__m128i countsCharacters = _mm_setzero_si128();
+			__m128i countsOtherPlanes = _mm_setzero_si128();
+			for (size_t block = 0; block < blocks; block++, i += 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(us + i));
+				countsCharacters = _mm_sub_epi8(countsCharacters, _mm_cmpgt_epi8(v, lastTrail));
+				countsOtherPlanes = _mm_sub_epi8(countsOtherPlanes, _mm_cmpeq_epi8(_mm_max_epu8(v, fourByteLead), v));
+			}
+			characters += SumBytes(countsCharacters);
+			otherPlanes += SumBytes(countsOtherPlanes);
+		}
+	}
+#elif defined(CELLBUFFER_NEON)
+	{
+		const uint8x16_t firstTrail = vdupq_n_u8(0x80);
+		const uint8x16_t afterTrail = vdupq_n_u8(0xc0);
+		const uint8x16_t fourByteLead = vdupq_n_u8(0xf0);
+		while (i + 16 <= length) {
+			const size_t blocks = std::min((length - i) / 16, blocksPerSum);
+			uint8x16_t countsCharacters = vdupq_n_u8(0);
+			uint8x16_t countsOtherPlanes = vdupq_n_u8(0);
+			for (size_t block = 0; block < blocks; block++, i += 16) {
+				const uint8x16_t v = vld1q_u8(us + i);
+				const uint8x16_t notTrail = vorrq_u8(vcltq_u8(v, firstTrail), vcgeq_u8(v, afterTrail));
+				countsCharacters = vsubq_u8(countsCharacters, notTrail);
+				countsOtherPlanes = vsubq_u8(countsOtherPlanes, vcgeq_u8(v, fourByteLead));
+			}
+			characters += vaddlvq_u8(countsCharacters);
+			otherPlanes += vaddlvq_u8(countsOtherPlanes);
+		}
+	}
+#endif
+	for (; i < length; i++) {
+		characters += !UTF8IsTrailByte(us[i]);
+		otherPlanes += us[i] >= 0xf0;
+	}
+	return CountWidths(characters - otherPlanes, otherPlanes);
+}
+
+}
+
+CountWidths CellBuffer::CountCharacterWidths(Sci::Position position, Sci::Position end) const noexcept {
+	// Count directly from each contiguous segment of the buffer: the two parts either side of
+	// the gap or the pieces of a piece table. A character split between segments is measured
+	// from a copy of its bytes.
+	const SplitView view = AllView();
+	CountWidths cw;
+	while (position < end) {
+		std::string_view segment;
+		if (pieces) {
+			segment = pieces->SegmentAt(position);
+		} else if (position < static_cast<Sci::Position>(view.length1)) {
+			segment = std::string_view(view.segment1 + position, view.length1 - position);
+		} else if (position < static_cast<Sci::Position>(view.length)) {
+			segment = std::string_view(view.segment2 + position, view.length - position);
+		}
+		if (segment.empty()) {
+			break;
+		}
+		const Sci::Position segmentEnd = position + segment.length();
+		if (segmentEnd >= end) {
+			AddCharacterWidthsUTF8(segment.substr(0, end - position), false, cw);
+			break;
+		}
+		position += AddCharacterWidthsUTF8(segment, true, cw);
+		while (position < segmentEnd) {
+			char bytes[UTF8MaxBytes]{};
+			const Sci::Position lenBytes = std::min<Sci::Position>(UTF8MaxBytes, end - position);
+			for (Sci::Position b = 0; b < lenBytes; b++) {
+				bytes[b] = CharAt(position + b);
+			}
+			const int lenChar = UTF8Classify(bytes, lenBytes) & UTF8MaskWidth;
+			cw.CountChar(lenChar);
+			position += lenChar;
+		}
+	}
+	return cw;
 }
 
 bool CellBuffer::MaintainingLineCharacterIndex() const noexcept {
@@ -767,16 +1247,12 @@ bool CellBuffer::MaintainingLineCharacterIndex() const noexcept {
 }
 
 void CellBuffer::RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineLast) {
-	std::string text;
 	Sci::Position posLineEnd = LineStart(lineFirst);
 	for (Sci::Line line = lineFirst; line <= lineLast; line++) {
-		// Find line start and end, retrieve text of line, count characters and update line width
+		// Find line start and end, count characters and update line width
 		const Sci::Position posLineStart = posLineEnd;
 		posLineEnd = LineStart(line+1);
-		const Sci::Position width = posLineEnd - posLineStart;
-		text.resize(width);
-		GetCharRange(text.data(), posLineStart, width);
-		const CountWidths cw = CountCharacterWidthsUTF8(text);
+		const CountWidths cw = CountCharacterWidths(posLineStart, posLineEnd);
 		plv->SetLineCharactersWidth(line, cw);
 	}
 }
@@ -786,7 +1262,7 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 		return;
 	PLATFORM_ASSERT(insertLength > 0);
 
-	const unsigned char chAfter = substance.ValueAt(position);
+	const unsigned char chAfter = CharAt(position);
 	bool breakingUTF8LineEnd = false;
 	if (utf8LineEnds == LineEndType::Unicode && UTF8IsTrailByte(chAfter)) {
 		breakingUTF8LineEnd = UTF8LineEndOverlaps(position);
@@ -808,16 +1284,39 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 			UTF8IsValid(std::string_view(s, insertLength));
 	}
 
-	substance.InsertFromArray(position, s, 0, insertLength);
-	if (hasStyles) {
+	if (pieces) {
+		pieces->Insert(position, s, insertLength);
+	} else {
+		substance.InsertFromArray(position, s, 0, insertLength);
+	}
+	if (styleRuns) {
+		// Inserted text may extend the run before it so is then reset to the default style
+		styleRuns->InsertSpace(position, insertLength);
+		styleRuns->FillRange(position, 0, insertLength);
+	} else if (hasStyles) {
 		style.InsertValue(position, insertLength, 0);
 	}
 
+	if (insertLength >= bulkInsertionLength) {
+		// Loading a file with millions of short lines would otherwise grow the line starts many times.
+		// Only allocate when the line count at least doubles so a long series of appends still grows
+		// geometrically instead of reallocating for each one. A leading sample decides whether
+		// counting the whole insertion is worthwhile.
+		const Sci::Line lines = plv->Lines();
+		const Sci::Line sampleEnds = CountLineEnds(std::string_view(s, bulkInsertionLength));
+		if (sampleEnds * (insertLength / bulkInsertionLength) >= lines) {
+			const Sci::Line lineEnds = CountLineEnds(std::string_view(s, insertLength));
+			if (lineEnds >= lines) {
+				plv->AllocateLines(lines + lineEnds);
+			}
+		}
+	}
+
 	const bool atLineStart = plv->LineStart(lineInsert-1) == position;
 	// Point all the lines after the insertion point further along in the buffer
 	plv->InsertText(lineInsert-1, insertLength);
-	unsigned char chBeforePrev = substance.ValueAt(position - 2);
-	unsigned char chPrev = substance.ValueAt(position - 1);
+	unsigned char chBeforePrev = CharAt(position - 2);
+	unsigned char chPrev = CharAt(position - 1);
 	if (chPrev == '\r' && chAfter == '\n') {
 		// Splitting up a crlf pair at position
 		InsertLine(lineInsert, position, false);
@@ -855,15 +1354,20 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 			eolTable[0xa9] = 3;
 		}
 
+		const bool unicodeLineEnds = utf8LineEnds == LineEndType::Unicode;
 		do {
 			// skip to line end
-			ch = *ptr++;
-			uint8_t type;
-			while ((type = eolTable[ch]) == 0 && ptr < end) {
-				chBeforePrev = chPrev;
-				chPrev = ch;
-				ch = *ptr++;
+			const size_t skip = FindLineEndByte(std::string_view(ptr, end - ptr), unicodeLineEnds);
+			if (skip > 0) {
+				chBeforePrev = (skip > 1) ? ptr[skip - 2] : chPrev;
+				chPrev = ptr[skip - 1];
+				ptr += skip;
+				if (ptr == end) {
+					break;
+				}
 			}
+			ch = *ptr++;
+			const uint8_t type = eolTable[ch];
 			switch (type) {
 			case 2: // '\r'
 				if (*ptr == '\n') {
@@ -928,7 +1432,7 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 		chPrev = ch;
 		// May have end of UTF-8 line end in buffer and start in insertion
 		for (int j = 0; j < UTF8SeparatorLength-1; j++) {
-			const unsigned char chAt = substance.ValueAt(position + insertLength + j);
+			const unsigned char chAt = CharAt(position + insertLength + j);
 			const unsigned char back3[3] = {chBeforePrev, chPrev, chAt};
 			if (UTF8IsSeparator(back3)) {
 				InsertLine(lineInsert, (position + insertLength + j) + 1, atLineStart);
@@ -944,7 +1448,8 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 	}
 	if (maintainingIndex) {
 		if (simpleInsertion && (lineInsert == lineStart)) {
-			const CountWidths cw = CountCharacterWidthsUTF8(std::string_view(s, insertLength));
+			// Already checked that the insertion is valid UTF-8
+			const CountWidths cw = CountCharacterWidthsValidUTF8(std::string_view(s, insertLength));
 			plv->InsertCharacters(linePosition, cw);
 		} else {
 			RecalculateIndexLineStarts(linePosition, lineInsert - 1);
@@ -958,7 +1463,7 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 
 	Sci::Line lineRecalculateStart = Sci::invalidPosition;
 
-	if ((position == 0) && (deleteLength == substance.Length())) {
+	if ((position == 0) && (deleteLength == Length())) {
 		// If whole buffer is being deleted, faster to reinitialise lines data
 		// than to delete each line.
 		plv->Init();
@@ -970,9 +1475,9 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 		Sci::Line lineRemove = linePosition + 1;
 
 		plv->InsertText(lineRemove-1, - (deleteLength));
-		const unsigned char chPrev = substance.ValueAt(position - 1);
+		const unsigned char chPrev = CharAt(position - 1);
 		const unsigned char chBefore = chPrev;
-		unsigned char chNext = substance.ValueAt(position);
+		unsigned char chNext = CharAt(position);
 
 		// Check for breaking apart a UTF-8 sequence
 		// Needs further checks that text is UTF-8 or that some other break apart is occurring
@@ -987,7 +1492,7 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 				GetCharRange(text.data(), position, deleteLength);
 				if (UTF8IsValid(text)) {
 					// Everything is good
-					const CountWidths cw = CountCharacterWidthsUTF8(text);
+					const CountWidths cw = CountCharacterWidthsValidUTF8(text);
 					plv->InsertCharacters(linePosition, -cw);
 				} else {
 					lineRecalculateStart = linePosition;
@@ -1010,9 +1515,17 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 			}
 		}
 
+		// Reading through a view avoids searching for the piece of each byte
+		std::optional<PieceView> view;
+		if (pieces) {
+			view.emplace(*pieces);
+		}
+		auto charAt = [this, &view](Sci::Position pos) noexcept -> char {
+			return view ? view->CharAt(pos) : substance.ValueAt(pos);
+		};
 		unsigned char ch = chNext;
 		for (Sci::Position i = 0; i < deleteLength; i++) {
-			chNext = substance.ValueAt(position + i + 1);
+			chNext = charAt(position + i + 1);
 			if (ch == '\r') {
 				if (chNext != '\n') {
 					RemoveLine(lineRemove);
@@ -1026,7 +1539,7 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 			} else if (utf8LineEnds == LineEndType::Unicode) {
 				if (!UTF8IsAscii(ch)) {
 					const unsigned char next3[3] = {ch, chNext,
-						static_cast<unsigned char>(substance.ValueAt(position + i + 2))};
+						static_cast<unsigned char>(charAt(position + i + 2))};
 					if (UTF8IsSeparator(next3) || UTF8IsNEL(next3)) {
 						RemoveLine(lineRemove);
 					}
@@ -1037,18 +1550,24 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 		}
 		// May have to fix up end if last deletion causes cr to be next to lf
 		// or removes one of a crlf pair
-		const char chAfter = substance.ValueAt(position + deleteLength);
+		const char chAfter = CharAt(position + deleteLength);
 		if (chBefore == '\r' && chAfter == '\n') {
 			// Using lineRemove-1 as cr ended line before start of deletion
 			RemoveLine(lineRemove - 1);
 			plv->SetLineStart(lineRemove - 1, position + 1);
 		}
 	}
-	substance.DeleteRange(position, deleteLength);
+	if (pieces) {
+		pieces->DeleteRange(position, deleteLength);
+	} else {
+		substance.DeleteRange(position, deleteLength);
+	}
 	if (lineRecalculateStart >= 0) {
 		RecalculateIndexLineStarts(lineRecalculateStart, lineRecalculateStart);
 	}
-	if (hasStyles) {
+	if (styleRuns) {
+		styleRuns->DeleteRange(position, deleteLength);
+	} else if (hasStyles) {
 		style.DeleteRange(position, deleteLength);
 	}
 }
@@ -1108,7 +1627,7 @@ void CellBuffer::PerformUndoStep() {
 		changeHistory->StartReversion();
 	}
 	if (previousStep.at == ActionType::insert) {
-		if (substance.Length() < previousStep.lenData) {
+		if (Length() < previousStep.lenData) {
 			throw std::runtime_error(
 				"CellBuffer::PerformUndoStep: deletion must be less than document length.");
 		}
@@ -1163,6 +1682,18 @@ int CellBuffer::UndoActions() const noexcept {
 	return uh->Actions();
 }
 
+void CellBuffer::SetUndoMemoryLimit(size_t limit) noexcept {
+	uh->SetMemoryLimit(limit);
+}
+
+size_t CellBuffer::UndoMemoryLimit() const noexcept {
+	return uh->MemoryLimit();
+}
+
+size_t CellBuffer::UndoMemoryUsage() const noexcept {
+	return uh->MemoryUsage();
+}
+
 void CellBuffer::SetUndoSavePoint(int action) noexcept {
 	uh->SetSavePoint(action);
 }
@@ -1283,6 +1814,9 @@ void CellBuffer::PushUndoActionType(int type, Sci::Position position) {
 }
 
 void CellBuffer::ChangeLastUndoActionText(size_t length, const char *text) {
+	if (pieces) {
+		text = pieces->Store(text, length);
+	}
 	uh->ChangeLastUndoActionText(length, text);
 }
 
@@ -1323,3 +1857,10 @@ Sci::Position CellBuffer::EditionNextDelete(Sci::Position pos) const noexcept {
 	}
 	return Length() + 1;
 }
+
+size_t CellBuffer::ChangeHistoryMemoryUsage() const noexcept {
+	if (changeHistory) {
+		return changeHistory->MemoryUsage();
+	}
+	return 0;
+}
@@ -8,6 +8,10 @@
 #ifndef CELLBUFFER_H
 #define CELLBUFFER_H
 
+namespace Scintilla {
+class IMappedText;
+}
+
 namespace Scintilla::Internal {
 
 // Interface to per-line data that wants to see each line insertion and deletion
@@ -18,10 +22,14 @@ public:
 	virtual void InsertLine(Sci::Line line)=0;
 	virtual void InsertLines(Sci::Line line, Sci::Line lines) = 0;
 	virtual void RemoveLine(Sci::Line line)=0;
+	virtual size_t MemoryUsage() const noexcept=0;
 };
 
 class UndoHistory;
 class ChangeHistory;
+class PieceTable;
+template <typename DISTANCE, typename STYLE>
+class RunStyles;
 
 /**
  * The line vector contains information about each of the lines in a cell buffer.
@@ -66,6 +74,52 @@ struct SplitView {
 	}
 };
 
+struct CountWidths {
+	// Measures the number of characters in a string divided into those
+	// from the Base Multilingual Plane and those from other planes.
+	Sci::Position countBasePlane;
+	Sci::Position countOtherPlanes;
+	explicit CountWidths(Sci::Position countBasePlane_=0, Sci::Position countOtherPlanes_=0) noexcept :
+		countBasePlane(countBasePlane_),
+		countOtherPlanes(countOtherPlanes_) {
+	}
+	CountWidths operator-() const noexcept {
+		return CountWidths(-countBasePlane, -countOtherPlanes);
+	}
+	Sci::Position WidthUTF32() const noexcept {
+		// All code points take one code unit in UTF-32.
+		return countBasePlane + countOtherPlanes;
+	}
+	Sci::Position WidthUTF16() const noexcept {
+		// UTF-16 takes 2 code units for other planes
+		return countBasePlane + 2 * countOtherPlanes;
+	}
+	void CountChar(int lenChar) noexcept {
+		if (lenChar == 4) {
+			countOtherPlanes++;
+		} else {
+			countBasePlane++;
+		}
+	}
+};
+
+// Scanning kernels used when inserting text and maintaining the line character indices.
+// These process 16 or 32 bytes at a time with SSE2, AVX2, or NEON when the compiler targets
+// them and fall back to scalar loops otherwise.
+
+// Position of the first byte that may end a line: CR, LF, and, when unicodeLineEnds, the final
+// bytes of NEL, LS, and PS. Returns the length when there is none.
+size_t FindLineEndByte(std::string_view sv, bool unicodeLineEnds) noexcept;
+// Count CR, LF, and CR+LF line ends. Unicode line ends are not counted.
+Sci::Line CountLineEnds(std::string_view sv) noexcept;
+// Length of the initial run of ASCII bytes.
+size_t AsciiPrefixLength(std::string_view sv) noexcept;
+// Count characters in UTF-8 text with each byte of invalid UTF-8 counting as one character.
+CountWidths CountCharacterWidthsUTF8(std::string_view sv) noexcept;
+// Count characters in text already known to be valid UTF-8 by counting the bytes that are not
+// trail bytes. Faster than CountCharacterWidthsUTF8 but wrong for invalid UTF-8.
+CountWidths CountCharacterWidthsValidUTF8(std::string_view sv) noexcept;
+
 
 /**
  * Holder for an expandable array of characters that supports undo and line markers.
@@ -77,7 +131,9 @@ private:
 	bool hasStyles;
 	bool largeDocument;
 	SplitVector<char> substance;
+	std::unique_ptr<PieceTable> pieces;	// Replaces substance when set
 	SplitVector<char> style;
+	std::unique_ptr<RunStyles<Sci::Position, char>> styleRuns;	// Replaces style when set
 	bool readOnly;
 	bool utf8Substance;
 	Scintilla::LineEndType utf8LineEnds;
@@ -100,7 +156,7 @@ private:
 
 public:
 
-	CellBuffer(bool hasStyles_, bool largeDocument_);
+	CellBuffer(bool hasStyles_, bool largeDocument_, bool pieceTable_=false, bool styleRuns_=false);
 	// Deleted so CellBuffer objects can not be copied.
 	CellBuffer(const CellBuffer &) = delete;
 	CellBuffer(CellBuffer &&) = delete;
@@ -117,10 +173,15 @@ public:
 	const char *BufferPointer();
 	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept;
 	Sci::Position GapPosition() const noexcept;
+	/// Piece table buffers have no gap and return an empty view.
 	SplitView AllView() const noexcept;
+	const PieceTable *Pieces() const noexcept;
+	CountWidths CountCharacterWidths(Sci::Position position, Sci::Position end) const noexcept;
 
 	Sci::Position Length() const noexcept;
 	void Allocate(Sci::Position newSize);
+	size_t TextMemoryUsage() const noexcept;
+	size_t StyleMemoryUsage() const noexcept;
 	void SetUTF8Substance(bool utf8Substance_) noexcept;
 	Scintilla::LineEndType GetLineEndTypes() const noexcept { return utf8LineEnds; }
 	void SetLineEndTypes(Scintilla::LineEndType utf8LineEnds_);
@@ -131,6 +192,7 @@ public:
 	void ReleaseLineCharacterIndex(Scintilla::LineCharacterIndexType lineCharacterIndex);
 	Sci::Line Lines() const noexcept;
 	void AllocateLines(Sci::Line lines);
+	size_t LineMemoryUsage() const noexcept;
 	Sci::Position LineStart(Sci::Line line) const noexcept;
 	Sci::Position LineEnd(Sci::Line line) const noexcept;
 	Sci::Position IndexLineStart(Sci::Line line, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept;
@@ -142,8 +204,13 @@ public:
 
 	/// Setting styles for positions outside the range of the buffer is safe and has no effect.
 	/// @return true if the style of a character is changed.
-	bool SetStyleAt(Sci::Position position, char styleValue) noexcept;
-	bool SetStyleFor(Sci::Position position, Sci::Position lengthStyle, char styleValue) noexcept;
+	bool SetStyleAt(Sci::Position position, char styleValue);
+	bool SetStyleFor(Sci::Position position, Sci::Position lengthStyle, char styleValue);
+	/// Set the styles of lengthStyle characters from position, a run of equal styles at a time
+	/// when styles are stored as runs.
+	/// @return true if the style of a character is changed with the changed range in first and last.
+	bool SetStyles(Sci::Position position, Sci::Position lengthStyle, const char *styles,
+		Sci::Position &first, Sci::Position &last);
 
 	const char *DeleteChars(Sci::Position position, Sci::Position deleteLength, bool &startSequence);
 
@@ -151,6 +218,13 @@ public:
 	void SetReadOnly(bool set) noexcept;
 	bool IsLarge() const noexcept;
 	bool HasStyles() const noexcept;
+	bool HasStyleRuns() const noexcept;
+	bool IsPieceTable() const noexcept;
+	/// An empty piece table buffer with no undo history can refer to text instead of copying
+	/// it when it is next inserted. Takes ownership of text when returning true.
+	bool SetMappedText(Scintilla::IMappedText *text);
+	/// Copy the mapped text, if any, so it is released. Returns false if there was none.
+	bool DetachMappedText();
 
 	/// The save point is a marker in the undo stack where the container has stated that
 	/// the buffer was saved. Undo and redo can move over the save point.
@@ -183,6 +257,9 @@ public:
 	void PerformRedoStep();
 
 	int UndoActions() const noexcept;
+	void SetUndoMemoryLimit(size_t limit) noexcept;
+	size_t UndoMemoryLimit() const noexcept;
+	size_t UndoMemoryUsage() const noexcept;
 	void SetUndoSavePoint(int action) noexcept;
 	int UndoSavePoint() const noexcept;
 	void SetUndoDetach(int action) noexcept;
@@ -202,6 +279,7 @@ public:
 	[[nodiscard]] Sci::Position EditionEndRun(Sci::Position pos) const noexcept;
 	[[nodiscard]] unsigned int EditionDeletesAt(Sci::Position pos) const noexcept;
 	[[nodiscard]] Sci::Position EditionNextDelete(Sci::Position pos) const noexcept;
+	[[nodiscard]] size_t ChangeHistoryMemoryUsage() const noexcept;
 };
 
 }
@@ -92,6 +92,10 @@ void ChangeStack::SetSavePoint() noexcept {
 	}
 }
 
+size_t ChangeStack::MemoryUsage() const noexcept {
+	return steps.capacity() * sizeof(int) + changes.capacity() * sizeof(ChangeSpan);
+}
+
 void ChangeStack::Check() const noexcept {
 #ifdef _DEBUG
 	// Ensure count in steps same as insertions;
@@ -318,6 +322,20 @@ size_t ChangeLog::DeletionCount(Sci::Position start, Sci::Position length) const
 	return count;
 }
 
+size_t ChangeLog::MemoryUsage() const noexcept {
+	size_t usage = changeStack.MemoryUsage() + insertEdition.MemoryUsage() + deleteEdition.MemoryUsage();
+	const Sci::Position length = deleteEdition.Length();
+	Sci::Position position = 0;
+	while (position <= length) {
+		const EditionSetOwned &editions = deleteEdition.ValueAt(position);
+		if (editions) {
+			usage += sizeof(EditionSet) + editions->capacity() * sizeof(EditionCount);
+		}
+		position = deleteEdition.PositionNext(position);
+	}
+	return usage;
+}
+
 void ChangeLog::Check() const noexcept {
 	assert(insertEdition.Length() == deleteEdition.Length());
 	changeStack.Check();
@@ -478,6 +496,14 @@ Sci::Position ChangeHistory::EditionNextDelete(Sci::Position pos) const noexcept
 	return next;
 }
 
+size_t ChangeHistory::MemoryUsage() const noexcept {
+	size_t usage = changeLog.MemoryUsage();
+	if (changeLogReversions) {
+		usage += changeLogReversions->MemoryUsage();
+	}
+	return usage;
+}
+
 size_t ChangeHistory::DeletionCount(Sci::Position start, Sci::Position length) const noexcept {
 	return changeLog.DeletionCount(start, length);
 }
@@ -133,6 +133,8 @@ public:
 	void SetClickNotified(bool notified) noexcept override {
 		clickNotified = notified;
 	}
+
+	size_t MemoryUsage() const noexcept override;
 };
 
 template <typename POS>
@@ -304,6 +306,16 @@ Sci::Position DecorationList<POS>::End(int indicator, Sci::Position position) no
 	return 0;
 }
 
+template <typename POS>
+size_t DecorationList<POS>::MemoryUsage() const noexcept {
+	size_t usage = decorationList.capacity() * sizeof(std::unique_ptr<Decoration<POS>>) +
+		decorationView.capacity() * sizeof(const IDecoration *);
+	for (const std::unique_ptr<Decoration<POS>> &deco : decorationList) {
+		usage += sizeof(Decoration<POS>) + deco->rs.MemoryUsage();
+	}
+	return usage;
+}
+
 }
 
 namespace Scintilla::Internal {
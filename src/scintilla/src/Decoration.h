@@ -48,6 +48,8 @@ public:
 
 	virtual bool ClickNotified() const noexcept = 0;
 	virtual void SetClickNotified(bool notified) noexcept = 0;
+
+	virtual size_t MemoryUsage() const noexcept = 0;
 };
 
 std::unique_ptr<IDecoration> DecorationCreate(bool largeDocument, int indicator);
@@ -24,6 +24,10 @@
 #include <algorithm>
 #include <memory>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <thread>
 
 #ifndef NO_CXX11_REGEX
 #include <regex>
@@ -41,12 +45,15 @@
 #include "SplitVector.h"
 #include "Partitioning.h"
 #include "RunStyles.h"
+#include "PieceTable.h"
 #include "CellBuffer.h"
 #include "PerLine.h"
 #include "CharClassify.h"
 #include "Decoration.h"
 #include "CaseFolder.h"
 #include "Document.h"
+#include "BackgroundStyler.h"
+#include "BraceIndex.h"
 #include "RESearch.h"
 #include "UniConversion.h"
 #include "ElapsedPeriod.h"
@@ -64,12 +71,53 @@ LexInterface::LexInterface(Document *pdoc_) noexcept : pdoc(pdoc_), performingSt
 
 LexInterface::~LexInterface() noexcept = default;
 
+namespace {
+
+// Styles are copied into a background snapshot from this far before the start of styling as
+// lexers may back up to a safe point.
+constexpr Sci::Position backgroundLookBehind = 0x100000;
+// Text after the end of styling is included so lexers that look ahead see the same text as
+// they would in the document.
+constexpr Sci::Position backgroundLookAhead = 0x10000;
+// Ranges are only split for concurrent lexing into pieces at least this long.
+constexpr Sci::Position concurrentPieceMinimum = 0x100000;
+
+void MergeChunk(Document *pdoc, const StyledChunk &chunk) {
+	if (!chunk.styles.empty()) {
+		pdoc->StartStyling(chunk.position);
+		pdoc->SetStyles(chunk.styles.length(), chunk.styles.data());
+	}
+	const Sci::Line lines = pdoc->LinesTotal();
+	for (size_t i = 0; i < chunk.levels.size(); i++) {
+		const Sci::Line line = chunk.line + i;
+		if (line < lines) {
+			pdoc->SetLineState(line, chunk.lineStates[i]);
+			pdoc->SetLevel(line, chunk.levels[i]);
+		}
+	}
+	for (const StyledChunk::Fill &fill : chunk.fills) {
+		pdoc->DecorationSetCurrentIndicator(fill.indicator);
+		pdoc->DecorationFillRange(fill.position, fill.value, fill.fillLength);
+	}
+	if (chunk.lexerStateStart >= 0) {
+		pdoc->ChangeLexerState(chunk.lexerStateStart, chunk.lexerStateEnd);
+	}
+	if (chunk.errorStatus) {
+		pdoc->SetErrorStatus(chunk.errorStatus);
+	}
+}
+
+}
+
 void LexInterface::SetInstance(ILexer5 *instance_) noexcept {
+	background.reset();
 	instance.reset(instance_);
 }
 
 void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 	if (pdoc && instance && !performingStyle) {
+		StopBackground();
+
 		// Protect against reentrance, which may occur, for example, when
 		// fold points are discovered while performing styling and the folding
 		// code looks for child lines which may trigger styling.
@@ -88,7 +136,9 @@ void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 			styleStart = pdoc->StyleAt(start - 1);
 
 		if (len > 0) {
-			instance->Lex(start, len, styleStart, pdoc);
+			if (!LexConcurrently(start, end, styleStart)) {
+				instance->Lex(start, len, styleStart, pdoc);
+			}
 			instance->Fold(start, len, styleStart, pdoc);
 		}
 
@@ -107,6 +157,118 @@ bool LexInterface::UseContainerLexing() const noexcept {
 	return !instance;
 }
 
+bool LexInterface::StyleInBackground(Sci::Position start, Sci::Position end) {
+	if (!pdoc || !instance || performingStyle || background) {
+		return false;
+	}
+	try {
+		const Sci::Position lengthDoc = pdoc->Length();
+		end = std::min(end, lengthDoc);
+		const Sci::Position stylesStart = pdoc->LineStartPosition(std::max<Sci::Position>(start - backgroundLookBehind, 0));
+		const Sci::Line lineLast = pdoc->SciLineFromPosition(std::min(end + backgroundLookAhead, lengthDoc));
+		const Sci::Position length = std::min(pdoc->LineStart(lineLast + 1), lengthDoc);
+		std::shared_ptr<const SnapshotText> source = std::make_shared<SnapshotText>(*pdoc, length);
+		background = std::make_unique<BackgroundStyler>(
+			std::make_unique<StyleSnapshot>(*pdoc, source, stylesStart, length, true), start, end);
+		background->Start(instance.get());
+		return true;
+	} catch (...) {
+		// Failed to copy the document or to start a thread so style on the main thread
+		background.reset();
+		return false;
+	}
+}
+
+bool LexInterface::LexConcurrently(Sci::Position start, Sci::Position end, int styleStart) {
+	if ((end - start < concurrentPieceMinimum * 2) || (instance->Version() < lvRelease6)) {
+		return false;
+	}
+	const int checkpoint = static_cast<ILexer6 *>(instance.get())->Checkpoint();
+	if ((checkpoint == lcNone) || (pdoc->dbcsCodePage && (pdoc->dbcsCodePage != CpUtf8))) {
+		return false;
+	}
+	const size_t pieces = std::min<size_t>(std::thread::hardware_concurrency(), (end - start) / concurrentPieceMinimum);
+	if (pieces < 2) {
+		return false;
+	}
+	try {
+		ConcurrentStyler styler(*pdoc, start, end, pieces);
+		styler.Lex(instance.get(), styleStart);
+		for (size_t piece = 0; piece < styler.Pieces(); piece++) {
+			const Sci::Position pieceStart = styler.PieceStart(piece);
+			const Sci::Position pieceEnd = styler.PieceEnd(piece);
+			Sci::Position from = pieceStart;
+			if ((piece > 0) && (checkpoint == lcLineState)) {
+				// The piece was lexed from the default state so lex lines from the real state
+				// until reaching the same state as the piece, after which its results are right
+				const StyleSnapshot &snapshot = styler.Snapshot(piece);
+				Sci::Line line = pdoc->SciLineFromPosition(from);
+				while ((from < pieceEnd) &&
+					((pdoc->StyleAt(from - 1) != snapshot.StyleAt(from - 1)) ||
+					(pdoc->GetLineState(line - 1) != snapshot.GetLineState(line - 1)))) {
+					const Sci::Position lineEnd = std::min(pdoc->LineStart(line + 1), pieceEnd);
+					instance->Lex(from, lineEnd - from, pdoc->StyleAt(from - 1), pdoc);
+					from = lineEnd;
+					line++;
+				}
+			}
+			if (from < pieceEnd) {
+				// Keep any restyling the lexer did before the piece when it backed up to a safe start
+				MergeChunk(pdoc, styler.Results(piece, (from > pieceStart) ? from : 0));
+			}
+		}
+		return true;
+	} catch (...) {
+		// Failed to copy the document or to start a thread so lex the whole range
+		return false;
+	}
+}
+
+bool LexInterface::BackgroundStyling() {
+	if (background && background->Cancelled() && !mergingBackground && !background->Running()) {
+		background.reset();
+	}
+	return background != nullptr;
+}
+
+bool LexInterface::MergeBackground() {
+	if (!background || mergingBackground) {
+		return false;
+	}
+	mergingBackground = true;
+	// Check before taking chunks so no chunk published after the worker finishes is missed
+	const bool running = background->Running();
+	std::vector<StyledChunk> chunks = background->TakeChunks();
+	for (const StyledChunk &chunk : chunks) {
+		if (!chunk.styles.empty() && (chunk.position > pdoc->GetEndStyled())) {
+			// Styling was invalidated before this chunk so it can not be merged
+			background->Cancel();
+			break;
+		}
+		MergeChunk(pdoc, chunk);
+	}
+	if (!running) {
+		background.reset();
+	}
+	mergingBackground = false;
+	return running;
+}
+
+void LexInterface::StopBackground() {
+	if (background) {
+		// Finish the current chunk and keep everything published so far
+		background->Stop();
+		background->Wait();
+		MergeBackground();
+	}
+}
+
+void LexInterface::CancelBackground(Sci::Position position) noexcept {
+	if (background && (position < background->Limit())) {
+		background->Cancel();
+	}
+}
+
 ActionDuration::ActionDuration(double duration_, double minDuration_, double maxDuration_) noexcept :
 	duration(duration_), minDuration(minDuration_), maxDuration(maxDuration_) {
 }
@@ -150,7 +312,8 @@ CharacterExtracted::CharacterExtracted(const unsigned char *charBytes, size_t wi
 
 Document::Document(DocumentOption options) :
 	refCount(0),
-	cb(!FlagSet(options, DocumentOption::StylesNone), FlagSet(options, DocumentOption::TextLarge)),
+	cb(!FlagSet(options, DocumentOption::StylesNone), FlagSet(options, DocumentOption::TextLarge),
+		FlagSet(options, DocumentOption::PieceTable), FlagSet(options, DocumentOption::StylesRuns)),
 	endStyled(0),
 	styleClock(0),
 	enteredModification(0),
@@ -233,6 +396,15 @@ void Document::RemoveLine(Sci::Line line) {
 	}
 }
 
+size_t Document::MemoryUsage() const noexcept {
+	size_t usage = 0;
+	for (const std::unique_ptr<PerLine> &pl : perLineData) {
+		if (pl)
+			usage += pl->MemoryUsage();
+	}
+	return usage;
+}
+
 LineMarkers *Document::Markers() const noexcept {
 	return static_cast<LineMarkers *>(perLineData[ldMarkers].get());
 }
@@ -269,6 +441,9 @@ bool Document::SetDBCSCodePage(int dbcsCodePage_) {
 		SetCaseFolder(nullptr);
 		cb.SetLineEndTypes(lineEndBitSet & LineEndTypesSupported());
 		cb.SetUTF8Substance(CpUtf8 == dbcsCodePage);
+		backgroundIndexer.reset();
+		braceIndexes.clear();
+		tagIndex.reset();
 		ModifiedAt(0);	// Need to restyle whole document
 		return true;
 	}
@@ -358,6 +533,39 @@ int Document::UndoActions() const noexcept {
 	return cb.UndoActions();
 }
 
+void Document::SetUndoMemoryLimit(Sci::Position limit) noexcept {
+	cb.SetUndoMemoryLimit(std::max<Sci::Position>(limit, 0));
+}
+
+Sci::Position Document::UndoMemoryLimit() const noexcept {
+	return cb.UndoMemoryLimit();
+}
+
+Sci::Position Document::UndoMemoryUsage() const noexcept {
+	return cb.UndoMemoryUsage();
+}
+
+Sci::Position Document::MemoryUsage(MemoryCategory category) const noexcept {
+	switch (category) {
+	case MemoryCategory::Text:
+		return cb.TextMemoryUsage();
+	case MemoryCategory::Styles:
+		return cb.StyleMemoryUsage();
+	case MemoryCategory::LineIndex:
+		return cb.LineMemoryUsage();
+	case MemoryCategory::LineData:
+		return MemoryUsage();
+	case MemoryCategory::Undo:
+		return cb.UndoMemoryUsage();
+	case MemoryCategory::ChangeHistory:
+		return cb.ChangeHistoryMemoryUsage();
+	case MemoryCategory::Decorations:
+		return decorations->MemoryUsage();
+	default:
+		return 0;
+	}
+}
+
 void Document::SetUndoSavePoint(int action) noexcept {
 	cb.SetUndoSavePoint(action);
 }
@@ -629,6 +837,13 @@ Sci::Line Document::GetLastChild(Sci::Line lineParent, std::optional<FoldLevel>
 	const Sci::Line maxLine = LinesTotal() - 1;
 	const Sci::Line lookLastLine = (lastLine != -1) ? std::min(maxLine, lastLine) : maxLine;
 	Sci::Line lineMaxSubord = lineParent;
+	// Styled lines before lookLastLine have their final levels so the subordinate ones can be skipped
+	// by the level index. The loop below checks the rest, styling as it goes.
+	const Sci::Line lineStyled = std::min(SciLineFromPosition(GetEndStyled()), lookLastLine);
+	if (lineMaxSubord + 1 < lineStyled) {
+		const Sci::Line lineNext = Levels()->NextLevelAtMost(lineMaxSubord + 1, lineStyled, LevelNumber(levelStart));
+		lineMaxSubord = (lineNext >= 0) ? lineNext - 1 : lineStyled - 1;
+	}
 	while (lineMaxSubord < maxLine) {
 		EnsureStyledTo(LineStart(lineMaxSubord + 2));
 		if (!IsSubordinate(levelStart, GetFoldLevel(lineMaxSubord + 1)))
@@ -1412,6 +1627,8 @@ EncodingFamily Document::CodePageFamily() const noexcept {
 void Document::ModifiedAt(Sci::Position pos) noexcept {
 	if (endStyled > pos)
 		endStyled = pos;
+	if (pli)
+		pli->CancelBackground(pos);
 }
 
 void Document::CheckReadOnly() {
@@ -1555,6 +1772,22 @@ int SCI_METHOD Document::AddData(const char *data, Sci_Position length) {
 	return static_cast<int>(Status::Ok);
 }
 
+Sci::Position Document::SetMappedText(IMappedText *text) {
+	// A piece table refers to the text where it is while other documents copy it
+	const char *data = text->Data();
+	const Sci::Position length = text->Length();
+	if (cb.SetMappedText(text)) {
+		return InsertString(0, data, length);
+	}
+	const Sci::Position inserted = InsertString(Length(), data, length);
+	text->Release();
+	return inserted;
+}
+
+bool Document::DetachMappedText() {
+	return cb.DetachMappedText();
+}
+
 IDocumentEditable *Document::AsDocumentEditable() noexcept {
 	return static_cast<IDocumentEditable *>(this);
 }
@@ -1802,6 +2035,9 @@ Sci::Position Document::GetColumn(Sci::Position pos) const {
 Sci::Position Document::CountCharacters(Sci::Position startPos, Sci::Position endPos) const noexcept {
 	startPos = MovePositionOutsideChar(startPos, 1, false);
 	endPos = MovePositionOutsideChar(endPos, -1, false);
+	if (CpUtf8 == dbcsCodePage) {
+		return cb.CountCharacterWidths(startPos, endPos).WidthUTF32();
+	}
 	Sci::Position count = 0;
 	Sci::Position i = startPos;
 	while (i < endPos) {
@@ -1814,6 +2050,9 @@ Sci::Position Document::CountCharacters(Sci::Position startPos, Sci::Position en
 Sci::Position Document::CountUTF16(Sci::Position startPos, Sci::Position endPos) const noexcept {
 	startPos = MovePositionOutsideChar(startPos, 1, false);
 	endPos = MovePositionOutsideChar(endPos, -1, false);
+	if (CpUtf8 == dbcsCodePage) {
+		return cb.CountCharacterWidths(startPos, endPos).WidthUTF16();
+	}
 	Sci::Position count = 0;
 	Sci::Position i = startPos;
 	while (i < endPos) {
@@ -1942,7 +2181,9 @@ std::string_view Document::EOLString() const noexcept {
 
 DocumentOption Document::Options() const noexcept {
 	return (IsLarge() ? DocumentOption::TextLarge : DocumentOption::Default) |
-		(cb.HasStyles() ? DocumentOption::Default : DocumentOption::StylesNone);
+		(cb.HasStyles() ? DocumentOption::Default : DocumentOption::StylesNone) |
+		(cb.IsPieceTable() ? DocumentOption::PieceTable : DocumentOption::Default) |
+		(cb.HasStyleRuns() ? DocumentOption::StylesRuns : DocumentOption::Default);
 }
 
 bool Document::IsWhiteLine(Sci::Line line) const {
@@ -2283,231 +2524,245 @@ bool SplitMatch(const SplitView &view, size_t start, std::string_view text) noex
 	return true;
 }
 
+ptrdiff_t SplitFindChar(const PieceView &view, size_t start, size_t length, int ch) noexcept {
+	return view.FindChar(start, length, ch);
 }
 
-/**
- * Find text in document, supporting both forward and backward
- * searches (just pass minPos > maxPos to do a backward search)
- * Has not been tested with backwards DBCS searches yet.
- */
-Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, const char *search,
-                        FindOption flags, Sci::Position *length) {
-	if (*length <= 0)
-		return minPos;
-	const bool caseSensitive = FlagSet(flags, FindOption::MatchCase);
-	const bool word = FlagSet(flags, FindOption::WholeWord);
-	const bool wordStart = FlagSet(flags, FindOption::WordStart);
-	const bool regExp = FlagSet(flags, FindOption::RegExp);
-	if (regExp) {
-		if (!regex)
-			regex = std::unique_ptr<RegexSearchBase>(CreateRegexSearch(&charClass));
-		return regex->FindText(this, minPos, maxPos, search, caseSensitive, word, wordStart, flags, length);
-	} else {
+bool SplitMatch(const PieceView &view, size_t start, std::string_view text) noexcept {
+	return view.Match(start, text);
+}
 
-		const bool forward = minPos <= maxPos;
-		const int increment = forward ? 1 : -1;
-
-		// Range endpoints should not be inside DBCS characters, but just in case, move them.
-		const Sci::Position startPos = MovePositionOutsideChar(minPos, increment, false);
-		const Sci::Position endPos = MovePositionOutsideChar(maxPos, increment, false);
-
-		// Compute actual search ranges needed
-		const Sci::Position lengthFind = *length;
-
-		//Platform::DebugPrintf("Find %d %d %s %d\n", startPos, endPos, ft->lpstrText, lengthFind);
-		const Sci::Position limitPos = std::max(startPos, endPos);
-		Sci::Position pos = startPos;
-		if (!forward) {
-			// Back all of a character
-			pos = NextPosition(pos, increment);
-		}
-		const SplitView cbView = cb.AllView();
-		if (caseSensitive) {
-			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
-			const unsigned char charStartSearch =  search[0];
-			if (forward && ((0 == dbcsCodePage) || (CpUtf8 == dbcsCodePage && !UTF8IsTrailByte(charStartSearch)))) {
-				// This is a fast case where there is no need to test byte values to iterate
-				// so becomes the equivalent of a memchr+memcmp loop.
-				// UTF-8 search will not be self-synchronizing when starts with trail byte
-				const std::string_view suffix(search + 1, lengthFind - 1);
-				while (pos < endSearch) {
-					pos = SplitFindChar(cbView, pos, limitPos - pos, charStartSearch);
-					if (pos < 0) {
-						break;
+}
+
+template <typename View>
+Sci::Position Document::FindInView(const View &cbView, Sci::Position minPos, Sci::Position maxPos, const char *search,
+	bool caseSensitive, bool word, bool wordStart, Sci::Position *length) {
+	const bool forward = minPos <= maxPos;
+	const int increment = forward ? 1 : -1;
+
+	// Range endpoints should not be inside DBCS characters, but just in case, move them.
+	const Sci::Position startPos = MovePositionOutsideChar(minPos, increment, false);
+	const Sci::Position endPos = MovePositionOutsideChar(maxPos, increment, false);
+
+	// Compute actual search ranges needed
+	const Sci::Position lengthFind = *length;
+
+	//Platform::DebugPrintf("Find %d %d %s %d\n", startPos, endPos, ft->lpstrText, lengthFind);
+	const Sci::Position limitPos = std::max(startPos, endPos);
+	Sci::Position pos = startPos;
+	if (!forward) {
+		// Back all of a character
+		pos = NextPosition(pos, increment);
+	}
+	if (caseSensitive) {
+		const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
+		const unsigned char charStartSearch =  search[0];
+		if (forward && ((0 == dbcsCodePage) || (CpUtf8 == dbcsCodePage && !UTF8IsTrailByte(charStartSearch)))) {
+			// This is a fast case where there is no need to test byte values to iterate
+			// so becomes the equivalent of a memchr+memcmp loop.
+			// UTF-8 search will not be self-synchronizing when starts with trail byte
+			const std::string_view suffix(search + 1, lengthFind - 1);
+			while (pos < endSearch) {
+				pos = SplitFindChar(cbView, pos, limitPos - pos, charStartSearch);
+				if (pos < 0) {
+					break;
+				}
+				if (SplitMatch(cbView, pos + 1, suffix) && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+					return pos;
+				}
+				pos++;
+			}
+		} else {
+			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
+				const unsigned char leadByte = cbView.CharAt(pos);
+				if (leadByte == charStartSearch) {
+					bool found = (pos + lengthFind) <= limitPos;
+					// SplitMatch could be called here but it is slower with g++ -O2
+					for (int indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
+						found = cbView.CharAt(pos + indexSearch) == search[indexSearch];
 					}
-					if (SplitMatch(cbView, pos + 1, suffix) && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+					if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
 						return pos;
 					}
-					pos++;
 				}
-			} else {
-				while (forward ? (pos < endSearch) : (pos >= endSearch)) {
-					const unsigned char leadByte = cbView.CharAt(pos);
-					if (leadByte == charStartSearch) {
-						bool found = (pos + lengthFind) <= limitPos;
-						// SplitMatch could be called here but it is slower with g++ -O2
-						for (int indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
-							found = cbView.CharAt(pos + indexSearch) == search[indexSearch];
-						}
-						if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
-							return pos;
+				if (forward && UTF8IsAscii(leadByte)) {
+					pos++;
+				} else {
+					if (dbcsCodePage) {
+						if (!NextCharacter(pos, increment)) {
+							break;
 						}
-					}
-					if (forward && UTF8IsAscii(leadByte)) {
-						pos++;
 					} else {
-						if (dbcsCodePage) {
-							if (!NextCharacter(pos, increment)) {
-								break;
-							}
-						} else {
-							pos += increment;
-						}
+						pos += increment;
 					}
 				}
 			}
-		} else if (CpUtf8 == dbcsCodePage) {
-			constexpr size_t maxFoldingExpansion = 4;
-			std::vector<char> searchThing((lengthFind+1) * UTF8MaxBytes * maxFoldingExpansion + 1);
-			const size_t lenSearch =
-				pcf->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
-			while (forward ? (pos < endPos) : (pos >= endPos)) {
-				int widthFirstCharacter = 1;
-				Sci::Position posIndexDocument = pos;
-				size_t indexSearch = 0;
-				bool characterMatches = true;
-				while (indexSearch < lenSearch) {
-					const unsigned char leadByte = cbView.CharAt(posIndexDocument);
-					int widthChar = 1;
-					size_t lenFlat = 1;
-					if (UTF8IsAscii(leadByte)) {
-						if ((posIndexDocument + 1) > limitPos) {
-							break;
-						}
-						characterMatches = searchThing[indexSearch] == MakeLowerCase(leadByte);
-					} else {
-						char bytes[UTF8MaxBytes]{ static_cast<char>(leadByte) };
-						const int widthCharBytes = UTF8BytesOfLead[leadByte];
-						for (int b = 1; b < widthCharBytes; b++) {
-							bytes[b] = cbView.CharAt(posIndexDocument + b);
-						}
-						widthChar = UTF8Classify(bytes, widthCharBytes) & UTF8MaskWidth;
-						if (!indexSearch) {	// First character
-							widthFirstCharacter = widthChar;
-						}
-						if ((posIndexDocument + widthChar) > limitPos) {
-							break;
-						}
-						char folded[UTF8MaxBytes * maxFoldingExpansion + 1];
-						lenFlat = pcf->Fold(folded, sizeof(folded), bytes, widthChar);
-						// memcmp may examine lenFlat bytes in both arguments so assert it doesn't read past end of searchThing
-						assert((indexSearch + lenFlat) <= searchThing.size());
-						// Does folded match the buffer
-						characterMatches = 0 == memcmp(folded, searchThing.data() + indexSearch, lenFlat);
-					}
-					if (!characterMatches) {
+		}
+	} else if (CpUtf8 == dbcsCodePage) {
+		constexpr size_t maxFoldingExpansion = 4;
+		std::vector<char> searchThing((lengthFind+1) * UTF8MaxBytes * maxFoldingExpansion + 1);
+		const size_t lenSearch =
+			pcf->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
+		while (forward ? (pos < endPos) : (pos >= endPos)) {
+			int widthFirstCharacter = 1;
+			Sci::Position posIndexDocument = pos;
+			size_t indexSearch = 0;
+			bool characterMatches = true;
+			while (indexSearch < lenSearch) {
+				const unsigned char leadByte = cbView.CharAt(posIndexDocument);
+				int widthChar = 1;
+				size_t lenFlat = 1;
+				if (UTF8IsAscii(leadByte)) {
+					if ((posIndexDocument + 1) > limitPos) {
 						break;
 					}
-					posIndexDocument += widthChar;
-					indexSearch += lenFlat;
-				}
-				if (characterMatches && (indexSearch == lenSearch)) {
-					if (MatchesWordOptions(word, wordStart, pos, posIndexDocument - pos)) {
-						*length = posIndexDocument - pos;
-						return pos;
-					}
-				}
-				if (forward) {
-					pos += widthFirstCharacter;
+					characterMatches = searchThing[indexSearch] == MakeLowerCase(leadByte);
 				} else {
-					if (!NextCharacter(pos, increment)) {
-						break;
+					char bytes[UTF8MaxBytes]{ static_cast<char>(leadByte) };
+					const int widthCharBytes = UTF8BytesOfLead[leadByte];
+					for (int b = 1; b < widthCharBytes; b++) {
+						bytes[b] = cbView.CharAt(posIndexDocument + b);
 					}
-				}
-			}
-		} else if (dbcsCodePage) {
-			constexpr size_t maxBytesCharacter = 2;
-			constexpr size_t maxFoldingExpansion = 4;
-			std::vector<char> searchThing((lengthFind+1) * maxBytesCharacter * maxFoldingExpansion + 1);
-			const size_t lenSearch = pcf->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
-			while (forward ? (pos < endPos) : (pos >= endPos)) {
-				int widthFirstCharacter = 0;
-				Sci::Position indexDocument = 0;
-				size_t indexSearch = 0;
-				bool characterMatches = true;
-				while (((pos + indexDocument) < limitPos) &&
-					(indexSearch < lenSearch)) {
-					const unsigned char leadByte = cbView.CharAt(pos + indexDocument);
-					const int widthChar = (!UTF8IsAscii(leadByte) && IsDBCSLeadByteNoExcept(leadByte)) ? 2 : 1;
-					if (!widthFirstCharacter) {
+					widthChar = UTF8Classify(bytes, widthCharBytes) & UTF8MaskWidth;
+					if (!indexSearch) {	// First character
 						widthFirstCharacter = widthChar;
 					}
-					if ((pos + indexDocument + widthChar) > limitPos) {
+					if ((posIndexDocument + widthChar) > limitPos) {
 						break;
 					}
-					size_t lenFlat = 1;
-					if (widthChar == 1) {
-						characterMatches = searchThing[indexSearch] == MakeLowerCase(leadByte);
-					} else {
-						const char bytes[maxBytesCharacter + 1] {
-							static_cast<char>(leadByte),
-							cbView.CharAt(pos + indexDocument + 1)
-						};
-						char folded[maxBytesCharacter * maxFoldingExpansion + 1];
-						lenFlat = pcf->Fold(folded, sizeof(folded), bytes, widthChar);
-						// memcmp may examine lenFlat bytes in both arguments so assert it doesn't read past end of searchThing
-						assert((indexSearch + lenFlat) <= searchThing.size());
-						// Does folded match the buffer
-						characterMatches = 0 == memcmp(folded, searchThing.data() + indexSearch, lenFlat);
-					}
-					if (!characterMatches) {
-						break;
-					}
-					indexDocument += widthChar;
-					indexSearch += lenFlat;
+					char folded[UTF8MaxBytes * maxFoldingExpansion + 1];
+					lenFlat = pcf->Fold(folded, sizeof(folded), bytes, widthChar);
+					// memcmp may examine lenFlat bytes in both arguments so assert it doesn't read past end of searchThing
+					assert((indexSearch + lenFlat) <= searchThing.size());
+					// Does folded match the buffer
+					characterMatches = 0 == memcmp(folded, searchThing.data() + indexSearch, lenFlat);
 				}
-				if (characterMatches && (indexSearch == lenSearch)) {
-					if (MatchesWordOptions(word, wordStart, pos, indexDocument)) {
-						*length = indexDocument;
-						return pos;
-					}
+				if (!characterMatches) {
+					break;
 				}
-				if (forward) {
-					pos += widthFirstCharacter;
-				} else {
-					if (!NextCharacter(pos, increment)) {
-						break;
-					}
+				posIndexDocument += widthChar;
+				indexSearch += lenFlat;
+			}
+			if (characterMatches && (indexSearch == lenSearch)) {
+				if (MatchesWordOptions(word, wordStart, pos, posIndexDocument - pos)) {
+					*length = posIndexDocument - pos;
+					return pos;
 				}
 			}
-		} else {
-			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
-			std::vector<char> searchThing(lengthFind + 1);
-			pcf->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
-			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
-				bool found = (pos + lengthFind) <= limitPos;
-				for (int indexSearch = 0; (indexSearch < lengthFind) && found; indexSearch++) {
-					const char ch = cbView.CharAt(pos + indexSearch);
-					const char chTest = searchThing[indexSearch];
-					if (UTF8IsAscii(ch)) {
-						found = chTest == MakeLowerCase(ch);
-					} else {
-						char folded[2];
-						pcf->Fold(folded, sizeof(folded), &ch, 1);
-						found = folded[0] == chTest;
-					}
+			if (forward) {
+				pos += widthFirstCharacter;
+			} else {
+				if (!NextCharacter(pos, increment)) {
+					break;
+				}
+			}
+		}
+	} else if (dbcsCodePage) {
+		constexpr size_t maxBytesCharacter = 2;
+		constexpr size_t maxFoldingExpansion = 4;
+		std::vector<char> searchThing((lengthFind+1) * maxBytesCharacter * maxFoldingExpansion + 1);
+		const size_t lenSearch = pcf->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
+		while (forward ? (pos < endPos) : (pos >= endPos)) {
+			int widthFirstCharacter = 0;
+			Sci::Position indexDocument = 0;
+			size_t indexSearch = 0;
+			bool characterMatches = true;
+			while (((pos + indexDocument) < limitPos) &&
+				(indexSearch < lenSearch)) {
+				const unsigned char leadByte = cbView.CharAt(pos + indexDocument);
+				const int widthChar = (!UTF8IsAscii(leadByte) && IsDBCSLeadByteNoExcept(leadByte)) ? 2 : 1;
+				if (!widthFirstCharacter) {
+					widthFirstCharacter = widthChar;
+				}
+				if ((pos + indexDocument + widthChar) > limitPos) {
+					break;
+				}
+				size_t lenFlat = 1;
+				if (widthChar == 1) {
+					characterMatches = searchThing[indexSearch] == MakeLowerCase(leadByte);
+				} else {
+					const char bytes[maxBytesCharacter + 1] {
+						static_cast<char>(leadByte),
+						cbView.CharAt(pos + indexDocument + 1)
+					};
+					char folded[maxBytesCharacter * maxFoldingExpansion + 1];
+					lenFlat = pcf->Fold(folded, sizeof(folded), bytes, widthChar);
+					// memcmp may examine lenFlat bytes in both arguments so assert it doesn't read past end of searchThing
+					assert((indexSearch + lenFlat) <= searchThing.size());
+					// Does folded match the buffer
+					characterMatches = 0 == memcmp(folded, searchThing.data() + indexSearch, lenFlat);
+				}
+				if (!characterMatches) {
+					break;
 				}
-				if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+				indexDocument += widthChar;
+				indexSearch += lenFlat;
+			}
+			if (characterMatches && (indexSearch == lenSearch)) {
+				if (MatchesWordOptions(word, wordStart, pos, indexDocument)) {
+					*length = indexDocument;
 					return pos;
 				}
-				pos += increment;
+			}
+			if (forward) {
+				pos += widthFirstCharacter;
+			} else {
+				if (!NextCharacter(pos, increment)) {
+					break;
+				}
 			}
 		}
+	} else {
+		const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
+		std::vector<char> searchThing(lengthFind + 1);
+		pcf->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
+		while (forward ? (pos < endSearch) : (pos >= endSearch)) {
+			bool found = (pos + lengthFind) <= limitPos;
+			for (int indexSearch = 0; (indexSearch < lengthFind) && found; indexSearch++) {
+				const char ch = cbView.CharAt(pos + indexSearch);
+				const char chTest = searchThing[indexSearch];
+				if (UTF8IsAscii(ch)) {
+					found = chTest == MakeLowerCase(ch);
+				} else {
+					char folded[2];
+					pcf->Fold(folded, sizeof(folded), &ch, 1);
+					found = folded[0] == chTest;
+				}
+			}
+			if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+				return pos;
+			}
+			pos += increment;
+		}
 	}
 	//Platform::DebugPrintf("Not found\n");
 	return -1;
 }
 
+/**
+ * Find text in document, supporting both forward and backward
+ * searches (just pass minPos > maxPos to do a backward search)
+ * Has not been tested with backwards DBCS searches yet.
+ */
+Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, const char *search,
+                        FindOption flags, Sci::Position *length) {
+	if (*length <= 0)
+		return minPos;
+	const bool caseSensitive = FlagSet(flags, FindOption::MatchCase);
+	const bool word = FlagSet(flags, FindOption::WholeWord);
+	const bool wordStart = FlagSet(flags, FindOption::WordStart);
+	const bool regExp = FlagSet(flags, FindOption::RegExp);
+	if (regExp) {
+		if (!regex)
+			regex = std::unique_ptr<RegexSearchBase>(CreateRegexSearch(&charClass));
+		return regex->FindText(this, minPos, maxPos, search, caseSensitive, word, wordStart, flags, length);
+	}
+	if (const PieceTable *pieces = cb.Pieces()) {
+		return FindInView(PieceView(*pieces), minPos, maxPos, search, caseSensitive, word, wordStart, length);
+	}
+	return FindInView(cb.AllView(), minPos, maxPos, search, caseSensitive, word, wordStart, length);
+}
+
 const char *Document::SubstituteByPosition(const char *text, Sci::Position *length) {
 	if (regex) {
 		return regex->SubstituteByPosition(this, text, length);
@@ -2580,19 +2835,11 @@ bool SCI_METHOD Document::SetStyles(Sci_Position length, const char *styles) {
 		return false;
 	}
 	enteredStyling++;
-	bool didChange = false;
 	Sci::Position startMod = 0;
 	Sci::Position endMod = 0;
-	for (int iPos = 0; iPos < length; iPos++, endStyled++) {
-		PLATFORM_ASSERT(endStyled < Length());
-		if (cb.SetStyleAt(endStyled, styles[iPos])) {
-			if (!didChange) {
-				startMod = endStyled;
-			}
-			didChange = true;
-			endMod = endStyled;
-		}
-	}
+	PLATFORM_ASSERT(endStyled + length <= Length());
+	const bool didChange = cb.SetStyles(endStyled, length, styles, startMod, endMod);
+	endStyled += length;
 	if (didChange) {
 		const DocModification mh(ModificationFlags::ChangeStyle | ModificationFlags::User,
 			                startMod, endMod - startMod + 1);
@@ -2606,8 +2853,12 @@ void Document::EnsureStyledTo(Sci::Position pos) {
 	if ((enteredStyling == 0) && (pos > GetEndStyled())) {
 		IncrementStyleClock();
 		if (pli && !pli->UseContainerLexing()) {
-			const Sci::Position endStyledTo = LineStartPosition(GetEndStyled());
-			pli->Colourise(endStyledTo, pos);
+			// Background results may already cover some or all of the range
+			pli->StopBackground();
+			if (pos > GetEndStyled()) {
+				const Sci::Position endStyledTo = LineStartPosition(GetEndStyled());
+				pli->Colourise(endStyledTo, pos);
+			}
 		} else {
 			// Ask the watchers to style, and stop as soon as one responds.
 			for (std::vector<WatcherWithUserData>::iterator it = watchers.begin();
@@ -2625,6 +2876,32 @@ void Document::StyleToAdjustingLineDuration(Sci::Position pos) {
 	durationStyleOneByte.AddSample(pos - stylingStart, epStyling.Duration());
 }
 
+bool Document::StyleInBackground(Sci::Position pos) {
+	if (!pli || pli->UseContainerLexing() || (enteredStyling != 0) || (pos <= GetEndStyled())) {
+		return false;
+	}
+	if (pli->BackgroundStyling()) {
+		return true;
+	}
+	if (dbcsCodePage && (dbcsCodePage != CpUtf8)) {
+		// Snapshots do not handle DBCS
+		return false;
+	}
+	const Sci::Position start = LineStartPosition(GetEndStyled());
+	// Ranges that can be styled quickly are not worth a thread
+	if (pos - start <= static_cast<Sci::Position>(durationStyleOneByte.ActionsInAllowedTime(0.02))) {
+		return false;
+	}
+	return pli->StyleInBackground(start, pos);
+}
+
+bool Document::MergeBackgroundStyling() {
+	if (!pli) {
+		return false;
+	}
+	return pli->MergeBackground();
+}
+
 LexInterface *Document::GetLexInterface() const noexcept {
 	return pli.get();
 }
@@ -2864,8 +3141,24 @@ void Document::NotifyGroupCompleted() noexcept {
 void Document::NotifyModified(DocModification mh) {
 	if (FlagSet(mh.modificationType, ModificationFlags::InsertText)) {
 		decorations->InsertSpace(mh.position, mh.length);
+		for (const std::unique_ptr<BraceIndex> &braceIndex : braceIndexes) {
+			braceIndex->InsertText(mh.position, mh.length);
+		}
+		if (tagIndex) {
+			tagIndex->InsertText(mh.position, mh.length);
+		}
 	} else if (FlagSet(mh.modificationType, ModificationFlags::DeleteText)) {
 		decorations->DeleteRange(mh.position, mh.length);
+		for (const std::unique_ptr<BraceIndex> &braceIndex : braceIndexes) {
+			braceIndex->DeleteText(mh.position, mh.length);
+		}
+		if (tagIndex) {
+			tagIndex->DeleteText(mh.position, mh.length);
+		}
+	} else if (FlagSet(mh.modificationType, ModificationFlags::ChangeStyle)) {
+		for (const std::unique_ptr<BraceIndex> &braceIndex : braceIndexes) {
+			braceIndex->ChangeStyle(mh.position, mh.position + mh.length);
+		}
 	}
 	for (const WatcherWithUserData &watcher : watchers) {
 		watcher.watcher->NotifyModified(this, mh, watcher.userData);
@@ -2981,6 +3274,11 @@ Sci::Position Document::ExtendStyleRange(Sci::Position pos, int delta, bool sing
 
 namespace {
 
+// Smaller documents are scanned
+constexpr Sci::Position braceIndexMinimum = 0x40000;
+// Indexes kept for different braces and styles
+constexpr size_t braceIndexesMaximum = 4;
+
 constexpr char BraceOpposite(char ch) noexcept {
 	switch (ch) {
 	case '(':
@@ -3016,8 +3314,22 @@ Sci::Position Document::BraceMatch(Sci::Position position, Sci::Position /*maxRe
 	int direction = -1;
 	if (chBrace == '(' || chBrace == '[' || chBrace == '{' || chBrace == '<')
 		direction = 1;
+	const Sci::Position start = useStartPos ? startPos : position + direction;
+
+	if ((dbcsCodePage == 0 || dbcsCodePage == CpUtf8) && (LengthNoExcept() >= braceIndexMinimum)) {
+		try {
+			const char chOpen = static_cast<char>((direction > 0) ? chBrace : chSeek);
+			const char chClose = static_cast<char>((direction > 0) ? chSeek : chBrace);
+			return BraceIndexFor(chOpen, chClose, styBrace)->Match(*this, position, start);
+		} catch (...) {
+			// Fall back to scanning
+			backgroundIndexer.reset();
+			braceIndexes.clear();
+		}
+	}
+
 	int depth = 1;
-	position = useStartPos ? startPos : position + direction;
+	position = start;
 
 	// Avoid using MovePositionOutsideChar to check DBCS trail byte
 	unsigned char maxSafeChar = 0xff;
@@ -3040,6 +3352,113 @@ Sci::Position Document::BraceMatch(Sci::Position position, Sci::Position /*maxRe
 	return -1;
 }
 
+BraceIndex *Document::BraceIndexFor(char chOpen, char chClose, int style) {
+	const auto it = std::find_if(braceIndexes.begin(), braceIndexes.end(),
+		[chOpen, style](const std::unique_ptr<BraceIndex> &braceIndex) noexcept {
+			return braceIndex->For(chOpen, style);
+		});
+	if (it == braceIndexes.end()) {
+		if (braceIndexes.size() >= braceIndexesMaximum) {
+			// A job for the index is abandoned first so it is never applied to another
+			backgroundIndexer.reset();
+			braceIndexes.pop_back();
+		}
+		braceIndexes.insert(braceIndexes.begin(), std::make_unique<BraceIndex>(*this, chOpen, chClose, style));
+	} else {
+		std::rotate(braceIndexes.begin(), it, it + 1);
+	}
+	return braceIndexes.front().get();
+}
+
+Sci::Position Document::TagMatch(Sci::Position position, bool html) noexcept {
+	if (dbcsCodePage != 0 && dbcsCodePage != CpUtf8) {
+		return -1;
+	}
+	try {
+		if (!tagIndex || !tagIndex->For(html)) {
+			backgroundIndexer.reset();
+			tagIndex = std::make_unique<TagIndex>(*this, html);
+		}
+		return tagIndex->Match(*this, position);
+	} catch (...) {
+		backgroundIndexer.reset();
+		tagIndex.reset();
+		return -1;
+	}
+}
+
+bool Document::BraceIndexPending() const noexcept {
+	return std::any_of(braceIndexes.begin(), braceIndexes.end(),
+		[this](const std::unique_ptr<BraceIndex> &braceIndex) noexcept {
+			return braceIndex->Pending(*this);
+		}) || (tagIndex && tagIndex->Pending());
+}
+
+void Document::BuildBraceIndexes(Sci::Position length) {
+	for (const std::unique_ptr<BraceIndex> &braceIndex : braceIndexes) {
+		if (braceIndex->Pending(*this)) {
+			braceIndex->Build(*this, length);
+			return;
+		}
+	}
+	if (tagIndex && tagIndex->Pending()) {
+		tagIndex->Build(*this, length);
+	}
+}
+
+// Start summarising about length bytes of the first index with pending blocks on a worker.
+// Return true if a worker is summarising.
+bool Document::BuildBraceIndexesInBackground(Sci::Position length) {
+	if (backgroundIndexer) {
+		return true;
+	}
+	try {
+		std::unique_ptr<IndexJob> job;
+		for (const std::unique_ptr<BraceIndex> &braceIndex : braceIndexes) {
+			if (braceIndex->Pending(*this)) {
+				job = braceIndex->Prepare(*this, length);
+				break;
+			}
+		}
+		if (!job && tagIndex && tagIndex->Pending()) {
+			job = tagIndex->Prepare(*this, length);
+		}
+		if (!job) {
+			return false;
+		}
+		backgroundIndexer = std::make_unique<BackgroundIndexer>(std::move(job));
+	} catch (...) {
+		// Summarise in idle time instead
+		backgroundIndexer.reset();
+		return false;
+	}
+	return true;
+}
+
+// Apply the summaries made by the worker once it has finished.
+// Return true while it is still running.
+bool Document::MergeBraceIndexes() {
+	if (!backgroundIndexer) {
+		return false;
+	}
+	if (backgroundIndexer->Running()) {
+		return true;
+	}
+	const std::unique_ptr<IndexJob> job = backgroundIndexer->Finish();
+	backgroundIndexer.reset();
+	if (job) {
+		for (const std::unique_ptr<BraceIndex> &braceIndex : braceIndexes) {
+			if (braceIndex->Merge(*job)) {
+				return false;
+			}
+		}
+		if (tagIndex) {
+			tagIndex->Merge(*job);
+		}
+	}
+	return false;
+}
+
 /**
  * Implementation of RegexSearchBase for the default built-in regular expression engine
  */
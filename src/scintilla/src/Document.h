@@ -17,6 +17,10 @@ class LineMarkers;
 class LineLevels;
 class LineState;
 class LineAnnotation;
+class BackgroundStyler;
+class BraceIndex;
+class TagIndex;
+class BackgroundIndexer;
 
 enum class EncodingFamily { eightBit, unicode, dbcs };
 
@@ -211,6 +215,9 @@ protected:
 	Document *pdoc;
 	LexerInstance instance;
 	bool performingStyle;	///< Prevent reentrance
+	std::unique_ptr<BackgroundStyler> background;
+	bool mergingBackground = false;	///< Prevent reentrance while merging background results
+	bool LexConcurrently(Sci::Position start, Sci::Position end, int styleStart);
 public:
 	explicit LexInterface(Document *pdoc_) noexcept;
 	// Deleted so LexInterface objects can not be copied.
@@ -223,6 +230,13 @@ public:
 	void Colourise(Sci::Position start, Sci::Position end);
 	virtual Scintilla::LineEndType LineEndTypesSupported();
 	bool UseContainerLexing() const noexcept;
+	// Styling on a worker thread. The instance is owned by the worker while it runs so
+	// StopBackground must be called before the instance is used on the main thread.
+	bool StyleInBackground(Sci::Position start, Sci::Position end);
+	bool BackgroundStyling();
+	bool MergeBackground();
+	void StopBackground();
+	void CancelBackground(Sci::Position position) noexcept;
 };
 
 struct RegexError : public std::runtime_error {
@@ -277,7 +291,7 @@ bool DiscardLastCombinedCharacter(std::string_view &text) noexcept;
 
 /**
  */
-class Document : PerLine, public Scintilla::IDocument, public Scintilla::ILoader, public Scintilla::IDocumentEditable {
+class Document : PerLine, public Scintilla::IDocument5, public Scintilla::ILoader, public Scintilla::IDocumentEditable {
 
 public:
 	/** Used to pair watcher pointer with user data. */
@@ -322,6 +336,13 @@ private:
 	std::unique_ptr<RegexSearchBase> regex;
 	std::unique_ptr<LexInterface> pli;
 
+	// Most recently used first
+	std::vector<std::unique_ptr<BraceIndex>> braceIndexes;
+	BraceIndex *BraceIndexFor(char chOpen, char chClose, int style);
+	std::unique_ptr<TagIndex> tagIndex;
+	// Summarising blocks of one of the indexes on a worker thread
+	std::unique_ptr<BackgroundIndexer> backgroundIndexer;
+
 	std::map<void *, ViewStateShared>viewData;
 
 public:
@@ -356,6 +377,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	Scintilla::LineEndType LineEndTypesSupported() const;
 	bool SetDBCSCodePage(int dbcsCodePage_);
@@ -364,7 +386,7 @@ public:
 	Scintilla::LineEndType GetLineEndTypesActive() const noexcept { return cb.GetLineEndTypes(); }
 
 	int SCI_METHOD Version() const override {
-		return Scintilla::dvRelease4;
+		return Scintilla::dvRelease5;
 	}
 	int SCI_METHOD DEVersion() const noexcept override;
 
@@ -404,6 +426,8 @@ public:
 	Sci::Position InsertString(Sci::Position position, std::string_view sv);
 	void ChangeInsertion(const char *s, Sci::Position length);
 	int SCI_METHOD AddData(const char *data, Sci_Position length) override;
+	Sci::Position SetMappedText(Scintilla::IMappedText *text);
+	bool DetachMappedText();
 	IDocumentEditable *AsDocumentEditable() noexcept;
 	void *SCI_METHOD ConvertToDocument() override;
 	Sci::Position Undo();
@@ -429,6 +453,10 @@ public:
 	bool TentativeActive() const noexcept { return cb.TentativeActive(); }
 
 	int UndoActions() const noexcept;
+	void SetUndoMemoryLimit(Sci::Position limit) noexcept;
+	Sci::Position UndoMemoryLimit() const noexcept;
+	Sci::Position UndoMemoryUsage() const noexcept;
+	Sci::Position MemoryUsage(Scintilla::MemoryCategory category) const noexcept;
 	void SetUndoSavePoint(int action) noexcept;
 	int UndoSavePoint() const noexcept;
 	void SetUndoDetach(int action) noexcept;
@@ -450,7 +478,7 @@ public:
 	[[nodiscard]] Sci::Position EditionNextDelete(Sci::Position pos) const noexcept { return cb.EditionNextDelete(pos); }
 
 	const char *SCI_METHOD BufferPointer() override { return cb.BufferPointer(); }
-	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept { return cb.RangePointer(position, rangeLength); }
+	const char *SCI_METHOD RangePointer(Sci_Position position, Sci_Position rangeLength) noexcept override { return cb.RangePointer(position, rangeLength); }
 	Sci::Position GapPosition() const noexcept { return cb.GapPosition(); }
 
 	int SCI_METHOD GetLineIndentation(Sci_Position line) override;
@@ -548,6 +576,8 @@ public:
 	Sci::Position GetEndStyled() const noexcept { return endStyled; }
 	void EnsureStyledTo(Sci::Position pos);
 	void StyleToAdjustingLineDuration(Sci::Position pos);
+	bool StyleInBackground(Sci::Position pos);
+	bool MergeBackgroundStyling();
 	int GetStyleClock() const noexcept { return styleClock; }
 	void IncrementStyleClock() noexcept;
 	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) override;
@@ -595,8 +625,16 @@ public:
 	Sci::Position ParaDown(Sci::Position pos) const;
 	int IndentSize() const noexcept { return actualIndentInChars; }
 	Sci::Position BraceMatch(Sci::Position position, Sci::Position maxReStyle, Sci::Position startPos, bool useStartPos) noexcept;
+	Sci::Position TagMatch(Sci::Position position, bool html) noexcept;
+	bool BraceIndexPending() const noexcept;
+	void BuildBraceIndexes(Sci::Position length);
+	bool BuildBraceIndexesInBackground(Sci::Position length);
+	bool MergeBraceIndexes();
 
 private:
+	template <typename View>
+	Sci::Position FindInView(const View &cbView, Sci::Position minPos, Sci::Position maxPos, const char *search,
+		bool caseSensitive, bool word, bool wordStart, Sci::Position *length);
 	void NotifyModifyAttempt();
 	void NotifySavePoint(bool atSavePoint);
 	void NotifyGroupCompleted() noexcept;
@@ -66,6 +66,7 @@
 #include "EditModel.h"
 #include "MarginView.h"
 #include "EditView.h"
+#include "BackgroundWrapper.h"
 #include "Editor.h"
 #include "ElapsedPeriod.h"
 
@@ -74,6 +75,16 @@ using namespace Scintilla::Internal;
 
 namespace {
 
+// Bytes of braces summarised in each idle call
+constexpr Sci::Position braceIndexIdleLength = 0x100000;
+// Bytes of braces or tags summarised by each worker so edits only discard a bounded amount of work
+constexpr Sci::Position braceIndexBackgroundLength = 0x800000;
+
+// Less pending wrapping than this is done in idle time as starting a worker is not worth it
+constexpr Sci::Position backgroundWrapMinimum = 0x10000;
+// Bytes wrapped by each worker so edits only discard a bounded amount of work
+constexpr Sci::Position backgroundWrapBlock = 0x400000;
+
 /*
 	return whether this modification represents an operation that
 	may reasonably be deferred (not done now OR [possibly] at all)
@@ -123,7 +134,9 @@ Timer::Timer() noexcept :
 Idler::Idler() noexcept :
 		state(false), idlerID(nullptr) {}
 
-Editor::Editor() : durationWrapOneByte(0.000001, 0.00000001, 0.00001) {
+Editor::Editor() :
+	durationWrapOneByte(0.000001, 0.00000001, 0.00001),
+	durationWrapElapsedOneByte(0.000001, 0.00000001, 0.00001) {
 	ctrlID = 0;
 
 	stylesValid = false;
@@ -193,6 +206,8 @@ Editor::Editor() : durationWrapOneByte(0.000001, 0.00000001, 0.00001) {
 	willRedrawAll = false;
 	idleStyling = IdleStyling::None;
 	needIdleStyling = false;
+	backgroundStyling = false;
+	backgroundIndexing = false;
 
 	modEventMask = ModificationFlags::EventMaskAll;
 	commandEvents = true;
@@ -203,6 +218,7 @@ Editor::Editor() : durationWrapOneByte(0.000001, 0.00000001, 0.00001) {
 	foldAutomatic = AutomaticFold::None;
 
 	insideWrapScroll = false;
+	backgroundWrapping = false;
 
 	convertPastes = true;
 
@@ -1507,6 +1523,11 @@ void Editor::NeedWrapping(Sci::Line docLineStart, Sci::Line docLineEnd) {
 	if (wrapPending.AddRange(docLineStart, docLineEnd)) {
 		view.llc.Invalidate(LineLayout::ValidLevel::positions);
 	}
+	// Heights measured by the worker are stale once its lines change
+	if (backgroundWrapper && (docLineStart < backgroundWrapper->LineEnd())) {
+		backgroundWrapper->Cancel();
+	}
+	MarkBackgroundWrapped(docLineStart, docLineEnd - docLineStart, false);
 	// Wrap lines during idle.
 	if (Wrapping() && wrapPending.NeedsWrap()) {
 		SetIdle(true);
@@ -1542,8 +1563,27 @@ bool Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToW
 	std::vector<int> linesAfterWrap(linesBeingWrapped);
 
 	size_t threads = std::min<size_t>(linesBeingWrapped, view.maxLayoutThreads);
-	if (!surface->SupportsFeature(Supports::ThreadSafeMeasureWidths)) {
-		threads = 1;
+
+	// When the surface can't measure on several threads at once, each thread measures on a worker
+	// surface of its own with fonts it makes itself
+	std::vector<std::unique_ptr<Surface>> surfaceThreads;
+	std::vector<std::unique_ptr<ViewStyle>> vsThreads;
+	if ((threads > 1) && !surface->SupportsFeature(Supports::ThreadSafeMeasureWidths)) {
+		for (size_t th = 0; th < threads; th++) {
+			std::unique_ptr<Surface> surfaceWorker = CreateWorkerSurface();
+			if (!surfaceWorker) {
+				break;
+			}
+			surfaceThreads.push_back(std::move(surfaceWorker));
+			vsThreads.push_back(std::make_unique<ViewStyle>(vs));
+			vsThreads.back()->technology = vs.technology;
+			vsThreads.back()->ClearFonts();
+		}
+		if (surfaceThreads.size() < threads) {
+			surfaceThreads.clear();
+			vsThreads.clear();
+			threads = 1;
+		}
 	}
 
 	const bool multiThreaded = threads > 1;
@@ -1568,10 +1608,21 @@ bool Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToW
 	// Protect the line layout cache from being accessed from multiple threads simultaneously
 	std::mutex mutexRetrieve;
 
+	// Time spent working in each thread, each thread only writes its own element
+	std::vector<double> durationThreads(threads);
+
 	std::vector<std::future<void>> futures;
 	for (size_t th = 0; th < threads; th++) {
 		std::future<void> fut = std::async(policy,
-			[=, &surface, &nextIndex, &linesAfterWrap, &mutexRetrieve]() {
+			[=, &surface, &nextIndex, &linesAfterWrap, &mutexRetrieve, &durationThreads, &surfaceThreads, &vsThreads]() {
+			ElapsedPeriod epThread;
+			Surface *surfaceThread = surface;
+			const ViewStyle *vsThread = &vs;
+			if (!surfaceThreads.empty()) {
+				surfaceThread = surfaceThreads[th].get();
+				vsThreads[th]->Refresh(*surfaceThread, pdoc->tabInChars);
+				vsThread = vsThreads[th].get();
+			}
 			// llTemporary is reused for non-significant lines, avoiding allocation costs.
 			std::shared_ptr<LineLayout> llTemporary = std::make_shared<LineLayout>(-1, 200);
 			while (true) {
@@ -1591,10 +1642,11 @@ bool Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToW
 						ll = llTemporary;
 						ll->ReSet(lineNumber, lengthLine);
 					}
-					view.LayoutLine(*this, surface, vs, ll.get(), wrapWidth, multiThreaded);
+					view.LayoutLine(*this, surfaceThread, *vsThread, ll.get(), wrapWidth, multiThreaded);
 					linesAfterWrap[i] = ll->lines;
 				}
 			}
+			durationThreads[th] = epThread.Duration();
 		});
 		futures.push_back(std::move(fut));
 	}
@@ -1603,9 +1655,13 @@ bool Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToW
 	}
 	// End of multiple threads
 
-	// Multiply duration by number of threads to produce (near) equivalence to duration if single threaded
+	// Sum the time each thread worked for to produce (near) equivalence to duration if single threaded.
+	// Threads that finish early or start late don't count the time they were idle.
 	const double durationShortLines = epWrapping.Duration(true);
-	const double durationShortLinesThreads = durationShortLines * static_cast<double>(threads);
+	double durationShortLinesThreads = 0.0;
+	for (const double durationThread : durationThreads) {
+		durationShortLinesThreads += durationThread;
+	}
 
 	// Wrap all the long lines in the main thread.
 	// LayoutLine may then multi-thread over segments in each line.
@@ -1646,10 +1702,29 @@ bool Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToW
 	}
 
 	durationWrapOneByte.AddSample(bytesBeingWrapped, durationShortLinesThreads + durationLongLines);
+	durationWrapElapsedOneByte.AddSample(bytesBeingWrapped, durationShortLines + durationLongLines);
 
 	return wrapsDone > 0;
 }
 
+// The line to keep at the top of the view while line heights change.
+Editor::LineDocSub Editor::WrapScrollAnchor() const {
+	if (scrollToAfterWrap) {
+		return scrollToAfterWrap.value();
+	}
+	const Sci::Line lineDocTop = pcs->DocFromDisplay(topLine);
+	const Sci::Line subLineTop = topLine - pcs->DisplayFromDoc(lineDocTop);
+	return { lineDocTop, subLineTop };
+}
+
+void Editor::ScrollAfterWrap(Sci::Line goodTopLine) {
+	insideWrapScroll = true;
+	SetScrollBars();
+	SetTopLine(std::clamp<Sci::Line>(goodTopLine, 0, MaxScrollPos()));
+	SetVerticalScrollPos();
+	insideWrapScroll = false;
+}
+
 // Perform  wrapping for a subset of the lines needing wrapping.
 // wsAll: wrap all lines which need wrapping in this single call
 // wsVisible: wrap currently visible lines
@@ -1671,6 +1746,7 @@ bool Editor::WrapLines(WrapScope ws) {
 			wrapOccurred = true;
 		}
 		wrapPending.Reset();
+		backgroundWrapped.DeleteAll();
 
 	} else if (wrapPending.NeedsWrap()) {
 		wrapPending.start = std::min(wrapPending.start, pdoc->LinesTotal());
@@ -1683,13 +1759,7 @@ bool Editor::WrapLines(WrapScope ws) {
 		Sci::Line lineToWrapEnd = std::min(wrapPending.end, pdoc->LinesTotal());
 
 		const Sci::Line lineDocTop = pcs->DocFromDisplay(topLine);
-		LineDocSub lineScrollTo;
-		if (scrollToAfterWrap) {
-			lineScrollTo = scrollToAfterWrap.value();
-		} else {
-			const Sci::Line subLineTop = topLine - pcs->DisplayFromDoc(lineDocTop);
-			lineScrollTo = { lineDocTop, subLineTop };
-		}
+		const LineDocSub lineScrollTo = WrapScrollAnchor();
 		if (ws == WrapScope::wsVisible) {
 			lineToWrap = std::clamp(lineDocTop-5, wrapPending.start, pdoc->LinesTotal());
 			// Priority wrap to just after visible area.
@@ -1752,16 +1822,151 @@ bool Editor::WrapLines(WrapScope ws) {
 	}
 
 	if (wrapOccurred) {
-		insideWrapScroll = true;
-		SetScrollBars();
-		SetTopLine(std::clamp<Sci::Line>(goodTopLine, 0, MaxScrollPos()));
-		SetVerticalScrollPos();
-		insideWrapScroll = false;
+		ScrollAfterWrap(goodTopLine);
 	}
 
 	return wrapOccurred;
 }
 
+// Start wrapping the next block of pending lines on a worker when there are enough of them.
+// Return true if a worker is wrapping.
+bool Editor::WrapInBackground() {
+	if (backgroundWrapper) {
+		return true;
+	}
+	// Documents with Unicode line ends are wrapped on the main thread as the snapshot
+	// document only has the default line ends
+	if (!backgroundWrapping || !Wrapping() || !wrapPending.NeedsWrap() ||
+		(pdoc->GetLineEndTypesActive() != LineEndType::Default)) {
+		return false;
+	}
+	const Sci::Line lineToWrap = std::min(wrapPending.start, pdoc->LinesTotal());
+	const Sci::Line lineEndNeedWrap = std::min(wrapPending.end, pdoc->LinesTotal());
+	if (pdoc->LineStart(lineEndNeedWrap) - pdoc->LineStart(lineToWrap) < backgroundWrapMinimum) {
+		return false;
+	}
+	std::unique_ptr<Surface> surface = CreateWorkerSurface();
+	if (!surface) {
+		return false;
+	}
+	const Sci::Line lineToWrapEnd = std::min(pdoc->LineFromPositionAfter(lineToWrap, backgroundWrapBlock), lineEndNeedWrap);
+
+	// Ensure all lines being wrapped are styled.
+	pdoc->EnsureStyledTo(pdoc->LineStart(lineToWrapEnd));
+
+	RefreshStyleData();
+	wrapWidth = static_cast<int>(GetTextRectangle().Width());
+	try {
+		backgroundWrapper = std::make_unique<BackgroundWrapper>(*pdoc, vs, *reprs, std::move(surface),
+			wrapWidth, lineToWrap, lineToWrapEnd);
+		backgroundWrapper->Start();
+	} catch (...) {
+		// Wrap on the main thread instead
+		backgroundWrapper.reset();
+		return false;
+	}
+	FineTickerStart(TickReason::wrap, 50, 10);
+	return true;
+}
+
+// Apply the heights published by the worker.
+// Return false once the worker has finished or was abandoned.
+bool Editor::MergeBackgroundWrapping() {
+	if (!backgroundWrapper) {
+		return false;
+	}
+	const bool running = backgroundWrapper->Running();
+	std::vector<WrappedChunk> chunks = backgroundWrapper->TakeChunks();
+	if (backgroundWrapper->Width() != wrapWidth || !Wrapping() || !wrapPending.NeedsWrap()) {
+		// Width or mode changed since the worker started so its heights are wrong
+		chunks.clear();
+		backgroundWrapper->Cancel();
+	}
+	const LineDocSub lineScrollTo = WrapScrollAnchor();
+	bool heightChanged = false;
+	for (const WrappedChunk &chunk : chunks) {
+		const Sci::Line lineEnd = std::min(chunk.line + static_cast<Sci::Line>(chunk.subLines.size()), pdoc->LinesTotal());
+		// Lines before wrapPending.start were wrapped on the main thread when shown
+		const Sci::Line lineFirst = std::max(chunk.line, wrapPending.start);
+		const Sci::Line lineLast = std::min(lineEnd, wrapPending.end);
+		for (Sci::Line line = lineFirst; line < lineLast; line++) {
+			int linesWrapped = chunk.subLines[line - chunk.line];
+			if (vs.annotationVisible != AnnotationVisible::Hidden) {
+				linesWrapped += pdoc->AnnotationLines(line);
+			}
+			if (pcs->SetHeight(line, linesWrapped)) {
+				heightChanged = true;
+			}
+			wrapPending.Wrapped(line);
+		}
+		MarkBackgroundWrapped(lineFirst, lineLast - lineFirst, true);
+	}
+	if (wrapPending.start >= std::min(wrapPending.end, pdoc->LinesTotal())) {
+		wrapPending.Reset();
+		scrollToAfterWrap.reset();
+	}
+	if (heightChanged) {
+		ScrollAfterWrap(pcs->DisplayFromDocSub(lineScrollTo.lineDoc, lineScrollTo.subLine));
+		Redraw();
+	}
+	if (!running) {
+		backgroundWrapper.reset();
+		return false;
+	}
+	return true;
+}
+
+// Record which lines have heights measured by the worker.
+void Editor::MarkBackgroundWrapped(Sci::Line line, Sci::Line lines, bool wrapped) {
+	const Sci::Line linesTotal = pdoc->LinesTotal();
+	if (backgroundWrapped.Length() != linesTotal) {
+		// Out of step with the document so forget what was marked
+		backgroundWrapped.DeleteAll();
+		if (!wrapped) {
+			return;
+		}
+		backgroundWrapped.InsertSpace(0, linesTotal);
+	}
+	line = std::clamp<Sci::Line>(line, 0, linesTotal);
+	lines = std::min(lines, linesTotal - line);
+	if (lines > 0) {
+		backgroundWrapped.FillRange(line, wrapped ? 1 : 0, lines);
+	}
+}
+
+// Wrap visible lines that were wrapped in the background with the main thread's fonts and
+// current styles so what is drawn matches the heights.
+// Return true if any height changed.
+bool Editor::WrapShownBackgroundLines() {
+	if (!Wrapping() || (backgroundWrapped.Length() != pdoc->LinesTotal())) {
+		return false;
+	}
+	const Sci::Line lineDocTop = pcs->DocFromDisplay(topLine);
+	const Sci::Line lineDocBottom = std::min(pcs->DocFromDisplay(topLine + LinesOnScreen() + 1) + 1, pdoc->LinesTotal());
+	const Sci::Line lineMarked = backgroundWrapped.Find(1, lineDocTop);
+	if ((lineMarked < 0) || (lineMarked >= lineDocBottom)) {
+		return false;
+	}
+	AutoSurface surface(this);
+	if (!surface) {
+		return false;
+	}
+	const LineDocSub lineScrollTo = WrapScrollAnchor();
+	bool heightChanged = false;
+	for (Sci::Line lineDoc = lineDocTop; lineDoc < lineDocBottom; lineDoc++) {
+		if (backgroundWrapped.ValueAt(lineDoc)) {
+			if (WrapOneLine(surface, lineDoc)) {
+				heightChanged = true;
+			}
+		}
+	}
+	MarkBackgroundWrapped(lineDocTop, lineDocBottom - lineDocTop, false);
+	if (heightChanged) {
+		ScrollAfterWrap(pcs->DisplayFromDocSub(lineScrollTo.lineDoc, lineScrollTo.subLine));
+	}
+	return heightChanged;
+}
+
 void Editor::LinesJoin() {
 	if (!RangeContainsProtected(targetRange.start.Position(), targetRange.end.Position())) {
 		UndoGroup ug(pdoc);
@@ -1889,7 +2094,7 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 	}
 
 	// Wrap the visible lines if needed.
-	if (WrapLines(WrapScope::wsVisible)) {
+	if (WrapLines(WrapScope::wsVisible) || WrapShownBackgroundLines()) {
 		// The wrapping process has changed the height of some lines so
 		// abandon this paint for a complete repaint.
 		if (AbandonPaint()) {
@@ -2854,6 +3059,13 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 			} else {
 				pcs->DeleteLines(lineOfPos, -mh.linesAdded);
 			}
+			if (backgroundWrapped.Length() == pdoc->LinesTotal() - mh.linesAdded) {
+				if (mh.linesAdded > 0) {
+					backgroundWrapped.InsertSpace(lineOfPos, mh.linesAdded);
+				} else {
+					backgroundWrapped.DeleteRange(lineOfPos, -mh.linesAdded);
+				}
+			}
 			view.LinesAddedOrRemoved(lineOfPos, mh.linesAdded);
 		}
 		if (FlagSet(mh.modificationType, ModificationFlags::ChangeAnnotation)) {
@@ -5239,15 +5451,27 @@ void Editor::ButtonUpWithModifiers(Point pt, unsigned int curTime, KeyMod modifi
 bool Editor::Idle() {
 	NotifyUpdateUI();
 
-	bool needWrap = Wrapping() && wrapPending.NeedsWrap();
+	// While a worker is wrapping, its results are merged by the wrap timer
+	bool needWrap = Wrapping() && wrapPending.NeedsWrap() && !backgroundWrapper;
 
 	if (needWrap) {
-		// Wrap lines during idle.
-		WrapLines(WrapScope::wsIdle);
+		// Wrap lines during idle, on a worker when there are many.
+		if (!WrapInBackground()) {
+			WrapLines(WrapScope::wsIdle);
+		}
 		// No more wrapping
-		needWrap = wrapPending.NeedsWrap();
+		needWrap = wrapPending.NeedsWrap() && !backgroundWrapper;
 	} else if (needIdleStyling) {
 		IdleStyle();
+	} else if (pdoc->BraceIndexPending()) {
+		// Summarise on a worker whose results are merged by the index timer or a little at a time here
+		if (backgroundIndexing && pdoc->BuildBraceIndexesInBackground(braceIndexBackgroundLength)) {
+			if (!FineTickerRunning(TickReason::index)) {
+				FineTickerStart(TickReason::index, 10, 5);
+			}
+		} else {
+			pdoc->BuildBraceIndexes(braceIndexIdleLength);
+		}
 	}
 
 	// Add more idle things to do here, but make sure idleDone is
@@ -5255,7 +5479,9 @@ bool Editor::Idle() {
 	// false will stop calling this idle function until SetIdle() is
 	// called again.
 
-	const bool idleDone = !needWrap && !needIdleStyling; // && thatDone && theOtherThingDone...
+	// While a worker is summarising, its results are merged by the index timer
+	const bool indexDone = !pdoc->BraceIndexPending() || FineTickerRunning(TickReason::index);
+	const bool idleDone = !needWrap && !needIdleStyling && indexDone; // && thatDone && theOtherThingDone...
 
 	return !idleDone;
 }
@@ -5289,6 +5515,34 @@ void Editor::TickFor(TickReason reason) {
 			}
 			FineTickerCancel(TickReason::dwell);
 			break;
+		case TickReason::style:
+			if (!pdoc->MergeBackgroundStyling()) {
+				// Background styling finished or was abandoned so show the results and
+				// continue with any styling still needed
+				FineTickerCancel(TickReason::style);
+				Redraw();
+				StartIdleStyling(false);
+			}
+			break;
+		case TickReason::wrap:
+			if (!MergeBackgroundWrapping()) {
+				// Worker finished or was abandoned so continue with any wrapping still needed
+				FineTickerCancel(TickReason::wrap);
+				if (Wrapping() && wrapPending.NeedsWrap()) {
+					SetIdle(true);
+				}
+			}
+			break;
+		case TickReason::index:
+			// Once the worker finishes, apply its summaries and start it on the next blocks
+			if (!pdoc->MergeBraceIndexes() &&
+				!(backgroundIndexing && pdoc->BuildBraceIndexesInBackground(braceIndexBackgroundLength))) {
+				FineTickerCancel(TickReason::index);
+				if (pdoc->BraceIndexPending()) {
+					SetIdle(true);
+				}
+			}
+			break;
 		default:
 			// tickPlatform handled by subclass
 			break;
@@ -5407,6 +5661,13 @@ void Editor::StartIdleStyling(bool truncatedLastStyling) {
 // Style for an area but bound the amount of styling to remain responsive
 void Editor::StyleAreaBounded(PRectangle rcArea, bool scrolling) {
 	const Sci::Position posAfterArea = PositionAfterArea(rcArea);
+	if (backgroundStyling && pdoc->StyleInBackground(posAfterArea)) {
+		// Styling is performed on another thread and merged as each chunk arrives
+		if (!FineTickerRunning(TickReason::style)) {
+			FineTickerStart(TickReason::style, 50, 10);
+		}
+		return;
+	}
 	const Sci::Position posAfterMax = PositionAfterMaxStyling(posAfterArea, scrolling);
 	if (posAfterMax < posAfterArea) {
 		// Idle styling may be performed before current visible area
@@ -5813,6 +6074,56 @@ void Editor::FoldAll(FoldAction action) {
 	Redraw();
 }
 
+void Editor::FoldAllAtLevel(FoldLevel level, FoldAction action) {
+	// Works on the whole document with a single update of the display rather than calling
+	// FoldLine for each header which relayouts each time.
+	level = LevelNumberPart(level);
+	const Sci::Line maxLine = pdoc->LinesTotal();
+	bool expanding = action == FoldAction::Expand;
+	if (!expanding) {
+		// Only lines that have been styled can be contracted so expanding does not need the rest
+		pdoc->EnsureStyledTo(pdoc->Length());
+	}
+	if (action == FoldAction::Toggle) {
+		// Discover current state from the first header of the level
+		for (Sci::Line line = 0; line < maxLine; line++) {
+			const FoldLevel levelLine = pdoc->GetFoldLevel(line);
+			if (LevelIsHeader(levelLine) && (LevelNumberPart(levelLine) == level)) {
+				expanding = !pcs->GetExpanded(line);
+				break;
+			}
+		}
+	}
+	Sci::Line line = 0;
+	while (line < maxLine) {
+		const FoldLevel levelLine = pdoc->GetFoldLevel(line);
+		if (LevelIsHeader(levelLine) && (LevelNumberPart(levelLine) == level)) {
+			// Headers inside this fold are at deeper levels so continue after it
+			Sci::Line lineMaxSubord = line;
+			if (expanding) {
+				pcs->SetExpanded(line, true);
+				// Headers hidden inside a contracted fold keep their lines hidden
+				lineMaxSubord = pcs->GetVisible(line) ? ExpandLine(line) : pdoc->GetLastChild(line);
+			} else {
+				lineMaxSubord = pdoc->GetLastChild(line);
+				if (lineMaxSubord > line) {
+					pcs->SetExpanded(line, false);
+					pcs->SetVisible(line + 1, lineMaxSubord, false);
+				}
+			}
+			line = std::max(lineMaxSubord, line) + 1;
+		} else {
+			line++;
+		}
+	}
+	if (!expanding && !pcs->GetVisible(pdoc->SciLineFromPosition(sel.MainCaret()))) {
+		// This does not re-expand the fold
+		EnsureCaretVisible();
+	}
+	SetScrollBars();
+	Redraw();
+}
+
 void Editor::FoldChanged(Sci::Line line, FoldLevel levelNow, FoldLevel levelPrev) {
 	if (LevelIsHeader(levelNow)) {
 		if (!LevelIsHeader(levelPrev)) {
@@ -5962,6 +6273,14 @@ std::unique_ptr<Surface> Editor::CreateMeasurementSurface() const {
 	return surf;
 }
 
+std::unique_ptr<Surface> Editor::CreateWorkerSurface() const {
+	std::unique_ptr<Surface> surf = CreateMeasurementSurface();
+	if (surf && !surf->SupportsFeature(Supports::ThreadSafeMeasureWidths)) {
+		return {};
+	}
+	return surf;
+}
+
 std::unique_ptr<Surface> Editor::CreateDrawingSurface(SurfaceID sid, std::optional<Scintilla::Technology> technologyOpt) const {
 	if (!wMain.GetID()) {
 		return {};
@@ -6744,6 +7063,26 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetUndoActions:
 		return pdoc->UndoActions();
 
+	case Message::SetUndoMemoryLimit:
+		pdoc->SetUndoMemoryLimit(PositionFromUPtr(wParam));
+		break;
+
+	case Message::GetUndoMemoryLimit:
+		return pdoc->UndoMemoryLimit();
+
+	case Message::GetUndoMemoryUsage:
+		return pdoc->UndoMemoryUsage();
+
+	case Message::GetMemoryUsage:
+		switch (static_cast<MemoryCategory>(wParam)) {
+		case MemoryCategory::LayoutCache:
+			return view.llc.MemoryUsage();
+		case MemoryCategory::PositionCache:
+			return view.posCache->MemoryUsage();
+		default:
+			return pdoc->MemoryUsage(static_cast<MemoryCategory>(wParam));
+		}
+
 	case Message::SetUndoSavePoint:
 		pdoc->SetUndoSavePoint(static_cast<int>(wParam));
 		break;
@@ -7207,6 +7546,30 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetIdleStyling:
 		return static_cast<sptr_t>(idleStyling);
 
+	case Message::SetBackgroundStyling:
+		backgroundStyling = wParam != 0;
+		break;
+
+	case Message::GetBackgroundStyling:
+		return backgroundStyling;
+
+	case Message::SetBackgroundWrapping:
+		backgroundWrapping = wParam != 0;
+		if (!backgroundWrapping && backgroundWrapper) {
+			backgroundWrapper->Cancel();
+		}
+		break;
+
+	case Message::GetBackgroundWrapping:
+		return backgroundWrapping;
+
+	case Message::SetBackgroundIndexing:
+		backgroundIndexing = wParam != 0;
+		break;
+
+	case Message::GetBackgroundIndexing:
+		return backgroundIndexing;
+
 	case Message::SetWrapMode:
 		if (vs.SetWrapState(static_cast<Wrap>(wParam))) {
 			xOffset = 0;
@@ -7281,6 +7644,11 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetLayoutThreads:
 		return view.GetLayoutThreads();
 
+	case Message::GetWrapDuration: {
+			const ActionDuration &duration = wParam ? durationWrapElapsedOneByte : durationWrapOneByte;
+			return static_cast<sptr_t>(duration.Duration() * 1.0e9 * 1024);
+		}
+
 	case Message::SetScrollWidth:
 		PLATFORM_ASSERT(wParam > 0);
 		if ((wParam > 0) && (wParam != static_cast<unsigned int>(scrollWidth))) {
@@ -7944,6 +8312,10 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		FoldAll(static_cast<FoldAction>(wParam));
 		break;
 
+	case Message::FoldAllAtLevel:
+		FoldAllAtLevel(static_cast<FoldLevel>(wParam), static_cast<FoldAction>(lParam));
+		break;
+
 	case Message::ExpandChildren:
 		FoldExpand(LineFromUPtr(wParam), FoldAction::Expand, static_cast<FoldLevel>(lParam));
 		break;
@@ -8353,10 +8725,29 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::BraceMatch:
 		// wParam is position of char to find brace for,
 		// lParam is maximum amount of text to restyle to find it
-		return pdoc->BraceMatch(PositionFromUPtr(wParam), lParam, 0, false);
+		{
+			const Sci::Position match = pdoc->BraceMatch(PositionFromUPtr(wParam), lParam, 0, false);
+			// Finish summarising the braces in idle time so later matches are quick
+			if (pdoc->BraceIndexPending())
+				SetIdle(true);
+			return match;
+		}
 
 	case Message::BraceMatchNext:
-		return pdoc->BraceMatch(PositionFromUPtr(wParam), 0, lParam, true);
+		{
+			const Sci::Position match = pdoc->BraceMatch(PositionFromUPtr(wParam), 0, lParam, true);
+			if (pdoc->BraceIndexPending())
+				SetIdle(true);
+			return match;
+		}
+
+	case Message::TagMatch:
+		{
+			const Sci::Position match = pdoc->TagMatch(PositionFromUPtr(wParam), lParam != 0);
+			if (pdoc->BraceIndexPending())
+				SetIdle(true);
+			return match;
+		}
 
 	case Message::GetViewEOL:
 		return vs.viewEOL;
@@ -8462,6 +8853,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 			return reinterpret_cast<sptr_t>(loader);
 		}
 
+	case Message::SetMappedText:
+		return pdoc->SetMappedText(static_cast<IMappedText *>(PtrFromSPtr(lParam)));
+
+	case Message::DetachMappedText:
+		return pdoc->DetachMappedText();
+
 	case Message::SetModEventMask:
 		modEventMask = static_cast<ModificationFlags>(wParam);
 		return 0;
@@ -10,6 +10,8 @@
 
 namespace Scintilla::Internal {
 
+class BackgroundWrapper;
+
 /**
  */
 class Timer {
@@ -264,6 +266,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	WorkNeeded workNeeded;
 	Scintilla::IdleStyling idleStyling;
 	bool needIdleStyling;
+	bool backgroundStyling;
+	bool backgroundIndexing;
 
 	Scintilla::ModificationFlags modEventMask;
 	bool commandEvents;
@@ -283,12 +287,19 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	// Wrapping support
 	WrapPending wrapPending;
 	ActionDuration durationWrapOneByte;
+	// Elapsed time rather than time summed over layout threads
+	ActionDuration durationWrapElapsedOneByte;
 	bool insideWrapScroll;
 	struct LineDocSub {
 		Scintilla::Line lineDoc = 0;
 		Scintilla::Line subLine = 0;
 	};
 	std::optional<LineDocSub> scrollToAfterWrap;
+	bool backgroundWrapping;
+	std::unique_ptr<BackgroundWrapper> backgroundWrapper;
+	// Lines wrapped in the background, which are wrapped again when shown as they were
+	// measured with the worker's fonts and may have been styled since
+	RunStyles<Sci::Line, char> backgroundWrapped;
 
 	bool convertPastes;
 
@@ -413,7 +424,13 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	bool WrapOneLine(Surface *surface, Sci::Line lineToWrap);
 	bool WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToWrapEnd);
 	enum class WrapScope {wsAll, wsVisible, wsIdle};
+	LineDocSub WrapScrollAnchor() const;
+	void ScrollAfterWrap(Sci::Line goodTopLine);
 	bool WrapLines(WrapScope ws);
+	bool WrapInBackground();
+	bool MergeBackgroundWrapping();
+	void MarkBackgroundWrapped(Sci::Line line, Sci::Line lines, bool wrapped);
+	bool WrapShownBackgroundLines();
 	void LinesJoin();
 	void LinesSplit(int pixelWidth);
 
@@ -559,7 +576,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void ButtonUpWithModifiers(Point pt, unsigned int curTime, Scintilla::KeyMod modifiers);
 
 	bool Idle();
-	enum class TickReason { caret, scroll, widen, dwell, platform };
+	enum class TickReason { caret, scroll, widen, dwell, style, wrap, index, platform };
 	virtual void TickFor(TickReason reason);
 	virtual bool FineTickerRunning(TickReason reason);
 	virtual void FineTickerStart(TickReason reason, int millis, int tolerance);
@@ -604,6 +621,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void FoldChanged(Sci::Line line, Scintilla::FoldLevel levelNow, Scintilla::FoldLevel levelPrev);
 	void NeedShown(Sci::Position pos, Sci::Position len);
 	void FoldAll(Scintilla::FoldAction action);
+	void FoldAllAtLevel(Scintilla::FoldLevel level, Scintilla::FoldAction action);
 
 	Sci::Position GetTag(char *tagValue, int tagNumber);
 	enum class ReplaceType {basic, patterns, minimal};
@@ -620,6 +638,9 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	virtual std::string UTF8FromEncoded(std::string_view encoded) const = 0;
 	virtual std::string EncodedFromUTF8(std::string_view utf8) const = 0;
 	virtual std::unique_ptr<Surface> CreateMeasurementSurface() const;
+	// A surface only used on a worker thread, with fonts made on that thread, or nullptr if
+	// text can't be measured on other threads
+	virtual std::unique_ptr<Surface> CreateWorkerSurface() const;
 	virtual std::unique_ptr<Surface> CreateDrawingSurface(SurfaceID sid, std::optional<Scintilla::Technology> technologyOpt = {}) const;
 
 	Sci::Line WrapCount(Sci::Line line);
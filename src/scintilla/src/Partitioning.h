@@ -91,6 +91,10 @@ public:
 		return PositionFromPartition(Partitions());
 	}
 
+	size_t MemoryUsage() const noexcept {
+		return body.MemoryUsage();
+	}
+
 	void InsertPartition(T partition, T pos) {
 		if (stepPartition < partition) {
 			ApplyStep(partition);
@@ -65,6 +65,12 @@ MarkerHandleNumber const *MarkerHandleSet::GetMarkerHandleNumber(int which) cons
 	return nullptr;
 }
 
+size_t MarkerHandleSet::MemoryUsage() const noexcept {
+	// Each node of the list holds a MarkerHandleNumber and a link.
+	const size_t nodes = std::distance(mhList.begin(), mhList.end());
+	return sizeof(MarkerHandleSet) + nodes * (sizeof(MarkerHandleNumber) + sizeof(void *));
+}
+
 bool MarkerHandleSet::InsertHandle(int handle, int markerNum) {
 	mhList.push_front(MarkerHandleNumber(handle, markerNum));
 	return true;
@@ -116,6 +122,16 @@ void LineMarkers::RemoveLine(Sci::Line line) {
 	}
 }
 
+size_t LineMarkers::MemoryUsage() const noexcept {
+	size_t usage = markers.MemoryUsage();
+	for (Sci::Line line = 0; line < markers.Length(); line++) {
+		if (markers[line]) {
+			usage += markers[line]->MemoryUsage();
+		}
+	}
+	return usage;
+}
+
 Sci::Line LineMarkers::LineFromHandle(int markerHandle) const noexcept {
 	for (Sci::Line line = 0; line < markers.Length(); line++) {
 		if (markers[line] && markers[line]->Contains(markerHandle)) {
@@ -213,14 +229,254 @@ void LineMarkers::DeleteMarkFromHandle(int markerHandle) {
 	}
 }
 
+namespace {
+
+// Lines have level numbers below this so it marks a block without any line of a kind
+constexpr int levelNone = 0x10000;
+
+// Documents with fewer lines are searched line by line
+constexpr Sci::Line levelIndexMinimum = 0x4000;
+
+}
+
+LevelIndex::LevelIndex(Sci::Line lines) {
+	blocks.InsertText(0, lines);
+	for (Sci::Line start = blockSize; start < lines; start += blockSize) {
+		blocks.InsertPartition(blocks.Partitions(), start);
+	}
+	leaves.resize(BlockCount());
+	leafValid.resize(BlockCount());
+	Reset();
+}
+
+size_t LevelIndex::BlockCount() const noexcept {
+	return blocks.Partitions();
+}
+
+Sci::Line LevelIndex::BlockStart(size_t block) const noexcept {
+	return blocks.PositionFromPartition(static_cast<Sci::Line>(block));
+}
+
+void LevelIndex::Reset() {
+	leafBase = 1;
+	while (leafBase < BlockCount()) {
+		leafBase *= 2;
+	}
+	nodes.assign(leafBase, Summary{ levelNone, levelNone });
+	nodeValid.assign(leafBase, false);
+}
+
+void LevelIndex::InvalidateBlock(size_t block) noexcept {
+	if (block >= leafValid.size()) {
+		return;
+	}
+	leafValid[block] = false;
+	for (size_t node = (leafBase + block) / 2; node >= 1; node /= 2) {
+		nodeValid[node] = false;
+	}
+}
+
+bool LevelIndex::Matches(int level, int atMost, bool headers) noexcept {
+	const FoldLevel foldLevel = static_cast<FoldLevel>(level);
+	if (headers ? !LevelIsHeader(foldLevel) : LevelIsWhitespace(foldLevel)) {
+		return false;
+	}
+	return LevelNumber(foldLevel) <= atMost;
+}
+
+LevelIndex::Summary LevelIndex::Summarise(const SplitVector<int> &levels, size_t block) const noexcept {
+	Summary summary{ levelNone, levelNone };
+	const Sci::Line end = BlockStart(block + 1);
+	for (Sci::Line line = BlockStart(block); line < end; line++) {
+		const FoldLevel level = static_cast<FoldLevel>(levels.ValueAt(line));
+		if (!LevelIsWhitespace(level)) {
+			summary.minLevel = std::min(summary.minLevel, LevelNumber(level));
+		}
+		if (LevelIsHeader(level)) {
+			summary.minHeader = std::min(summary.minHeader, LevelNumber(level));
+		}
+	}
+	return summary;
+}
+
+const LevelIndex::Summary &LevelIndex::Node(const SplitVector<int> &levels, size_t node) noexcept {
+	if (node >= leafBase) {
+		static constexpr Summary empty{ levelNone, levelNone };
+		const size_t leaf = node - leafBase;
+		if (leaf >= leaves.size()) {
+			return empty;
+		}
+		if (!leafValid[leaf]) {
+			leaves[leaf] = Summarise(levels, leaf);
+			leafValid[leaf] = true;
+		}
+		return leaves[leaf];
+	}
+	if (!nodeValid[node]) {
+		const Summary left = Node(levels, node * 2);
+		const Summary &right = Node(levels, node * 2 + 1);
+		nodes[node].minLevel = std::min(left.minLevel, right.minLevel);
+		nodes[node].minHeader = std::min(left.minHeader, right.minHeader);
+		nodeValid[node] = true;
+	}
+	return nodes[node];
+}
+
+// Find the first block in [first, last) with a line that matches.
+size_t LevelIndex::SearchForward(const SplitVector<int> &levels, int level, bool headers, size_t node, size_t lo, size_t hi, size_t first, size_t last) noexcept {
+	if (hi <= first || lo >= last) {
+		return notFound;
+	}
+	const Summary &summary = Node(levels, node);
+	if ((headers ? summary.minHeader : summary.minLevel) > level) {
+		return notFound;
+	}
+	if (hi - lo == 1) {
+		return lo;
+	}
+	const size_t middle = (lo + hi) / 2;
+	const size_t found = SearchForward(levels, level, headers, node * 2, lo, middle, first, last);
+	if (found != notFound) {
+		return found;
+	}
+	return SearchForward(levels, level, headers, node * 2 + 1, middle, hi, first, last);
+}
+
+// Find the last block in [first, last) with a line that matches.
+size_t LevelIndex::SearchBackward(const SplitVector<int> &levels, int level, bool headers, size_t node, size_t lo, size_t hi, size_t first, size_t last) noexcept {
+	if (hi <= first || lo >= last) {
+		return notFound;
+	}
+	const Summary &summary = Node(levels, node);
+	if ((headers ? summary.minHeader : summary.minLevel) > level) {
+		return notFound;
+	}
+	if (hi - lo == 1) {
+		return lo;
+	}
+	const size_t middle = (lo + hi) / 2;
+	const size_t found = SearchBackward(levels, level, headers, node * 2 + 1, middle, hi, first, last);
+	if (found != notFound) {
+		return found;
+	}
+	return SearchBackward(levels, level, headers, node * 2, lo, middle, first, last);
+}
+
+void LevelIndex::InsertLines(Sci::Line line, Sci::Line lines) {
+	const size_t block = blocks.PartitionFromPosition(line);
+	blocks.InsertText(static_cast<Sci::Line>(block), lines);
+	InvalidateBlock(block);
+	const Sci::Line end = BlockStart(block + 1);
+	if (end - BlockStart(block) > blockSize * 2) {
+		// Split a grown block into pieces of blockSize
+		size_t inserted = 0;
+		for (Sci::Line start = BlockStart(block) + blockSize; start < end; start += blockSize) {
+			inserted++;
+			blocks.InsertPartition(static_cast<Sci::Line>(block + inserted), start);
+		}
+		leaves.insert(leaves.begin() + block + 1, inserted, Summary{ levelNone, levelNone });
+		leafValid.insert(leafValid.begin() + block + 1, inserted, false);
+		Reset();
+	}
+}
+
+void LevelIndex::RemoveLine(Sci::Line line) {
+	const size_t block = blocks.PartitionFromPosition(line);
+	blocks.InsertText(static_cast<Sci::Line>(block), -1);
+	InvalidateBlock(block);
+	if ((BlockStart(block + 1) == BlockStart(block)) && (BlockCount() > 1)) {
+		// Empty blocks are removed
+		blocks.RemovePartition(static_cast<Sci::Line>((block + 1 < BlockCount()) ? block + 1 : block));
+		leaves.erase(leaves.begin() + block);
+		leafValid.erase(leafValid.begin() + block);
+		Reset();
+	}
+}
+
+void LevelIndex::Invalidate(Sci::Line line) noexcept {
+	if ((line >= 0) && (line < blocks.Length())) {
+		InvalidateBlock(blocks.PartitionFromPosition(line));
+	}
+}
+
+Sci::Line LevelIndex::FindForward(const SplitVector<int> &levels, Sci::Line lineStart, Sci::Line lineEnd, int atMost, bool headers) noexcept {
+	lineEnd = std::min(lineEnd, blocks.Length());
+	if (lineStart >= lineEnd) {
+		return -1;
+	}
+	// The first and last blocks may be partly outside the range so they are looked at line by line
+	const size_t blockFirst = blocks.PartitionFromPosition(lineStart);
+	const size_t blockLast = blocks.PartitionFromPosition(lineEnd - 1);
+	const Sci::Line endFirst = std::min(BlockStart(blockFirst + 1), lineEnd);
+	for (Sci::Line line = lineStart; line < endFirst; line++) {
+		if (Matches(levels.ValueAt(line), atMost, headers)) {
+			return line;
+		}
+	}
+	if (blockFirst == blockLast) {
+		return -1;
+	}
+	const size_t found = SearchForward(levels, atMost, headers, 1, 0, leafBase, blockFirst + 1, blockLast);
+	const size_t block = (found == notFound) ? blockLast : found;
+	const Sci::Line end = std::min(BlockStart(block + 1), lineEnd);
+	for (Sci::Line line = BlockStart(block); line < end; line++) {
+		if (Matches(levels.ValueAt(line), atMost, headers)) {
+			return line;
+		}
+	}
+	return -1;
+}
+
+Sci::Line LevelIndex::FindBackward(const SplitVector<int> &levels, Sci::Line lineEnd, int atMost, bool headers) noexcept {
+	lineEnd = std::min(lineEnd, blocks.Length());
+	if (lineEnd <= 0) {
+		return -1;
+	}
+	const size_t blockLast = blocks.PartitionFromPosition(lineEnd - 1);
+	size_t block = blockLast;
+	while (block != notFound) {
+		const Sci::Line start = BlockStart(block);
+		for (Sci::Line line = std::min(BlockStart(block + 1), lineEnd) - 1; line >= start; line--) {
+			if (Matches(levels.ValueAt(line), atMost, headers)) {
+				return line;
+			}
+		}
+		if (block != blockLast) {
+			// The block had a match
+			break;
+		}
+		block = SearchBackward(levels, atMost, headers, 1, 0, leafBase, 0, blockLast);
+	}
+	return -1;
+}
+
+size_t LevelIndex::Blocks() const noexcept {
+	return BlockCount();
+}
+
+LevelIndex *LineLevels::Index() const noexcept {
+	if (!index && (levels.Length() >= levelIndexMinimum)) {
+		try {
+			index = std::make_unique<LevelIndex>(levels.Length());
+		} catch (...) {
+			// Search line by line instead
+		}
+	}
+	return index.get();
+}
+
 void LineLevels::Init() {
 	levels.DeleteAll();
+	index.reset();
 }
 
 void LineLevels::InsertLine(Sci::Line line) {
 	if (levels.Length()) {
 		const int level = (line < levels.Length()) ? levels[line] : static_cast<int>(Scintilla::FoldLevel::Base);
 		levels.Insert(line, level);
+		if (index) {
+			index->InsertLines(line, 1);
+		}
 	}
 }
 
@@ -228,6 +484,9 @@ void LineLevels::InsertLines(Sci::Line line, Sci::Line lines) {
 	if (levels.Length()) {
 		const int level = (line < levels.Length()) ? levels[line] : static_cast<int>(Scintilla::FoldLevel::Base);
 		levels.InsertValue(line, lines, level);
+		if (index) {
+			index->InsertLines(line, lines);
+		}
 	}
 }
 
@@ -241,15 +500,25 @@ void LineLevels::RemoveLine(Sci::Line line) {
 			levels[line-1] &= ~static_cast<int>(Scintilla::FoldLevel::HeaderFlag);
 		else if (line > 0)
 			levels[line-1] |= firstHeader;
+		if (index) {
+			index->RemoveLine(line);
+			index->Invalidate(line - 1);
+		}
 	}
 }
 
+size_t LineLevels::MemoryUsage() const noexcept {
+	return levels.MemoryUsage();
+}
+
 void LineLevels::ExpandLevels(Sci::Line sizeNew) {
+	index.reset();
 	levels.InsertValue(levels.Length(), sizeNew - levels.Length(), static_cast<int>(Scintilla::FoldLevel::Base));
 }
 
 void LineLevels::ClearLevels() {
 	levels.DeleteAll();
+	index.reset();
 }
 
 int LineLevels::SetLevel(Sci::Line line, int level, Sci::Line lines) {
@@ -260,6 +529,9 @@ int LineLevels::SetLevel(Sci::Line line, int level, Sci::Line lines) {
 		}
 		prev = levels[line];
 		levels[line] = level;
+		if (index && (prev != level)) {
+			index->Invalidate(line);
+		}
 	}
 	return prev;
 }
@@ -280,6 +552,9 @@ Scintilla::FoldLevel LineLevels::GetFoldLevel(Sci::Line line) const noexcept {
 
 Sci::Line LineLevels::GetFoldParent(Sci::Line line) const noexcept {
 	const FoldLevel level = LevelNumberPart(GetFoldLevel(line));
+	if (LevelIndex *levelIndex = Index()) {
+		return levelIndex->FindBackward(levels, line, static_cast<int>(level) - 1, true);
+	}
 	for (Sci::Line lineLook = line - 1; lineLook >= 0; lineLook--) {
 		const FoldLevel levelTry = GetFoldLevel(lineLook);
 		if (LevelIsHeader(levelTry) && LevelNumberPart(levelTry) < level) {
@@ -289,6 +564,28 @@ Sci::Line LineLevels::GetFoldParent(Sci::Line line) const noexcept {
 	return -1;
 }
 
+Sci::Line LineLevels::NextLevelAtMost(Sci::Line lineStart, Sci::Line lineEnd, int level) const noexcept {
+	if (LevelIndex *levelIndex = Index()) {
+		// Lines past the levels are at the base level so only the ones before are indexed
+		const Sci::Line lineIndexed = std::min(lineEnd, levels.Length());
+		const Sci::Line found = levelIndex->FindForward(levels, lineStart, lineIndexed, level, false);
+		if (found >= 0) {
+			return found;
+		}
+		lineStart = std::max(lineStart, lineIndexed);
+	}
+	for (Sci::Line line = lineStart; line < lineEnd; line++) {
+		if (LevelIndex::Matches(GetLevel(line), level, false)) {
+			return line;
+		}
+	}
+	return -1;
+}
+
+bool LineLevels::Indexed() const noexcept {
+	return Index() != nullptr;
+}
+
 void LineState::Init() {
 	lineStates.DeleteAll();
 }
@@ -315,6 +612,10 @@ void LineState::RemoveLine(Sci::Line line) {
 	}
 }
 
+size_t LineState::MemoryUsage() const noexcept {
+	return lineStates.MemoryUsage();
+}
+
 int LineState::SetLineState(Sci::Line line, int state, Sci::Line lines) {
 	int stateOld = state;
 	if ((line >= 0) && (line < lines)) {
@@ -389,6 +690,17 @@ void LineAnnotation::RemoveLine(Sci::Line line) {
 	}
 }
 
+size_t LineAnnotation::MemoryUsage() const noexcept {
+	size_t usage = annotations.MemoryUsage();
+	for (Sci::Line line = 0; line < annotations.Length(); line++) {
+		if (annotations[line]) {
+			const size_t length = Length(line);
+			usage += sizeof(AnnotationHeader) + length + (MultipleStyles(line) ? length : 0);
+		}
+	}
+	return usage;
+}
+
 bool LineAnnotation::MultipleStyles(Sci::Line line) const noexcept {
 	if (annotations.Length() && (line >= 0) && (line < annotations.Length()) && annotations[line])
 		return reinterpret_cast<AnnotationHeader *>(annotations[line].get())->style == IndividualStyles;
@@ -509,6 +821,16 @@ void LineTabstops::RemoveLine(Sci::Line line) {
 	}
 }
 
+size_t LineTabstops::MemoryUsage() const noexcept {
+	size_t usage = tabstops.MemoryUsage();
+	for (Sci::Line line = 0; line < tabstops.Length(); line++) {
+		if (tabstops[line]) {
+			usage += sizeof(TabstopList) + tabstops[line]->capacity() * sizeof(int);
+		}
+	}
+	return usage;
+}
+
 bool LineTabstops::ClearTabstops(Sci::Line line) noexcept {
 	if (line < tabstops.Length()) {
 		TabstopList *tl = tabstops[line].get();
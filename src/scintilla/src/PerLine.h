@@ -36,6 +36,7 @@ public:
 	bool RemoveNumber(int markerNum, bool all);
 	void CombineWith(MarkerHandleSet *other) noexcept;
 	MarkerHandleNumber const *GetMarkerHandleNumber(int which) const noexcept;
+	size_t MemoryUsage() const noexcept;
 };
 
 class LineMarkers : public PerLine {
@@ -49,6 +50,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	int MarkValue(Sci::Line line) const noexcept;
 	Sci::Line MarkerNext(Sci::Line lineStart, int mask) const noexcept;
@@ -61,8 +63,58 @@ public:
 	int NumberFromLine(Sci::Line line, int which) const noexcept;
 };
 
+/**
+ * Summaries of the fold levels of blocks of lines combined in segment trees so that the end of a
+ * fold and the parent of a line are found without looking at every line in between.
+ * Summaries are made on demand and kept until a line in their block changes.
+ */
+class LevelIndex {
+	struct Summary {
+		// Lowest level number of the lines that are not whitespace
+		int minLevel;
+		// Lowest level number of the header lines
+		int minHeader;
+	};
+	Partitioning<Sci::Line> blocks;
+	std::vector<Summary> leaves;
+	std::vector<bool> leafValid;
+	// Inner nodes from root 1. Node leafBase + n is leaf n.
+	std::vector<Summary> nodes;
+	std::vector<bool> nodeValid;
+	size_t leafBase = 1;
+
+	size_t BlockCount() const noexcept;
+	Sci::Line BlockStart(size_t block) const noexcept;
+	void Reset();
+	void InvalidateBlock(size_t block) noexcept;
+	Summary Summarise(const SplitVector<int> &levels, size_t block) const noexcept;
+	const Summary &Node(const SplitVector<int> &levels, size_t node) noexcept;
+	size_t SearchForward(const SplitVector<int> &levels, int level, bool headers, size_t node, size_t lo, size_t hi, size_t first, size_t last) noexcept;
+	size_t SearchBackward(const SplitVector<int> &levels, int level, bool headers, size_t node, size_t lo, size_t hi, size_t first, size_t last) noexcept;
+
+public:
+	static constexpr Sci::Line blockSize = 0x400;
+	static constexpr size_t notFound = static_cast<size_t>(-1);
+
+	explicit LevelIndex(Sci::Line lines);
+
+	/// Does the level pass a search for headers or for lines that are not whitespace at or below level?
+	static bool Matches(int level, int atMost, bool headers) noexcept;
+	void InsertLines(Sci::Line line, Sci::Line lines);
+	void RemoveLine(Sci::Line line);
+	void Invalidate(Sci::Line line) noexcept;
+	/// First line in [lineStart, lineEnd) that matches or -1.
+	Sci::Line FindForward(const SplitVector<int> &levels, Sci::Line lineStart, Sci::Line lineEnd, int atMost, bool headers) noexcept;
+	/// Last line before lineEnd that matches or -1.
+	Sci::Line FindBackward(const SplitVector<int> &levels, Sci::Line lineEnd, int atMost, bool headers) noexcept;
+	size_t Blocks() const noexcept;
+};
+
 class LineLevels : public PerLine {
 	SplitVector<int> levels;
+	// Made when a document with many lines is first searched
+	mutable std::unique_ptr<LevelIndex> index;
+	LevelIndex *Index() const noexcept;
 public:
 	LineLevels() {
 	}
@@ -70,6 +122,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	void ExpandLevels(Sci::Line sizeNew=-1);
 	void ClearLevels();
@@ -77,6 +130,9 @@ public:
 	int GetLevel(Sci::Line line) const noexcept;
 	FoldLevel GetFoldLevel(Sci::Line line) const noexcept;
 	Sci::Line GetFoldParent(Sci::Line line) const noexcept;
+	/// First line in [lineStart, lineEnd) that is not whitespace and has a level number of at most level or -1.
+	Sci::Line NextLevelAtMost(Sci::Line lineStart, Sci::Line lineEnd, int level) const noexcept;
+	bool Indexed() const noexcept;
 };
 
 class LineState : public PerLine {
@@ -88,6 +144,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	int SetLineState(Sci::Line line, int state, Sci::Line lines);
 	int GetLineState(Sci::Line line);
@@ -105,6 +162,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	bool MultipleStyles(Sci::Line line) const noexcept;
 	int Style(Sci::Line line) const noexcept;
@@ -129,6 +187,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	bool ClearTabstops(Sci::Line line) noexcept;
 	bool AddTabstop(Sci::Line line, int x);
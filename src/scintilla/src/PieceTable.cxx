@@ -0,0 +1,362 @@
+// Scintilla source code edit control
+/** @file PieceTable.cxx
+ ** Holds the text of a document as a sequence of pieces of unchanging text.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+#include "ILoader.h"
+
+#include "Debugging.h"
+
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "PieceTable.h"
+
+using namespace Scintilla::Internal;
+
+namespace {
+
+// Small additions such as typing share blocks of this size
+constexpr size_t blockSize = 0x10000;
+
+}
+
+PieceTable::PieceTable() : pieces(16) {
+	pieces.Insert(0, nullptr);
+}
+
+PieceTable::~PieceTable() noexcept {
+	if (original) {
+		original->Release();
+	}
+}
+
+char *PieceTable::Allocate(size_t length) {
+	if (length > (blockAllocated - blockUsed)) {
+		// Text that would fill much of a block gets its own allocation so the current block
+		// can still be used. Each allocation has a spare byte at its end so text from
+		// different allocations is never contiguous and there is room for a NUL.
+		const bool separate = length >= (blockSize / 2);
+		const size_t size = separate ? length : blockSize;
+		std::unique_ptr<char[]> allocation(new char[size + 1]);
+		char *start = allocation.get();
+		blocks.push_back(std::move(allocation));
+		storedMemory += size + 1;
+		if (separate) {
+			return start;
+		}
+		block = start;
+		blockAllocated = size;
+		blockUsed = 0;
+	}
+	char *start = block + blockUsed;
+	blockUsed += length;
+	return start;
+}
+
+const char *PieceTable::PieceEnd(Sci::Position piece) const noexcept {
+	return pieces.ValueAt(piece) + (starts.PositionFromPartition(piece + 1) - starts.PositionFromPartition(piece));
+}
+
+bool PieceTable::Contiguous(Sci::Position piece) const noexcept {
+	// Whether piece continues on in memory from the piece before it
+	if ((piece <= 0) || (piece >= Pieces())) {
+		return false;
+	}
+	const char *endPrevious = PieceEnd(piece - 1);
+	return (endPrevious == pieces.ValueAt(piece)) && (endPrevious != originalText.data() + originalText.length());
+}
+
+Sci::Position PieceTable::Split(Sci::Position position) {
+	// Ensure a piece starts at position and return that piece
+	if (position >= Length()) {
+		return Pieces();
+	}
+	const Sci::Position piece = starts.PartitionFromPosition(position);
+	const Sci::Position start = starts.PositionFromPartition(piece);
+	if (start == position) {
+		return piece;
+	}
+	pieces.Insert(piece + 1, pieces.ValueAt(piece) + (position - start));
+	starts.InsertPartition(piece + 1, position);
+	return piece + 1;
+}
+
+void PieceTable::Join(Sci::Position piece) {
+	if (Contiguous(piece)) {
+		starts.RemovePartition(piece);
+		pieces.Delete(piece);
+	}
+}
+
+void PieceTable::Merge(Sci::Position first, Sci::Position last, const char *text) {
+	// Replace the pieces from first up to last with a single piece starting at text
+	for (Sci::Position piece = first + 1; piece < last; piece++) {
+		starts.RemovePartition(first + 1);
+	}
+	pieces.DeleteRange(first + 1, last - first - 1);
+	pieces.SetValueAt(first, text);
+}
+
+void PieceTable::DropCopies() noexcept {
+	bufferCopy.reset();
+	rangeCopy.reset();
+	copiedMemory = 0;
+}
+
+bool PieceTable::SetOriginal(Scintilla::IMappedText *text) noexcept {
+	if (original || !text) {
+		return false;
+	}
+	original = text;
+	originalText = std::string_view(text->Data(), text->Length());
+	return true;
+}
+
+std::string_view PieceTable::OriginalText() const noexcept {
+	return originalText;
+}
+
+const char *PieceTable::DetachOriginal() {
+	if (!original) {
+		return nullptr;
+	}
+	const size_t length = originalText.length();
+	std::unique_ptr<char[]> allocation(new char[length + 1]);
+	char *copy = allocation.get();
+	memcpy(copy, originalText.data(), length);
+	blocks.push_back(std::move(allocation));
+	storedMemory += length + 1;
+	// Compared as addresses as pieces point into different allocations
+	const uintptr_t originalStart = reinterpret_cast<uintptr_t>(originalText.data());
+	for (Sci::Position piece = 0; piece < Pieces(); piece++) {
+		const uintptr_t address = reinterpret_cast<uintptr_t>(pieces.ValueAt(piece));
+		if (pieces.ValueAt(piece) && (address >= originalStart) && (address <= originalStart + length)) {
+			pieces.SetValueAt(piece, copy + (address - originalStart));
+		}
+	}
+	original->Release();
+	original = nullptr;
+	originalText = {};
+	return copy;
+}
+
+const char *PieceTable::Store(const char *s, Sci::Position length) {
+	if (length <= 0) {
+		return s;
+	}
+	if (!originalText.empty()) {
+		const uintptr_t address = reinterpret_cast<uintptr_t>(s);
+		const uintptr_t originalStart = reinterpret_cast<uintptr_t>(originalText.data());
+		if ((address >= originalStart) && (address + length <= originalStart + originalText.length())) {
+			return s;
+		}
+	}
+	char *text = Allocate(length);
+	memcpy(text, s, length);
+	return text;
+}
+
+Sci::Position PieceTable::Length() const noexcept {
+	return starts.Length();
+}
+
+char PieceTable::ValueAt(Sci::Position position) const noexcept {
+	if ((position < 0) || (position >= Length())) {
+		return 0;
+	}
+	const Sci::Position piece = starts.PartitionFromPosition(position);
+	return pieces.ValueAt(piece)[position - starts.PositionFromPartition(piece)];
+}
+
+void PieceTable::GetRange(char *buffer, Sci::Position position, Sci::Position retrieveLength) const noexcept {
+	while (retrieveLength > 0) {
+		const std::string_view segment = SegmentAt(position);
+		const Sci::Position lengthCopy = std::min<Sci::Position>(retrieveLength, segment.length());
+		if (lengthCopy <= 0) {
+			return;
+		}
+		memcpy(buffer, segment.data(), lengthCopy);
+		buffer += lengthCopy;
+		position += lengthCopy;
+		retrieveLength -= lengthCopy;
+	}
+}
+
+std::string_view PieceTable::SegmentAt(Sci::Position position) const noexcept {
+	if ((position < 0) || (position >= Length())) {
+		return {};
+	}
+	const Sci::Position piece = starts.PartitionFromPosition(position);
+	const Sci::Position start = starts.PositionFromPartition(piece);
+	const Sci::Position end = starts.PositionFromPartition(piece + 1);
+	return std::string_view(pieces.ValueAt(piece) + (position - start), end - position);
+}
+
+void PieceTable::Insert(Sci::Position position, const char *s, Sci::Position insertLength) {
+	if (insertLength <= 0) {
+		return;
+	}
+	PLATFORM_ASSERT(position >= 0 && position <= Length());
+	DropCopies();
+	if (Length() == 0) {
+		pieces.SetValueAt(0, s);
+		starts.InsertText(0, insertLength);
+		return;
+	}
+	const Sci::Position piece = Split(position);
+	pieces.Insert(piece, s);
+	starts.InsertPartition(piece, position);
+	starts.InsertText(piece, insertLength);
+	// Undo and redo put back text that was next to its neighbours so the pieces can be rejoined.
+	// Typing is appended to the same block so extends the piece before.
+	Join(piece + 1);
+	Join(piece);
+}
+
+void PieceTable::DeleteRange(Sci::Position position, Sci::Position deleteLength) {
+	if (deleteLength <= 0) {
+		return;
+	}
+	PLATFORM_ASSERT(position >= 0 && position + deleteLength <= Length());
+	DropCopies();
+	if ((position == 0) && (deleteLength == Length())) {
+		starts.DeleteAll();
+		pieces.DeleteAll();
+		pieces.Insert(0, nullptr);
+		return;
+	}
+	const Sci::Position first = Split(position);
+	const Sci::Position last = Split(position + deleteLength);
+	// Combine the deleted pieces into one, shrink that to nothing, then remove it
+	Merge(first, last, pieces.ValueAt(first));
+	starts.InsertText(first, -deleteLength);
+	starts.RemovePartition(first + 1);
+	pieces.Delete(first);
+	Join(first);
+}
+
+const char *PieceTable::StoreRange(Sci::Position position, Sci::Position rangeLength) {
+	const std::string_view segment = SegmentAt(position);
+	if (static_cast<Sci::Position>(segment.length()) >= rangeLength) {
+		return segment.empty() ? "" : segment.data();
+	}
+	char *text = Allocate(rangeLength);
+	GetRange(text, position, rangeLength);
+	return text;
+}
+
+const char *PieceTable::RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept {
+	if ((position < 0) || (rangeLength < 0) || (position + rangeLength > Length())) {
+		return nullptr;
+	}
+	const std::string_view segment = SegmentAt(position);
+	if (static_cast<Sci::Position>(segment.length()) >= rangeLength) {
+		return segment.empty() ? "" : segment.data();
+	}
+	if (bufferCopy) {
+		return bufferCopy.get() + position;
+	}
+	try {
+		rangeCopy.reset();
+		copiedMemory = 0;
+		rangeCopy.reset(new char[rangeLength]);
+		copiedMemory = rangeLength;
+		GetRange(rangeCopy.get(), position, rangeLength);
+		return rangeCopy.get();
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+const char *PieceTable::BufferPointer() {
+	const Sci::Position length = Length();
+	if (length == 0) {
+		return "";
+	}
+	if (!bufferCopy) {
+		// A whole copy serves any range so a range copy is no longer needed
+		DropCopies();
+		bufferCopy.reset(new char[length + 1]);
+		copiedMemory = length + 1;
+		GetRange(bufferCopy.get(), 0, length);
+		bufferCopy[length] = '\0';
+	}
+	return bufferCopy.get();
+}
+
+Sci::Position PieceTable::Pieces() const noexcept {
+	return pieces.Length();
+}
+
+Sci::Position PieceTable::PieceFromPosition(Sci::Position position) const noexcept {
+	return starts.PartitionFromPosition(position);
+}
+
+Sci::Position PieceTable::PieceStart(Sci::Position piece) const noexcept {
+	return starts.PositionFromPartition(piece);
+}
+
+const char *PieceTable::PieceText(Sci::Position piece) const noexcept {
+	return pieces.ValueAt(piece);
+}
+
+size_t PieceTable::MemoryUsage() const noexcept {
+	// The original text belongs to the application so is not counted
+	return storedMemory + copiedMemory + blocks.capacity() * sizeof(blocks[0]) + starts.MemoryUsage() + pieces.MemoryUsage();
+}
+
+PieceView::PieceView(const PieceTable &table_) noexcept : table(&table_) {
+}
+
+void PieceView::Locate(Sci::Position position) const noexcept {
+	if ((position < 0) || (position >= table->Length())) {
+		start = 0;
+		end = 0;
+		text = nullptr;
+		return;
+	}
+	const Sci::Position piece = table->PieceFromPosition(position);
+	start = table->PieceStart(piece);
+	end = table->PieceStart(piece + 1);
+	text = table->PieceText(piece);
+}
+
+Sci::Position PieceView::FindChar(Sci::Position position, Sci::Position length, int ch) const noexcept {
+	const Sci::Position limit = position + length;
+	while (position < limit) {
+		if ((position < start) || (position >= end)) {
+			Locate(position);
+			if ((position < start) || (position >= end)) {
+				return -1;
+			}
+		}
+		const Sci::Position lengthRun = std::min(limit, end) - position;
+		const char *match = static_cast<const char *>(memchr(text + (position - start), ch, lengthRun));
+		if (match) {
+			return start + (match - text);
+		}
+		position += lengthRun;
+	}
+	return -1;
+}
+
+bool PieceView::Match(Sci::Position position, std::string_view sv) const noexcept {
+	for (size_t i = 0; i < sv.length(); i++) {
+		if (CharAt(position + i) != sv[i]) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,122 @@
+// Scintilla source code edit control
+/** @file PieceTable.h
+ ** Holds the text of a document as a sequence of pieces of unchanging text.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+namespace Scintilla::Internal {
+
+/**
+ * A piece table holds the document as a list of pieces, each a pointer to text that never moves
+ * or changes. The text is either the original text supplied by the application, often a memory
+ * mapped file, or text appended to blocks that are only ever added to. Insertions and deletions
+ * only split and join pieces so huge documents load without copying and undo can refer to the
+ * text of pieces instead of saving its own copy.
+ */
+class PieceTable {
+	Scintilla::IMappedText *original = nullptr;
+	std::string_view originalText;
+	std::vector<std::unique_ptr<char[]>> blocks;
+	char *block = nullptr;	// Block that small additions are appended to
+	size_t blockAllocated = 0;
+	size_t blockUsed = 0;
+	size_t storedMemory = 0;
+	// The pieces are separated by the partitions and piece n starts at pieces[n].
+	// An empty table has one empty piece.
+	Partitioning<Sci::Position> starts;
+	SplitVector<const char *> pieces;
+	// Contiguous copies handed out by BufferPointer and RangePointer. They are not part of the pieces
+	// so they are freed by the next change instead of adding up.
+	std::unique_ptr<char[]> bufferCopy;
+	std::unique_ptr<char[]> rangeCopy;
+	size_t copiedMemory = 0;
+
+	char *Allocate(size_t length);
+	const char *PieceEnd(Sci::Position piece) const noexcept;
+	bool Contiguous(Sci::Position piece) const noexcept;
+	Sci::Position Split(Sci::Position position);
+	void Join(Sci::Position piece);
+	void Merge(Sci::Position first, Sci::Position last, const char *text);
+	void DropCopies() noexcept;
+
+public:
+	PieceTable();
+	// Deleted so PieceTable objects can not be copied.
+	PieceTable(const PieceTable &) = delete;
+	PieceTable(PieceTable &&) = delete;
+	PieceTable &operator=(const PieceTable &) = delete;
+	PieceTable &operator=(PieceTable &&) = delete;
+	~PieceTable() noexcept;
+
+	/// Take ownership of text that following insertions may refer to without copying.
+	/// Only possible while no original text has been set.
+	bool SetOriginal(Scintilla::IMappedText *text) noexcept;
+	/// Copy text to the add blocks, unless it is already part of the original text, and
+	/// return a pointer that stays valid for the life of the table.
+	const char *Store(const char *s, Sci::Position length);
+	/// The text set by SetOriginal, empty if there is none.
+	std::string_view OriginalText() const noexcept;
+	/// Copy the original text to the add blocks so it can be released. Returns the copy, which
+	/// anything else referring to the original text should be moved to, or nullptr if there was
+	/// no original text.
+	const char *DetachOriginal();
+
+	Sci::Position Length() const noexcept;
+	char ValueAt(Sci::Position position) const noexcept;
+	void GetRange(char *buffer, Sci::Position position, Sci::Position retrieveLength) const noexcept;
+	/// Contiguous text from position to the end of its piece.
+	std::string_view SegmentAt(Sci::Position position) const noexcept;
+
+	/// Insert text that has been returned by Store so it is only referred to.
+	void Insert(Sci::Position position, const char *s, Sci::Position insertLength);
+	void DeleteRange(Sci::Position position, Sci::Position deleteLength);
+
+	/// Text of a range that stays valid for the life of the table, such as for undo.
+	/// It is only copied when it spans pieces.
+	const char *StoreRange(Sci::Position position, Sci::Position rangeLength);
+
+	/// A range spanning pieces is copied to return it as contiguous text. The copy is valid until
+	/// the next change or call. Returns nullptr if memory for the copy can not be allocated.
+	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept;
+	/// A NUL terminated copy of all the text that is valid until the next change.
+	const char *BufferPointer();
+
+	Sci::Position Pieces() const noexcept;
+	Sci::Position PieceFromPosition(Sci::Position position) const noexcept;
+	Sci::Position PieceStart(Sci::Position piece) const noexcept;
+	const char *PieceText(Sci::Position piece) const noexcept;
+	size_t MemoryUsage() const noexcept;
+};
+
+/**
+ * Reads a piece table remembering the current piece so that runs of nearby positions do not
+ * search for their piece. Each thread should use its own view.
+ */
+class PieceView {
+	const PieceTable *table;
+	mutable Sci::Position start = 0;
+	mutable Sci::Position end = 0;
+	mutable const char *text = nullptr;
+	void Locate(Sci::Position position) const noexcept;
+public:
+	explicit PieceView(const PieceTable &table_) noexcept;
+	char CharAt(Sci::Position position) const noexcept {
+		if ((position < start) || (position >= end)) {
+			Locate(position);
+			if ((position < start) || (position >= end)) {
+				return 0;
+			}
+		}
+		return text[position - start];
+	}
+	// Equivalent of memchr over the pieces
+	Sci::Position FindChar(Sci::Position position, Sci::Position length, int ch) const noexcept;
+	bool Match(Sci::Position position, std::string_view sv) const noexcept;
+};
+
+}
+
+#endif
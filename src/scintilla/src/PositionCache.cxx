@@ -320,6 +320,17 @@ int LineLayout::EndLineStyle() const noexcept {
 	return styles[numCharsBeforeEOL > 0 ? numCharsBeforeEOL-1 : 0];
 }
 
+size_t LineLayout::MemoryUsage() const noexcept {
+	const size_t lineAllocation = maxLineLength + 1;
+	size_t usage = sizeof(LineLayout) + lineAllocation * 2 + (lineAllocation + 1) * sizeof(XYPOSITION) +
+		lenLineStarts * sizeof(int);
+	if (bidiData) {
+		usage += sizeof(BidiData) + bidiData->stylesFonts.capacity() * sizeof(std::shared_ptr<Font>) +
+			bidiData->widthReprs.capacity() * sizeof(XYPOSITION);
+	}
+	return usage;
+}
+
 void LineLayout::WrapLine(const Document *pdoc, Sci::Position posLineStart, Wrap wrapState, XYPOSITION wrapWidth) {
 	// Document wants document positions but simpler to work in line positions
 	// so take care of adding and subtracting line start in a lambda.
@@ -637,6 +648,16 @@ std::shared_ptr<LineLayout> LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci:
 	return std::make_shared<LineLayout>(lineNumber, maxChars);
 }
 
+size_t LineLayoutCache::MemoryUsage() const noexcept {
+	size_t usage = cache.capacity() * sizeof(std::shared_ptr<LineLayout>);
+	for (const std::shared_ptr<LineLayout> &ll : cache) {
+		if (ll) {
+			usage += ll->MemoryUsage();
+		}
+	}
+	return usage;
+}
+
 namespace {
 
 // Simply pack the (maximum 4) character bytes into an int
@@ -995,6 +1016,7 @@ public:
 	static size_t Hash(unsigned int styleNumber_, bool unicode_, std::string_view sv) noexcept;
 	[[nodiscard]] bool NewerThan(const PositionCacheEntry &other) const noexcept;
 	void ResetClock() noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
 };
 
 class PositionCache : public IPositionCache {
@@ -1015,6 +1037,7 @@ public:
 	void Clear() noexcept override;
 	void SetSize(size_t size_) override;
 	[[nodiscard]] size_t GetSize() const noexcept override;
+	[[nodiscard]] size_t MemoryUsage() const noexcept override;
 	void MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 		bool unicode, std::string_view sv, XYPOSITION *positions, bool needsLocking) override;
 };
@@ -1085,6 +1108,13 @@ void PositionCacheEntry::ResetClock() noexcept {
 	}
 }
 
+size_t PositionCacheEntry::MemoryUsage() const noexcept {
+	if (positions) {
+		return (len + (len / sizeof(XYPOSITION)) + 1) * sizeof(XYPOSITION);
+	}
+	return 0;
+}
+
 PositionCache::PositionCache() = default;
 
 void PositionCache::Clear() noexcept {
@@ -1106,6 +1136,16 @@ size_t PositionCache::GetSize() const noexcept {
 	return pces.size();
 }
 
+size_t PositionCache::MemoryUsage() const noexcept {
+	size_t usage = pces.capacity() * sizeof(PositionCacheEntry);
+	if (!allClear) {
+		for (const PositionCacheEntry &pce : pces) {
+			usage += pce.MemoryUsage();
+		}
+	}
+	return usage;
+}
+
 void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 	bool unicode, std::string_view sv, XYPOSITION *positions, bool needsLocking) {
 	const Style &style = vstyle.styles[styleNumber];
@@ -102,6 +102,7 @@ public:
 	Interval SpanByte(int index) const noexcept;
 	int EndLineStyle() const noexcept;
 	void WrapLine(const Document *pdoc, Sci::Position posLineStart, Wrap wrapState, XYPOSITION wrapWidth);
+	size_t MemoryUsage() const noexcept;
 };
 
 struct ScreenLine : public IScreenLine {
@@ -167,6 +168,7 @@ public:
 	Scintilla::LineCache GetLevel() const noexcept { return level; }
 	std::shared_ptr<LineLayout> Retrieve(Sci::Line lineNumber, Sci::Line lineCaret, int maxChars, int styleClock_,
 		Sci::Line linesOnScreen, Sci::Line linesInDoc);
+	size_t MemoryUsage() const noexcept;
 };
 
 class Representation {
@@ -262,6 +264,7 @@ public:
 	virtual void Clear() noexcept = 0;
 	virtual void SetSize(size_t size_) = 0;
 	virtual size_t GetSize() const noexcept = 0;
+	virtual size_t MemoryUsage() const noexcept = 0;
 	virtual void MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 		bool unicode, std::string_view sv, XYPOSITION *positions, bool needsLocking) = 0;
 };
@@ -290,6 +290,11 @@ DISTANCE RunStyles<DISTANCE, STYLE>::Find(STYLE value, DISTANCE start) const noe
 	return -1;
 }
 
+template <typename DISTANCE, typename STYLE>
+size_t RunStyles<DISTANCE, STYLE>::MemoryUsage() const noexcept {
+	return starts.MemoryUsage() + styles.MemoryUsage();
+}
+
 template <typename DISTANCE, typename STYLE>
 void RunStyles<DISTANCE, STYLE>::Check() const {
 	if (Length() < 0) {
@@ -49,6 +49,7 @@ public:
 	bool AllSame() const noexcept;
 	bool AllSameAs(STYLE value) const noexcept;
 	DISTANCE Find(STYLE value, DISTANCE start) const noexcept;
+	size_t MemoryUsage() const noexcept;
 
 	void Check() const;
 };
@@ -656,6 +656,7 @@ const char *LexState::DescribeWordListSets() {
 
 void LexState::SetWordList(int n, const char *wl) {
 	if (instance) {
+		StopBackground();
 		const Sci_Position firstModification = instance->WordListSet(n, wl);
 		if (firstModification >= 0) {
 			pdoc->ModifiedAt(firstModification);
@@ -679,6 +680,7 @@ const char *LexState::GetName() const {
 
 void *LexState::PrivateCall(int operation, void *pointer) {
 	if (instance) {
+		StopBackground();
 		return instance->PrivateCall(operation, pointer);
 	}
 	return nullptr;
@@ -707,6 +709,7 @@ const char *LexState::DescribeProperty(const char *name) {
 
 void LexState::PropSet(const char *key, const char *val) {
 	if (instance) {
+		StopBackground();
 		const Sci_Position firstModification = instance->PropertySet(key, val);
 		if (firstModification >= 0) {
 			pdoc->ModifiedAt(firstModification);
@@ -740,6 +743,7 @@ LineEndType LexState::LineEndTypesSupported() {
 
 int LexState::AllocateSubStyles(int styleBase, int numberStyles) {
 	if (instance) {
+		StopBackground();
 		return instance->AllocateSubStyles(styleBase, numberStyles);
 	}
 	return -1;
@@ -775,12 +779,14 @@ int LexState::PrimaryStyleFromStyle(int style) {
 
 void LexState::FreeSubStyles() {
 	if (instance) {
+		StopBackground();
 		instance->FreeSubStyles();
 	}
 }
 
 void LexState::SetIdentifiers(int style, const char *identifiers) {
 	if (instance) {
+		StopBackground();
 		instance->SetIdentifiers(style, identifiers);
 		pdoc->ModifiedAt(0);
 	}
@@ -38,6 +38,10 @@ public:
 	Sci::Position PositionOfElement(Sci::Position element) const noexcept {
 		return starts.PositionFromPartition(element);
 	}
+	size_t MemoryUsage() const noexcept {
+		// Memory owned by the elements themselves is not included.
+		return starts.MemoryUsage() + values.MemoryUsage();
+	}
 	Sci::Position ElementFromPosition(Sci::Position position) const noexcept {
 		if (position < Length()) {
 			return starts.PartitionFromPosition(position);
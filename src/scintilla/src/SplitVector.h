@@ -166,6 +166,11 @@ public:
 		return lengthBody;
 	}
 
+	/// Retrieve the number of bytes allocated for the buffer including the gap.
+	size_t MemoryUsage() const noexcept {
+		return body.capacity() * sizeof(T);
+	}
+
 	/// Insert a single value into the buffer.
 	/// Inserting at positions outside the current range fails.
 	void Insert(ptrdiff_t position, T v) {
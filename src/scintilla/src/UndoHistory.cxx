@@ -15,6 +15,7 @@
 #include <climits>
 
 #include <stdexcept>
+#include <new>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -184,18 +185,82 @@ Sci::Position UndoActions::Length(int action) const noexcept {
 	return lengths.SignedValueAt(action);
 }
 
+// Temporary file holding the oldest undo text
+struct SpillFile {
+	FILE *fp = nullptr;
+	SpillFile() noexcept : fp(std::tmpfile()) {
+	}
+	// Deleted so SpillFile objects can not be copied.
+	SpillFile(const SpillFile &) = delete;
+	SpillFile(SpillFile &&) = delete;
+	SpillFile &operator=(const SpillFile &) = delete;
+	SpillFile &operator=(SpillFile &&) = delete;
+	~SpillFile() noexcept {
+		if (fp) {
+			fclose(fp);
+		}
+	}
+	bool Seek(size_t position) const noexcept {
+#if defined(_WIN32)
+		return _fseeki64(fp, static_cast<__int64>(position), SEEK_SET) == 0;
+#else
+		return fseeko(fp, static_cast<off_t>(position), SEEK_SET) == 0;
+#endif
+	}
+	bool Write(size_t position, const char *data, size_t length) const noexcept {
+		return fp && Seek(position) && (fwrite(data, 1, length, fp) == length);
+	}
+	bool Read(size_t position, char *data, size_t length) const noexcept {
+		return fp && Seek(position) && (fread(data, 1, length, fp) == length);
+	}
+};
+
+ScrapStack::ScrapStack() noexcept = default;
+
+ScrapStack::~ScrapStack() noexcept = default;
+
 void ScrapStack::Clear() noexcept {
-	stack.clear();
+	// Assign rather than clear so the memory is released
+	stack = std::string();
 	current = 0;
+	base = 0;
+	spilled = 0;
+	spill.reset();
+}
+
+void ScrapStack::SpillTo(size_t position) {
+	if (position <= base) {
+		return;
+	}
+	if (!spill) {
+		spill = std::make_unique<SpillFile>();
+	}
+	// Only text that is not already in the file needs to be written
+	if (spilled < position) {
+		if (!spill->Write(spilled, stack.data() + spilled - base, position - spilled)) {
+			// No room for it on disk so keep it in memory
+			return;
+		}
+		spilled = position;
+	}
+	stack.erase(0, position - base);
+	base = position;
+	stack.shrink_to_fit();
 }
 
 const char *ScrapStack::Push(const char *text, size_t length) {
-	if (current < stack.length()) {
-		stack.resize(current);
+	if (current < base + stack.length()) {
+		stack.resize(current - base);
+	}
+	// Anything in the spill file after current is being replaced
+	spilled = std::min(spilled, current);
+	if (limit && (stack.length() + length > limit)) {
+		// Keep the most recent half in memory so this doesn't happen on every push
+		SpillTo(current - std::min(stack.length(), limit / 2));
 	}
 	stack.append(text, length);
-	current = stack.length();
-	return stack.data() + current - length;
+	current = base + stack.length();
+	return stack.data() + stack.length() - length;
 }
 
 void ScrapStack::SetCurrent(size_t position) noexcept {
@@ -203,7 +268,7 @@ void ScrapStack::SetCurrent(size_t position) noexcept {
 }
 
 void ScrapStack::MoveForward(size_t length) noexcept {
-	if ((current + length) <= stack.length()) {
+	if ((current + length) <= (base + stack.length())) {
 		current += length;
 	}
 }
@@ -214,12 +279,54 @@ void ScrapStack::MoveBack(size_t length) noexcept {
 	}
 }
 
+size_t ScrapStack::Current() const noexcept {
+	return current;
+}
+
 const char *ScrapStack::CurrentText() const noexcept {
-	return stack.data() + current;
+	return stack.data() + current - base;
 }
 
 const char *ScrapStack::TextAt(size_t position) const noexcept {
-	return stack.data() + position;
+	return stack.data() + position - base;
+}
+
+bool ScrapStack::Load(size_t position) noexcept {
+	if (position >= base) {
+		return true;
+	}
+	if (!spill) {
+		return false;
+	}
+	// Undo tends to keep going back so read in at least half the limit at a time
+	size_t start = 0;
+	if (limit && (base > limit / 2)) {
+		start = std::min(position, base - limit / 2);
+	}
+	try {
+		std::string text(base - start, '\0');
+		if (!spill->Read(start, text.data(), text.length())) {
+			return false;
+		}
+		text.append(stack);
+		stack = std::move(text);
+		base = start;
+	} catch (const std::bad_alloc &) {
+		return false;
+	}
+	return true;
+}
+
+void ScrapStack::SetMemoryLimit(size_t limit_) noexcept {
+	limit = limit_;
+}
+
+size_t ScrapStack::MemoryLimit() const noexcept {
+	return limit;
+}
+
+size_t ScrapStack::MemoryUsage() const noexcept {
+	return stack.capacity();
 }
 
 // The undo history stores a sequence of user operations that represent the user's view of the
@@ -243,7 +350,14 @@ int UndoHistory::PreviousAction() const noexcept {
 	return currentAction - 1;
 }
 
-UndoHistory::UndoHistory() {
+void UndoHistory::SetText(int action, const char *text) {
+	if (texts.size() <= static_cast<size_t>(action)) {
+		texts.resize(action + 1);
+	}
+	texts[action] = text;
+}
+
+UndoHistory::UndoHistory(bool referenceText_) : referenceText(referenceText_) {
 	scraps = std::make_unique<ScrapStack>();
 }
 
@@ -320,13 +434,19 @@ const char *UndoHistory::AppendAction(ActionType at, Sci::Position position, con
 	if ((currentAction > 0) && startSequence) {
 		actions.types[PreviousAction()].mayCoalesce = false;
 	}
-	const char *dataNew = lengthData ? scraps->Push(data, lengthData) : nullptr;
+	const char *dataNew = nullptr;
+	if (lengthData) {
+		dataNew = referenceText ? data : scraps->Push(data, lengthData);
+	}
 	if (currentAction >= actions.SSize()) {
 		actions.PushBack();
 	} else {
 		actions.Truncate(currentAction+1);
 	}
 	actions.Create(currentAction, at, position, lengthData, mayCoalesce);
+	if (referenceText) {
+		SetText(currentAction, dataNew);
+	}
 	currentAction++;
 	return dataNew;
 }
@@ -372,6 +492,7 @@ void UndoHistory::DeleteUndoHistory() noexcept {
 	savePoint = 0;
 	tentativePoint = -1;
 	scraps->Clear();
+	texts.clear();
 	memory = {};
 }
 
@@ -379,6 +500,20 @@ int UndoHistory::Actions() const noexcept {
 	return static_cast<int>(actions.SSize());
 }
 
+void UndoHistory::SetMemoryLimit(size_t limit) noexcept {
+	scraps->SetMemoryLimit(limit);
+}
+
+size_t UndoHistory::MemoryLimit() const noexcept {
+	return scraps->MemoryLimit();
+}
+
+size_t UndoHistory::MemoryUsage() const noexcept {
+	return scraps->MemoryUsage() + texts.capacity() * sizeof(const char *) +
+		actions.types.capacity() * sizeof(UndoActionType) +
+		actions.positions.SizeInBytes() + actions.lengths.SizeInBytes();
+}
+
 void UndoHistory::SetSavePoint(int action) noexcept {
 	savePoint = action;
 }
@@ -468,6 +603,9 @@ void UndoHistory::SetCurrent(int action, intptr_t lengthDocument) {
 	// Find position in scraps for action
 	memory = {};
 	const size_t lengthSum = actions.LengthTo(action);
+	if (!scraps->Load(lengthSum)) {
+		throw std::runtime_error("UndoHistory::SetCurrent: undo text could not be read back.");
+	}
 	scraps->SetCurrent(lengthSum);
 	currentAction = action;
 	if (!Validate(lengthDocument)) {
@@ -496,6 +634,10 @@ Sci::Position UndoHistory::Length(int action) const noexcept {
 }
 
 std::string_view UndoHistory::Text(int action) noexcept {
+	if (referenceText) {
+		const size_t length = actions.Length(action);
+		return {length ? texts[action] : "", length};
+	}
 	// Assumes first call after any changes is for action 0.
 	// TODO: may need to invalidate memory in other circumstances
 	if (action == 0) {
@@ -511,6 +653,9 @@ std::string_view UndoHistory::Text(int action) noexcept {
 		position += actions.Length(act);
 	}
 	const size_t length = actions.Length(action);
+	if (!scraps->Load(position)) {
+		return {};
+	}
 	const char *scrap = scraps->TextAt(position);
 	memory = {action, position};
 	return {scrap, length};
@@ -525,7 +670,24 @@ void UndoHistory::PushUndoActionType(int type, Sci::Position position) {
 void UndoHistory::ChangeLastUndoActionText(size_t length, const char *text) {
 	assert(actions.lengths.ValueAt(actions.SSize()-1) == 0);
 	actions.lengths.SetValueAt(actions.SSize()-1, length);
-	scraps->Push(text, length);
+	if (referenceText) {
+		SetText(static_cast<int>(actions.SSize()-1), text);
+	} else {
+		scraps->Push(text, length);
+	}
+}
+
+void UndoHistory::RelocateText(const char *start, size_t length, const char *destination) noexcept {
+	if (!referenceText) {
+		return;
+	}
+	const uintptr_t startAddress = reinterpret_cast<uintptr_t>(start);
+	for (const char *&text : texts) {
+		const uintptr_t address = reinterpret_cast<uintptr_t>(text);
+		if (text && (address >= startAddress) && (address <= startAddress + length)) {
+			text = destination + (address - startAddress);
+		}
+	}
 }
 
 void UndoHistory::SetTentative(int action) noexcept {
@@ -561,7 +723,7 @@ bool UndoHistory::CanUndo() const noexcept {
 	return (currentAction > 0) && (actions.SSize() != 0);
 }
 
-int UndoHistory::StartUndo() const noexcept {
+int UndoHistory::StartUndo() noexcept {
 	assert(currentAction >= 0);
 
 	// Count the steps in this action
@@ -570,9 +732,16 @@ int UndoHistory::StartUndo() const noexcept {
 	}
 
 	int act = currentAction - 1;
+	size_t lengthSteps = actions.Length(act);
 
 	while (act > 0 && !actions.AtStart(act)) {
 		act--;
+		lengthSteps += actions.Length(act);
+	}
+
+	// The text of all the steps may have been spilled
+	if (!referenceText && !scraps->Load(scraps->Current() - lengthSteps)) {
+		return 0;
 	}
 	return currentAction - act;
 }
@@ -587,7 +756,7 @@ Action UndoHistory::GetUndoStep() const noexcept {
 		actions.Length(previousAction)
 	};
 	if (acta.lenData) {
-		acta.data = scraps->CurrentText() - acta.lenData;
+		acta.data = referenceText ? texts[previousAction] : scraps->CurrentText() - acta.lenData;
 	}
 	return acta;
 }
@@ -630,7 +799,7 @@ Action UndoHistory::GetRedoStep() const noexcept {
 		actions.Length(currentAction)
 	};
 	if (acta.lenData) {
-		acta.data = scraps->CurrentText();
+		acta.data = referenceText ? texts[currentAction] : scraps->CurrentText();
 	}
 	return acta;
 }
@@ -62,17 +62,41 @@ struct UndoActions {
 	[[nodiscard]] Sci::Position Length(int action) const noexcept;
 };
 
+struct SpillFile;
+
+// ScrapStack holds the text of all the undo actions. When a memory limit is set, the oldest text
+// is moved out to a temporary file and read back in when undo reaches it. All positions are
+// into the whole stack, not just the part held in memory.
+
 class ScrapStack {
-	std::string stack;
+	std::string stack;	// Text from base onwards
 	size_t current = 0;
+	size_t base = 0;	// Text before base is only in the spill file
+	size_t spilled = 0;	// Text before spilled in the spill file matches the stack
+	size_t limit = 0;	// Most text to hold in memory or 0 for no limit
+	std::unique_ptr<SpillFile> spill;
+	void SpillTo(size_t position);
 public:
+	ScrapStack() noexcept;
+	// Deleted so ScrapStack objects can not be copied.
+	ScrapStack(const ScrapStack &) = delete;
+	ScrapStack(ScrapStack &&) = delete;
+	ScrapStack &operator=(const ScrapStack &) = delete;
+	ScrapStack &operator=(ScrapStack &&) = delete;
+	~ScrapStack() noexcept;
 	void Clear() noexcept;
 	const char *Push(const char *text, size_t length);
 	void SetCurrent(size_t position) noexcept;
 	void MoveForward(size_t length) noexcept;
 	void MoveBack(size_t length) noexcept;
+	[[nodiscard]] size_t Current() const noexcept;
 	[[nodiscard]] const char *CurrentText() const noexcept;
 	[[nodiscard]] const char *TextAt(size_t position) const noexcept;
+	// Make sure text from position onwards is in memory, returns false if it can't be read back
+	bool Load(size_t position) noexcept;
+	void SetMemoryLimit(size_t limit_) noexcept;
+	[[nodiscard]] size_t MemoryLimit() const noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
 };
 
 constexpr int coalesceFlag = 0x100;
@@ -88,13 +112,17 @@ class UndoHistory {
 	int tentativePoint = -1;
 	std::optional<int> detach;	// Never set if savePoint set (>= 0)
 	std::unique_ptr<ScrapStack> scraps;
+	// When referring to text, each action points to text owned by the document instead of scraps
+	bool referenceText;
+	std::vector<const char *> texts;
 	struct actPos { int act; size_t position; };
 	std::optional<actPos> memory;
 
 	int PreviousAction() const noexcept;
+	void SetText(int action, const char *text);
 
 public:
-	UndoHistory();
+	explicit UndoHistory(bool referenceText_=false);
 	~UndoHistory() noexcept;
 
 	const char *AppendAction(ActionType at, Sci::Position position, const char *data, Sci::Position lengthData, bool &startSequence, bool mayCoalesce=true);
@@ -108,6 +136,11 @@ public:
 
 	[[nodiscard]] int Actions() const noexcept;
 
+	/// Limit the amount of undo text held in memory. Older text is moved out to a temporary file.
+	void SetMemoryLimit(size_t limit) noexcept;
+	[[nodiscard]] size_t MemoryLimit() const noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
+
 	/// The save point is a marker in the undo stack where the container has stated that
 	/// the buffer was saved. Undo and redo can move over the save point.
 	void SetSavePoint(int action) noexcept;
@@ -135,6 +168,9 @@ public:
 	[[nodiscard]] std::string_view Text(int action) noexcept;
 	void PushUndoActionType(int type, Sci::Position position);
 	void ChangeLastUndoActionText(size_t length, const char *text);
+	/// When referring to text, point actions that refer to the length bytes at start to the
+	/// same text at destination.
+	void RelocateText(const char *start, size_t length, const char *destination) noexcept;
 
 	// Tentative actions are used for input composition so that it can be undone cleanly
 	void SetTentative(int action) noexcept;
@@ -147,7 +183,7 @@ public:
 	/// To perform an undo, StartUndo is called to retrieve the number of steps, then UndoStep is
 	/// called that many times. Similarly for redo.
 	bool CanUndo() const noexcept;
-	int StartUndo() const noexcept;
+	int StartUndo() noexcept;
 	Action GetUndoStep() const noexcept;
 	void CompletedUndoStep() noexcept;
 	bool CanRedo() const noexcept;
@@ -439,6 +439,12 @@ void ViewStyle::Refresh(Surface &surface, int tabInChars) {
 	textStart = marginInside ? fixedColumnWidth : leftMarginWidth;
 }
 
+void ViewStyle::ClearFonts() noexcept {
+	for (Style &style : styles) {
+		style.Copy(nullptr, style);
+	}
+}
+
 void ViewStyle::ReleaseAllExtendedStyles() noexcept {
 	nextExtendedStyle = 256;
 }
@@ -199,6 +199,8 @@ public:
 	~ViewStyle();
 	void CalculateMarginWidthAndMask() noexcept;
 	void Refresh(Surface &surface, int tabInChars);
+	// Drops the fonts so a copy used on another thread can Refresh with fonts made there
+	void ClearFonts() noexcept;
 	void ReleaseAllExtendedStyles() noexcept;
 	int AllocateExtendedStyles(int numberStyles);
 	void EnsureStyle(size_t index);
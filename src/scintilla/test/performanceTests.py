@@ -58,6 +58,35 @@ class TestPerformance(unittest.TestCase):
 		self.xite.DoEvents()
 		self.assertTrue(self.ed.Length > 0)
 
+	def testHugeUnicodeLineEnds(self):
+		self.ed.SetCodePage(65001)
+		self.ed.SetLineEndTypesAllowed(1)
+		data = "Fold Margin=折りたたみ表示用の余白(&F)\u2028\r\n".encode('utf-8')
+		data = data * 100000
+		start = timer()
+		self.ed.AddText(len(data), data)
+		end = timer()
+		duration = end - start
+		print("%6.3f testHugeUnicodeLineEnds" % duration)
+		self.xite.DoEvents()
+		self.assertEqual(self.ed.LineCount, 200001)
+
+	def testHugeCharacterIndex(self):
+		self.ed.SetCodePage(65001)
+		oneLine = "Fold Margin=NagasakiOsakaHiroshimaHanedaKyoto(&F) 余白\n".encode('utf-8')
+		data = oneLine * 100000
+		self.ed.AddText(len(data), data)
+		start = timer()
+		self.ed.AllocateLineCharacterIndex(self.ed.SC_LINECHARACTERINDEX_UTF16)
+		for i in range(20):
+			count = self.ed.CountCharacters(0, self.ed.Length)
+			self.assertEqual(count, 53 * 100000)
+		end = timer()
+		duration = end - start
+		print("%6.3f testHugeCharacterIndex" % duration)
+		self.ed.ReleaseLineCharacterIndex(self.ed.SC_LINECHARACTERINDEX_UTF16)
+		self.xite.DoEvents()
+
 	def testHugeInserts(self):
 		data = (string.ascii_letters + string.digits + "\n").encode('utf-8')
 		data = data * 100000
@@ -12,6 +12,8 @@ CXXFLAGS = /MP /EHsc /std:c++17 $(OPTIMIZATION) /nologo /D_HAS_AUTO_PTR_ETC=1 /w
 TESTSRC=test*.cxx
 # Files being tested from scintilla/src directory
 TESTEDSRC=\
+ ../../src/BackgroundStyler.cxx \
+ ../../src/BraceIndex.cxx \
  ../../src/CaseConvert.cxx \
  ../../src/CaseFolder.cxx \
  ../../src/CellBuffer.cxx \
@@ -23,6 +25,7 @@ TESTEDSRC=\
  ../../src/Document.cxx \
  ../../src/Geometry.cxx \
  ../../src/PerLine.cxx \
+ ../../src/PieceTable.cxx \
  ../../src/RESearch.cxx \
  ../../src/RunStyles.cxx \
  ../../src/Selection.cxx \
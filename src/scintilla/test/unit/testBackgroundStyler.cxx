@@ -0,0 +1,329 @@
+/** @file testBackgroundStyler.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <future>
+
+#include "ScintillaTypes.h"
+
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "BackgroundStyler.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+// Test BackgroundStyler.
+
+namespace {
+
+// Styles digits as 1 and strings, which may continue over lines, as 2.
+// Line states hold brace depth which is used as the fold level.
+// With the lcLineStart checkpoint, strings end at line ends and depth is not carried over lines.
+class LexerNumbers final : public ILexer6 {
+	int checkpoint;
+	bool declare;
+public:
+	explicit LexerNumbers(int checkpoint_=lcLineState, bool declare_=false) noexcept :
+		checkpoint(checkpoint_), declare(declare_) {
+	}
+	int SCI_METHOD Version() const override {
+		return lvRelease6;
+	}
+	void SCI_METHOD Release() override {
+		delete this;
+	}
+	const char *SCI_METHOD PropertyNames() override {
+		return "";
+	}
+	int SCI_METHOD PropertyType(const char *) override {
+		return 0;
+	}
+	const char *SCI_METHOD DescribeProperty(const char *) override {
+		return "";
+	}
+	Sci_Position SCI_METHOD PropertySet(const char *, const char *) override {
+		return -1;
+	}
+	const char *SCI_METHOD DescribeWordListSets() override {
+		return "";
+	}
+	Sci_Position SCI_METHOD WordListSet(int, const char *) override {
+		return -1;
+	}
+	void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, IDocument *pAccess) override {
+		std::string text(lengthDoc, '\0');
+		pAccess->GetCharRange(text.data(), startPos, lengthDoc);
+		std::string styles(lengthDoc, '\0');
+		const bool lineStart = checkpoint == lcLineStart;
+		bool inString = !lineStart && (initStyle == 2);
+		Sci_Position line = pAccess->LineFromPosition(startPos);
+		int depth = (!lineStart && (line > 0)) ? pAccess->GetLineState(line - 1) : 0;
+		for (Sci_Position i = 0; i < lengthDoc; i++) {
+			const char ch = text[i];
+			if (inString) {
+				styles[i] = 2;
+				inString = ch != '"';
+			} else if (ch == '"') {
+				styles[i] = 2;
+				inString = true;
+			} else if (ch >= '0' && ch <= '9') {
+				styles[i] = 1;
+			}
+			if (ch == '{') {
+				depth++;
+			} else if ((ch == '}') && (depth > 0)) {
+				depth--;
+			}
+			if ((ch == '\n') || (i == lengthDoc - 1)) {
+				pAccess->SetLineState(line, depth);
+				line++;
+				if (lineStart) {
+					inString = false;
+					depth = 0;
+				}
+			}
+		}
+		pAccess->StartStyling(startPos);
+		pAccess->SetStyles(lengthDoc, styles.data());
+	}
+	void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int, IDocument *pAccess) override {
+		const Sci_Position lineLast = pAccess->LineFromPosition(startPos + lengthDoc - 1);
+		for (Sci_Position line = pAccess->LineFromPosition(startPos); line <= lineLast; line++) {
+			const int depth = (line > 0) ? pAccess->GetLineState(line - 1) : 0;
+			pAccess->SetLevel(line, static_cast<int>(FoldLevel::Base) + depth);
+		}
+	}
+	void *SCI_METHOD PrivateCall(int, void *) override {
+		return nullptr;
+	}
+	int SCI_METHOD LineEndTypesSupported() override {
+		return 0;
+	}
+	int SCI_METHOD AllocateSubStyles(int, int) override {
+		return -1;
+	}
+	int SCI_METHOD SubStylesStart(int) override {
+		return -1;
+	}
+	int SCI_METHOD SubStylesLength(int) override {
+		return 0;
+	}
+	int SCI_METHOD StyleFromSubStyle(int subStyle) override {
+		return subStyle;
+	}
+	int SCI_METHOD PrimaryStyleFromStyle(int style) override {
+		return style;
+	}
+	void SCI_METHOD FreeSubStyles() override {
+	}
+	void SCI_METHOD SetIdentifiers(int, const char *) override {
+	}
+	int SCI_METHOD DistanceToSecondaryStyles() override {
+		return 0;
+	}
+	const char *SCI_METHOD GetSubStyleBases() override {
+		return "";
+	}
+	int SCI_METHOD NamedStyles() override {
+		return 3;
+	}
+	const char *SCI_METHOD NameOfStyle(int) override {
+		return "";
+	}
+	const char *SCI_METHOD TagsOfStyle(int) override {
+		return "";
+	}
+	const char *SCI_METHOD DescriptionOfStyle(int) override {
+		return "";
+	}
+	const char *SCI_METHOD GetName() override {
+		return "numbers";
+	}
+	int SCI_METHOD GetIdentifier() override {
+		return 0;
+	}
+	const char *SCI_METHOD PropertyGet(const char *) override {
+		return "";
+	}
+	int SCI_METHOD Checkpoint() override {
+		return declare ? checkpoint : lcNone;
+	}
+};
+
+struct LexedDocument {
+	Document document;
+
+	explicit LexedDocument(std::string_view text, LexerNumbers *lexer=new LexerNumbers()) : document(DocumentOption::Default) {
+		document.InsertString(0, text);
+		document.SetLexInterface(std::make_unique<LexInterface>(&document));
+		document.GetLexInterface()->SetInstance(lexer);
+	}
+
+	void RequireSameState(const LexedDocument &other) const {
+		REQUIRE(Styles() == other.Styles());
+		for (Sci::Line line = 0; line < document.LinesTotal(); line++) {
+			REQUIRE(document.GetLevel(line) == other.document.GetLevel(line));
+			REQUIRE(document.GetLineState(line) == other.document.GetLineState(line));
+		}
+	}
+
+	std::string Styles() const {
+		std::string styles(document.Length(), '\0');
+		document.GetStyleRange(reinterpret_cast<unsigned char *>(styles.data()), 0, document.Length());
+		return styles;
+	}
+
+	void MergeUntilFinished() {
+		while (document.MergeBackgroundStyling()) {
+		}
+	}
+};
+
+std::string TestText(int repeats=30000) {
+	// Long enough to be lexed as several chunks
+	std::string text;
+	for (int i = 0; i < repeats; i++) {
+		text += "int a = 123;\n{\n\"string\ncontinues\" 45\n}\n";
+	}
+	return text;
+}
+
+}
+
+TEST_CASE("BackgroundStyler") {
+
+	const std::string text = TestText();
+	LexedDocument reference(text);
+	reference.document.EnsureStyledTo(reference.document.Length());
+	REQUIRE(reference.document.GetEndStyled() == reference.document.Length());
+
+	SECTION("MatchesMainThreadStyling") {
+		LexedDocument ld(text);
+		REQUIRE(ld.document.StyleInBackground(ld.document.Length()));
+		// A second request joins the job already running
+		REQUIRE(ld.document.StyleInBackground(ld.document.Length()));
+		ld.MergeUntilFinished();
+		REQUIRE(ld.document.GetEndStyled() == ld.document.Length());
+		ld.RequireSameState(reference);
+		// Nothing left to style
+		REQUIRE(!ld.document.StyleInBackground(ld.document.Length()));
+	}
+
+	SECTION("ContinuesFromEndStyled") {
+		LexedDocument ld(text);
+		const Sci::Position partStyled = ld.document.LineStart(1000);
+		ld.document.EnsureStyledTo(partStyled);
+		REQUIRE(ld.document.StyleInBackground(ld.document.Length()));
+		ld.MergeUntilFinished();
+		REQUIRE(ld.Styles() == reference.Styles());
+	}
+
+	SECTION("EnsureStyledStopsAndMerges") {
+		LexedDocument ld(text);
+		REQUIRE(ld.document.StyleInBackground(ld.document.Length()));
+		ld.document.EnsureStyledTo(ld.document.Length());
+		REQUIRE(!ld.document.MergeBackgroundStyling());
+		REQUIRE(ld.document.GetEndStyled() == ld.document.Length());
+		REQUIRE(ld.Styles() == reference.Styles());
+	}
+
+	SECTION("ShortRangesStyledDirectly") {
+		LexedDocument ld(text);
+		REQUIRE(!ld.document.StyleInBackground(10));
+		REQUIRE(!ld.document.MergeBackgroundStyling());
+	}
+
+	SECTION("ModificationDiscardsResults") {
+		LexedDocument ld(text);
+		REQUIRE(ld.document.StyleInBackground(ld.document.Length()));
+		ld.document.InsertString(0, "\"");
+		ld.MergeUntilFinished();
+		// Styles from before the change would all be wrong now so none are merged
+		REQUIRE(ld.document.GetEndStyled() == 0);
+		REQUIRE(ld.Styles() == std::string(ld.document.Length(), '\0'));
+		// Styling again produces the same result as the main thread
+		LexedDocument changed(std::string("\"") + text);
+		changed.document.EnsureStyledTo(changed.document.Length());
+		REQUIRE(ld.document.StyleInBackground(ld.document.Length()));
+		ld.MergeUntilFinished();
+		REQUIRE(ld.Styles() == changed.Styles());
+	}
+}
+
+TEST_CASE("ConcurrentStyler") {
+
+	// Long enough to be split into several pieces
+	const std::string text = TestText(150000);
+
+	SECTION("Pieces") {
+		LexedDocument ld(text);
+		const Sci::Position start = ld.document.LineStart(10);
+		ConcurrentStyler styler(ld.document, start, ld.document.Length(), 4);
+		REQUIRE(styler.Pieces() == 4);
+		REQUIRE(styler.PieceStart(0) == start);
+		for (size_t piece = 1; piece < styler.Pieces(); piece++) {
+			// Contiguous and split at line starts
+			REQUIRE(styler.PieceStart(piece) == styler.PieceEnd(piece - 1));
+			REQUIRE(styler.PieceStart(piece) == ld.document.LineStartPosition(styler.PieceStart(piece)));
+		}
+		REQUIRE(styler.PieceEnd(3) == ld.document.Length());
+	}
+
+	SECTION("LineStart") {
+		LexedDocument reference(text, new LexerNumbers(lcLineStart, false));
+		reference.document.EnsureStyledTo(reference.document.Length());
+		LexedDocument ld(text, new LexerNumbers(lcLineStart, true));
+		ld.document.EnsureStyledTo(ld.document.Length());
+		REQUIRE(ld.document.GetEndStyled() == ld.document.Length());
+		ld.RequireSameState(reference);
+	}
+
+	SECTION("LineState") {
+		// Pieces that start inside a string or braces are lexed again from the real state
+		LexedDocument reference(text, new LexerNumbers(lcLineState, false));
+		reference.document.EnsureStyledTo(reference.document.Length());
+		LexedDocument ld(text, new LexerNumbers(lcLineState, true));
+		ld.document.EnsureStyledTo(ld.document.Length());
+		REQUIRE(ld.document.GetEndStyled() == ld.document.Length());
+		ld.RequireSameState(reference);
+	}
+
+	SECTION("ContinuesFromEndStyled") {
+		LexedDocument reference(text, new LexerNumbers(lcLineState, false));
+		reference.document.EnsureStyledTo(reference.document.Length());
+		LexedDocument ld(text, new LexerNumbers(lcLineState, true));
+		ld.document.EnsureStyledTo(ld.document.LineStart(1002));
+		ld.document.EnsureStyledTo(ld.document.Length());
+		ld.RequireSameState(reference);
+	}
+}
@@ -0,0 +1,712 @@
+/** @file testBraceIndex.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <optional>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <atomic>
+#include <future>
+
+#include "ScintillaTypes.h"
+
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+
+#include "CharacterCategoryMap.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "BraceIndex.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+// Test BraceIndex.
+
+namespace {
+
+// Deterministic text of nested braces with filler between them. Braces left open are closed
+// at the end so many matches are far apart.
+std::string BraceText(size_t length, unsigned int seed) {
+	std::string text;
+	unsigned int state = seed;
+	int depth = 0;
+	while (text.length() < length) {
+		state = state * 1103515245 + 12345;
+		const unsigned int choice = (state >> 16) % 16;
+		if (choice == 0 || (choice == 1 && depth < 3)) {
+			text.push_back('{');
+			depth++;
+		} else if (choice == 2 && depth > 0) {
+			text.push_back('}');
+			depth--;
+		} else if (choice == 3) {
+			text.push_back('\n');
+		} else {
+			text.append("ab");
+		}
+	}
+	text.append(depth, '}');
+	return text;
+}
+
+// The same rules as Document::BraceMatch
+Sci::Position LinearMatch(const Document &document, Sci::Position position, Sci::Position start) {
+	const char chBrace = document.CharAt(position);
+	const char chSeek = (chBrace == '{') ? '}' : '{';
+	const int style = document.StyleIndexAt(position);
+	const int direction = (chBrace == '{') ? 1 : -1;
+	int depth = 1;
+	for (Sci::Position pos = start; (pos >= 0) && (pos < document.Length()); pos += direction) {
+		const char ch = document.CharAt(pos);
+		if ((ch == chBrace || ch == chSeek) && ((pos > document.GetEndStyled()) || (document.StyleIndexAt(pos) == style))) {
+			depth += (ch == chBrace) ? 1 : -1;
+			if (depth == 0)
+				return pos;
+		}
+	}
+	return -1;
+}
+
+// Check the braces of the index's style near the ends of the document, where matches are
+// furthest apart, and at a sample of positions between
+void CheckMatches(Document &document, BraceIndex &braceIndex, int style, Sci::Position step) {
+	const Sci::Position length = document.Length();
+	constexpr Sci::Position edge = 300;
+	for (Sci::Position position = 0; position < length;
+		position = (position < edge || position >= length - edge) ? position + 1 : std::min(position + step, length - edge)) {
+		const char ch = document.CharAt(position);
+		if ((ch == '{' || ch == '}') && (document.StyleIndexAt(position) == style)) {
+			const int direction = (ch == '{') ? 1 : -1;
+			const Sci::Position expected = LinearMatch(document, position, position + direction);
+			REQUIRE(braceIndex.Match(document, position, position + direction) == expected);
+		}
+	}
+}
+
+void StyleAll(Document &document, const std::string &styles) {
+	document.StartStyling(0);
+	document.SetStyles(styles.length(), styles.data());
+}
+
+// Deterministic markup of nested elements with the constructs whose contents are not tags, some
+// long enough to cross blocks. Elements left open are closed at the end.
+std::string MarkupText(size_t length, unsigned int seed, bool html) {
+	static const char *const names[] = { "a", "div", "Item", "br", "img", "script", "STYLE", "p" };
+	static const char *const others[] = {
+		"<!-- <a> </a> -->", "<![CDATA[ <a> ]] > ]]>", "<?pi <a> ?>", "<!DOCTYPE doc>", "a < b << c",
+		"<!-->", "<!>", "</>", "<x attr='<a>' other=\"/>\"/>", "<x>", "text\n",
+	};
+	std::string text;
+	unsigned int state = seed;
+	const auto next = [&state](unsigned int range) {
+		state = state * 1103515245 + 12345;
+		return (state >> 16) % range;
+	};
+	std::vector<std::string> open;
+	while (text.length() < length) {
+		const unsigned int choice = next(16);
+		if (choice < 5) {
+			const std::string name = names[next(std::size(names))];
+			text += "<" + name;
+			if (next(2)) {
+				text += " key=\"v>a</b>\"";
+			}
+			if (next(5) == 0) {
+				text += "/>";
+			} else {
+				text += ">";
+				if (html && (name == "script" || name == "STYLE")) {
+					text += "if (a<b && c</d) {} </scripted> </styles>";
+					text += "</" + name + " >";
+				} else {
+					open.push_back(name);
+				}
+			}
+		} else if (choice < 8 && !open.empty()) {
+			text += "</" + open.back() + ">";
+			open.pop_back();
+		} else if (choice == 8) {
+			const std::string filler(next(4) ? next(40) : next(TagIndex::blockSize), 'c');
+			text += "<!-- " + filler + " <p> -->";
+		} else if (choice == 9) {
+			text += std::string(next(300), 't');
+		} else {
+			text += others[next(std::size(others))];
+		}
+	}
+	while (!open.empty()) {
+		text += "</" + open.back() + ">";
+		open.pop_back();
+	}
+	return text;
+}
+
+bool NameStart(char ch) noexcept {
+	return std::isalpha(static_cast<unsigned char>(ch)) || ch == '_' || ch == ':' || static_cast<unsigned char>(ch) >= 0x80;
+}
+
+bool NameCharacter(char ch) noexcept {
+	return NameStart(ch) || std::isdigit(static_cast<unsigned char>(ch)) || ch == '-' || ch == '.';
+}
+
+// Does text at position start with the lower case name and not continue with a name character?
+bool StartsWithName(const std::string &text, size_t position, const std::string &name) {
+	for (size_t i = 0; i < name.length(); i++) {
+		if ((position + i >= text.length()) || (std::tolower(static_cast<unsigned char>(text[position + i])) != name[i])) {
+			return false;
+		}
+	}
+	return (position + name.length() >= text.length()) || !NameCharacter(text[position + name.length()]);
+}
+
+// Tags found by tokenizing the whole text
+std::vector<TagIndex::Tag> LinearTags(const std::string &text, bool html) {
+	static const std::string voidElements[] = {
+		"area", "base", "br", "col", "embed", "hr", "img", "input", "link", "meta", "source", "track", "wbr"
+	};
+	std::vector<TagIndex::Tag> tags;
+	size_t i = 0;
+	while (((i = text.find('<', i)) != std::string::npos) && (i + 1 < text.length())) {
+		const char chNext = text[i + 1];
+		size_t end = std::string::npos;
+		if (text.compare(i, 4, "<!--") == 0) {
+			end = text.find("-->", i + 2);
+			end = (end == std::string::npos) ? end : end + 2;
+		} else if (text.compare(i, 3, "<![") == 0) {
+			end = text.find("]]>", i + 3);
+			end = (end == std::string::npos) ? end : end + 2;
+		} else if (chNext == '!') {
+			end = text.find('>', i + 2);
+		} else if (chNext == '?') {
+			end = text.find("?>", i + 1);
+			end = (end == std::string::npos) ? end : end + 1;
+		} else if (chNext == '/') {
+			tags.push_back({ static_cast<Sci::Position>(i), -1 });
+			end = text.find('>', i + 2);
+		} else if (NameStart(chNext)) {
+			const bool empty = html && std::any_of(std::begin(voidElements), std::end(voidElements),
+				[&](const std::string &name) { return StartsWithName(text, i + 1, name); });
+			std::string raw;
+			if (html && StartsWithName(text, i + 1, "script")) {
+				raw = "script";
+			} else if (html && StartsWithName(text, i + 1, "style")) {
+				raw = "style";
+			}
+			if (!empty) {
+				tags.push_back({ static_cast<Sci::Position>(i), 1 });
+			}
+			end = i + 2;
+			while ((end < text.length()) && (text[end] != '>')) {
+				if (text[end] == '"' || text[end] == '\'') {
+					end = text.find(text[end], end + 1);
+					if (end == std::string::npos) {
+						break;
+					}
+				}
+				end++;
+			}
+			if (end >= text.length()) {
+				break;
+			}
+			if (!raw.empty()) {
+				// Text up to the end tag
+				size_t close = end;
+				while (((close = text.find("</", close)) != std::string::npos) && !StartsWithName(text, close + 2, raw)) {
+					close++;
+				}
+				if (close == std::string::npos) {
+					break;
+				}
+				tags.push_back({ static_cast<Sci::Position>(close), -1 });
+				end = text.find('>', close);
+			} else if (!empty && (text[end - 1] == '/')) {
+				tags.push_back({ static_cast<Sci::Position>(end - 1), -1 });
+			}
+		} else {
+			i++;
+			continue;
+		}
+		if (end == std::string::npos) {
+			break;
+		}
+		i = end + 1;
+	}
+	return tags;
+}
+
+// Check a sample of tags, including all near the ends of the document, against counting the tags
+// found by tokenizing
+void CheckTagMatches(Document &document, TagIndex &tagIndex, bool html, size_t step) {
+	std::string text(document.Length(), '\0');
+	document.GetCharRange(text.data(), 0, document.Length());
+	const std::vector<TagIndex::Tag> tags = LinearTags(text, html);
+	constexpr size_t edge = 30;
+	for (size_t t = 0; t < tags.size(); t = (t < edge || t + edge >= tags.size()) ? t + 1 : std::min(t + step, tags.size() - edge)) {
+		Sci::Position expected = -1;
+		int depth = 0;
+		const int direction = tags[t].delta;
+		for (size_t m = t; m < tags.size(); m += direction) {
+			depth += tags[m].delta * direction;
+			if (depth == 0) {
+				expected = tags[m].position;
+				break;
+			}
+		}
+		REQUIRE(tagIndex.Match(document, tags[t].position) == expected);
+	}
+}
+
+}
+
+TEST_CASE("BraceIndex") {
+
+	SECTION("FindEitherByte") {
+		REQUIRE(FindEitherByte("", '{', '}') == 0);
+		REQUIRE(FindEitherByte("abc", '{', '}') == 3);
+		REQUIRE(FindEitherByte("a}c", '{', '}') == 1);
+		const std::string text = std::string(40, 'a') + "{" + std::string(30, 'b') + "}";
+		REQUIRE(FindEitherByte(text, '{', '}') == 40);
+		REQUIRE(FindEitherByte(std::string_view(text).substr(41), '{', '}') == 30);
+		REQUIRE(FindEitherByte(std::string(100, 'a'), '{', '}') == 100);
+	}
+
+	SECTION("Blocks") {
+		Document doc(DocumentOption::Default);
+		const std::string text = BraceText(BraceIndex::blockSize * 5 + 100, 1);
+		doc.InsertString(0, text);
+		BraceIndex braceIndex(doc, '{', '}', 0);
+		REQUIRE(braceIndex.Blocks() == 6);
+		// Unstyled text counts braces of any style
+		REQUIRE(braceIndex.Pending(doc));
+		REQUIRE(braceIndex.Build(doc, BraceIndex::blockSize * 2));
+		REQUIRE(!braceIndex.Build(doc, BraceIndex::blockSize * 10));
+		// Styled blocks count braces of the style
+		StyleAll(doc, std::string(BraceIndex::blockSize * 2, '\0'));
+		REQUIRE(braceIndex.Pending(doc));
+		REQUIRE(!braceIndex.Build(doc, BraceIndex::blockSize * 2));
+		StyleAll(doc, std::string(text.length(), '\0'));
+		REQUIRE(braceIndex.Build(doc, BraceIndex::blockSize * 2));
+		REQUIRE(!braceIndex.Build(doc, BraceIndex::blockSize * 10));
+		REQUIRE(!braceIndex.Pending(doc));
+	}
+
+	SECTION("MatchUnstyled") {
+		Document doc(DocumentOption::Default);
+		doc.InsertString(0, BraceText(BraceIndex::blockSize * 7 + 321, 2));
+		BraceIndex braceIndex(doc, '{', '}', 0);
+		CheckMatches(doc, braceIndex, 0, 997);
+		// Wide ranges where text is unbalanced
+		doc.InsertString(0, "}}{{{{");
+		braceIndex.InsertText(0, 6);
+		doc.InsertString(doc.Length(), "}}}}{{");
+		braceIndex.InsertText(doc.Length() - 6, 6);
+		CheckMatches(doc, braceIndex, 0, 1999);
+	}
+
+	SECTION("MatchStyled") {
+		Document doc(DocumentOption::Default);
+		const std::string text = BraceText(BraceIndex::blockSize * 6, 3);
+		doc.InsertString(0, text);
+		std::string styles(text.length(), '\0');
+		for (size_t i = 0; i < styles.length(); i += 7) {
+			styles[i] = 1;
+		}
+		StyleAll(doc, styles);
+		BraceIndex braceIndex(doc, '{', '}', 0);
+		CheckMatches(doc, braceIndex, 0, 1013);
+		BraceIndex braceIndexStyled(doc, '{', '}', 1);
+		CheckMatches(doc, braceIndexStyled, 1, 1013);
+
+		// Styles that change are reported
+		doc.StartStyling(BraceIndex::blockSize * 2);
+		const std::string restyle(BraceIndex::blockSize, '\1');
+		doc.SetStyles(restyle.length(), restyle.data());
+		braceIndex.ChangeStyle(BraceIndex::blockSize * 2, BraceIndex::blockSize * 3);
+		braceIndexStyled.ChangeStyle(BraceIndex::blockSize * 2, BraceIndex::blockSize * 3);
+		CheckMatches(doc, braceIndex, 0, 1013);
+		CheckMatches(doc, braceIndexStyled, 1, 1013);
+
+		// After the end of styling, braces of any style count
+		doc.StartStyling(BraceIndex::blockSize * 3 + 50);
+		CheckMatches(doc, braceIndex, 0, 1013);
+		CheckMatches(doc, braceIndexStyled, 1, 1013);
+	}
+
+	SECTION("Edits") {
+		Document doc(DocumentOption::Default);
+		doc.InsertString(0, BraceText(BraceIndex::blockSize * 6, 4));
+		// Inserted text has style 0 so restyling does not change styles
+		StyleAll(doc, std::string(doc.Length(), '\0'));
+		BraceIndex braceIndex(doc, '{', '}', 0);
+		CheckMatches(doc, braceIndex, 0, 1511);
+
+		// Small edits inside blocks
+		doc.InsertString(100, "{{");
+		braceIndex.InsertText(100, 2);
+		doc.DeleteChars(BraceIndex::blockSize * 3 + 10, 5);
+		braceIndex.DeleteText(BraceIndex::blockSize * 3 + 10, 5);
+		StyleAll(doc, std::string(doc.Length(), '\0'));
+		CheckMatches(doc, braceIndex, 0, 1511);
+
+		// Insertion large enough to split its block
+		std::string inserted = BraceText(BraceIndex::blockSize * 3, 5);
+		inserted.resize(BraceIndex::blockSize * 3);
+		doc.InsertString(BraceIndex::blockSize + 7, inserted);
+		braceIndex.InsertText(BraceIndex::blockSize + 7, inserted.length());
+		REQUIRE(braceIndex.Blocks() == 10);
+		StyleAll(doc, std::string(doc.Length(), '\0'));
+		CheckMatches(doc, braceIndex, 0, 1511);
+
+		// Deletion over several blocks
+		doc.DeleteChars(BraceIndex::blockSize / 2, BraceIndex::blockSize * 4);
+		braceIndex.DeleteText(BraceIndex::blockSize / 2, BraceIndex::blockSize * 4);
+		StyleAll(doc, std::string(doc.Length(), '\0'));
+		CheckMatches(doc, braceIndex, 0, 1511);
+
+		// Deletion of everything
+		const Sci::Position length = doc.Length();
+		doc.DeleteChars(0, length);
+		braceIndex.DeleteText(0, length);
+		REQUIRE(braceIndex.Blocks() == 1);
+		doc.InsertString(0, "{}");
+		braceIndex.InsertText(0, 2);
+		REQUIRE(braceIndex.Match(doc, 0, 1) == 1);
+		REQUIRE(braceIndex.Match(doc, 1, 0) == 0);
+	}
+
+	SECTION("DocumentBraceMatch") {
+		// Large documents use an index updated by the document
+		for (const DocumentOption option : { DocumentOption::Default, DocumentOption::PieceTable }) {
+			Document doc(option);
+			const std::string text = BraceText(0x60000, 6);
+			doc.InsertString(0, text);
+			StyleAll(doc, std::string(text.length(), '\0'));
+			for (int round = 0; round < 3; round++) {
+				for (Sci::Position position = 0; position < doc.Length(); position += 4099) {
+					while ((position < doc.Length()) && (doc.CharAt(position) != '{') && (doc.CharAt(position) != '}')) {
+						position++;
+					}
+					if (position >= doc.Length()) {
+						break;
+					}
+					const int direction = (doc.CharAt(position) == '{') ? 1 : -1;
+					REQUIRE(doc.BraceMatch(position, 0, 0, false) == LinearMatch(doc, position, position + direction));
+					REQUIRE(doc.BraceMatch(position, 0, position + direction * 10, true) ==
+						LinearMatch(doc, position, position + direction * 10));
+				}
+				doc.InsertString(round * 1000, "{{}");
+				doc.DeleteChars(0x30000, 0x8000);
+				doc.StartStyling(0x20000);
+				const std::string styles(0x100, '\2');
+				doc.SetStyles(styles.length(), styles.data());
+			}
+			REQUIRE(doc.BraceIndexPending());
+			doc.BuildBraceIndexes(doc.Length());
+			REQUIRE(!doc.BraceIndexPending());
+		}
+	}
+
+	SECTION("Background") {
+		Document doc(DocumentOption::Default);
+		const std::string text = BraceText(BraceIndex::blockSize * 7 + 55, 7);
+		doc.InsertString(0, text);
+		std::string styles(text.length(), '\0');
+		for (size_t i = 0; i < styles.length(); i += 5) {
+			styles[i] = 1;
+		}
+		StyleAll(doc, styles);
+		// Styling stops part way so blocks after it count braces of any style
+		doc.StartStyling(BraceIndex::blockSize * 4 + 10);
+		BraceIndex braceIndex(doc, '{', '}', 1);
+		BraceIndex other(doc, '{', '}', 0);
+
+		// Jobs are only applied by the index that prepared them
+		std::unique_ptr<IndexJob> job = braceIndex.Prepare(doc, BraceIndex::blockSize * 4);
+		REQUIRE(job);
+		job->Run();
+		REQUIRE(!other.Merge(*job));
+		REQUIRE(braceIndex.Merge(*job));
+		REQUIRE(braceIndex.Pending(doc));
+
+		// Results of a job prepared before an edit are discarded
+		job = braceIndex.Prepare(doc, BraceIndex::blockSize * 2);
+		REQUIRE(job);
+		doc.InsertString(BraceIndex::blockSize * 5 + 5, "}{{");
+		braceIndex.InsertText(BraceIndex::blockSize * 5 + 5, 3);
+		job->Run();
+		REQUIRE(braceIndex.Merge(*job));
+		REQUIRE(braceIndex.Pending(doc));
+
+		// Jobs run on a worker summarise every block the same as idle time
+		while ((job = braceIndex.Prepare(doc, BraceIndex::blockSize * 3))) {
+			BackgroundIndexer indexer(std::move(job));
+			job = indexer.Finish();
+			REQUIRE(job);
+			REQUIRE(braceIndex.Merge(*job));
+		}
+		REQUIRE(!braceIndex.Pending(doc));
+		CheckMatches(doc, braceIndex, 1, 1009);
+
+		// Cancelled jobs are discarded
+		doc.DeleteChars(10, 5);
+		braceIndex.DeleteText(10, 5);
+		job = braceIndex.Prepare(doc, doc.Length());
+		REQUIRE(job);
+		job->cancelled = true;
+		job->Run();
+		REQUIRE(braceIndex.Merge(*job));
+		REQUIRE(braceIndex.Pending(doc));
+		CheckMatches(doc, braceIndex, 1, 1009);
+	}
+}
+
+TEST_CASE("TagIndex") {
+
+	SECTION("Constructs") {
+		Document doc(DocumentOption::Default);
+		const std::string text = "<a><!-- <b> --><c x='</a>' y=\"/>\"><![CDATA[</c>]]><?pi </a> ?><d/></c> a < b </a><e>";
+		doc.InsertString(0, text);
+		TagIndex tagIndex(doc, false);
+		REQUIRE(tagIndex.Match(doc, 0) == 77);
+		REQUIRE(tagIndex.Match(doc, 77) == 0);
+		REQUIRE(tagIndex.Match(doc, 15) == 66);
+		REQUIRE(tagIndex.Match(doc, 66) == 15);
+		REQUIRE(tagIndex.Match(doc, 62) == 64);
+		REQUIRE(tagIndex.Match(doc, 64) == 62);
+		// Not tags
+		for (const Sci::Position position : { 1, 3, 8, 21, 30, 34, 43, 50, 55, 73 }) {
+			REQUIRE(tagIndex.Match(doc, position) == -1);
+		}
+		REQUIRE(tagIndex.Match(doc, -1) == -1);
+		REQUIRE(tagIndex.Match(doc, doc.Length()) == -1);
+		// An unclosed start tag matches nothing
+		REQUIRE(tagIndex.Match(doc, 81) == -1);
+	}
+
+	SECTION("HTML") {
+		Document doc(DocumentOption::Default);
+		const std::string text = "<p><br><img src=x/><script>if (a<b) x='</p>';</SCRIPT ></p>";
+		doc.InsertString(0, text);
+		TagIndex tagIndex(doc, true);
+		REQUIRE(tagIndex.Match(doc, 0) == 55);
+		REQUIRE(tagIndex.Match(doc, 55) == 0);
+		REQUIRE(tagIndex.Match(doc, 3) == -1);
+		REQUIRE(tagIndex.Match(doc, 7) == -1);
+		REQUIRE(tagIndex.Match(doc, 19) == 45);
+		REQUIRE(tagIndex.Match(doc, 45) == 19);
+		REQUIRE(tagIndex.Match(doc, 32) == -1);
+		REQUIRE(tagIndex.Match(doc, 39) == -1);
+		// As XML, every start tag needs an end tag and script contains tags
+		TagIndex tagIndexXML(doc, false);
+		REQUIRE(tagIndexXML.Match(doc, 7) == 17);
+		REQUIRE(tagIndexXML.Match(doc, 32) == 55);
+		REQUIRE(tagIndexXML.Match(doc, 0) == -1);
+	}
+
+	SECTION("Blocks") {
+		for (const bool html : { false, true }) {
+			Document doc(DocumentOption::Default);
+			doc.InsertString(0, MarkupText(TagIndex::blockSize * 7 + 100, 7, html));
+			TagIndex tagIndex(doc, html);
+			REQUIRE(tagIndex.Blocks() == static_cast<size_t>((doc.Length() + TagIndex::blockSize - 1) / TagIndex::blockSize));
+			REQUIRE(tagIndex.Pending());
+			CheckTagMatches(doc, tagIndex, html, 37);
+			REQUIRE(!tagIndex.Build(doc, doc.Length()));
+			CheckTagMatches(doc, tagIndex, html, 11);
+		}
+	}
+
+	SECTION("BlockBoundaries") {
+		// Constructs decided by several bytes placed across the end of the first block
+		static const char *const snippets[] = {
+			"<!-- <a> -->", "<![CDATA[ <a> ]]>", "<?pi <a> ?>", "<a/>", "<br>", "<script> <a> </script>",
+			"<a x='>'></a>", "<style><a></STYLE>",
+		};
+		for (const bool html : { false, true }) {
+			for (const char *snippet : snippets) {
+				for (Sci::Position offset = 0; offset < 24; offset++) {
+					Document doc(DocumentOption::Default);
+					const std::string filler(TagIndex::blockSize - 3 - offset, 'x');
+					doc.InsertString(0, "<r>" + filler + snippet + "<b></b></r>");
+					TagIndex tagIndex(doc, html);
+					CheckTagMatches(doc, tagIndex, html, 1);
+					// Changing the bytes before the end of the block changes tags after it
+					const Sci::Position position = 3 + static_cast<Sci::Position>(filler.length());
+					doc.DeleteChars(position, 1);
+					tagIndex.DeleteText(position, 1);
+					CheckTagMatches(doc, tagIndex, html, 1);
+					doc.InsertString(position, "<", 1);
+					tagIndex.InsertText(position, 1);
+					CheckTagMatches(doc, tagIndex, html, 1);
+				}
+			}
+		}
+	}
+
+	SECTION("Edits") {
+		for (const bool html : { false, true }) {
+			Document doc(DocumentOption::Default);
+			doc.InsertString(0, MarkupText(TagIndex::blockSize * 6, 8, html));
+			TagIndex tagIndex(doc, html);
+			CheckTagMatches(doc, tagIndex, html, 41);
+			unsigned int state = 9;
+			const auto next = [&state](unsigned int range) {
+				state = state * 1103515245 + 12345;
+				return (state >> 16) % range;
+			};
+			for (int edit = 0; edit < 40; edit++) {
+				const Sci::Position position = next(static_cast<unsigned int>(doc.Length()));
+				if (next(2)) {
+					// Insertions that change what the text after them is, some large enough to split blocks
+					static const char *const inserted[] = { "<!--", "-->", "<a>", "</a>", "'", "\"", "<![CDATA[", "<script>", "</script>", ">" };
+					const std::string text = next(8) ? inserted[next(std::size(inserted))] :
+						MarkupText(TagIndex::blockSize * 2 + next(1000), next(1000), html);
+					doc.InsertString(position, text);
+					tagIndex.InsertText(position, text.length());
+				} else {
+					const Sci::Position length = std::min<Sci::Position>(doc.Length() - position,
+						next(4) ? next(20) : next(TagIndex::blockSize * 3));
+					doc.DeleteChars(position, length);
+					tagIndex.DeleteText(position, length);
+				}
+				CheckTagMatches(doc, tagIndex, html, 97);
+			}
+
+			// Deletion of everything
+			const Sci::Position length = doc.Length();
+			doc.DeleteChars(0, length);
+			tagIndex.DeleteText(0, length);
+			REQUIRE(tagIndex.Blocks() == 1);
+			doc.InsertString(0, "<a/>");
+			tagIndex.InsertText(0, 4);
+			REQUIRE(tagIndex.Match(doc, 0) == 2);
+		}
+	}
+
+	SECTION("DocumentTagMatch") {
+		// The document keeps its index up to date
+		for (const DocumentOption option : { DocumentOption::Default, DocumentOption::PieceTable }) {
+			Document doc(option);
+			doc.InsertString(0, MarkupText(TagIndex::blockSize * 5, 10, true));
+			for (int round = 0; round < 3; round++) {
+				std::string text(doc.Length(), '\0');
+				doc.GetCharRange(text.data(), 0, doc.Length());
+				const std::vector<TagIndex::Tag> tags = LinearTags(text, true);
+				TagIndex tagIndex(doc, true);
+				for (size_t t = 0; t < tags.size(); t += 13) {
+					REQUIRE(doc.TagMatch(tags[t].position, true) == tagIndex.Match(doc, tags[t].position));
+				}
+				doc.InsertString(round * 1000, "<!-- ");
+				doc.DeleteChars(TagIndex::blockSize * 2, 0x2000);
+			}
+			REQUIRE(doc.BraceIndexPending());
+			doc.BuildBraceIndexes(doc.Length());
+			REQUIRE(!doc.BraceIndexPending());
+		}
+	}
+
+	SECTION("Background") {
+		for (const bool html : { false, true }) {
+			Document doc(DocumentOption::Default);
+			doc.InsertString(0, MarkupText(TagIndex::blockSize * 7, 11, html));
+			TagIndex tagIndex(doc, html);
+			TagIndex other(doc, html);
+
+			// Jobs are only applied by the index that prepared them
+			std::unique_ptr<IndexJob> job = tagIndex.Prepare(doc, TagIndex::blockSize * 2);
+			REQUIRE(job);
+			job->Run();
+			REQUIRE(!other.Merge(*job));
+			REQUIRE(tagIndex.Merge(*job));
+			REQUIRE(tagIndex.Pending());
+
+			// Results of a job prepared before an edit are discarded
+			job = tagIndex.Prepare(doc, TagIndex::blockSize * 2);
+			REQUIRE(job);
+			doc.InsertString(TagIndex::blockSize * 2 + 5, "<!--");
+			tagIndex.InsertText(TagIndex::blockSize * 2 + 5, 4);
+			job->Run();
+			REQUIRE(tagIndex.Merge(*job));
+			REQUIRE(tagIndex.Pending());
+
+			// Each job continues from the exit state of the blocks before it
+			while ((job = tagIndex.Prepare(doc, TagIndex::blockSize * 2))) {
+				BackgroundIndexer indexer(std::move(job));
+				job = indexer.Finish();
+				REQUIRE(job);
+				REQUIRE(tagIndex.Merge(*job));
+			}
+			REQUIRE(!tagIndex.Pending());
+			CheckTagMatches(doc, tagIndex, html, 29);
+
+			// An edit that changes the state at the start of later blocks makes them pending
+			doc.InsertString(TagIndex::blockSize + 3, "<![CDATA[");
+			tagIndex.InsertText(TagIndex::blockSize + 3, 9);
+			REQUIRE(tagIndex.Pending());
+			while ((job = tagIndex.Prepare(doc, TagIndex::blockSize * 3))) {
+				job->Run();
+				REQUIRE(tagIndex.Merge(*job));
+			}
+			REQUIRE(!tagIndex.Pending());
+			CheckTagMatches(doc, tagIndex, html, 29);
+		}
+	}
+
+	SECTION("DocumentBackground") {
+		Document doc(DocumentOption::Default);
+		const std::string text = BraceText(0x60000, 12) + MarkupText(TagIndex::blockSize * 4, 12, true);
+		doc.InsertString(0, text);
+		StyleAll(doc, std::string(text.length(), '\0'));
+		// Matching creates the indexes
+		const Sci::Position brace = text.find('{');
+		REQUIRE(doc.BraceMatch(brace, 0, 0, false) == LinearMatch(doc, brace, brace + 1));
+		const Sci::Position tag = text.find('<');
+		REQUIRE(doc.TagMatch(tag, true) == TagIndex(doc, true).Match(doc, tag));
+		REQUIRE(doc.BraceIndexPending());
+		// As the editor's index timer does
+		while (doc.MergeBraceIndexes() || doc.BuildBraceIndexesInBackground(0x20000)) {
+		}
+		REQUIRE(!doc.BraceIndexPending());
+		// Edits while the worker runs discard its results
+		REQUIRE(!doc.MergeBraceIndexes());
+		doc.InsertString(0x10000, "{{<a>");
+		REQUIRE(doc.BuildBraceIndexesInBackground(doc.Length()));
+		doc.DeleteChars(0x20000, 0x1000);
+		while (doc.MergeBraceIndexes()) {
+		}
+		REQUIRE(doc.BraceIndexPending());
+		while (doc.MergeBraceIndexes() || doc.BuildBraceIndexesInBackground(0x20000)) {
+		}
+		REQUIRE(!doc.BraceIndexPending());
+		for (Sci::Position position = 0; position < 0x5F000; position += 4099) {
+			while ((doc.CharAt(position) != '{') && (doc.CharAt(position) != '}')) {
+				position++;
+			}
+			const int direction = (doc.CharAt(position) == '{') ? 1 : -1;
+			REQUIRE(doc.BraceMatch(position, 0, 0, false) == LinearMatch(doc, position, position + direction));
+		}
+	}
+}
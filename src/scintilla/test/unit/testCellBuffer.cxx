@@ -15,6 +15,7 @@
 #include <memory>
 
 #include "ScintillaTypes.h"
+#include "ILoader.h"
 
 #include "Debugging.h"
 
@@ -24,8 +25,10 @@
 #include "RunStyles.h"
 #include "SparseVector.h"
 #include "ChangeHistory.h"
+#include "PieceTable.h"
 #include "CellBuffer.h"
 #include "UndoHistory.h"
+#include "UniConversion.h"
 
 #include "catch.hpp"
 
@@ -64,6 +67,50 @@ TEST_CASE("ScrapStack") {
 		const char *text5 = ss.Push("1", 1);
 		REQUIRE(memcmp(text5, "1", 1) == 0);
 	}
+
+	SECTION("MemoryLimit") {
+		ss.SetMemoryLimit(4);
+		REQUIRE(ss.MemoryLimit() == 4);
+
+		ss.Push("abc", 3);
+		ss.Push("def", 3);
+		const char *t = ss.Push("ghi", 3);
+		REQUIRE(memcmp(t, "ghi", 3) == 0);
+		REQUIRE(ss.Current() == 9);
+
+		// Read back part of the spilled text
+		REQUIRE(ss.Load(2));
+		REQUIRE(memcmp(ss.TextAt(2), "cdefghi", 7) == 0);
+
+		// Replace text that is in the spill file
+		ss.SetCurrent(2);
+		const char *t2 = ss.Push("XY", 2);
+		REQUIRE(memcmp(t2, "XY", 2) == 0);
+		REQUIRE(ss.Load(0));
+		REQUIRE(memcmp(ss.TextAt(0), "abXY", 4) == 0);
+
+		// Spill over the top of the replaced text
+		ss.Push("123", 3);
+		ss.Push("45", 2);
+		REQUIRE(ss.Load(0));
+		REQUIRE(memcmp(ss.TextAt(0), "abXY12345", 9) == 0);
+
+		ss.MoveBack(9);
+		REQUIRE(memcmp(ss.CurrentText(), "abXY12345", 9) == 0);
+	}
+
+	SECTION("MemoryUsage") {
+		ss.SetMemoryLimit(1000);
+		const std::string line(100, 'x');
+		for (int i = 0; i < 100; i++) {
+			ss.Push(line.c_str(), line.length());
+		}
+		REQUIRE(ss.Current() == 10000);
+		REQUIRE(ss.MemoryUsage() < 2000);
+
+		REQUIRE(ss.Load(0));
+		REQUIRE(ss.MemoryUsage() >= 10000);
+	}
 }
 
 TEST_CASE("CellBuffer") {
@@ -240,6 +287,24 @@ TEST_CASE("CellBuffer") {
 		REQUIRE(cb.Length() == 0);
 	}
 
+	SECTION("BulkInsert") {
+		// Large insertions allocate the line starts once without the spare room left by growing
+		std::string text;
+		for (int i = 0; i < 0x4000; i++) {
+			text.append(i % 2 ? "ab\r\n" : "ab\n\r");
+		}
+		bool startSequence = false;
+		cb.InsertString(0, text.data(), text.length(), startSequence);
+		const Sci::Line lines = 0x4000 * 2 - 0x4000 / 2 + 1;
+		REQUIRE(cb.Lines() == lines);
+		REQUIRE(cb.LineMemoryUsage() >= (lines + 1) * sizeof(int));
+		REQUIRE(cb.LineMemoryUsage() < (lines + 1 + lines / 16) * sizeof(int));
+		REQUIRE(cb.LineStart(1) == 3);
+		REQUIRE(cb.LineStart(2) == 4);
+		REQUIRE(cb.LineStart(3) == 8);
+		REQUIRE(cb.LineStart(lines - 1) == static_cast<Sci::Position>(text.length()));
+	}
+
 }
 
 bool Equal(const Action &a, ActionType at, Sci::Position position, std::string_view value) noexcept {
@@ -424,6 +489,37 @@ TEST_CASE("UndoHistory") {
 		REQUIRE(uh.Actions() == 1);
 	}
 
+	SECTION("MemoryLimit") {
+		uh.SetMemoryLimit(4);
+		REQUIRE(uh.MemoryLimit() == 4);
+
+		bool startSequence = false;
+		uh.AppendAction(ActionType::insert, 0, "ab", 2, startSequence, false);
+		uh.AppendAction(ActionType::insert, 2, "cd", 2, startSequence, false);
+		uh.AppendAction(ActionType::remove, 2, "cd", 2, startSequence, false);
+		const char *val = uh.AppendAction(ActionType::insert, 2, "ef", 2, startSequence, false);
+		REQUIRE(memcmp(val, "ef", 2) == 0);
+		REQUIRE(uh.Actions() == 4);
+		REQUIRE(uh.MemoryUsage() > 0);
+
+		// Undo all the way back, reading in spilled text as needed
+		const std::string_view expected[] = { "ab", "cd", "cd", "ef" };
+		for (int act = 3; act >= 0; act--) {
+			const int steps = uh.StartUndo();
+			REQUIRE(steps == 1);
+			const Action action = uh.GetUndoStep();
+			REQUIRE(action.lenData == 2);
+			REQUIRE(memcmp(action.data, expected[act].data(), 2) == 0);
+			uh.CompletedUndoStep();
+		}
+		REQUIRE(!uh.CanUndo());
+
+		// Spilled text is also available when iterating the actions
+		for (int act = 0; act < uh.Actions(); act++) {
+			REQUIRE(uh.Text(act) == expected[act]);
+		}
+	}
+
 	SECTION("Coalesce") {
 
 		bool startSequence = false;
@@ -1656,3 +1752,537 @@ TEST_CASE("CellBufferLong") {
 	}
 }
 #endif
+
+namespace {
+
+// Straightforward versions of the scanning kernels to check the vectorised versions against.
+
+size_t FindLineEndByteSlow(std::string_view sv, bool unicodeLineEnds) {
+	for (size_t i = 0; i < sv.length(); i++) {
+		const unsigned char ch = sv[i];
+		if ((ch == '\r') || (ch == '\n') || (unicodeLineEnds && ((ch == 0x85) || (ch == 0xa8) || (ch == 0xa9)))) {
+			return i;
+		}
+	}
+	return sv.length();
+}
+
+Sci::Line CountLineEndsSlow(std::string_view sv) {
+	Sci::Line count = 0;
+	for (size_t i = 0; i < sv.length(); i++) {
+		if ((sv[i] == '\r') || ((sv[i] == '\n') && ((i == 0) || (sv[i - 1] != '\r')))) {
+			count++;
+		}
+	}
+	return count;
+}
+
+CountWidths CountCharacterWidthsSlow(std::string_view sv) {
+	CountWidths cw;
+	while (!sv.empty()) {
+		const int lenChar = UTF8Classify(sv) & UTF8MaskWidth;
+		cw.CountChar(lenChar);
+		sv.remove_prefix(lenChar);
+	}
+	return cw;
+}
+
+// Text mixing ASCII, line ends, multi-byte characters, and, when invalid, stray bytes in
+// runs that cross the 16 and 32 byte blocks at different offsets.
+std::string MixedText(size_t length, bool invalid) {
+	constexpr std::string_view pieces[] = {
+		"a", "bc", "\r", "\n", "\r\n", "\xC2\x85", "\xE2\x80\xA8", "\xE2\x80\xA9",
+		"\xC3\xA9", "\xE6\x97\xA5", "\xF0\x90\x8D\x88", "0123456789abcdefghijklmnopqrstuvwxyz",
+	};
+	constexpr std::string_view stray[] = { "\x80", "\xA8", "\xE2\x80", "\xF0\x90", "\xFF" };
+	RandomSequence rseq;
+	std::string text;
+	while (text.length() < length) {
+		if (invalid && (rseq.Next() % 8 == 0)) {
+			text.append(stray[rseq.Next() % std::size(stray)]);
+		} else {
+			text.append(pieces[rseq.Next() % std::size(pieces)]);
+		}
+	}
+	text.resize(length);
+	return text;
+}
+
+}
+
+TEST_CASE("ScanningKernels") {
+
+	const std::string valid = MixedText(3000, false);
+	const std::string invalid = MixedText(3000, true);
+
+	SECTION("FindLineEndByte") {
+		REQUIRE(FindLineEndByte("", false) == 0);
+		REQUIRE(FindLineEndByte("abc", false) == 3);
+		for (const std::string &text : { valid, invalid }) {
+			for (size_t start = 0; start < 40; start++) {
+				for (const bool unicodeLineEnds : { false, true }) {
+					std::string_view sv(text);
+					sv.remove_prefix(start);
+					while (!sv.empty()) {
+						const size_t found = FindLineEndByte(sv, unicodeLineEnds);
+						REQUIRE(found == FindLineEndByteSlow(sv, unicodeLineEnds));
+						sv.remove_prefix(std::min(found + 1, sv.length()));
+					}
+				}
+			}
+		}
+		// Only line end bytes beyond the first few blocks
+		const std::string spaces = std::string(100, ' ') + "\xA9";
+		REQUIRE(FindLineEndByte(spaces, false) == spaces.length());
+		REQUIRE(FindLineEndByte(spaces, true) == 100);
+	}
+
+	SECTION("CountLineEnds") {
+		REQUIRE(CountLineEnds("") == 0);
+		REQUIRE(CountLineEnds("\n") == 1);
+		REQUIRE(CountLineEnds("\r\n\n\r") == 3);
+		for (size_t start = 0; start < 40; start++) {
+			for (size_t length = 0; length < 200; length += 7) {
+				const std::string_view sv = std::string_view(invalid).substr(start, length);
+				REQUIRE(CountLineEnds(sv) == CountLineEndsSlow(sv));
+			}
+			const std::string_view sv = std::string_view(invalid).substr(start);
+			REQUIRE(CountLineEnds(sv) == CountLineEndsSlow(sv));
+		}
+		// CR+LF split across blocks and enough blocks to need the counters summed more than once
+		std::string lines;
+		for (int i = 0; i < 3000; i++) {
+			lines.append(std::string(i % 31, 'x'));
+			lines.append(i % 3 ? "\r\n" : "\n");
+		}
+		REQUIRE(CountLineEnds(lines) == 3000);
+		const std::string lineFeeds(20000, '\n');
+		REQUIRE(CountLineEnds(lineFeeds) == 20000);
+	}
+
+	SECTION("AsciiPrefixLength") {
+		REQUIRE(AsciiPrefixLength("") == 0);
+		for (size_t length = 0; length < 100; length++) {
+			const std::string text = std::string(length, 'a') + "\xC3\xA9" + "b";
+			REQUIRE(AsciiPrefixLength(text) == length);
+			REQUIRE(AsciiPrefixLength(std::string_view(text).substr(0, length)) == length);
+		}
+	}
+
+	SECTION("CountCharacterWidths") {
+		for (size_t start = 0; start < 40; start++) {
+			const std::string_view sv = std::string_view(invalid).substr(start);
+			const CountWidths cw = CountCharacterWidthsUTF8(sv);
+			const CountWidths cwSlow = CountCharacterWidthsSlow(sv);
+			REQUIRE(cw.countBasePlane == cwSlow.countBasePlane);
+			REQUIRE(cw.countOtherPlanes == cwSlow.countOtherPlanes);
+		}
+		// Valid text starting at character boundaries
+		std::string_view sv(valid);
+		while (!sv.empty()) {
+			const CountWidths cw = CountCharacterWidthsValidUTF8(sv);
+			const CountWidths cwSlow = CountCharacterWidthsSlow(sv);
+			REQUIRE(cw.countBasePlane == cwSlow.countBasePlane);
+			REQUIRE(cw.countOtherPlanes == cwSlow.countOtherPlanes);
+			sv.remove_prefix(UTF8Classify(sv) & UTF8MaskWidth);
+		}
+	}
+
+	SECTION("CountCharacterWidthsAcrossGap") {
+		// Move the gap through the text so characters are split by it
+		CellBuffer cb(true, false);
+		bool startSequence = false;
+		cb.InsertString(0, invalid.data(), invalid.length(), startSequence);
+		for (Sci::Position gap = 0; gap < 200; gap++) {
+			cb.DeleteChars(gap, 1, startSequence);
+			cb.InsertString(gap, invalid.data() + gap, 1, startSequence);
+			REQUIRE(cb.GapPosition() == gap + 1);
+			for (Sci::Position start = 0; start < 8; start++) {
+				for (const Sci::Position end : { gap, gap + 1, gap + 3, gap + 40, static_cast<Sci::Position>(invalid.length()) }) {
+					const CountWidths cw = cb.CountCharacterWidths(start, end);
+					const std::string_view sv = std::string_view(invalid).substr(start, std::max<Sci::Position>(end - start, 0));
+					const CountWidths cwSlow = CountCharacterWidthsSlow(sv);
+					REQUIRE(cw.countBasePlane == cwSlow.countBasePlane);
+					REQUIRE(cw.countOtherPlanes == cwSlow.countOtherPlanes);
+				}
+			}
+		}
+	}
+
+	SECTION("InsertMatchesReset") {
+		// Lines found while inserting match those found by the simpler scan when the line end
+		// types change. Insert in pieces so insertions start and end within line ends.
+		for (const bool unicodeLineEnds : { false, true }) {
+			const LineEndType lineEndType = unicodeLineEnds ? LineEndType::Unicode : LineEndType::Default;
+			CellBuffer cb(true, false);
+			cb.SetUTF8Substance(true);
+			cb.SetLineEndTypes(lineEndType);
+			bool startSequence = false;
+			for (size_t position = 0; position < invalid.length(); position += 97) {
+				const size_t length = std::min<size_t>(97, invalid.length() - position);
+				cb.InsertString(position, invalid.data() + position, length, startSequence);
+			}
+			std::vector<Sci::Position> starts;
+			for (Sci::Line line = 0; line <= cb.Lines(); line++) {
+				starts.push_back(cb.LineStart(line));
+			}
+			REQUIRE(cb.Lines() > 50);
+			cb.SetLineEndTypes(unicodeLineEnds ? LineEndType::Default : LineEndType::Unicode);
+			cb.SetLineEndTypes(lineEndType);
+			REQUIRE(cb.Lines() + 1 == static_cast<Sci::Line>(starts.size()));
+			for (Sci::Line line = 0; line <= cb.Lines(); line++) {
+				REQUIRE(cb.LineStart(line) == starts[line]);
+			}
+
+			// Character index calculated for each line
+			cb.AllocateLineCharacterIndex(LineCharacterIndexType::Utf16 | LineCharacterIndexType::Utf32);
+			CountWidths cwStart;
+			for (Sci::Line line = 0; line < cb.Lines(); line++) {
+				REQUIRE(cb.IndexLineStart(line, LineCharacterIndexType::Utf16) == cwStart.WidthUTF16());
+				REQUIRE(cb.IndexLineStart(line, LineCharacterIndexType::Utf32) == cwStart.WidthUTF32());
+				const std::string_view lineText = std::string_view(invalid).substr(
+					starts[line], starts[line + 1] - starts[line]);
+				const CountWidths cwLine = CountCharacterWidthsSlow(lineText);
+				cwStart.countBasePlane += cwLine.countBasePlane;
+				cwStart.countOtherPlanes += cwLine.countOtherPlanes;
+			}
+		}
+	}
+}
+
+namespace {
+
+class MappedText final : public IMappedText {
+	std::string text;
+	bool *released;
+public:
+	MappedText(std::string_view text_, bool *released_) : text(text_), released(released_) {
+	}
+	const char *SCI_METHOD Data() override {
+		return text.data();
+	}
+	Sci_Position SCI_METHOD Length() override {
+		return text.length();
+	}
+	void SCI_METHOD Release() override {
+		*released = true;
+		delete this;
+	}
+};
+
+std::string Contents(const CellBuffer &cb) {
+	std::string contents(cb.Length(), '\0');
+	cb.GetCharRange(contents.data(), 0, cb.Length());
+	return contents;
+}
+
+}
+
+TEST_CASE("CellBufferPieceTable") {
+
+	CellBuffer cb(true, false, true);
+	bool startSequence = false;
+
+	SECTION("UndoRefersToPieces") {
+		REQUIRE(cb.IsPieceTable());
+		const std::string text(100000, 'x');
+		const char *inserted = cb.InsertString(0, text.data(), text.length(), startSequence);
+		REQUIRE(inserted == cb.Pieces()->PieceText(0));
+		// Only the action is recorded, not its text
+		REQUIRE(cb.UndoMemoryUsage() < 1000);
+		const char *deleted = cb.DeleteChars(100, 1000, startSequence);
+		REQUIRE(deleted == inserted + 100);
+		REQUIRE(2 == cb.Pieces()->Pieces());
+		REQUIRE(cb.UndoMemoryUsage() < 1000);
+		REQUIRE(cb.UndoActionText(1) == std::string_view(inserted + 100, 1000));
+		UndoBlock(cb);
+		REQUIRE(text.length() == static_cast<size_t>(cb.Length()));
+		REQUIRE(1 == cb.Pieces()->Pieces());
+		UndoBlock(cb);
+		REQUIRE(0 == cb.Length());
+		RedoBlock(cb);
+		RedoBlock(cb);
+		REQUIRE(text.length() - 1000 == static_cast<size_t>(cb.Length()));
+	}
+
+	SECTION("MappedText") {
+		bool released = false;
+		bool releasedOther = false;
+		CellBuffer cbMapped(true, false, true);
+		MappedText *mapped = new MappedText("Two\nLines", &released);
+		cbMapped.SetUndoCollection(false);
+		REQUIRE(cbMapped.SetMappedText(mapped));
+		cbMapped.InsertString(0, mapped->Data(), mapped->Length(), startSequence);
+		REQUIRE(cbMapped.Pieces()->PieceText(0) == mapped->Data());
+		REQUIRE(2 == cbMapped.Lines());
+		REQUIRE(4 == cbMapped.LineStart(1));
+		cbMapped.SetUndoCollection(true);
+		cbMapped.InsertString(3, "!", 1, startSequence);
+		REQUIRE("Two!\nLines" == Contents(cbMapped));
+		REQUIRE(!released);
+		// Can not replace the text while the undo history may refer to it
+		MappedText *other = new MappedText("Other", &releasedOther);
+		cbMapped.DeleteChars(0, cbMapped.Length(), startSequence);
+		REQUIRE(!cbMapped.SetMappedText(other));
+		cbMapped.DeleteUndoHistory();
+		REQUIRE(cbMapped.SetMappedText(other));
+		REQUIRE(released);
+		REQUIRE(!releasedOther);
+	}
+
+	SECTION("DetachMappedText") {
+		bool released = false;
+		CellBuffer cbMapped(true, false, true);
+		REQUIRE(!cbMapped.DetachMappedText());
+		MappedText *mapped = new MappedText("One\nTwo\nThree", &released);
+		cbMapped.SetUndoCollection(false);
+		REQUIRE(cbMapped.SetMappedText(mapped));
+		cbMapped.InsertString(0, mapped->Data(), mapped->Length(), startSequence);
+		cbMapped.SetUndoCollection(true);
+		// Undo refers to the deleted "Two" in the mapped text
+		const char *deleted = cbMapped.DeleteChars(4, 4, startSequence);
+		REQUIRE(deleted == mapped->Data() + 4);
+		const uintptr_t mappedStart = reinterpret_cast<uintptr_t>(mapped->Data());
+		const uintptr_t mappedEnd = mappedStart + mapped->Length();
+		auto inMapped = [mappedStart, mappedEnd](const char *text) {
+			const uintptr_t address = reinterpret_cast<uintptr_t>(text);
+			return (address >= mappedStart) && (address <= mappedEnd);
+		};
+		REQUIRE(cbMapped.DetachMappedText());
+		REQUIRE(released);
+		REQUIRE(!cbMapped.DetachMappedText());
+		for (Sci::Position piece = 0; piece < cbMapped.Pieces()->Pieces(); piece++) {
+			REQUIRE(!inMapped(cbMapped.Pieces()->PieceText(piece)));
+		}
+		REQUIRE(!inMapped(cbMapped.UndoActionText(0).data()));
+		REQUIRE("One\nThree" == Contents(cbMapped));
+		REQUIRE(cbMapped.UndoActionText(0) == "Two\n");
+		UndoBlock(cbMapped);
+		REQUIRE("One\nTwo\nThree" == Contents(cbMapped));
+		REQUIRE(3 == cbMapped.Lines());
+	}
+
+	SECTION("DetachEmptyMappedText") {
+		bool released = false;
+		CellBuffer cbMapped(true, false, true);
+		MappedText *mapped = new MappedText(std::string(100000, 'x'), &released);
+		cbMapped.SetUndoCollection(false);
+		REQUIRE(cbMapped.SetMappedText(mapped));
+		cbMapped.InsertString(0, mapped->Data(), mapped->Length(), startSequence);
+		cbMapped.DeleteChars(0, cbMapped.Length(), startSequence);
+		// Nothing refers to the text any more so it is released without being copied
+		REQUIRE(cbMapped.DetachMappedText());
+		REQUIRE(released);
+		REQUIRE(cbMapped.Pieces()->MemoryUsage() < 1000);
+	}
+
+	SECTION("NotPieceTable") {
+		CellBuffer cbGap(true, false);
+		REQUIRE(!cbGap.IsPieceTable());
+		REQUIRE(!cbGap.Pieces());
+		bool released = false;
+		MappedText mapped("Text", &released);
+		REQUIRE(!cbGap.SetMappedText(&mapped));
+	}
+
+	SECTION("CharacterSplitBetweenPieces") {
+		cb.SetUTF8Substance(true);
+		cb.AllocateLineCharacterIndex(LineCharacterIndexType::Utf16);
+		// Inserted in this order the two halves of the e-acute are not next to each other in memory
+		cb.InsertString(0, "\xA9" "b\n", 3, startSequence);
+		cb.InsertString(0, "a\xC3", 2, startSequence);
+		REQUIRE(2 == cb.Pieces()->Pieces());
+		REQUIRE(4 == cb.CountCharacterWidths(0, 5).WidthUTF16());
+		REQUIRE(4 == cb.IndexLineStart(1, LineCharacterIndexType::Utf16));
+	}
+
+	SECTION("MatchesGapBuffer") {
+		// Perform the same random changes, undos, and redos on both kinds of buffer
+		CellBuffer cbGap(true, false);
+		for (CellBuffer *pcb : {&cb, &cbGap}) {
+			pcb->SetUTF8Substance(true);
+			pcb->SetLineEndTypes(LineEndType::Unicode);
+			pcb->AllocateLineCharacterIndex(LineCharacterIndexType::Utf16);
+		}
+		const std::string mixed = MixedText(2000, true);
+		RandomSequence rseq;
+		for (int i = 0; i < 3000; i++) {
+			const int r = rseq.Next() % 10;
+			const Sci::Position length = cb.Length();
+			if (r <= 3) {
+				const Sci::Position pos = rseq.Next() % (length + 1);
+				const size_t start = rseq.Next() % 1000;
+				const Sci::Position len = rseq.Next() % 40 + 1;
+				for (CellBuffer *pcb : {&cb, &cbGap}) {
+					pcb->InsertString(pos, mixed.data() + start, len, startSequence);
+				}
+			} else if (r <= 6) {
+				const Sci::Position pos = rseq.Next() % (length + 1);
+				const Sci::Position len = std::min<Sci::Position>(rseq.Next() % 30 + 1, length - pos);
+				if (len > 0) {
+					for (CellBuffer *pcb : {&cb, &cbGap}) {
+						pcb->DeleteChars(pos, len, startSequence);
+					}
+				}
+			} else if (r <= 8) {
+				const bool undo = rseq.Next() % 2 == 1;
+				for (CellBuffer *pcb : {&cb, &cbGap}) {
+					if (undo) {
+						UndoBlock(*pcb);
+					} else {
+						RedoBlock(*pcb);
+					}
+				}
+			} else {
+				const Sci::Position pos = rseq.Next() % (length + 1);
+				const Sci::Position len = std::min<Sci::Position>(rseq.Next() % 50, length - pos);
+				REQUIRE(std::string_view(cb.RangePointer(pos, len), len) == std::string_view(cbGap.RangePointer(pos, len), len));
+			}
+			REQUIRE(cb.Length() == cbGap.Length());
+		}
+		REQUIRE(Contents(cb) == Contents(cbGap));
+		REQUIRE(cb.Lines() == cbGap.Lines());
+		for (Sci::Line line = 0; line <= cb.Lines(); line++) {
+			REQUIRE(cb.LineStart(line) == cbGap.LineStart(line));
+			REQUIRE(cb.IndexLineStart(line, LineCharacterIndexType::Utf16) ==
+				cbGap.IndexLineStart(line, LineCharacterIndexType::Utf16));
+		}
+		REQUIRE(std::string_view(cb.BufferPointer()) == std::string_view(cbGap.BufferPointer()));
+	}
+}
+
+namespace {
+
+std::string Styles(const CellBuffer &cb) {
+	std::string styles(cb.Length(), '\0');
+	cb.GetStyleRange(reinterpret_cast<unsigned char *>(styles.data()), 0, cb.Length());
+	return styles;
+}
+
+}
+
+TEST_CASE("CellBufferStyleRuns") {
+
+	CellBuffer cb(true, false, false, true);
+	bool startSequence = false;
+
+	SECTION("Setup") {
+		REQUIRE(cb.HasStyleRuns());
+		REQUIRE(!CellBuffer(true, false).HasStyleRuns());
+		// Runs need styles to be stored
+		REQUIRE(!CellBuffer(false, false, false, true).HasStyleRuns());
+	}
+
+	SECTION("SetStyles") {
+		cb.InsertString(0, "abcdefghij", 10, startSequence);
+		REQUIRE(std::string(10, '\0') == Styles(cb));
+		Sci::Position first = -1;
+		Sci::Position last = -1;
+		REQUIRE(cb.SetStyles(2, 5, "\1\1\1\2\2", first, last));
+		REQUIRE(2 == first);
+		REQUIRE(6 == last);
+		REQUIRE(std::string("\0\0\1\1\1\2\2\0\0\0", 10) == Styles(cb));
+		REQUIRE(1 == cb.StyleAt(4));
+		REQUIRE(2 == cb.StyleAt(5));
+		REQUIRE(0 == cb.StyleAt(-1));
+		REQUIRE(0 == cb.StyleAt(10));
+		// Only the changed part is reported
+		REQUIRE(cb.SetStyles(2, 5, "\1\1\1\3\2", first, last));
+		REQUIRE(5 == first);
+		REQUIRE(5 == last);
+		REQUIRE(!cb.SetStyles(2, 5, "\1\1\1\3\2", first, last));
+		// Styles past the end are ignored
+		REQUIRE(!cb.SetStyleFor(8, 5, 4));
+		REQUIRE(!cb.SetStyleAt(10, 4));
+		REQUIRE(cb.SetStyleAt(9, 4));
+		REQUIRE(std::string("\0\0\1\1\1\3\2\0\0\4", 10) == Styles(cb));
+	}
+
+	SECTION("InsertDelete") {
+		cb.InsertString(0, "abcdefghij", 10, startSequence);
+		cb.SetStyleFor(0, 10, 1);
+		// Inserted text is style 0 even inside or after a run
+		cb.InsertString(5, "xy", 2, startSequence);
+		cb.InsertString(12, "z", 1, startSequence);
+		cb.InsertString(0, "w", 1, startSequence);
+		REQUIRE(std::string("\0\1\1\1\1\1\0\0\1\1\1\1\1\0", 14) == Styles(cb));
+		cb.DeleteChars(4, 6, startSequence);
+		REQUIRE(std::string("\0\1\1\1\1\1\1\0", 8) == Styles(cb));
+		UndoBlock(cb);
+		REQUIRE(14 == cb.Length());
+		REQUIRE(std::string(6, '\0') == Styles(cb).substr(4, 6));
+	}
+
+	SECTION("MemoryUsage") {
+		const std::string text(1000000, 'x');
+		cb.InsertString(0, text.data(), text.length(), startSequence);
+		CellBuffer cbGap(true, false);
+		cbGap.InsertString(0, text.data(), text.length(), startSequence);
+		for (CellBuffer *pcb : {&cb, &cbGap}) {
+			for (Sci::Position pos = 0; pos < pcb->Length(); pos += 100) {
+				pcb->SetStyleFor(pos, 10, 1);
+			}
+		}
+		REQUIRE(Styles(cb) == Styles(cbGap));
+		REQUIRE(cb.StyleMemoryUsage() < cbGap.StyleMemoryUsage() / 2);
+	}
+
+	SECTION("MatchesGapBuffer") {
+		// Perform the same random changes and styling on both kinds of style storage
+		CellBuffer cbGap(true, false);
+		const std::string mixed = MixedText(2000, true);
+		RandomSequence rseq;
+		for (int i = 0; i < 3000; i++) {
+			const int r = rseq.Next() % 10;
+			const Sci::Position length = cb.Length();
+			if (r <= 2) {
+				const Sci::Position pos = rseq.Next() % (length + 1);
+				const size_t start = rseq.Next() % 1000;
+				const Sci::Position len = rseq.Next() % 40 + 1;
+				for (CellBuffer *pcb : {&cb, &cbGap}) {
+					pcb->InsertString(pos, mixed.data() + start, len, startSequence);
+				}
+			} else if (r <= 4) {
+				const Sci::Position pos = rseq.Next() % (length + 1);
+				const Sci::Position len = std::min<Sci::Position>(rseq.Next() % 30 + 1, length - pos);
+				if (len > 0) {
+					for (CellBuffer *pcb : {&cb, &cbGap}) {
+						pcb->DeleteChars(pos, len, startSequence);
+					}
+				}
+			} else if (r <= 5) {
+				const bool undo = rseq.Next() % 2 == 1;
+				for (CellBuffer *pcb : {&cb, &cbGap}) {
+					if (undo) {
+						UndoBlock(*pcb);
+					} else {
+						RedoBlock(*pcb);
+					}
+				}
+			} else {
+				const Sci::Position pos = rseq.Next() % (length + 1);
+				const Sci::Position len = std::min<Sci::Position>(rseq.Next() % 60, length - pos);
+				std::string styles;
+				while (static_cast<Sci::Position>(styles.length()) < len) {
+					styles.append(rseq.Next() % 8 + 1, static_cast<char>(rseq.Next() % 4));
+				}
+				styles.resize(len);
+				Sci::Position first = -1;
+				Sci::Position last = -1;
+				Sci::Position firstGap = -1;
+				Sci::Position lastGap = -1;
+				const bool changed = cb.SetStyles(pos, len, styles.data(), first, last);
+				REQUIRE(changed == cbGap.SetStyles(pos, len, styles.data(), firstGap, lastGap));
+				if (changed) {
+					// Runs may report a wider range when a run is refilled but never a narrower one
+					REQUIRE(first <= firstGap);
+					REQUIRE(last >= lastGap);
+				}
+			}
+			REQUIRE(cb.Length() == cbGap.Length());
+			const Sci::Position pos = rseq.Next() % (cb.Length() + 1);
+			REQUIRE(cb.StyleAt(pos) == cbGap.StyleAt(pos));
+		}
+		REQUIRE(Styles(cb) == Styles(cbGap));
+	}
+}
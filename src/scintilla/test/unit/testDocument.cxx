@@ -95,7 +95,7 @@ std::ostream &operator << (std::ostream &os, Match const &value) {
 struct DocPlus {
 	Document document;
 
-	DocPlus(std::string_view svInitial, int codePage) : document(DocumentOption::Default) {
+	DocPlus(std::string_view svInitial, int codePage, DocumentOption options=DocumentOption::Default) : document(options) {
 		SetCodePage(codePage);
 		document.InsertString(0, svInitial);
 	}
@@ -215,6 +215,29 @@ TEST_CASE("Document") {
 		}
 	}
 
+	SECTION("SearchInPieces") {
+		DocPlus doc("b-Ab", 0, DocumentOption::PieceTable);
+		doc.document.InsertString(0, "a");
+		doc.document.InsertString(3, "xy");
+		// a b- xy Ab
+		constexpr std::string_view finding = "ab";
+		Sci::Position lengthFinding = finding.length();
+		Sci::Position location = doc.FindNeedle(finding, FindOption::MatchCase, &lengthFinding);
+		REQUIRE(location == 0);
+		location = doc.FindNeedle(finding, FindOption::None, &lengthFinding);
+		REQUIRE(location == 0);
+		location = doc.document.FindText(1, doc.document.Length(), finding.data(), FindOption::None, &lengthFinding);
+		REQUIRE(location == 5);
+		location = doc.FindNeedleReverse(finding, FindOption::None, &lengthFinding);
+		REQUIRE(location == 5);
+		location = doc.document.FindText(1, doc.document.Length(), finding.data(), FindOption::MatchCase, &lengthFinding);
+		REQUIRE(location == -1);
+		constexpr std::string_view across = "-xyA";
+		lengthFinding = across.length();
+		location = doc.FindNeedle(across, FindOption::MatchCase, &lengthFinding);
+		REQUIRE(location == 2);
+	}
+
 	SECTION("InsensitiveSearchInLatin") {
 		DocPlus doc("abcde", 0);	// a b c d e
 		constexpr std::string_view finding = "B";
@@ -1240,4 +1263,70 @@ TEST_CASE("PerLine") {
 		REQUIRE(doc.document.AnnotationLines(1) == 3);
 		REQUIRE(doc.document.AnnotationLines(2) == 0);
 	}
+
+	SECTION("LastChild") {
+		// Enough lines for the level index to be used once the document is styled
+		constexpr Sci::Line lines = 20000;
+		DocPlus doc(std::string(lines - 1, '\n'), CpUtf8);
+		REQUIRE(doc.document.LinesTotal() == lines);
+		const int levelBase = static_cast<int>(FoldLevel::Base);
+		doc.document.SetLevel(0, levelBase | static_cast<int>(FoldLevel::HeaderFlag));
+		for (Sci::Line line = 1; line < lines - 1; line++) {
+			doc.document.SetLevel(line, levelBase + 1);
+		}
+		doc.document.SetLevel(10000, levelBase + 1 | static_cast<int>(FoldLevel::HeaderFlag));
+		for (Sci::Line line = 10001; line < 11000; line++) {
+			doc.document.SetLevel(line, levelBase + 2);
+		}
+		doc.document.SetLevel(lines - 3, levelBase | static_cast<int>(FoldLevel::WhiteFlag));
+		doc.document.SetLevel(lines - 2, levelBase | static_cast<int>(FoldLevel::WhiteFlag));
+		doc.document.StartStyling(0);
+		doc.document.SetStyleFor(doc.document.Length(), 0);
+
+		// Whitespace before the next line at the parent's level is included
+		REQUIRE(doc.document.GetLastChild(0, {}, -1) == lines - 2);
+		REQUIRE(doc.document.GetLastChild(0, {}, 500) == 500);
+		REQUIRE(doc.document.GetLastChild(10000, {}, -1) == 10999);
+		REQUIRE(doc.document.GetFoldParent(10500) == 10000);
+		REQUIRE(doc.document.GetFoldParent(12000) == 0);
+		REQUIRE(doc.document.GetFoldParent(9000) == 0);
+
+		doc.document.SetLevel(15000, levelBase);
+		REQUIRE(doc.document.GetLastChild(0, {}, -1) == 14999);
+		REQUIRE(doc.document.GetFoldParent(16000) == 0);
+		REQUIRE(doc.document.GetFoldParent(15000) == -1);
+
+		// Removing lines moves the end of the fold
+		doc.document.DeleteChars(0, 100);
+		REQUIRE(doc.document.GetLastChild(0, {}, -1) == 14899);
+	}
+}
+
+TEST_CASE("MemoryUsage") {
+
+	SECTION("Categories") {
+		DocPlus doc("a\nb\nc", CpUtf8);
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::Text) >= doc.document.Length());
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::Styles) >= doc.document.Length());
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::LineIndex) > 0);
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::ChangeHistory) == 0);
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::Decorations) == 0);
+		// View caches are not owned by the document
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::LayoutCache) == 0);
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::PositionCache) == 0);
+	}
+
+	SECTION("LineData") {
+		DocPlus doc("a\nb\nc", CpUtf8);
+		const Sci::Position usageBefore = doc.document.MemoryUsage(MemoryCategory::LineData);
+		doc.document.AnnotationSetText(1, "annotation");
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::LineData) > usageBefore);
+	}
+
+	SECTION("Decorations") {
+		DocPlus doc("abcdef", CpUtf8);
+		doc.document.decorations->SetCurrentIndicator(8);
+		doc.document.DecorationFillRange(1, 1, 2);
+		REQUIRE(doc.document.MemoryUsage(MemoryCategory::Decorations) > 0);
+	}
 }
@@ -236,6 +236,108 @@ TEST_CASE("LineLevels") {
 	}
 }
 
+namespace {
+
+// Fold levels of nested blocks with whitespace lines, from a deterministic sequence
+int NextLevel(unsigned int &state, int &depth) {
+	state = state * 1103515245 + 12345;
+	const unsigned int choice = (state >> 16) % 8;
+	int level = FoldBase + depth;
+	if (choice == 0 && depth < 20) {
+		level |= static_cast<int>(Scintilla::FoldLevel::HeaderFlag);
+		depth++;
+	} else if (choice == 1 && depth > 0) {
+		depth--;
+	} else if (choice == 2) {
+		level |= static_cast<int>(Scintilla::FoldLevel::WhiteFlag);
+	}
+	return level;
+}
+
+Sci::Line NextLevelAtMostByLine(const LineLevels &ll, Sci::Line lineStart, Sci::Line lineEnd, int level) {
+	for (Sci::Line line = lineStart; line < lineEnd; line++) {
+		if (LevelIndex::Matches(ll.GetLevel(line), level, false)) {
+			return line;
+		}
+	}
+	return -1;
+}
+
+Sci::Line FoldParentByLine(const LineLevels &ll, Sci::Line line) {
+	const int level = Scintilla::LevelNumber(ll.GetFoldLevel(line));
+	for (Sci::Line lineLook = line - 1; lineLook >= 0; lineLook--) {
+		if (LevelIndex::Matches(ll.GetLevel(lineLook), level - 1, true)) {
+			return lineLook;
+		}
+	}
+	return -1;
+}
+
+}
+
+TEST_CASE("LevelIndex") {
+
+	LineLevels ll;
+	constexpr Sci::Line lines = 0x8000;
+	unsigned int state = 7;
+	int depth = 0;
+	for (Sci::Line line = 0; line < lines; line++) {
+		ll.SetLevel(line, NextLevel(state, depth), lines);
+	}
+
+	auto check = [&ll](Sci::Line linesNow) {
+		for (Sci::Line line = 0; line < linesNow; line += 97) {
+			const int level = Scintilla::LevelNumber(ll.GetFoldLevel(line));
+			REQUIRE(ll.NextLevelAtMost(line + 1, linesNow, level) == NextLevelAtMostByLine(ll, line + 1, linesNow, level));
+			REQUIRE(ll.NextLevelAtMost(line + 1, line + 3000, level) == NextLevelAtMostByLine(ll, line + 1, line + 3000, level));
+			REQUIRE(ll.GetFoldParent(line) == FoldParentByLine(ll, line));
+		}
+	};
+
+	SECTION("Search") {
+		check(lines);
+		REQUIRE(ll.Indexed());
+		// Nothing is at or below a level under the base
+		REQUIRE(ll.NextLevelAtMost(0, lines, FoldBase - 1) == -1);
+	}
+
+	SECTION("SetLevel") {
+		check(lines);
+		for (Sci::Line line = 5; line < lines; line += 1001) {
+			ll.SetLevel(line, FoldBase | static_cast<int>(Scintilla::FoldLevel::HeaderFlag), lines);
+		}
+		check(lines);
+	}
+
+	SECTION("InsertRemoveLine") {
+		check(lines);
+		Sci::Line linesNow = lines;
+		for (int i = 0; i < 200; i++) {
+			state = state * 1103515245 + 12345;
+			const Sci::Line line = (state >> 8) % linesNow;
+			if (i % 3 == 0) {
+				ll.RemoveLine(line);
+				linesNow--;
+			} else {
+				// Enough lines to split blocks
+				ll.InsertLines(line, (i % 3 == 1) ? 1 : 3000);
+				linesNow += (i % 3 == 1) ? 1 : 3000;
+				ll.SetLevel(line, NextLevel(state, depth), linesNow);
+			}
+			if (i % 20 == 0) {
+				check(linesNow);
+			}
+		}
+		check(linesNow);
+		// Removing every line of a block
+		for (int i = 0; i < 3000; i++) {
+			ll.RemoveLine(100);
+			linesNow--;
+		}
+		check(linesNow);
+	}
+}
+
 TEST_CASE("LineState") {
 
 	LineState ls;
@@ -0,0 +1,313 @@
+/** @file testPieceTable.cxx
+ ** Unit Tests for Scintilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <memory>
+
+#include "ILoader.h"
+
+#include "Debugging.h"
+
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "PieceTable.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+// Test PieceTable.
+
+namespace {
+
+class MappedString final : public IMappedText {
+	std::string text;
+	int *releases;
+public:
+	MappedString(std::string_view text_, int *releases_) : text(text_), releases(releases_) {
+	}
+	const char *SCI_METHOD Data() override {
+		return text.data();
+	}
+	Sci_Position SCI_METHOD Length() override {
+		return text.length();
+	}
+	void SCI_METHOD Release() override {
+		(*releases)++;
+		delete this;
+	}
+};
+
+std::string Contents(const PieceTable &pt) {
+	std::string contents(pt.Length(), '\0');
+	pt.GetRange(contents.data(), 0, pt.Length());
+	return contents;
+}
+
+void Insert(PieceTable &pt, Sci::Position position, std::string_view sv) {
+	pt.Insert(position, pt.Store(sv.data(), sv.length()), sv.length());
+}
+
+}
+
+TEST_CASE("PieceTable") {
+
+	PieceTable pt;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(0 == pt.Length());
+		REQUIRE(1 == pt.Pieces());
+		REQUIRE(0 == pt.ValueAt(0));
+		REQUIRE(pt.SegmentAt(0).empty());
+		REQUIRE(std::string_view(pt.BufferPointer()).empty());
+	}
+
+	SECTION("InsertAndRead") {
+		Insert(pt, 0, "Scilla");
+		Insert(pt, 3, "nti");
+		REQUIRE("Scintilla" == Contents(pt));
+		REQUIRE(3 == pt.Pieces());
+		REQUIRE('S' == pt.ValueAt(0));
+		REQUIRE('n' == pt.ValueAt(3));
+		REQUIRE('a' == pt.ValueAt(8));
+		REQUIRE(0 == pt.ValueAt(9));
+		REQUIRE(0 == pt.ValueAt(-1));
+		REQUIRE("nti" == pt.SegmentAt(3));
+		REQUIRE("i" == pt.SegmentAt(5));
+		REQUIRE("lla" == pt.SegmentAt(6));
+		REQUIRE(6 == pt.PieceStart(2));
+		REQUIRE(1 == pt.PieceFromPosition(5));
+	}
+
+	SECTION("AppendingExtendsPiece") {
+		// Typing stores each character next to the one before so it stays as one piece
+		Insert(pt, 0, "a");
+		Insert(pt, 1, "b");
+		Insert(pt, 2, "c");
+		REQUIRE("abc" == Contents(pt));
+		REQUIRE(1 == pt.Pieces());
+	}
+
+	SECTION("DeleteAndRestore") {
+		Insert(pt, 0, "Scintilla");
+		const std::string_view deleted = pt.SegmentAt(2).substr(0, 4);
+		pt.DeleteRange(2, 4);
+		REQUIRE("Sclla" == Contents(pt));
+		REQUIRE(2 == pt.Pieces());
+		// Putting back the deleted text joins the pieces again
+		pt.Insert(2, deleted.data(), deleted.length());
+		REQUIRE("Scintilla" == Contents(pt));
+		REQUIRE(1 == pt.Pieces());
+	}
+
+	SECTION("DeleteAcrossPieces") {
+		Insert(pt, 0, "ace");
+		Insert(pt, 1, "b");
+		Insert(pt, 3, "d");
+		REQUIRE("abcde" == Contents(pt));
+		pt.DeleteRange(1, 3);
+		REQUIRE("ae" == Contents(pt));
+		pt.DeleteRange(1, 1);
+		REQUIRE("a" == Contents(pt));
+		pt.DeleteRange(0, 1);
+		REQUIRE(0 == pt.Length());
+		REQUIRE(1 == pt.Pieces());
+		Insert(pt, 0, "x");
+		REQUIRE("x" == Contents(pt));
+	}
+
+	SECTION("RangePointer") {
+		Insert(pt, 0, "ace");
+		Insert(pt, 1, "b");
+		Insert(pt, 3, "d");
+		REQUIRE(5 == pt.Pieces());
+		// Within a piece
+		const char *pd = pt.RangePointer(3, 1);
+		REQUIRE(*pd == 'd');
+		REQUIRE(5 == pt.Pieces());
+		// Across pieces is a copy that leaves the pieces alone
+		const char *pbcd = pt.RangePointer(1, 3);
+		REQUIRE(std::string_view(pbcd, 3) == "bcd");
+		REQUIRE(5 == pt.Pieces());
+		REQUIRE("abcde" == Contents(pt));
+		REQUIRE(!pt.RangePointer(3, 3));
+	}
+
+	SECTION("StoreRange") {
+		Insert(pt, 0, "ace");
+		Insert(pt, 1, "b");
+		const char *pc = pt.StoreRange(2, 1);
+		REQUIRE(pc == pt.SegmentAt(2).data());
+		const char *pbc = pt.StoreRange(1, 2);
+		REQUIRE(std::string_view(pbc, 2) == "bc");
+		// Still valid after the text changes
+		pt.DeleteRange(0, 4);
+		REQUIRE(std::string_view(pbc, 2) == "bc");
+	}
+
+	SECTION("BufferPointer") {
+		Insert(pt, 0, "ace");
+		Insert(pt, 1, "b");
+		Insert(pt, 3, "d");
+		const char *buffer = pt.BufferPointer();
+		REQUIRE(std::string_view(buffer) == "abcde");
+		REQUIRE(5 == pt.Pieces());
+		REQUIRE(buffer == pt.BufferPointer());
+		// Ranges come from the copy
+		REQUIRE(pt.RangePointer(1, 3) == buffer + 1);
+		pt.DeleteRange(4, 1);
+		REQUIRE(std::string_view(pt.BufferPointer()) == "abcd");
+	}
+
+	SECTION("CopiesDoNotAccumulate") {
+		const std::string text(10000, 'x');
+		Insert(pt, 0, text);
+		Insert(pt, 5000, "y");
+		pt.BufferPointer();
+		const size_t memory = pt.MemoryUsage();
+		for (int i = 0; i < 100; i++) {
+			pt.DeleteRange(5000, 1);
+			Insert(pt, 5000, "y");
+			pt.BufferPointer();
+			pt.RangePointer(4000, 2000);
+		}
+		// Only the typing is added
+		REQUIRE(pt.MemoryUsage() < memory + 1000);
+	}
+
+	SECTION("Original") {
+		int releases = 0;
+		{
+			PieceTable ptOriginal;
+			MappedString *original = new MappedString("Scintilla", &releases);
+			REQUIRE(ptOriginal.SetOriginal(original));
+			REQUIRE(!ptOriginal.SetOriginal(original));
+			const size_t memoryBefore = ptOriginal.MemoryUsage();
+			// Text from the original is referred to, not copied
+			const char *text = ptOriginal.Store(original->Data(), original->Length());
+			REQUIRE(text == original->Data());
+			ptOriginal.Insert(0, text, original->Length());
+			REQUIRE(memoryBefore == ptOriginal.MemoryUsage());
+			REQUIRE(ptOriginal.SegmentAt(0).data() == original->Data());
+			// Parts of the original are also referred to
+			const char *part = ptOriginal.Store(original->Data() + 3, 3);
+			REQUIRE(part == original->Data() + 3);
+			// Other text is copied
+			const std::string other = "til";
+			REQUIRE(ptOriginal.Store(other.data(), other.length()) != other.data());
+			REQUIRE(0 == releases);
+		}
+		REQUIRE(1 == releases);
+	}
+
+	SECTION("DetachOriginal") {
+		int releases = 0;
+		PieceTable ptOriginal;
+		REQUIRE(!ptOriginal.DetachOriginal());
+		MappedString *original = new MappedString("Scintilla", &releases);
+		REQUIRE(ptOriginal.SetOriginal(original));
+		const std::string_view originalText = ptOriginal.OriginalText();
+		ptOriginal.Insert(0, ptOriginal.Store(originalText.data(), originalText.length()), originalText.length());
+		ptOriginal.DeleteRange(3, 3);
+		REQUIRE(2 == ptOriginal.Pieces());
+		const char *copy = ptOriginal.DetachOriginal();
+		REQUIRE(copy);
+		REQUIRE(1 == releases);
+		REQUIRE(ptOriginal.OriginalText().empty());
+		// The pieces now refer to the same places in the copy
+		REQUIRE(ptOriginal.PieceText(0) == copy);
+		REQUIRE(ptOriginal.PieceText(1) == copy + 6);
+		REQUIRE(ptOriginal.BufferPointer() == std::string_view("Scilla"));
+		REQUIRE(!ptOriginal.DetachOriginal());
+	}
+
+	SECTION("Random") {
+		// Compare against a string for a long series of insertions, deletions, and merges
+		std::string reference;
+		uint32_t seed = 1;
+		auto random = [&seed](uint32_t range) {
+			seed = seed * 1103515245 + 12345;
+			return (seed >> 8) % range;
+		};
+		for (int step = 0; step < 2000; step++) {
+			const Sci::Position length = pt.Length();
+			const uint32_t choice = random(10);
+			if (choice < 6 || length == 0) {
+				std::string text(random(20) + 1, '\0');
+				for (char &ch : text) {
+					ch = static_cast<char>('a' + random(26));
+				}
+				const Sci::Position position = random(static_cast<uint32_t>(length) + 1);
+				Insert(pt, position, text);
+				reference.insert(position, text);
+			} else if (choice < 9) {
+				const Sci::Position position = random(static_cast<uint32_t>(length));
+				const Sci::Position lengthDelete = std::min<Sci::Position>(random(30) + 1, length - position);
+				pt.DeleteRange(position, lengthDelete);
+				reference.erase(position, lengthDelete);
+			} else {
+				const Sci::Position position = random(static_cast<uint32_t>(length));
+				const Sci::Position lengthRange = std::min<Sci::Position>(random(40) + 1, length - position);
+				const char *range = pt.RangePointer(position, lengthRange);
+				REQUIRE(std::string_view(range, lengthRange) == std::string_view(reference).substr(position, lengthRange));
+			}
+			REQUIRE(static_cast<Sci::Position>(reference.length()) == pt.Length());
+		}
+		REQUIRE(reference == Contents(pt));
+		for (Sci::Position position = 0; position < pt.Length(); position++) {
+			REQUIRE(reference[position] == pt.ValueAt(position));
+		}
+	}
+}
+
+TEST_CASE("PieceView") {
+
+	PieceTable pt;
+	Insert(pt, 0, "a-b-c");
+	Insert(pt, 2, "xyz");
+	Insert(pt, 8, "b");
+	// a-xyzb-cb in pieces "a-" "xyz" "b-c" "b"
+	REQUIRE(4 == pt.Pieces());
+
+	SECTION("CharAt") {
+		const PieceView view(pt);
+		const std::string contents = Contents(pt);
+		for (Sci::Position position = 0; position < pt.Length(); position++) {
+			REQUIRE(contents[position] == view.CharAt(position));
+		}
+		// Backwards
+		for (Sci::Position position = pt.Length() - 1; position >= 0; position--) {
+			REQUIRE(contents[position] == view.CharAt(position));
+		}
+		REQUIRE(0 == view.CharAt(-1));
+		REQUIRE(0 == view.CharAt(pt.Length()));
+	}
+
+	SECTION("FindChar") {
+		const PieceView view(pt);
+		REQUIRE(5 == view.FindChar(0, pt.Length(), 'b'));
+		REQUIRE(8 == view.FindChar(6, pt.Length() - 6, 'b'));
+		REQUIRE(7 == view.FindChar(0, pt.Length(), 'c'));
+		REQUIRE(-1 == view.FindChar(0, 7, 'c'));
+		REQUIRE(-1 == view.FindChar(0, pt.Length(), 'q'));
+	}
+
+	SECTION("Match") {
+		const PieceView view(pt);
+		REQUIRE(view.Match(3, "yzb-c"));
+		REQUIRE(!view.Match(3, "yzb-d"));
+		REQUIRE(!view.Match(7, "cbx"));
+	}
+}
@@ -367,6 +367,17 @@ TEST_CASE("RunStyles") {
 		rs.Check();
 	}
 
+	SECTION("MemoryUsage") {
+		rs.InsertSpace(0, 100);
+		const size_t usageOneRun = rs.MemoryUsage();
+		REQUIRE(usageOneRun > 0);
+		for (int i = 0; i < 100; i += 2) {
+			rs.FillRange(i, 99, 1);
+		}
+		REQUIRE(100 == rs.Runs());
+		REQUIRE(rs.MemoryUsage() > usageOneRun);
+	}
+
 	SECTION("OutsideBounds") {
 		rs.InsertSpace(0, 1);
 		const int startFill = 1;
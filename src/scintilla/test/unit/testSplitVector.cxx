@@ -389,6 +389,15 @@ TEST_CASE("SplitVector") {
 		REQUIRE(5 == sv.GetGrowSize());
 	}
 
+	SECTION("MemoryUsage") {
+		REQUIRE(0 == sv.MemoryUsage());
+		sv.InsertValue(0, 1000, 87);
+		// Includes the gap so may be larger than the values stored
+		REQUIRE(1000 * sizeof(int) <= sv.MemoryUsage());
+		sv.DeleteAll();
+		REQUIRE(0 == sv.MemoryUsage());
+	}
+
 	SECTION("OutsideBounds") {
 		sv.InsertValue(0, 10, 87);
 		REQUIRE(0 == sv.ValueAt(-1));
@@ -619,7 +619,7 @@ class ScintillaWin :
 	void IdleWork() override;
 	void QueueIdleWork(WorkItems items, Sci::Position upTo) override;
 	bool SetIdle(bool on) override;
-	UINT_PTR timers[static_cast<int>(TickReason::dwell)+1] {};
+	UINT_PTR timers[static_cast<int>(TickReason::index)+1] {};
 	bool FineTickerRunning(TickReason reason) override;
 	void FineTickerStart(TickReason reason, int millis, int tolerance) override;
 	void FineTickerCancel(TickReason reason) override;
@@ -805,7 +805,7 @@ ScintillaWin::~ScintillaWin() {
 
 void ScintillaWin::Finalise() {
 	ScintillaBase::Finalise();
-	for (TickReason tr = TickReason::caret; tr <= TickReason::dwell;
+	for (TickReason tr = TickReason::caret; tr <= TickReason::index;
 		tr = static_cast<TickReason>(static_cast<int>(tr) + 1)) {
 		FineTickerCancel(tr);
 	}
@@ -115,6 +115,83 @@ $(DIR_O)/AutoComplete.obj: \
 	../src/CharacterType.h \
 	../src/Position.h \
 	../src/AutoComplete.h
+$(DIR_O)/BackgroundStyler.obj: \
+	../src/BackgroundStyler.cxx \
+	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/PieceTable.h \
+	../src/CellBuffer.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/BackgroundStyler.h \
+	../src/UniConversion.h
+$(DIR_O)/BackgroundWrapper.obj: \
+	../src/BackgroundWrapper.cxx \
+	../include/ScintillaTypes.h \
+	../include/ScintillaMessages.h \
+	../include/ScintillaStructures.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/Geometry.h \
+	../src/Platform.h \
+	../src/CharacterType.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/UniqueString.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/ContractionState.h \
+	../src/CellBuffer.h \
+	../src/PerLine.h \
+	../src/KeyMap.h \
+	../src/Indicator.h \
+	../src/LineMarker.h \
+	../src/Style.h \
+	../src/ViewStyle.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/UniConversion.h \
+	../src/Selection.h \
+	../src/PositionCache.h \
+	../src/EditModel.h \
+	../src/MarginView.h \
+	../src/EditView.h \
+	../src/BackgroundWrapper.h
+$(DIR_O)/BraceIndex.obj: \
+	../src/BraceIndex.cxx \
+	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../include/ILexer.h \
+	../src/Debugging.h \
+	../src/CharacterCategoryMap.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/RunStyles.h \
+	../src/PieceTable.h \
+	../src/CellBuffer.h \
+	../src/CharClassify.h \
+	../src/Decoration.h \
+	../src/CaseFolder.h \
+	../src/Document.h \
+	../src/BraceIndex.h
 $(DIR_O)/CallTip.obj: \
 	../src/CallTip.cxx \
 	../include/ScintillaTypes.h \
@@ -136,6 +213,8 @@ $(DIR_O)/CaseFolder.obj: \
 $(DIR_O)/CellBuffer.obj: \
 	../src/CellBuffer.cxx \
 	../include/ScintillaTypes.h \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
 	../src/Debugging.h \
 	../src/Position.h \
 	../src/SplitVector.h \
@@ -143,6 +222,7 @@ $(DIR_O)/CellBuffer.obj: \
 	../src/RunStyles.h \
 	../src/SparseVector.h \
 	../src/ChangeHistory.h \
+	../src/PieceTable.h \
 	../src/CellBuffer.h \
 	../src/UndoHistory.h \
 	../src/UniConversion.h
@@ -201,12 +281,15 @@ $(DIR_O)/Document.obj: \
 	../src/SplitVector.h \
 	../src/Partitioning.h \
 	../src/RunStyles.h \
+	../src/PieceTable.h \
 	../src/CellBuffer.h \
 	../src/PerLine.h \
 	../src/CharClassify.h \
 	../src/Decoration.h \
 	../src/CaseFolder.h \
 	../src/Document.h \
+	../src/BackgroundStyler.h \
+	../src/BraceIndex.h \
 	../src/RESearch.h \
 	../src/UniConversion.h \
 	../src/ElapsedPeriod.h
@@ -276,6 +359,7 @@ $(DIR_O)/Editor.obj: \
 	../src/EditModel.h \
 	../src/MarginView.h \
 	../src/EditView.h \
+	../src/BackgroundWrapper.h \
 	../src/Editor.h \
 	../src/ElapsedPeriod.h
 $(DIR_O)/EditView.obj: \
@@ -388,6 +472,15 @@ $(DIR_O)/PerLine.obj: \
 	../src/Partitioning.h \
 	../src/CellBuffer.h \
 	../src/PerLine.h
+$(DIR_O)/PieceTable.obj: \
+	../src/PieceTable.cxx \
+	../include/ILoader.h \
+	../include/Sci_Position.h \
+	../src/Debugging.h \
+	../src/Position.h \
+	../src/SplitVector.h \
+	../src/Partitioning.h \
+	../src/PieceTable.h
 $(DIR_O)/PositionCache.obj: \
 	../src/PositionCache.cxx \
 	../include/ScintillaTypes.h \
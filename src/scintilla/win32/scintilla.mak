@@ -86,6 +86,9 @@ depend:
 # Required for base Scintilla
 SRC_OBJS=\
 	$(DIR_O)\AutoComplete.obj \
+	$(DIR_O)\BackgroundStyler.obj \
+	$(DIR_O)\BackgroundWrapper.obj \
+	$(DIR_O)\BraceIndex.obj \
 	$(DIR_O)\CallTip.obj \
 	$(DIR_O)\CaseConvert.obj \
 	$(DIR_O)\CaseFolder.obj \
@@ -107,6 +110,7 @@ SRC_OBJS=\
 	$(DIR_O)\LineMarker.obj \
 	$(DIR_O)\MarginView.obj \
 	$(DIR_O)\PerLine.obj \
+	$(DIR_O)\PieceTable.obj \
 	$(DIR_O)\PositionCache.obj \
 	$(DIR_O)\RESearch.obj \
 	$(DIR_O)\RunStyles.obj \